@@ -25,24 +25,10 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 #include "Camera.h"
 #include <cassert>
 #include <vector>
+#include <algorithm>
 
 namespace rics
 {
-    static bool closed = false;
-    
-    void  __stdcall CameraEventCB(void* Context,
-                                  tPvInterface Interface,
-                                  tPvLinkEvent Event,
-                                  unsigned long UniqueId);
-
-    
-    //For sorting the cameras based on their unique IDs
-    bool uniqueIdSort(tPvCameraInfoEx& camInfo0, tPvCameraInfoEx& camInfo1)
-    {
-        return camInfo0.UniqueId < camInfo1.UniqueId;
-    }
-    
-    
     App::App():
     numCams_(0),
     name_(wxString::Format(wxT("MyApp-%s"), wxGetUserId().c_str())),
@@ -52,14 +38,14 @@ namespace rics
 
     App::~App()
     {
-        //uninitialise the cameras
-        for (unsigned long i = 0; i < numCams_; ++i)
+        cameraManager_.reset();
+
+        //uninitialise the cameras (a camera re-opened after being unplugged has a new handle)
+        for (size_t i = 0; i < cameras_.size(); ++i)
         {
-            tPvErr returnCode = PvCameraClose(hCamera_[i]);
-            assert(!returnCode);
+            cameras_[i].close();
         }
         
-        PvLinkCallbackUnRegister(CameraEventCB, ePvLinkRemove);
         PvUnInitialize();
     }
 
@@ -75,9 +61,8 @@ namespace rics
         //Initialise API
         if(!PvInitialize())
         {        
-            PvLinkCallbackRegister(CameraEventCB, ePvLinkRemove, this);
-            
-            initCameraHandlersUniqueID();
+            CameraStartup startup;
+            numCams_ = startup.open(&cameras_);
 
             //Abort if no cameras attached
             if (!numCams_)
@@ -86,25 +71,16 @@ namespace rics
                 return false; 
             }
 
-            if (numCams_ > 4)
-            {
-                wxLogError(_("More than 4 cameras attached, aborting."));
-                return false; 
-            }
-
-            //Calculate the stream bytes per second per camera
-            unsigned long streamBytesPerSecond = maxStreamBytesPerSecond_/numCams_;
-            
-            //Initialise the cameras
-            for (unsigned long i = 0; i < numCams_; ++i)
-            {
-                cameras_.push_back(Camera(hCamera_[i], streamBytesPerSecond));
-            }
+            //An unplugged camera pauses just its own stream until it is plugged back in.
+            cameraManager_ = boost::shared_ptr<CameraManager>(new CameraManager(&cameras_));
 
             wxInitAllImageHandlers();
 
-            //wxSize frameSize(619, 953); 
-            wxSize frameSize(420, 720);//This is the size of the GUI
+            //This is the size of the GUI. It grows with the number of preview panels.
+            wxSize grid = Canvas::panelGrid(numCams_);
+            wxSize frameSize(420, 720);
+            frameSize.SetWidth(std::max(frameSize.GetWidth(), grid.GetWidth()*205 + 10));
+            frameSize.SetHeight(frameSize.GetHeight() + (grid.GetHeight() - 2)*171);
             frame_ = new Frame(_T("RICS (Test Mode)"), 
                                wxDefaultPosition, 
                                frameSize, 
@@ -114,6 +90,8 @@ namespace rics
             frame_->SetIcon(wxIcon("aaaa"));
             frame_->Show(TRUE);
 
+            wxLogStatus(frame_, "%s", startup.timing().c_str());
+
             return TRUE;
         }
         else
@@ -123,48 +101,10 @@ namespace rics
         }
     }
 
-    void App::closeApp()
-    {
-        frame_->unpluggedClose();
-    }
-
-    //This method searches for cameras that are attached to the computer and opens those.
-    //This is preferred as it does not rely on any prior knowledge (ie IP addresses)
-    //of the cameras.
-    void App::initCameraHandlersUniqueID()
-    {        
-        tPvCameraInfoEx cams0[10]; //10 elements allocated in case more than 4 cameras attached.
-        unsigned long numCameras;
-        Sleep(1000);//Needs to sleep here otherwise it won't pick up any cameras.
-        numCameras = PvCameraListEx(cams0, 10, NULL, sizeof(tPvCameraInfoEx));
-        
-        if (!numCameras)
-        {
-            return;//No camera detected
-        }
-
-        if (numCameras > 4)
-        {
-            return; //Software designed to work with up to 4 cameras only!
-        }
-        
-        std::vector<tPvCameraInfoEx> cams1(cams0, cams0 + numCameras);
-
-        //Cameras are ordered based on their unique IDs.
-        std::sort(cams1.begin(), cams1.end(), uniqueIdSort);
-        
-        tPvHandle handle;
-
-        for (unsigned long i = 0; i < cams1.size(); ++i)
-        {
-            PvCameraOpen(cams1[i].UniqueId, ePvAccessMaster, &handle);
-            hCamera_.push_back(handle);
-            numCams_++;
-        }
-    }
-
     //This method opens the cameras using their IP address. The drawback of this
-    //method is that the camera's IP addresses need to be set before use.
+    //method is that the camera's IP addresses need to be set before use. 
+    //Not used; cameras are found by CameraStartup, which doesn't rely on any prior
+    //knowledge of the cameras.
     void App::initCameraHandlersIP()
     {     
         //The IP address of the cameras must be set to 169.254.1.x where x is in the range 
@@ -174,43 +114,30 @@ namespace rics
         if (!PvCameraOpenByAddr(inet_addr("169.254.1.2"), ePvAccessMaster, &handle))//Unique ID = 53044
         {
             hCamera_.push_back(handle);
+            interfaceIDs_.push_back(0);
             numCams_++;
         }
         
         if (!PvCameraOpenByAddr(inet_addr("169.254.1.3"), ePvAccessMaster, &handle))//Unique ID = 53045/
         {
             hCamera_.push_back(handle);
+            interfaceIDs_.push_back(0);
             numCams_++;
         }
         
         if (!PvCameraOpenByAddr(inet_addr("169.254.1.4"), ePvAccessMaster, &handle))//Unique ID = 53046
         {
             hCamera_.push_back(handle);
+            interfaceIDs_.push_back(0);
             numCams_++;
         }
 
         if (!PvCameraOpenByAddr(inet_addr("169.254.1.5"), ePvAccessMaster, &handle))//Unique ID = 53086
         {
             hCamera_.push_back(handle);
+            interfaceIDs_.push_back(0);
             numCams_++;
         }
     }
 
-    //This callback function is called when the camera is unplugged.
-    //The application should exit cleanly
-    void __stdcall CameraEventCB(void* context,
-                                 tPvInterface Interface,
-                                 tPvLinkEvent Event,
-                                 unsigned long UniqueId)
-    {
-        Sleep(100);//Needs to Sleep otherwise it won't quit properly.
-        if (!closed)
-        {
-            wxLogError(_("Camera(s) unplugged, aborting."));
-            App* app = (App*)context;
-            app->closeApp();
-            closed = true;
-        }
-    }
-
 } //namespace
\ No newline at end of file
@@ -25,6 +25,8 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 #define MYAPP_H
 
 #include "Frame.h"
+#include "CameraManager.h"
+#include "CameraStartup.h"
 #include <wx/wx.h>
 #include <wx/snglinst.h>
 #include <wx/help.h>
@@ -40,18 +42,16 @@ namespace rics
         App();
         ~App();
 
-        void closeApp();
-
     private:
         virtual bool OnInit();
-        void initCameraHandlersUniqueID();
         void initCameraHandlersIP();
 
     private:
         unsigned long numCams_;
         std::vector<tPvHandle> hCamera_;
+        std::vector<unsigned long> interfaceIDs_;
         Cameras cameras_;
-        static const unsigned long maxStreamBytesPerSecond_ = 120000000;
+        boost::shared_ptr<CameraManager> cameraManager_;
 
         const wxString name_;
         boost::shared_ptr<wxSingleInstanceChecker> instanceChecker_;
@@ -0,0 +1,102 @@
+/*
+Author: Nariman Habili
+
+Description: Shares the available gigabit ethernet bandwidth between the
+             cameras. Each network interface has its own budget, which is
+             split between the cameras on that interface in proportion to
+             the data rate each camera needs (frame rate x frame size).
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BandwidthAllocator.h"
+#include <map>
+
+namespace rics
+{
+    BandwidthAllocator::BandwidthAllocator(unsigned long bytesPerInterface):
+    bytesPerInterface_(bytesPerInterface)
+    {
+    }
+
+    BandwidthAllocator::~BandwidthAllocator()
+    {
+    }
+
+    //Set "StreamBytesPerSecond" on every camera. Should be called again whenever
+    //the frame rate or ROI of a camera changes.
+    void BandwidthAllocator::allocate(Cameras* cameras)
+    {
+        std::vector<unsigned long> interfaceIDs;
+        std::vector<double> demands;
+
+        for (size_t i = 0; i < (*cameras).size(); ++i)
+        {
+            interfaceIDs.push_back((*cameras)[i].interfaceID());
+            demands.push_back(static_cast<double>((*cameras)[i].frameRate())*(*cameras)[i].totalBytesPerFrame());
+        }
+
+        std::vector<unsigned long> bytes = allocation(interfaceIDs, demands);
+
+        for (size_t i = 0; i < (*cameras).size(); ++i)
+        {
+            (*cameras)[i].setStreamBytesPerSecond(bytes[i]);
+        }
+    }
+
+    //Bytes per second for each camera. Cameras on the same interface share its
+    //budget in proportion to their demand (bytes/sec). Cameras on other
+    //interfaces don't affect each other.
+    std::vector<unsigned long> BandwidthAllocator::allocation(const std::vector<unsigned long>& interfaceIDs,
+                                                              const std::vector<double>& demands) const
+    {
+        std::map<unsigned long, double> totalDemands;
+        std::map<unsigned long, size_t> numCameras;
+
+        for (size_t i = 0; i < interfaceIDs.size(); ++i)
+        {
+            totalDemands[interfaceIDs[i]] += demands[i];
+            ++numCameras[interfaceIDs[i]];
+        }
+
+        std::vector<unsigned long> bytes(interfaceIDs.size(), minBytesPerCamera_);
+
+        for (size_t i = 0; i < interfaceIDs.size(); ++i)
+        {
+            double total = totalDemands[interfaceIDs[i]];
+            double share;
+
+            if (total > 0.0)
+            {
+                share = bytesPerInterface_*demands[i]/total;
+            }
+            else
+            {
+                share = static_cast<double>(bytesPerInterface_)/numCameras[interfaceIDs[i]];
+            }
+
+            if (share > minBytesPerCamera_)
+            {
+                bytes[i] = static_cast<unsigned long>(share);
+            }
+        }
+
+        return bytes;
+    }
+
+}//namespace
\ No newline at end of file
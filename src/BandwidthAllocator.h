@@ -0,0 +1,57 @@
+/*
+Author: Nariman Habili
+
+Description: Shares the available gigabit ethernet bandwidth between the
+             cameras. Each network interface has its own budget, which is
+             split between the cameras on that interface in proportion to
+             the data rate each camera needs (frame rate x frame size).
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BANDWIDTH_ALLOCATOR_H
+#define BANDWIDTH_ALLOCATOR_H
+
+#include "Camera.h"
+#include <vector>
+
+namespace rics
+{
+    class BandwidthAllocator
+    {
+    public:
+        BandwidthAllocator(unsigned long bytesPerInterface = maxBytesPerInterface_);
+        ~BandwidthAllocator();
+
+        void allocate(Cameras* cameras);
+        std::vector<unsigned long> allocation(const std::vector<unsigned long>& interfaceIDs,
+                                              const std::vector<double>& demands) const;
+
+    public:
+        //For a gigabit ethernet card the maximum stream bytes per second is 124000000.
+        //A little is held back for resends.
+        static const unsigned long maxBytesPerInterface_ = 120000000;
+        static const unsigned long minBytesPerCamera_ = 1000000;
+
+    private:
+        unsigned long bytesPerInterface_;
+    };
+
+}//namespace
+
+#endif //BANDWIDTH_ALLOCATOR_H
\ No newline at end of file
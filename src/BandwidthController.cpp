@@ -0,0 +1,245 @@
+/*
+Author: Nariman Habili
+
+Description: Adjusts the stream bandwidth and packet size of the cameras
+             while streaming, based on the packet statistics reported by
+             the PvAPI. Every decision is logged to the database.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BandwidthController.h"
+#include "BandwidthAllocator.h"
+#include <boost/lexical_cast.hpp>
+#include <algorithm>
+
+namespace rics
+{
+    static const int samplePeriod = 2000;       //ms between samples
+    static const unsigned long resendLimit = 50;//resent packets per sample before backing off
+    static const double minScale = 0.5;         //never go below half the interface budget
+    static const int cleanSamplesUp = 15;       //clean samples before trying a larger packet size
+    static const unsigned long minPacketSize = 1500;
+
+    BandwidthController::BandwidthController()
+    {
+    }
+
+    BandwidthController::BandwidthController(Cameras* cameras, Database* db, Session* const session, bool fixedRate):
+    cameras_(cameras),
+    db_(db),
+    session_(session),
+    fixedRate_(fixedRate),
+    lastMissed_((*cameras).size(), 0),
+    lastResent_((*cameras).size(), 0),
+    streamBytes_((*cameras).size(), 0),
+    maxPacketSizes_((*cameras).size(), 0),
+    packetSizes_((*cameras).size(), 0),
+    cleanSamples_((*cameras).size(), 0)
+    {
+    }
+
+    BandwidthController::~BandwidthController()
+    {
+    }
+
+    void* BandwidthController::Entry()
+    {
+        //The packet size chosen in the camera properties is the largest the controller will use.
+        for (size_t i = 0; i < (*cameras_).size(); ++i)
+        {
+            lastMissed_[i] = (*cameras_)[i].packetsMissed();
+            lastResent_[i] = (*cameras_)[i].packetsResent();
+            streamBytes_[i] = (*cameras_)[i].streamBytesPerSecond();
+            maxPacketSizes_[i] = (*cameras_)[i].packetSize();
+            packetSizes_[i] = maxPacketSizes_[i];
+            scales_[(*cameras_)[i].interfaceID()] = 1.0;
+        }
+
+        while (!TestDestroy())
+        {
+            //Short sleeps so the thread can be deleted promptly.
+            for (int t = 0; t < samplePeriod && !TestDestroy(); t += 100)
+            {
+                Sleep(100);
+            }
+
+            if (!TestDestroy())
+            {
+                sample();
+            }
+        }
+
+        return NULL;
+    }
+
+    void BandwidthController::OnExit()
+    {
+    }
+
+    //Missed or heavily resent packets on any camera mean the interface (or the PC)
+    //can't keep up, so all cameras on that interface are backed off together.
+    //The budget creeps back up while the interface stays clean. Cameras that
+    //can't reach their frame rate get a bigger share of their interface. If an
+    //interface is still losing packets at the lowest budget the packet size is
+    //stepped down, and stepped back up after a long clean period.
+    void BandwidthController::sample()
+    {
+        size_t numCameras = (*cameras_).size();
+        std::vector<unsigned long> missed(numCameras);
+        std::vector<unsigned long> resent(numCameras);
+        std::vector<float> frameRates(numCameras);
+        std::vector<bool> lossy(numCameras);
+        std::map<unsigned long, bool> lossyInterfaces;
+
+        for (size_t i = 0; i < numCameras; ++i)
+        {
+            unsigned long m = (*cameras_)[i].packetsMissed();
+            unsigned long r = (*cameras_)[i].packetsResent();
+
+            //The driver's statistics restart when the camera is reconnected or
+            //recovered. Re-baseline rather than take the wrapped difference,
+            //and rewrite the share as the camera may have lost it.
+            if (m < lastMissed_[i] || r < lastResent_[i])
+            {
+                missed[i] = 0;
+                resent[i] = 0;
+                streamBytes_[i] = 0;
+            }
+            else
+            {
+                missed[i] = m - lastMissed_[i];
+                resent[i] = r - lastResent_[i];
+            }
+
+            lastMissed_[i] = m;
+            lastResent_[i] = r;
+            frameRates[i] = (*cameras_)[i].actualFrameRate();
+
+            lossy[i] = missed[i] > 0 || resent[i] > resendLimit;
+            lossyInterfaces[(*cameras_)[i].interfaceID()] |= lossy[i];
+        }
+
+        std::map<unsigned long, wxString> actions;
+        for (std::map<unsigned long, double>::iterator it = scales_.begin(); it != scales_.end(); ++it)
+        {
+            double scale = it->second;
+
+            if (lossyInterfaces[it->first])
+            {
+                scale = std::max(minScale, scale*0.9);
+            }
+            else
+            {
+                scale = std::min(1.0, scale*1.05);
+            }
+
+            actions[it->first] = scale < it->second ? "decrease" : (scale > it->second ? "increase" : "hold");
+            it->second = scale;
+        }
+
+        //Share each interface's budget between its cameras.
+        std::vector<unsigned long> bytes(numCameras);
+        for (std::map<unsigned long, double>::iterator it = scales_.begin(); it != scales_.end(); ++it)
+        {
+            std::vector<size_t> members;
+            std::vector<unsigned long> interfaceIDs;
+            std::vector<double> demands;
+
+            for (size_t i = 0; i < numCameras; ++i)
+            {
+                if ((*cameras_)[i].interfaceID() == it->first)
+                {
+                    float target = (*cameras_)[i].frameRate();
+                    double demand = static_cast<double>(target)*(*cameras_)[i].totalBytesPerFrame();
+
+                    if (fixedRate_ && !lossy[i] && frameRates[i] < 0.9f*target)
+                    {
+                        demand *= 1.25;
+                    }
+
+                    members.push_back(i);
+                    interfaceIDs.push_back(it->first);
+                    demands.push_back(demand);
+                }
+            }
+
+            BandwidthAllocator allocator(static_cast<unsigned long>(BandwidthAllocator::maxBytesPerInterface_*it->second));
+            std::vector<unsigned long> shares = allocator.allocation(interfaceIDs, demands);
+
+            for (size_t j = 0; j < members.size(); ++j)
+            {
+                bytes[members[j]] = shares[j];
+            }
+        }
+
+        for (size_t i = 0; i < numCameras; ++i)
+        {
+            unsigned long interfaceID = (*cameras_)[i].interfaceID();
+            wxString action = actions[interfaceID];
+
+            if (bytes[i] != streamBytes_[i])
+            {
+                (*cameras_)[i].setStreamBytesPerSecond(bytes[i]);
+                streamBytes_[i] = bytes[i];
+            }
+
+            //The packet size is changed by the camera thread, between frames.
+            if (lossy[i])
+            {
+                cleanSamples_[i] = 0;
+
+                if (scales_[interfaceID] <= minScale && packetSizes_[i] > minPacketSize)
+                {
+                    packetSizes_[i] = std::max(minPacketSize, packetSizes_[i] - 1000);
+                    (*cameras_)[i].requestPacketSize(packetSizes_[i]);
+                    action += ", packet size down";
+                }
+            }
+            else if (++cleanSamples_[i] >= cleanSamplesUp)
+            {
+                cleanSamples_[i] = 0;
+
+                if (packetSizes_[i] < maxPacketSizes_[i])
+                {
+                    packetSizes_[i] = std::min(maxPacketSizes_[i], packetSizes_[i] + 500);
+                    (*cameras_)[i].requestPacketSize(packetSizes_[i]);
+                    action += ", packet size up";
+                }
+            }
+
+            log(i, missed[i], resent[i], frameRates[i], bytes[i], packetSizes_[i], action);
+        }
+    }
+
+    void BandwidthController::log(size_t camera,
+                                  unsigned long missed,
+                                  unsigned long resent,
+                                  float frameRate,
+                                  unsigned long bytes,
+                                  unsigned long packetSize,
+                                  const wxString& action)
+    {
+        if (session_->createDB())
+        {
+            wxString cameraID = boost::lexical_cast<std::string>((*cameras_)[camera].uniqueID());
+            db_->databaseEnterBandwidth(cameraID, missed, resent, frameRate, bytes, packetSize, action);
+        }
+    }
+
+} //namespace
\ No newline at end of file
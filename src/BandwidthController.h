@@ -0,0 +1,77 @@
+/*
+Author: Nariman Habili
+
+Description: Adjusts the stream bandwidth and packet size of the cameras
+             while streaming, based on the packet statistics reported by
+             the PvAPI. Every decision is logged to the database.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BANDWIDTH_CONTROLLER_H
+#define BANDWIDTH_CONTROLLER_H
+
+#include "Camera.h"
+#include "Database.h"
+#include "Session.h"
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <windows.h>
+#include <map>
+#include <vector>
+
+namespace rics
+{
+    class BandwidthController : public wxThread
+    {
+    public:
+        BandwidthController();
+        BandwidthController(Cameras* cameras, Database* db, Session* const session, bool fixedRate);
+        ~BandwidthController();
+
+        void* Entry();
+
+        void OnExit();
+
+    private:
+        void sample();
+        void log(size_t camera,
+                 unsigned long missed,
+                 unsigned long resent,
+                 float frameRate,
+                 unsigned long bytes,
+                 unsigned long packetSize,
+                 const wxString& action);
+
+    private:
+        Cameras* cameras_;
+        Database* db_;
+        Session* session_;
+        bool fixedRate_;//cameras free run at their frame rate (not triggered)
+
+        std::vector<unsigned long> lastMissed_;
+        std::vector<unsigned long> lastResent_;
+        std::vector<unsigned long> streamBytes_;//last share written to each camera
+        std::vector<unsigned long> maxPacketSizes_;
+        std::vector<unsigned long> packetSizes_;
+        std::vector<int> cleanSamples_;
+        std::map<unsigned long, double> scales_;//fraction of the interface budget in use
+    };
+} //namespace
+
+#endif //BANDWIDTH_CONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,535 @@
+/*
+Author: Nariman Habili
+
+Description: Makes lower resolution or lower quality copies (proxies) of
+             every frame of a finished session. Frames are decoded with
+             DCT scaling, optionally rotated to suit the camera mounting
+             and re-encoded on a pool of worker threads. Finished frames
+             are recorded in the session database so an interrupted job
+             carries on where it stopped.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BatchProcessor.h"
+#include "JPEGWriter.h"
+#include <wx/dir.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <windows.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace rics
+{
+    static const size_t recordEvery = 200;//frames per database transaction, per worker
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////Work stealing queue
+    BatchQueue::BatchQueue(size_t workers):
+    queues_(workers),
+    mutexes_(new wxMutex[workers])
+    {
+    }
+
+    BatchQueue::~BatchQueue()
+    {
+    }
+
+    void BatchQueue::push(size_t worker, const BatchJob& job)
+    {
+        wxMutexLocker lock(mutexes_[worker]);
+        queues_[worker].push_back(job);
+    }
+
+    //Returns false when there is no work left anywhere.
+    bool BatchQueue::pop(size_t worker, BatchJob& job)
+    {
+        {
+            wxMutexLocker lock(mutexes_[worker]);
+            if (!queues_[worker].empty())
+            {
+                job = queues_[worker].front();
+                queues_[worker].pop_front();
+                return true;
+            }
+        }
+
+        for (size_t i = 1; i < queues_.size(); ++i)
+        {
+            size_t victim = (worker + i) % queues_.size();
+            wxMutexLocker lock(mutexes_[victim]);
+            if (!queues_[victim].empty())
+            {
+                job = queues_[victim].back();
+                queues_[victim].pop_back();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////Worker thread
+    BatchWorker::BatchWorker(BatchProcessor* processor, BatchQueue* queue, size_t index):
+    wxThread(wxTHREAD_JOINABLE),
+    processor_(processor),
+    queue_(queue),
+    index_(index)
+    {
+    }
+
+    BatchWorker::~BatchWorker()
+    {
+    }
+
+    //Buffers are kept for the life of the thread so nothing is allocated per frame.
+    void* BatchWorker::Entry()
+    {
+        JPEGReader reader;
+        std::vector<unsigned char> image;
+        std::vector<unsigned char> corrected;
+        std::vector<unsigned char> rotated;
+        std::vector<size_t> cameras;
+        std::vector<long> frames;
+        BatchJob job;
+
+        while (queue_->pop(index_, job))
+        {
+            if (processor_->process(job, reader, image, corrected, rotated))
+            {
+                cameras.push_back(job.camera);
+                frames.push_back(job.frame);
+            }
+
+            if (frames.size() >= recordEvery)
+            {
+                processor_->record(cameras, frames);
+                cameras.clear();
+                frames.clear();
+            }
+        }
+
+        processor_->record(cameras, frames);
+
+        return NULL;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////Batch processor
+    BatchProcessor::BatchProcessor(const wxString& sessionDir):
+    sessionDir_(sessionDir),
+    scale_(2),
+    quality_(80),
+    threads_(std::max(wxThread::GetCPUCount(), 1)),
+    minSharpness_(0.0),
+    done_(0),
+    failed_(0)
+    {
+        if (sessionDir_.EndsWith("\\") || sessionDir_.EndsWith("/"))
+        {
+            sessionDir_.RemoveLast();
+        }
+    }
+
+    BatchProcessor::~BatchProcessor()
+    {
+        db_.databaseClose();
+    }
+
+    //1, 2, 4 or 8
+    void BatchProcessor::setScale(unsigned long scale)
+    {
+        scale_ = scale;
+    }
+
+    void BatchProcessor::setQuality(unsigned long quality)
+    {
+        quality_ = quality;
+    }
+
+    void BatchProcessor::setThreads(unsigned long threads)
+    {
+        threads_ = std::max(threads, 1UL);
+    }
+
+    //0, 90, 180 or 270 degrees clockwise
+    void BatchProcessor::setRotation(const wxString& camera, int degrees)
+    {
+        rotations_[camera] = degrees;
+    }
+
+    //Output goes to <session>\<job name>\<camera>. Progress is kept per job name.
+    void BatchProcessor::setJobName(const wxString& name)
+    {
+        jobName_ = name;
+    }
+
+    //Frames scoring below this (see Sharpness) are left out. Frames recorded without 
+    //a score are kept.
+    void BatchProcessor::setMinSharpness(double sharpness)
+    {
+        minSharpness_ = sharpness;
+    }
+
+    //Lens models, by camera name (see RemapTable::loadModels). Cameras without a 
+    //model are not corrected.
+    bool BatchProcessor::setCalibration(const wxString& filename)
+    {
+        if (!wxFileExists(filename))
+        {
+            return false;
+        }
+
+        lensModels_.clear();
+        return RemapTable::loadModels(filename, lensModels_);
+    }
+
+    wxString BatchProcessor::jobName() const
+    {
+        if (jobName_ == "")
+        {
+            return wxString::Format("proxy_%lu_q%lu", scale_, quality_);
+        }
+
+        return jobName_;
+    }
+
+    bool BatchProcessor::run()
+    {
+        wxString sessionName = wxFileName(sessionDir_).GetFullName();
+        wxString filename = sessionDir_ + "\\" + sessionName + ".sdb";
+        if (!wxFileExists(filename))
+        {
+            wxLogError(_("Session database %s not found."), filename.c_str());
+            return false;
+        }
+        db_.openDatabase(filename);
+
+        std::vector<BatchJob> jobs;
+        if (!findFrames(jobs))
+        {
+            return false;
+        }
+
+        wxString outputDir = sessionDir_ + "\\" + jobName();
+        if (!wxDirExists(outputDir))
+        {
+            wxMkdir(outputDir);
+        }
+        for (size_t i = 0; i < cameras_.size(); ++i)
+        {
+            if (!wxDirExists(outputDir + "\\" + cameras_[i]))
+            {
+                wxMkdir(outputDir + "\\" + cameras_[i]);
+            }
+        }
+
+        wxLogMessage(_("%s: %lu frames to do on %lu threads."), jobName().c_str(), (unsigned long)jobs.size(), threads_);
+
+        //Contiguous runs of frames, one per worker.
+        BatchQueue queue(threads_);
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            queue.push(i*threads_/jobs.size(), jobs[i]);
+        }
+
+        std::vector<BatchWorker*> workers;
+        for (size_t i = 0; i < threads_; ++i)
+        {
+            BatchWorker* worker = new BatchWorker(this, &queue, i);
+            wxThreadError threadError = worker->Create();
+            assert(threadError == wxTHREAD_NO_ERROR);
+            worker->Run();
+            workers.push_back(worker);
+        }
+
+        wxLongLong start = wxGetLocalTimeMillis();
+        bool running = true;
+        while (running)
+        {
+            Sleep(2000);
+
+            running = false;
+            for (size_t i = 0; i < workers.size(); ++i)
+            {
+                running = running || workers[i]->IsRunning();
+            }
+
+            double seconds = (wxGetLocalTimeMillis() - start).ToDouble()/1000.0;
+            wxLogMessage(_("%ld of %lu frames, %.1f frames/sec"), done_, (unsigned long)jobs.size(), done_/seconds);
+        }
+
+        for (size_t i = 0; i < workers.size(); ++i)
+        {
+            workers[i]->Wait();
+            delete workers[i];
+        }
+
+        for (size_t i = 0; i < failures_.size(); ++i)
+        {
+            wxLogError(failures_[i]);
+        }
+        wxLogMessage(_("%s: %ld frames done, %ld failed."), jobName().c_str(), done_, failed_);
+
+        return failed_ == 0;
+    }
+
+    //Every subdirectory holding frames is a camera. Frames already done by this job are skipped.
+    bool BatchProcessor::findFrames(std::vector<BatchJob>& jobs)
+    {
+        wxDir session(sessionDir_);
+        if (!session.IsOpened())
+        {
+            return false;
+        }
+
+        wxString dirName;
+        bool more = session.GetFirst(&dirName, wxEmptyString, wxDIR_DIRS);
+        while (more)
+        {
+            wxDir dir(sessionDir_ + "\\" + dirName);
+            std::vector<long> frames;
+            wxString file;
+
+            bool moreFiles = dir.IsOpened() && dir.GetFirst(&file, "*.jpg", wxDIR_FILES);
+            while (moreFiles)
+            {
+                long frame;
+                if (file.BeforeFirst('.').ToLong(&frame))
+                {
+                    frames.push_back(frame);
+                }
+                moreFiles = dir.GetNext(&file);
+            }
+
+            //Frames saved to the session's other volumes are only found through the database.
+            std::map<long, wxString> paths = db_.framePaths(dirName);
+            if (!paths.empty())
+            {
+                std::set<long> found(frames.begin(), frames.end());
+                for (std::map<long, wxString>::const_iterator it = paths.begin(); it != paths.end(); ++it)
+                {
+                    if (found.insert(it->first).second)
+                    {
+                        frames.push_back(it->first);
+                    }
+                }
+            }
+
+            if (!frames.empty())
+            {
+                size_t camera = cameras_.size();
+                cameras_.push_back(dirName);
+                framePaths_.push_back(paths);
+                std::map<wxString, int>::const_iterator rotation = rotations_.find(dirName);
+                cameraRotations_.push_back(rotation == rotations_.end() ? 0 : rotation->second);
+                remapTables_.push_back(boost::shared_ptr<RemapTable>());
+                frameCrops_.push_back(lensModels_.find(dirName) != lensModels_.end() ? 
+                                      db_.frameCrops(dirName) : std::map<long, CropRegion>());
+
+                std::set<long> done = db_.batchDone(jobName(), dirName);
+                std::sort(frames.begin(), frames.end());
+
+                std::set<long> blurred;
+                if (minSharpness_ > 0.0)
+                {
+                    std::vector<FrameRecord> records = db_.frameRecords(dirName);
+                    for (size_t i = 0; i < records.size(); ++i)
+                    {
+                        if (records[i].sharpness >= 0.0 && records[i].sharpness < minSharpness_)
+                        {
+                            blurred.insert(records[i].frame);
+                        }
+                    }
+
+                    if (!blurred.empty())
+                    {
+                        wxLogMessage(_("%s: skipping %lu blurred frames."), dirName.c_str(), (unsigned long)blurred.size());
+                    }
+                }
+
+                for (size_t i = 0; i < frames.size(); ++i)
+                {
+                    if (done.find(frames[i]) == done.end() && blurred.find(frames[i]) == blurred.end())
+                    {
+                        BatchJob job;
+                        job.camera = camera;
+                        job.frame = frames[i];
+                        jobs.push_back(job);
+                    }
+                }
+            }
+
+            more = session.GetNext(&dirName);
+        }
+
+        return true;
+    }
+
+    //Same naming as Camera::frameName
+    wxString BatchProcessor::frameFile(long frame)
+    {
+        return wxString::Format("%07ld.jpg", frame);
+    }
+
+    //The table depends on the decoded frame size and the crop the frame was saved with, 
+    //so it is built when the first frame of a camera has been read. After that the 
+    //workers share it. It is rebuilt if a frame of another size or crop turns up; a 
+    //worker still using the old one keeps it alive through the pointer returned.
+    boost::shared_ptr<const RemapTable> BatchProcessor::remapTable(size_t camera, long frame, unsigned long width, unsigned long height)
+    {
+        LensModels::const_iterator model = lensModels_.find(cameras_[camera]);
+        if (model == lensModels_.end())
+        {
+            return boost::shared_ptr<const RemapTable>();
+        }
+
+        std::map<long, CropRegion>::const_iterator saved = frameCrops_[camera].find(frame);
+        CropRegion crop = saved == frameCrops_[camera].end() ? CropRegion() : saved->second;
+
+        wxMutexLocker lock(remapMutex_);
+        boost::shared_ptr<RemapTable>& table = remapTables_[camera];
+        if (!table || table->width() != width || table->height() != height || !(table->crop() == crop))
+        {
+            boost::shared_ptr<RemapTable> built(new RemapTable);
+            built->build(model->second, width, height, crop);
+            table = built;
+        }
+
+        return table;
+    }
+
+    //Called by the worker threads.
+    bool BatchProcessor::process(const BatchJob& job, 
+                                 JPEGReader& reader, 
+                                 std::vector<unsigned char>& image, 
+                                 std::vector<unsigned char>& corrected, 
+                                 std::vector<unsigned char>& rotated)
+    {
+        wxString camera = cameras_[job.camera];
+        wxString input = sessionDir_ + "\\" + camera + "\\" + frameFile(job.frame);
+
+        std::map<long, wxString>::const_iterator saved = framePaths_[job.camera].find(job.frame);
+        if (saved != framePaths_[job.camera].end() && wxFileExists(saved->second))
+        {
+            input = saved->second;
+        }
+        wxString output = sessionDir_ + "\\" + jobName() + "\\" + camera + "\\" + frameFile(job.frame);
+
+        try
+        {
+            unsigned long width;
+            unsigned long height;
+            reader.read(input.c_str(), scale_, image, width, height);
+
+            unsigned char* out = &image[0];
+            boost::shared_ptr<const RemapTable> table = remapTable(job.camera, job.frame, width, height);
+            if (table)
+            {
+                corrected.resize(3*width*height);
+                table->apply(&image[0], image.size(), &corrected[0]);
+                out = &corrected[0];
+            }
+
+            if (cameraRotations_[job.camera] != 0)
+            {
+                rotate(out, width, height, cameraRotations_[job.camera], rotated);
+                out = &rotated[0];
+            }
+
+            JPEGWriter writer;
+            writer.header(width, height, 3, JPEG::COLOR_RGB);
+            writer.setQuality(quality_);
+            writer.write(output.c_str(), out);
+        }
+        catch (std::runtime_error& e)
+        {
+            InterlockedIncrement(&failed_);
+            wxMutexLocker lock(failuresMutex_);
+            failures_.push_back(input + ": " + e.what());
+            return false;
+        }
+
+        InterlockedIncrement(&done_);
+        return true;
+    }
+
+    void BatchProcessor::record(const std::vector<size_t>& cameras, const std::vector<long>& frames)
+    {
+        if (frames.empty())
+        {
+            return;
+        }
+
+        std::vector<wxString> names;
+        for (size_t i = 0; i < cameras.size(); ++i)
+        {
+            names.push_back(cameras_[cameras[i]]);
+        }
+
+        db_.databaseEnterBatchDone(jobName(), names, frames);
+    }
+
+    //Rotate clockwise by 90, 180 or 270 degrees. Width and height are swapped for 90 and 270.
+    void BatchProcessor::rotate(const unsigned char* image, 
+                                unsigned long& width, 
+                                unsigned long& height, 
+                                int degrees, 
+                                std::vector<unsigned char>& rotated)
+    {
+        unsigned long w = width;
+        unsigned long h = height;
+        rotated.resize(3*w*h);
+
+        for (unsigned long y = 0; y < h; ++y)
+        {
+            const unsigned char* src = image + 3*y*w;
+
+            for (unsigned long x = 0; x < w; ++x)
+            {
+                size_t dst;
+                if (degrees == 90)
+                {
+                    dst = 3*(x*h + (h - 1 - y));
+                }
+                else if (degrees == 180)
+                {
+                    dst = 3*((h - 1 - y)*w + (w - 1 - x));
+                }
+                else
+                {
+                    dst = 3*((w - 1 - x)*h + y);
+                }
+
+                rotated[dst] = src[0];
+                rotated[dst + 1] = src[1];
+                rotated[dst + 2] = src[2];
+                src += 3;
+            }
+        }
+
+        if (degrees == 90 || degrees == 270)
+        {
+            width = h;
+            height = w;
+        }
+    }
+
+} //namespace
@@ -0,0 +1,143 @@
+/*
+Author: Nariman Habili
+
+Description: Makes lower resolution or lower quality copies (proxies) of
+             every frame of a finished session. Frames are decoded with
+             DCT scaling, optionally corrected for lens distortion and
+             rotated to suit the camera mounting and re-encoded on a pool of worker threads. Finished frames
+             are recorded in the session database so an interrupted job
+             carries on where it stopped.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BATCH_PROCESSOR_H
+#define BATCH_PROCESSOR_H
+
+#include "Database.h"
+#include "JPEGReader.h"
+#include "RemapTable.h"
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <boost/shared_array.hpp>
+#include <boost/shared_ptr.hpp>
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace rics
+{
+    struct BatchJob
+    {
+        size_t camera;
+        long frame;
+    };
+
+    //One queue per worker. A worker takes jobs from the front of its own queue
+    //and, once that is empty, steals from the back of the others. Each worker 
+    //starts with a contiguous run of frames so reads stay mostly sequential.
+    class BatchQueue
+    {
+    public:
+        BatchQueue(size_t workers);
+        ~BatchQueue();
+
+        void push(size_t worker, const BatchJob& job);
+        bool pop(size_t worker, BatchJob& job);
+
+    private:
+        std::vector<std::deque<BatchJob> > queues_;
+        boost::shared_array<wxMutex> mutexes_;
+    };
+
+    class BatchProcessor;
+
+    class BatchWorker : public wxThread
+    {
+    public:
+        BatchWorker(BatchProcessor* processor, BatchQueue* queue, size_t index);
+        ~BatchWorker();
+
+        void* Entry();
+
+    private:
+        BatchProcessor* processor_;
+        BatchQueue* queue_;
+        size_t index_;
+    };
+
+    class BatchProcessor
+    {
+    public:
+        BatchProcessor(const wxString& sessionDir);
+        ~BatchProcessor();
+
+        void setScale(unsigned long scale);
+        void setQuality(unsigned long quality);
+        void setThreads(unsigned long threads);
+        void setRotation(const wxString& camera, int degrees);
+        void setJobName(const wxString& name);
+        void setMinSharpness(double sharpness);
+        bool setCalibration(const wxString& filename);
+        wxString jobName() const;
+
+        bool run();
+
+        bool process(const BatchJob& job, 
+                     JPEGReader& reader, 
+                     std::vector<unsigned char>& image, 
+                     std::vector<unsigned char>& corrected, 
+                     std::vector<unsigned char>& rotated);
+        void record(const std::vector<size_t>& cameras, const std::vector<long>& frames);
+
+    private:
+        bool findFrames(std::vector<BatchJob>& jobs);
+        static wxString frameFile(long frame);
+        boost::shared_ptr<const RemapTable> remapTable(size_t camera, long frame, unsigned long width, unsigned long height);
+        static void rotate(const unsigned char* image, 
+                           unsigned long& width, 
+                           unsigned long& height, 
+                           int degrees, 
+                           std::vector<unsigned char>& rotated);
+
+    private:
+        wxString sessionDir_;
+        wxString jobName_;
+        unsigned long scale_;
+        unsigned long quality_;
+        unsigned long threads_;
+        std::map<wxString, int> rotations_;//clockwise degrees, by camera name
+        double minSharpness_;
+        LensModels lensModels_;
+
+        std::vector<wxString> cameras_;
+        std::vector<std::map<long, wxString> > framePaths_;//frames saved to other volumes, from the session database
+        std::vector<int> cameraRotations_;
+        std::vector<boost::shared_ptr<RemapTable> > remapTables_;//built from the first frame of each camera
+        std::vector<std::map<long, CropRegion> > frameCrops_;//for cameras with a lens model, from the session database
+        wxMutex remapMutex_;
+        Database db_;
+
+        volatile long done_;
+        volatile long failed_;
+        wxMutex failuresMutex_;
+        std::vector<wxString> failures_;
+    };
+} //namespace
+
+#endif //BATCH_PROCESSOR_H
@@ -0,0 +1,154 @@
+/*
+Author: Nariman Habili
+
+Description: Console tool (ricsproc) that makes resized, re-encoded copies of
+             the images of a finished session, using all processor cores.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BatchTool.h"
+#include <wx/cmdline.h>
+#include <wx/tokenzr.h>
+
+namespace rics
+{
+    BatchTool::BatchTool()
+    {
+    }
+
+    BatchTool::~BatchTool()
+    {
+    }
+
+    bool BatchTool::OnInit()
+    {
+        static const wxCmdLineEntryDesc cmdLineDesc[] =
+        {
+            { wxCMD_LINE_OPTION, "s", "scale", "reduce width and height by 1, 2, 4 or 8 (default 2)", wxCMD_LINE_VAL_NUMBER },
+            { wxCMD_LINE_OPTION, "q", "quality", "JPEG quality of the copies (default 80)", wxCMD_LINE_VAL_NUMBER },
+            { wxCMD_LINE_OPTION, "t", "threads", "worker threads (default: one per processor core)", wxCMD_LINE_VAL_NUMBER },
+            { wxCMD_LINE_OPTION, "r", "rotate", "clockwise rotation per camera, e.g. Left=90,Right=270" },
+            { wxCMD_LINE_OPTION, "m", "min-sharpness", "leave out frames with a lower sharpness score (see the camera tables)" },
+            { wxCMD_LINE_OPTION, "c", "calibration", "lens calibration file, one group per camera, to correct distortion" },
+            { wxCMD_LINE_OPTION, "j", "job", "output directory name, also used to resume (default proxy_<scale>_q<quality>)" },
+            { wxCMD_LINE_PARAM, NULL, NULL, "session directory" },
+            { wxCMD_LINE_NONE }
+        };
+
+        wxCmdLineParser parser(cmdLineDesc, argc, argv);
+        if (parser.Parse() != 0)
+        {
+            return false;
+        }
+
+        processor_ = boost::shared_ptr<BatchProcessor>(new BatchProcessor(parser.GetParam(0)));
+
+        long scale = 2;
+        parser.Found("scale", &scale);
+        if (scale != 1 && scale != 2 && scale != 4 && scale != 8)
+        {
+            wxLogError(_("Scale must be 1, 2, 4 or 8."));
+            return false;
+        }
+        processor_->setScale(scale);
+
+        long quality = 80;
+        parser.Found("quality", &quality);
+        if (quality < 1 || quality > 100)
+        {
+            wxLogError(_("Quality must be between 1 and 100."));
+            return false;
+        }
+        processor_->setQuality(quality);
+
+        long threads;
+        if (parser.Found("threads", &threads))
+        {
+            processor_->setThreads(threads > 0 ? threads : 1);
+        }
+
+        wxString rotations;
+        if (parser.Found("rotate", &rotations) && !parseRotations(rotations))
+        {
+            return false;
+        }
+
+        wxString minSharpness;
+        if (parser.Found("min-sharpness", &minSharpness))
+        {
+            double sharpness;
+            if (!minSharpness.ToDouble(&sharpness) || sharpness < 0.0)
+            {
+                wxLogError(_("Minimum sharpness must be a positive number."));
+                return false;
+            }
+            processor_->setMinSharpness(sharpness);
+        }
+
+        wxString calibration;
+        if (parser.Found("calibration", &calibration) && !processor_->setCalibration(calibration))
+        {
+            wxLogError(_("Could not read the lens calibration %s."), calibration.c_str());
+            return false;
+        }
+
+        wxString job;
+        if (parser.Found("job", &job))
+        {
+            processor_->setJobName(job);
+        }
+
+        return true;
+    }
+
+    int BatchTool::OnRun()
+    {
+        return processor_->run() ? 0 : 1;
+    }
+
+    int BatchTool::OnExit()
+    {
+        processor_.reset();
+        return 0;
+    }
+
+    //camera=degrees pairs separated by commas
+    bool BatchTool::parseRotations(const wxString& rotations)
+    {
+        wxStringTokenizer tokenizer(rotations, ",");
+        while (tokenizer.HasMoreTokens())
+        {
+            wxString token = tokenizer.GetNextToken();
+            wxString camera = token.BeforeFirst('=');
+            long degrees;
+
+            if (camera == "" || !token.AfterFirst('=').ToLong(&degrees) ||
+                (degrees != 0 && degrees != 90 && degrees != 180 && degrees != 270))
+            {
+                wxLogError(_("Invalid rotation '%s'. Use camera=0, 90, 180 or 270."), token.c_str());
+                return false;
+            }
+
+            processor_->setRotation(camera, degrees);
+        }
+
+        return true;
+    }
+
+} //namespace
@@ -0,0 +1,55 @@
+/*
+Author: Nariman Habili
+
+Description: Console tool (ricsproc) that makes resized, re-encoded copies of
+             the images of a finished session, using all processor cores.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BATCH_TOOL_H
+#define BATCH_TOOL_H
+
+#include "BatchProcessor.h"
+#include <wx/wx.h>
+#include <wx/app.h>
+#include <boost/shared_ptr.hpp>
+
+namespace rics
+{
+    class BatchTool: public wxAppConsole
+    {
+    public:
+        BatchTool();
+        ~BatchTool();
+
+    private:
+        virtual bool OnInit();
+        virtual int OnRun();
+        virtual int OnExit();
+        bool parseRotations(const wxString& rotations);
+
+    private:
+        boost::shared_ptr<BatchProcessor> processor_;
+    };
+
+    IMPLEMENT_APP_CONSOLE(BatchTool)
+
+} //namespace
+
+#endif //BATCH_TOOL_H
@@ -0,0 +1,291 @@
+/*
+Author: Nariman Habili
+
+Description: Benchmarks the capture pipeline by replaying a recorded session
+             through it (ricsbench). Reports frame rate and per frame 
+             latency for each camera.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BenchTool.h"
+#include "CaptureEngine.h"
+#include "version.h"
+#include <wx/cmdline.h>
+#include <wx/dir.h>
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <algorithm>
+
+namespace rics
+{
+    BenchTool::BenchTool():
+    speed_(1.0)
+    {
+    }
+
+    BenchTool::~BenchTool()
+    {
+    }
+
+    bool BenchTool::OnInit()
+    {
+        static const wxCmdLineEntryDesc cmdLineDesc[] =
+        {
+            { wxCMD_LINE_OPTION, "s", "speed", "multiple of real time, 0 for as fast as possible (default 1)" },
+            { wxCMD_LINE_OPTION, "r", "report", "append the results to this CSV file" },
+            { wxCMD_LINE_PARAM, NULL, NULL, "recorded session directory" },
+            { wxCMD_LINE_PARAM, NULL, NULL, "output directory" },
+            { wxCMD_LINE_NONE }
+        };
+
+        wxCmdLineParser parser(cmdLineDesc, argc, argv);
+        if (parser.Parse() != 0)
+        {
+            return false;
+        }
+
+        recordedDir_ = parser.GetParam(0);
+        outputDir_ = parser.GetParam(1);
+        parser.Found("report", &reportPath_);
+
+        wxString speed;
+        if (parser.Found("speed", &speed) && (!speed.ToDouble(&speed_) || speed_ < 0.0))
+        {
+            wxLogError(_("Speed must be 0 or more."));
+            return false;
+        }
+
+        return openReplay() && openSession();
+    }
+
+    int BenchTool::OnRun()
+    {
+        CaptureEngine engine(&cameras_, &gps_, session_.get(), &db_);
+        engine.setAdaptiveBandwidth(false);
+
+        //Gaps in the recording (eg thinned stationary frames) aren't stalls.
+        Watchdog watchdog;
+        watchdog.setEnabled(false);
+        engine.setWatchdog(watchdog);
+        engine.startGPS(NULL);
+
+        clock_->start();
+        wxLongLong start = wxGetLocalTimeMillis();
+        engine.start();
+
+        bool finished = false;
+        while (!finished)
+        {
+            Sleep(200);
+
+            finished = true;
+            for (size_t i = 0; i < frameReplays_.size(); ++i)
+            {
+                finished &= frameReplays_[i]->finished();
+            }
+        }
+
+        //Let the camera threads finish the last frames.
+        Sleep(1000);
+        engine.stop();
+        wxLongLong elapsed = wxGetLocalTimeMillis() - start;
+        engine.deleteAllThreads();
+
+        report(elapsed);
+
+        return 0;
+    }
+
+    int BenchTool::OnExit()
+    {
+        db_.databaseClose();
+        return 0;
+    }
+
+    //Each sub directory of the recorded session with images is a camera.
+    //Frames and NMEA sentences are released relative to the earliest 
+    //recorded time.
+    bool BenchTool::openReplay()
+    {
+        wxDir dir(recordedDir_);
+        if (!dir.IsOpened())
+        {
+            wxLogError(_("Can't open %s."), recordedDir_.c_str());
+            return false;
+        }
+
+        clock_ = ReplayClockPtr(new ReplayClock(speed_));
+
+        std::vector<wxString> names;
+        wxString name;
+        bool cont = dir.GetFirst(&name, wxEmptyString, wxDIR_DIRS);
+        while (cont)
+        {
+            names.push_back(name);
+            cont = dir.GetNext(&name);
+        }
+        std::sort(names.begin(), names.end());
+
+        wxLongLong origin = 0;
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            FrameReplayPtr replay(new FrameReplay(recordedDir_ + "\\" + names[i], clock_));
+            if (replay->size() == 0)
+            {
+                continue;
+            }
+
+            if (origin == 0 || replay->firstTime() < origin)
+            {
+                origin = replay->firstTime();
+            }
+
+            frameReplays_.push_back(replay);
+            cameras_.push_back(Camera(replay, names[i], static_cast<int>(frameReplays_.size())));
+        }
+
+        if (frameReplays_.empty())
+        {
+            wxLogError(_("No camera images in %s."), recordedDir_.c_str());
+            return false;
+        }
+
+        nmeaReplay_ = NMEAReplayPtr(new NMEAReplay(clock_));
+        if (nmeaReplay_->open(recordedDir_ + "\\gps.nmea"))
+        {
+            if (nmeaReplay_->firstTime() < origin)
+            {
+                origin = nmeaReplay_->firstTime();
+            }
+            gps_.setReplay(nmeaReplay_);
+        }
+        else
+        {
+            wxLogWarning(_("No gps.nmea in %s, replaying without GPS."), recordedDir_.c_str());
+        }
+
+        clock_->setOrigin(origin);
+
+        return true;
+    }
+
+    //A new session in the output directory, named after the recorded one.
+    bool BenchTool::openSession()
+    {
+        wxString name = wxFileName(recordedDir_).GetFullName();
+        wxString sessionDir = outputDir_ + "\\" + name;
+
+        if (wxDirExists(sessionDir))
+        {
+            wxLogError(_("%s already exists."), sessionDir.c_str());
+            return false;
+        }
+
+        if (!wxDirExists(outputDir_))
+        {
+            wxMkdir(outputDir_);
+        }
+        wxMkdir(sessionDir);
+
+        session_ = boost::shared_ptr<Session>(new Session(cameras_.size()));
+        session_->initCurrentFrame();
+
+        db_.openDatabase(sessionDir + "\\" + name + ".sdb");
+
+        for (size_t i = 0; i < cameras_.size(); ++i)
+        {
+            wxString cameraName = cameras_[i].cameraName();
+            wxString cameraDir = sessionDir + "\\" + cameraName;
+            wxMkdir(cameraDir);
+
+            db_.createTable(cameraName);
+            cameras_[i].setSessionPath(cameraDir);
+            cameras_[i].setSessionName(name);
+            cameras_[i].setFrameNumber(0);
+        }
+
+        session_->setSaveImages(true);
+        session_->setCreateDB(true);
+        session_->setSessionName(name);
+        session_->setPath(sessionDir);
+
+        return true;
+    }
+
+    //Latency is from the frame being handed to the camera thread to the thread
+    //being done with it (preview, stream, save, thumbnails and database).
+    void BenchTool::report(wxLongLong elapsed)
+    {
+        double seconds = elapsed.ToDouble()/1000.0;
+        wxDateTime now = wxDateTime::Now();
+        wxString date = now.FormatISODate() + " " + now.FormatISOTime();
+
+        wxFile csv;
+        if (reportPath_ != "")
+        {
+            bool exists = wxFileExists(reportPath_);
+            csv.Open(reportPath_, wxFile::write_append);
+            if (csv.IsOpened() && !exists)
+            {
+                csv.Write("version,date,session,speed,camera,frames,fps,mean_ms,p50_ms,p95_ms,max_ms\n");
+            }
+        }
+
+        wxLogMessage(_("%.1f seconds at speed %g."), seconds, speed_);
+
+        for (size_t i = 0; i < cameras_.size(); ++i)
+        {
+            std::vector<unsigned long> latencies = cameras_[i].latencies();
+            std::sort(latencies.begin(), latencies.end());
+
+            size_t frames = latencies.size();
+            double fps = seconds > 0.0 ? frames/seconds : 0.0;
+            double mean = 0.0;
+            unsigned long p50 = 0;
+            unsigned long p95 = 0;
+            unsigned long max = 0;
+
+            if (frames > 0)
+            {
+                for (size_t j = 0; j < frames; ++j)
+                {
+                    mean += latencies[j];
+                }
+                mean /= frames;
+
+                p50 = latencies[(frames - 1)/2];
+                p95 = latencies[(frames - 1)*95/100];
+                max = latencies.back();
+            }
+
+            wxString cameraName = cameras_[i].cameraName();
+            wxLogMessage(_("%s: %lu frames, %.2f frames/sec, latency ms mean %.1f, p50 %lu, p95 %lu, max %lu"), 
+                         cameraName.c_str(), static_cast<unsigned long>(frames), fps, mean, p50, p95, max);
+
+            if (csv.IsOpened())
+            {
+                csv.Write(wxString::Format("%s,%s,%s,%g,%s,%lu,%.2f,%.1f,%lu,%lu,%lu\n", 
+                                           RICS_VERSION, date.c_str(), session_->sessionName().c_str(), speed_, 
+                                           cameraName.c_str(), static_cast<unsigned long>(frames), fps, mean, 
+                                           p50, p95, max));
+            }
+        }
+    }
+
+} //namespace
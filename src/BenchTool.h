@@ -0,0 +1,76 @@
+/*
+Author: Nariman Habili
+
+Description: Benchmarks the capture pipeline by replaying a recorded session
+             through it (ricsbench). Reports frame rate and per frame 
+             latency for each camera.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCH_TOOL_H
+#define BENCH_TOOL_H
+
+#include "Camera.h"
+#include "GPS.h"
+#include "Database.h"
+#include "Session.h"
+#include "SessionReplay.h"
+#include "NMEALog.h"
+#include <wx/wx.h>
+#include <wx/app.h>
+#include <wx/longlong.h>
+#include <vector>
+
+namespace rics
+{
+    class BenchTool: public wxAppConsole
+    {
+    public:
+        BenchTool();
+        ~BenchTool();
+
+    private:
+        virtual bool OnInit();
+        virtual int OnRun();
+        virtual int OnExit();
+        bool openReplay();
+        bool openSession();
+        void report(wxLongLong elapsed);
+
+    private:
+        wxString recordedDir_;
+        wxString outputDir_;
+        wxString reportPath_;
+        double speed_;
+
+        ReplayClockPtr clock_;
+        std::vector<FrameReplayPtr> frameReplays_;
+        NMEAReplayPtr nmeaReplay_;
+
+        Cameras cameras_;
+        GPS gps_;
+        Database db_;
+        boost::shared_ptr<Session> session_;
+    };
+
+    IMPLEMENT_APP_CONSOLE(BenchTool)
+
+} //namespace
+
+#endif //BENCH_TOOL_H
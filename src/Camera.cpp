@@ -24,6 +24,9 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Camera.h"
 #include <boost/lexical_cast.hpp>
+#include <wx/filename.h>
+#include <algorithm>
+#include <cstdio>
 
 namespace rics
 {
@@ -38,44 +41,153 @@ namespace rics
     stepBytesOriginal_(width_*3*sizeof(unsigned char)),
     frameNumber_(0),
     sessionPath_(""),
+    framePath_(""),
     frameBuffer_(UCArray(new unsigned char[height_*width_*3])),
-    resized_(UCArray(new unsigned char[heightResized_*widthResized_*3]))//memory for resized image
+    resized_(UCArray(new unsigned char[heightResized_*widthResized_*3])),//memory for resized image
+    frameQueued_(false),
+    interfaceID_(0),
+    pendingPacketSize_(0),
+    thumbnailScale_(8),
+    sharpness_(width_, height_),
+    demosaic_(new Demosaic),
+    writer_(new ImageWriter),
+    archiveRaw_(false),
+    convertTime_(0.0),
+    saveRegion_(0, 0, width_, height_),
+    frameBytes_(0),
+    bytesSaved_(0.0),
+    queuedBytes_(0.0),
+    saveTimeTotal_(0.0),
+    saveTime_(0.0),
+    savedBytesPerFrame_(0.0),
+    replayID_(0),
+    replayFrameRate_(0.0f),
+    replayStart_(0),
+    frameArrival_(0),
+    uniqueID_(0),
+    unplugged_(0),
+    reconnectRequested_(0),
+    //Default camera parameters.
+    packetSize_(6000/*8228*/),
+    streamBytesPerSecond_(streamBytesPerSecond),
+    triggerMode_(/*"Freerun"*/"FixedRate"),
+    pixelFormat_("Bayer8"),
+    roiLeft_(0),
+    roiTop_(0),
+    frameRate_(4.0f),
+    settingsMutex_(new wxMutex)
+    {
+        //1/8 and 1/16 of the camera resolution (306x256 and 153x128 at full size)
+        thumbnailPacks_.push_back(boost::shared_ptr<ThumbnailPack>(new ThumbnailPack));
+        thumbnailPacks_.push_back(boost::shared_ptr<ThumbnailPack>(new ThumbnailPack));
+
+        //Kept so the camera can be found again if it is unplugged.
+        tPvErr returnCode = PvAttrUint32Get(handle(), "UniqueId", &uniqueID_);
+        assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+        cameraName_ = cameraName();
+
+        configure();
+    }
+
+    //Stream setup and the last settings given to the camera. Used when the camera is
+    //opened, and again when it is re-opened after being unplugged as it may have lost
+    //power (and its settings) in the meantime.
+    void Camera::configure()
     {
         //Set packet size. Maximum is 9014.
-        PvAttrUint32Set(handle(), "PacketSize", 6000/*8228*/);
+        PvAttrUint32Set(handle(), "PacketSize", packetSize_);
 
         //Calculating the "StreamBytesPerSecond". For a gigabit ethernet card, maximum stream
         //bytes per second is set to (maximum) 124000000. To find the "StreamBytesPerSecond" value, 
         //124000000 is divided by the number of cameras attached.
-        tPvErr returnCode = PvAttrUint32Set(handle(), "StreamBytesPerSecond", streamBytesPerSecond);
+        tPvErr returnCode = PvAttrUint32Set(handle(), "StreamBytesPerSecond", streamBytesPerSecond_);
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
 
         returnCode = PvCaptureStart(handle());
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
         returnCode = PvAttrEnumSet(handle(), "AcquisitionMode", "Continuous");
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
-        returnCode = PvAttrEnumSet(handle(), "PixelFormat", "Bayer8");
+        returnCode = PvAttrEnumSet(handle(), "PixelFormat", pixelFormat_.c_str());
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
-        returnCode = PvAttrEnumSet(handle(), "FrameStartTriggerMode", /*"Freerun"*/"FixedRate");
+        returnCode = PvAttrEnumSet(handle(), "FrameStartTriggerMode", triggerMode_.c_str());
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
         
-        //Set default camera parameters.
-        setROI(0, 0, height(), width());
-        setAutoMaxTime(5000);
-        setExposureTime(true, 0);
-        setFrameRate(4.0f);
-        setWhiteBalance(false, "R", 181);
-        setWhiteBalance(false, "B", 202);
-        setGain(false, 0);
+        setROI(roiLeft_, roiTop_, height(), width());
+        CameraSettings settings = this->settings();
+        setAutoMaxTime(settings.autoMaxTime());
+        setExposureTime(settings.autoExposure(), settings.exposureTime());
+        setFrameRate(frameRate_);
+        setWhiteBalance(settings.autoWhiteBalance(), "R", settings.whiteBalanceRed());
+        setWhiteBalance(settings.autoWhiteBalance(), "B", settings.whiteBalanceBlue());
+        setGain(settings.autoGain(), settings.gain());
+
+        allocateImageBuffer();
+    }
 
+    //The frame size depends on the pixel format and ROI.
+    void Camera::allocateImageBuffer()
+    {
         unsigned long totalBytesPerFrame;
-        returnCode = PvAttrUint32Get(handle(), "TotalBytesPerFrame", &totalBytesPerFrame);
+        tPvErr returnCode = PvAttrUint32Get(handle(), "TotalBytesPerFrame", &totalBytesPerFrame);
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
         image_.ImageBufferSize = totalBytesPerFrame;
         imageBuffer_ = UCArray(new unsigned char[totalBytesPerFrame]);
         image_.ImageBuffer = imageBuffer_.get();
     }
 
+    //A camera that replays the saved frames of a recorded session instead of
+    //streaming from the hardware. Only the capture path is supported (streaming, 
+    //saving and statistics), as there is no PvAPI handle.
+    Camera::Camera(FrameReplayPtr replay, const wxString& cameraName, int uniqueID):
+    hCamera_(NULL),
+    height_(replay->height()),
+    width_(replay->width()),
+    resizeFactor_(12),
+    heightResized_(height_/resizeFactor_),
+    widthResized_(width_/resizeFactor_),
+    stepBytesResized_(widthResized_*3*sizeof(unsigned char)),
+    stepBytesOriginal_(width_*3*sizeof(unsigned char)),
+    frameNumber_(0),
+    sessionPath_(""),
+    framePath_(""),
+    frameBuffer_(UCArray(new unsigned char[height_*width_*3])),
+    resized_(UCArray(new unsigned char[heightResized_*widthResized_*3])),
+    frameQueued_(false),
+    interfaceID_(0),
+    pendingPacketSize_(0),
+    thumbnailScale_(8),
+    sharpness_(width_, height_),
+    demosaic_(new Demosaic),
+    writer_(new ImageWriter),
+    archiveRaw_(false),
+    convertTime_(0.0),
+    saveRegion_(0, 0, width_, height_),
+    frameBytes_(0),
+    bytesSaved_(0.0),
+    queuedBytes_(0.0),
+    saveTimeTotal_(0.0),
+    saveTime_(0.0),
+    savedBytesPerFrame_(0.0),
+    replay_(replay),
+    replayName_(cameraName),
+    replayID_(uniqueID),
+    replayFrameRate_(0.0f),
+    replayStart_(0),
+    frameArrival_(0),
+    uniqueID_(uniqueID),
+    unplugged_(0),
+    reconnectRequested_(0),
+    packetSize_(0),
+    streamBytesPerSecond_(0),
+    pixelFormat_("Bayer8"),
+    settingsMutex_(new wxMutex)
+    {
+        thumbnailPacks_.push_back(boost::shared_ptr<ThumbnailPack>(new ThumbnailPack));
+        thumbnailPacks_.push_back(boost::shared_ptr<ThumbnailPack>(new ThumbnailPack));
+
+        memset(&image_, 0, sizeof(image_));
+    }
+
     Camera::~Camera()
     {
     }
@@ -108,11 +220,74 @@ namespace rics
         width_ = w;
     }
 
-    inline long Camera::frameNumber() const
+    //Size of the downscaled image returned by getNextFrame
+    unsigned long Camera::previewHeight() const
+    {
+        return heightResized_;
+    }
+
+    unsigned long Camera::previewWidth() const
+    {
+        return widthResized_;
+    }
+
+    //Size of the saved frames, the crop region (the whole frame if there is no crop).
+    unsigned long Camera::saveHeight() const
+    {
+        return saveRegion_.height();
+    }
+
+    unsigned long Camera::saveWidth() const
+    {
+        return saveRegion_.width();
+    }
+
+    //Size of the network preview stream, 1/scale of the saved frame.
+    unsigned long Camera::streamHeight(unsigned long scale) const
+    {
+        return saveHeight()/scale;
+    }
+
+    unsigned long Camera::streamWidth(unsigned long scale) const
+    {
+        return saveWidth()/scale;
+    }
+
+    //Copy the last frame into "image", keeping every scale'th pixel of every scale'th row.
+    //Must be called from the camera thread, after getNextFrame.
+    void Camera::streamImage(unsigned char* image, unsigned long scale) const
+    {
+        unsigned long h = streamHeight(scale);
+        unsigned long w = streamWidth(scale);
+        const unsigned char* original = frameBuffer_.get();
+
+        for (unsigned long j = 0; j < h; ++j)
+        {
+            const unsigned char* orig = original + scale*j*saveWidth()*3;
+
+            for (unsigned long i = 0; i < w; ++i)
+            {
+                image[0] = orig[0];
+                image[1] = orig[1];
+                image[2] = orig[2];
+
+                image += 3;
+                orig += 3*scale;
+            }
+        }
+    }
+
+    long Camera::frameNumber() const
     {
         return frameNumber_;
     }
 
+    //The camera's own count of the last frame received
+    unsigned long Camera::frameCount() const
+    {
+        return image_.FrameCount;
+    }
+
     void Camera::setFrameNumber(unsigned long fn)
     {
         frameNumber_ = fn;
@@ -135,6 +310,14 @@ namespace rics
     ////////Image streaming and saving
     void Camera::startStream()
     {
+        //The camera numbers the frames of a new stream from 1 (see CaptureSetCollector::setID()).
+        image_.FrameCount = 0;
+
+        if (replay_ || unplugged())
+        {
+            return;
+        }
+
         unsigned long started;
         tPvErr returnCode = PvCaptureQuery(handle(), &started);
         if (!started)
@@ -151,6 +334,11 @@ namespace rics
     //Stop video stream.
     void Camera::stopStream()
     {
+        if (replay_ || unplugged())
+        {
+            return;
+        }
+
         unsigned long started;
         tPvErr returnCode = PvCaptureQuery(handle(), &started);
         if (started)
@@ -159,28 +347,129 @@ namespace rics
             assert(returnCode == 0 || returnCode == ePvErrUnplugged);
             returnCode = PvCaptureQueueClear(handle());
             assert(returnCode == 0 || returnCode == ePvErrUnplugged);         
+            frameQueued_ = false;
             returnCode = PvCaptureEnd(handle());
             assert(returnCode == 0 || returnCode == ePvErrUnplugged);
         }
     }
 
     //Grab next frame. Note: Pointer belongs to Camera.
-    UCArray Camera::getNextFrame()
+    //Returns an empty array if no new frame arrived within "timeout" (ms). 
+    //The frame is left queued so the next call carries on waiting for it.
+    UCArray Camera::getNextFrame(unsigned long timeout)
     {
-        tPvErr returnCode = PvCaptureQueueFrame(handle(), &image_, NULL);
-        if (returnCode)
+        if (replay_)
         {
-            return resized_;
+            return getNextReplayFrame(timeout);
         }
+
+        tPvErr returnCode;
         
-        returnCode = PvCaptureWaitForFrameDone(handle(), &image_, PVINFINITE);
-        if (returnCode)
+        if (!frameQueued_)
         {
-            return resized_;
+            returnCode = PvCaptureQueueFrame(handle(), &image_, NULL);
+            if (returnCode)
+            {
+                return UCArray();
+            }
+            frameQueued_ = true;
+        }
+        
+        returnCode = PvCaptureWaitForFrameDone(handle(), &image_, timeout);
+        if (returnCode == ePvErrTimeout)
+        {
+            return UCArray();
+        }
+
+        frameQueued_ = false;
+        if (returnCode || image_.Status != ePvErrSuccess)
+        {
+            return UCArray();
+        }
+
+        LARGE_INTEGER start;
+        QueryPerformanceCounter(&start);
+
+        const unsigned char* bayer = static_cast<unsigned char*>(image_.ImageBuffer);
+        if (RawFormat::highBitDepth(image_.Format))
+        {
+            size_t pixels = image_.Width*image_.Height;
+            bayer_.resize(pixels);
+            if (archiveRaw_)
+            {
+                rawArchive_.resize(pixels);
+            }
+
+            rawFormat_.unpack(bayer, image_.Format, image_.BitDepth, pixels, &bayer_[0], archiveRaw_ ? &rawArchive_[0] : NULL);
+            bayer = &bayer_[0];
+        }
+
+        //The preview shows the whole frame, straight from the Bayer data. Only the 
+        //crop region is demosaiced and saved.
+        demosaic_->preview(bayer,
+                           image_.Width,
+                           image_.Height,
+                           image_.BayerPattern,
+                           resizeFactor_,
+                           resized_.get());
+        demosaic_->interpolate(bayer + saveRegion_.top()*image_.Width + saveRegion_.left(),
+                               image_.Width,
+                               saveWidth(),
+                               saveHeight(),
+                               image_.BayerPattern,
+                               frameBuffer_.get());
+
+        LARGE_INTEGER end;
+        LARGE_INTEGER frequency;
+        QueryPerformanceCounter(&end);
+        QueryPerformanceFrequency(&frequency);
+        double ms = 1000.0*(end.QuadPart - start.QuadPart)/frequency.QuadPart;
+        convertTime_ = convertTime_ == 0.0 ? ms : 0.9*convertTime_ + 0.1*ms;
+
+        frameArrival_ = wxGetLocalTimeMillis();
+        
+        return resized_;
+    }
+
+    //The next saved frame of the recorded session, once the replay clock says it's due.
+    UCArray Camera::getNextReplayFrame(unsigned long timeout)
+    {
+        long frame;
+        if (!replay_->next(timeout, replayImage_, frame))
+        {
+            return UCArray();
+        }
+
+        memcpy(frameBuffer_.get(), &replayImage_[0], replayImage_.size());
+        ++image_.FrameCount;
+
+        frameArrival_ = wxGetLocalTimeMillis();
+        if (replayStart_ == 0)
+        {
+            replayStart_ = frameArrival_;
+        }
+        resizePreview();
+
+        //Move the crop region to the start of the buffer, as a camera frame would be.
+        if (saveWidth() != width_ || saveHeight() != height_)
+        {
+            unsigned char* frame = frameBuffer_.get();
+            size_t rowBytes = saveWidth()*3;
+
+            for (unsigned long j = 0; j < saveHeight(); ++j)
+            {
+                memmove(frame + j*rowBytes, 
+                        frame + (saveRegion_.top() + j)*stepBytesOriginal_ + saveRegion_.left()*3, 
+                        rowBytes);
+            }
         }
 
+        return resized_;
+    }
+
+    void Camera::resizePreview()
+    {
         unsigned char *original = frameBuffer_.get();
-        PvUtilityColorInterpolate(&image_, &(original[0]), &(original[1]), &(original[2]), 2, 0);
 
         //This section resizes the image. Saves wxWidgets doing it. 
         //Byte order of images in frameBuffer are in bmp format (GBR, left to right, bottom to top).
@@ -201,24 +490,242 @@ namespace rics
                 orig += 3*resizeFactor_;//resizeFactor_*3, resized resizeFactor_ times
            }
         }
-        
-        return resized_;
     }
 
-    //save image as jpeg using the libjpeg library in wxWidgets
-    void Camera::saveImageWX()
+    //save image as jpeg using the libjpeg library in wxWidgets. False if it couldn't 
+    //be written.
+    bool Camera::saveImageWX()
     {
-        wxImage(width(), height(), frameBuffer_.get(), true)
-        .SaveFile(frameName(), wxBITMAP_TYPE_JPEG);
+        bool saved = wxImage(saveWidth(), saveHeight(), frameBuffer_.get(), true)
+                     .SaveFile(frameName(), wxBITMAP_TYPE_JPEG);
+
+        if (saved)
+        {
+            frameBytes_ += wxFileName::GetSize(frameName()).GetLo();
+        }
+
+        return saved;
     }
 
-    //save image as jpeg using the libjpeg-turbo library
-    void Camera::saveImageTurbo()
+    //save image as jpeg using the libjpeg-turbo library. Compressed in memory and 
+    //written in one go, so the size written is known. False if the file couldn't be
+    //written in full (e.g. the disk is full); what was written is removed.
+    //With write-behind the file is queued and written by the image writer, and false
+    //means an earlier file on the same drive couldn't be written.
+    bool Camera::saveImageTurbo()
     {
         JPEGWriter writer;
-        writer.header(width(), height(), 3, JPEG::COLOR_RGB);
+        writer.header(saveWidth(), saveHeight(), 3, JPEG::COLOR_RGB);
         writer.setQuality(80);
-        writer.write(frameName(), frameBuffer_.get());
+        writer.write(frameJPEG_, frameBuffer_.get());
+
+#if USE_WRITE_BEHIND
+        if (!writer_->write(frameName(), &frameJPEG_[0], frameJPEG_.size()))
+        {
+            return false;
+        }
+
+        frameBytes_ += frameJPEG_.size();
+        queuedBytes_ += frameJPEG_.size();
+        return true;
+#else
+
+        std::string name = frameName();
+        FILE* file = fopen(name.c_str(), "wb");
+        if (file == NULL)
+        {
+            return false;
+        }
+
+        size_t written = fwrite(&frameJPEG_[0], 1, frameJPEG_.size(), file);
+        bool saved = fclose(file) == 0 && written == frameJPEG_.size();
+
+        if (!saved)
+        {
+            remove(name.c_str());
+            return false;
+        }
+
+        frameBytes_ += written;
+        return true;
+#endif
+    }
+
+    //The 12 bit Bayer data of the last frame, next to its JPEG, as a 16 bit PGM
+    //(<frame>.pgm). Only when archiving is on and the pixel format is 12 or 16 bit.
+    void Camera::saveRawImage()
+    {
+        if (!archiveRaw_ || !RawFormat::highBitDepth(image_.Format) || rawArchive_.empty())
+        {
+            return;
+        }
+
+        std::string name = frameName();
+        name = name.substr(0, name.rfind('.')) + ".pgm";
+
+        FILE* file = fopen(name.c_str(), "wb");
+        if (file == NULL)
+        {
+            return;
+        }
+
+        fprintf(file, "P5\n%lu %lu\n4095\n", saveWidth(), saveHeight());
+        for (unsigned long j = 0; j < saveHeight(); ++j)
+        {
+            size_t offset = (saveRegion_.top() + j)*image_.Width + saveRegion_.left();
+            frameBytes_ += sizeof(unsigned short)*fwrite(&rawArchive_[offset], sizeof(unsigned short), saveWidth(), file);
+        }
+        fclose(file);
+    }
+
+    //Called by the camera thread once everything for the frame has been written, with 
+    //the time taken (ms), for the storage forecast.
+    void Camera::saveDone(double ms)
+    {
+        bytesSaved_ += frameBytes_;
+        saveTimeTotal_ += ms;
+        savedBytesPerFrame_ = savedBytesPerFrame_ == 0.0 ? frameBytes_ : 0.9*savedBytesPerFrame_ + 0.1*frameBytes_;
+        saveTime_ = saveTime_ == 0.0 ? ms : 0.9*saveTime_ + 0.1*ms;
+        frameBytes_ = 0;
+    }
+
+    //Wait for the queued JPEGs to be written, eg when capture stops.
+    void Camera::flushImages()
+    {
+        writer_->flush();
+    }
+
+    //The last JPEG the image writer couldn't write. It has been removed.
+    std::string Camera::lastWriteFailure() const
+    {
+        return writer_->lastFailure();
+    }
+
+    //JPEGs the image writer couldn't write. Each is kept in memory until it is 
+    //rewritten elsewhere or discarded.
+    std::vector<std::string> Camera::failedWrites() const
+    {
+        return writer_->failedWrites();
+    }
+
+    bool Camera::rewriteImage(const std::string& path, const std::string& newPath)
+    {
+        return writer_->requeue(path, newPath);
+    }
+
+    void Camera::discardImage(const std::string& path)
+    {
+        writer_->discard(path);
+    }
+
+    //Halve the width and height, averaging each 2x2 block. Done in place, as
+    //each output pixel is written no later than the first pixel it is read from.
+    static void halveImage(std::vector<unsigned char>& image, unsigned long& width, unsigned long& height)
+    {
+        unsigned long w = width/2;
+        unsigned long h = height/2;
+        unsigned long step = width*3;
+        unsigned char* out = &image[0];
+
+        for (unsigned long j = 0; j < h; ++j)
+        {
+            const unsigned char* row0 = &image[0] + 2*j*step;
+            const unsigned char* row1 = row0 + step;
+
+            for (unsigned long i = 0; i < w; ++i)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    *out++ = static_cast<unsigned char>((row0[c] + row0[c + 3] + row1[c] + row1[c + 3] + 2)/4);
+                }
+
+                row0 += 6;
+                row1 += 6;
+            }
+        }
+
+        width = w;
+        height = h;
+    }
+
+    //Save the thumbnail pyramid of the last frame to the thumbnail packs in the
+    //session directory. The first level is taken straight from the frame, like
+    //the network preview, and each further level is averaged from the one before.
+    //Must be called from the camera thread, after getNextFrame.
+    void Camera::saveThumbnails()
+    {
+        if (thumbnailPath_ != sessionPath_)
+        {
+            for (size_t i = 0; i < thumbnailPacks_.size(); ++i)
+            {
+                thumbnailPacks_[i]->create(sessionPath_, thumbnailScale_ << i);
+            }
+            thumbnailPath_ = sessionPath_;
+        }
+
+        unsigned long w = streamWidth(thumbnailScale_);
+        unsigned long h = streamHeight(thumbnailScale_);
+        thumbnail_.resize(w*h*3);
+        streamImage(&thumbnail_[0], thumbnailScale_);
+        appendThumbnail(0, w, h);
+
+        for (size_t level = 1; level < thumbnailPacks_.size(); ++level)
+        {
+            halveImage(thumbnail_, w, h);
+            appendThumbnail(level, w, h);
+        }
+    }
+
+    //Sharpness of the last frame, for the database. Must be called from the camera
+    //thread, after getNextFrame.
+    double Camera::measureSharpness()
+    {
+        return sharpness_.measure(frameBuffer_.get());
+    }
+
+    void Camera::appendThumbnail(size_t level, unsigned long width, unsigned long height)
+    {
+        JPEGWriter writer;
+        writer.header(width, height, 3, JPEG::COLOR_RGB);
+        writer.setQuality(75);
+        writer.write(thumbnailJPEG_, &thumbnail_[0]);
+
+        thumbnailPacks_[level]->append(frameNumber(), thumbnailJPEG_);
+        frameBytes_ += thumbnailJPEG_.size();
+    }
+
+    //Called by the camera thread when it has finished with the frame from 
+    //getNextFrame, whether or not it was saved. When replaying, the time from
+    //the frame arriving to here is kept for the benchmark report.
+    void Camera::frameDone()
+    {
+        if (replay_)
+        {
+            wxLongLong now = wxGetLocalTimeMillis();
+            latencies_.push_back((now - frameArrival_).GetLo());
+
+            double seconds = (now - replayStart_).ToDouble()/1000.0;
+            if (seconds > 0.0)
+            {
+                replayFrameRate_ = static_cast<float>(latencies_.size()/seconds);
+            }
+        }
+    }
+
+    //Milliseconds spent on each replayed frame by the pipeline.
+    const std::vector<unsigned long>& Camera::latencies() const
+    {
+        return latencies_;
+    }
+
+    bool Camera::replaying() const
+    {
+        return replay_.get() != NULL;
+    }
+
+    bool Camera::replayFinished() const
+    {
+        return replay_ && replay_->finished();
     }
 
     inline wxString Camera::sessionName()
@@ -236,16 +743,24 @@ namespace rics
         return sessionPath_;
     }
 
+    //Also the frame path, until setFramePath() is called.
     void Camera::setSessionPath(const wxString& sessionPath)
     { 
         sessionPath_ = sessionPath;
+        framePath_ = sessionPath;
+    }
+
+    //The directory the next JPEG (and PGM) is written to. Thumbnails stay in the session path.
+    void Camera::setFramePath(const wxString& framePath)
+    {
+        framePath_ = framePath;
     }
     
     std::string Camera::frameName()
     {
         std::string frameName;
         
-        frameName = sessionPath();
+        frameName = framePath_;
 
         if (frameNumber() < 10)
         {
@@ -299,6 +814,8 @@ namespace rics
     {
         setHeight(height);
         setWidth(width);
+        roiLeft_ = left;
+        roiTop_ = top;
 
         tPvErr returnCode = PvAttrUint32Set(handle(), "Width", width);
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
@@ -308,10 +825,40 @@ namespace rics
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
         returnCode = PvAttrUint32Set(handle(), "RegionY", top);
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+
+        fitCrop();
+    }
+
+    //The part of each frame that is demosaiced and saved, inside the ROI. Use a region
+    //of 0 width to save the whole frame. Not to be changed while streaming.
+    void Camera::setCrop(const CropRegion& crop)
+    {
+        crop_ = crop;
+        fitCrop();
+    }
+
+    //The region saved, fitted to the frame.
+    CropRegion Camera::crop() const
+    {
+        return saveRegion_;
+    }
+
+    void Camera::fitCrop()
+    {
+        saveRegion_ = crop_.fitted(width_, height_);
+        sharpness_ = Sharpness(saveWidth(), saveHeight());
     }
     
     void Camera::setExposureTime(bool autoMode, unsigned long exposureTime)
     {
+        if (replay_)
+        {
+            return;
+        }
+
+        wxMutexLocker lock(*settingsMutex_);
+        settings_.setAutoExposure(autoMode);
+        settings_.setExposureTime(exposureTime);
         tPvErr returnCode;
 
         if (autoMode)
@@ -330,6 +877,11 @@ namespace rics
 
     unsigned long Camera::exposureTime()
     {   
+        if (replay_ || unplugged())
+        {
+            return 0;
+        }
+
         unsigned long exposureTime;
         tPvErr returnCode = PvAttrUint32Get(handle(), "ExposureValue", &exposureTime);
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
@@ -342,6 +894,8 @@ namespace rics
     //few frames hence the image blur.
     void Camera::setAutoMaxTime(unsigned long exposureMaxTime)
     {
+        wxMutexLocker lock(*settingsMutex_);
+        settings_.setAutoMaxTime(exposureMaxTime);
         tPvErr returnCode;
         returnCode = PvAttrUint32Set(handle(), "ExposureAutoMax", exposureMaxTime);            
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
@@ -358,12 +912,72 @@ namespace rics
 
     void Camera::setFrameRate(float frameRate)
     {
+        frameRate_ = frameRate;
         tPvErr returnCode = PvAttrFloat32Set(handle(), "FrameRate", frameRate);
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
     }
 
+    float Camera::frameRate()
+    {
+        if (replay_)
+        {
+            return 0.0f;
+        }
+
+        if (unplugged())
+        {
+            return frameRate_;
+        }
+
+        float frameRate;
+        tPvErr returnCode = PvAttrFloat32Get(handle(), "FrameRate", &frameRate);
+        assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+        return frameRate;
+    }
+
+    //"FixedRate" (free run at the frame rate), "Software" (softwareTrigger()) 
+    //or "SyncIn1" (external pulse).
+    void Camera::setTriggerMode(char* mode)
+    {
+        if (replay_)
+        {
+            return;
+        }
+
+        triggerMode_ = mode;
+        if (unplugged())
+        {
+            return;
+        }
+
+        tPvErr returnCode = PvAttrEnumSet(handle(), "FrameStartTriggerMode", mode);
+        assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+    }
+
+    void Camera::softwareTrigger()
+    {
+        if (replay_ || unplugged())
+        {
+            return;
+        }
+
+        tPvErr returnCode = PvCommandRun(handle(), "FrameStartTriggerSoftware");
+        assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+    }
+
     void Camera::setWhiteBalance(bool autoMode, char* colour, unsigned long value)
     {
+        wxMutexLocker lock(*settingsMutex_);
+        settings_.setAutoWhiteBalance(autoMode);
+        if (colour[0] == 'R')
+        {
+            settings_.setWhiteBalanceRed(value);
+        }
+        else if (colour[0] == 'B')
+        {
+            settings_.setWhiteBalanceBlue(value);
+        }
+
         tPvErr returnCode;
 
         if (autoMode)
@@ -391,6 +1005,9 @@ namespace rics
 
     void Camera::setGain(bool autoMode, unsigned long gain)
     {
+        wxMutexLocker lock(*settingsMutex_);
+        settings_.setAutoGain(autoMode);
+        settings_.setGain(gain);
         tPvErr returnCode;
 
         if (autoMode)
@@ -411,8 +1028,236 @@ namespace rics
         }
     }
 
+    CameraSettings Camera::settings() const
+    {
+        wxMutexLocker lock(*settingsMutex_);
+        return settings_;
+    }
+
+    //Writes only the attributes that differ from the last settings given to the camera,
+    //so switching between similar profiles costs a few register writes. An unplugged
+    //camera just keeps the settings, they are written when it is re-opened.
+    //Returns the number of attributes written.
+    unsigned long Camera::applySettings(const CameraSettings& settings)
+    {
+        wxMutexLocker lock(*settingsMutex_);
+        return writeSettings(settings);
+    }
+
+    //Change only the exposure and gain of the current settings, eg from the camera
+    //thread's exposure control, so white balance or a profile applied at the same 
+    //time is kept.
+    unsigned long Camera::applyExposure(bool autoExposure, unsigned long exposureTime, bool autoGain, unsigned long gain)
+    {
+        wxMutexLocker lock(*settingsMutex_);
+
+        CameraSettings settings = settings_;
+        settings.setAutoExposure(autoExposure);
+        settings.setExposureTime(exposureTime);
+        settings.setAutoGain(autoGain);
+        settings.setGain(gain);
+
+        return writeSettings(settings);
+    }
+
+    //The body of applySettings(), called with the settings mutex locked.
+    unsigned long Camera::writeSettings(const CameraSettings& settings)
+    {
+        CameraSettings old = settings_;
+        settings_ = settings;
+
+        if (replay_ || unplugged())
+        {
+            return 0;
+        }
+
+        unsigned long written = 0;
+        tPvErr returnCode;
+
+        if (settings.autoMaxTime() != old.autoMaxTime())
+        {
+            returnCode = PvAttrUint32Set(handle(), "ExposureAutoMax", settings.autoMaxTime());
+            assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+            ++written;
+        }
+
+        if (settings.autoExposure() != old.autoExposure())
+        {
+            returnCode = PvAttrEnumSet(handle(), "ExposureMode", settings.autoExposure() ? "Auto" : "Manual");
+            assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+            ++written;
+        }
+
+        if (!settings.autoExposure() && (settings.exposureTime() != old.exposureTime() || old.autoExposure()))
+        {
+            returnCode = PvAttrUint32Set(handle(), "ExposureValue", settings.exposureTime());
+            assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+            ++written;
+        }
+
+        if (settings.autoGain() != old.autoGain())
+        {
+            if (settings.autoGain())
+            {
+                returnCode = PvAttrUint32Set(handle(), "GainAutoMax", 24);
+                assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+                returnCode = PvAttrUint32Set(handle(), "GainAutoMin", 0);
+                assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+                written += 2;
+            }
+
+            returnCode = PvAttrEnumSet(handle(), "GainMode", settings.autoGain() ? "Auto" : "Manual");
+            assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+            ++written;
+        }
+
+        if (!settings.autoGain() && (settings.gain() != old.gain() || old.autoGain()))
+        {
+            returnCode = PvAttrUint32Set(handle(), "GainValue", settings.gain());
+            assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+            ++written;
+        }
+
+        if (settings.autoWhiteBalance() != old.autoWhiteBalance())
+        {
+            returnCode = PvAttrEnumSet(handle(), "WhitebalMode", settings.autoWhiteBalance() ? "Auto" : "Manual");
+            assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+            ++written;
+        }
+
+        if (!settings.autoWhiteBalance())
+        {
+            if (settings.whiteBalanceRed() != old.whiteBalanceRed() || old.autoWhiteBalance())
+            {
+                returnCode = PvAttrUint32Set(handle(), "WhitebalValueRed", settings.whiteBalanceRed());
+                assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+                ++written;
+            }
+
+            if (settings.whiteBalanceBlue() != old.whiteBalanceBlue() || old.autoWhiteBalance())
+            {
+                returnCode = PvAttrUint32Set(handle(), "WhitebalValueBlue", settings.whiteBalanceBlue());
+                assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+                ++written;
+            }
+        }
+
+        return written;
+    }
+
+    ColourSettings Camera::colour() const
+    {
+        return demosaic_->colour();
+    }
+
+    //Colour correction done on the PC, as the frame is converted from Bayer to RGB.
+    //Takes effect from the next frame, so it can be changed while streaming. Not
+    //applied to replayed frames, which are already RGB.
+    void Camera::setColour(const ColourSettings& colour)
+    {
+        demosaic_->setColour(colour);
+    }
+
+    //"Bayer8", "Bayer12Packed" or "Bayer16". The higher bit depths take 1.5 and 2 times the 
+    //bandwidth. Only while not streaming, as the frame size changes.
+    void Camera::setPixelFormat(const wxString& format)
+    {
+        pixelFormat_ = format.c_str();
+
+        if (replay_ || unplugged())
+        {
+            return;
+        }
+
+        tPvErr returnCode = PvCaptureQueueClear(handle());
+        assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+        frameQueued_ = false;
+        returnCode = PvAttrEnumSet(handle(), "PixelFormat", pixelFormat_.c_str());
+        assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+
+        allocateImageBuffer();
+    }
+
+    wxString Camera::pixelFormat() const
+    {
+        return pixelFormat_;
+    }
+
+    //See RawFormat::setToneGamma. Only used by 12 and 16 bit formats.
+    void Camera::setToneGamma(double gamma)
+    {
+        rawFormat_.setToneGamma(gamma);
+    }
+
+    double Camera::toneGamma() const
+    {
+        return rawFormat_.toneGamma();
+    }
+
+    //Keep the 12 bit Bayer data of each saved frame as well as the JPEG.
+    void Camera::setArchiveRaw(bool archiveRaw)
+    {
+        archiveRaw_ = archiveRaw;
+    }
+
+    bool Camera::archiveRaw() const
+    {
+        return archiveRaw_;
+    }
+
+    //Time taken to turn the last frames into RGB (unpacking, tone mapping, demosaic 
+    //and colour), in ms.
+    double Camera::convertTime() const
+    {
+        return convertTime_;
+    }
+
+    //Time taken to encode and write each saved frame (JPEG, thumbnails and raw data),
+    //in ms.
+    double Camera::saveTime() const
+    {
+        return saveTime_;
+    }
+
+    //All the time spent saving (ms), and all the bytes written, since the camera was opened.
+    double Camera::saveTimeTotal() const
+    {
+        return saveTimeTotal_;
+    }
+
+    double Camera::bytesSaved() const
+    {
+        return bytesSaved_;
+    }
+
+    //Bytes actually on disk: those written by the camera thread and the JPEGs the image
+    //writer has finished. Less than bytesSaved() while JPEGs are queued.
+    double Camera::bytesWritten() const
+    {
+        return bytesSaved_ - queuedBytes_ + writer_->bytesWritten();
+    }
+
+    //See ImageWriter::backlog()
+    double Camera::writeBacklog() const
+    {
+        return writer_->backlog();
+    }
+
+    //ms from a JPEG being queued to it being on disk, eg writeLatency(99).
+    double Camera::writeLatency(double percentile) const
+    {
+        return writer_->latency(percentile);
+    }
+
+    //Bytes written for each saved frame, smoothed.
+    double Camera::savedBytesPerFrame() const
+    {
+        return savedBytesPerFrame_;
+    }
+
     void Camera::adjustPacketSize(unsigned long packetSize)
     {
+        packetSize_ = packetSize;
         tPvErr returnCode = PvCaptureEnd(handle());
         returnCode = PvCaptureAdjustPacketSize(handle(), packetSize);//*/PvAttrUint32Set(handle(), "PacketSize", packetSize);
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
@@ -420,24 +1265,250 @@ namespace rics
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
     }
 
+    unsigned long Camera::packetSize()
+    {
+        if (unplugged())
+        {
+            return packetSize_;
+        }
+
+        unsigned long packetSize;
+        tPvErr returnCode = PvAttrUint32Get(handle(), "PacketSize", &packetSize);
+        assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+        return packetSize;
+    }
+
+    //The packet size can't be changed while a frame is queued, so a request from 
+    //another thread (eg the BandwidthController) is left here and applied by the 
+    //camera thread between frames.
+    void Camera::requestPacketSize(unsigned long packetSize)
+    {
+        pendingPacketSize_ = packetSize;
+    }
+
+    void Camera::applyPacketSize()
+    {
+        unsigned long packetSize = pendingPacketSize_;
+        if (packetSize == 0)
+        {
+            return;
+        }
+        pendingPacketSize_ = 0;
+
+        tPvErr returnCode = PvCaptureQueueClear(handle());
+        assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+        frameQueued_ = false;
+        adjustPacketSize(packetSize);
+    }
+
+    //Restart a stalled stream without closing the camera: clear the capture queue,
+    //stop the acquisition, renegotiate the packet size (the link may have come back 
+    //with a smaller MTU) and start again. Returns false if the camera didn't respond,
+    //eg it is still unplugged.
+    bool Camera::recover()
+    {
+        if (replay_)
+        {
+            return true;
+        }
+
+        unsigned long packetSize;
+        tPvErr returnCode = PvAttrUint32Get(handle(), "PacketSize", &packetSize);
+        if (returnCode)
+        {
+            return false;
+        }
+
+        PvCaptureQueueClear(handle());
+        frameQueued_ = false;
+        PvCommandRun(handle(), "AcquisitionStop");
+        PvCaptureEnd(handle());
+
+        returnCode = PvCaptureAdjustPacketSize(handle(), packetSize);
+        if (!returnCode)
+        {
+            returnCode = PvCaptureStart(handle());
+        }
+        if (!returnCode)
+        {
+            returnCode = PvCommandRun(handle(), "AcquisitionStart");
+        }
+
+        return returnCode == ePvErrSuccess;
+    }
+
+    //Called from the PvAPI link callback. The camera thread stops using the camera
+    //until it is plugged back in.
+    void Camera::setUnplugged()
+    {
+        InterlockedExchange(&unplugged_, 1);
+        InterlockedExchange(&reconnectRequested_, 0);
+    }
+
+    bool Camera::unplugged() const
+    {
+        return unplugged_ != 0;
+    }
+
+    //Called from the PvAPI link callback when the camera appears again. The camera
+    //is re-opened by the camera thread (reconnect()), between frames.
+    void Camera::requestReconnect()
+    {
+        if (unplugged())
+        {
+            InterlockedExchange(&reconnectRequested_, 1);
+        }
+    }
+
+    bool Camera::reconnectRequested() const
+    {
+        return reconnectRequested_ != 0;
+    }
+
+    //Open the camera again by its unique ID and give it back its stream setup and 
+    //settings. The old handle is closed first. Returns false if the camera couldn't
+    //be opened, in which case it stays unplugged and can be retried.
+    bool Camera::reconnect()
+    {
+        InterlockedExchange(&reconnectRequested_, 0);
+
+        if (hCamera_ != NULL)
+        {
+            PvCameraClose(hCamera_);
+            hCamera_ = NULL;
+        }
+
+        tPvHandle handle;
+        if (PvCameraOpen(uniqueID_, ePvAccessMaster, &handle))
+        {
+            return false;
+        }
+
+        hCamera_ = handle;
+        frameQueued_ = false;
+        pendingPacketSize_ = 0;
+        configure();
+
+        InterlockedExchange(&unplugged_, 0);
+        startStream();
+
+        return true;
+    }
+
+    //Close the camera when the application exits.
+    void Camera::close()
+    {
+        if (!replay_ && hCamera_ != NULL)
+        {
+            PvCameraClose(hCamera_);
+            hCamera_ = NULL;
+        }
+    }
+
+    unsigned long Camera::packetsMissed()
+    {
+        if (replay_ || unplugged())
+        {
+            return 0;
+        }
+
+        unsigned long missed;
+        tPvErr returnCode = PvAttrUint32Get(handle(), "StatPacketsMissed", &missed);
+        assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+        return missed;
+    }
+
+    unsigned long Camera::packetsResent()
+    {
+        if (replay_ || unplugged())
+        {
+            return 0;
+        }
+
+        unsigned long resent;
+        tPvErr returnCode = PvAttrUint32Get(handle(), "StatPacketsResent", &resent);
+        assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+        return resent;
+    }
+
+    //Calculated for each camera by the BandwidthAllocator.
+    void Camera::setStreamBytesPerSecond(unsigned long bytes)
+    {
+        streamBytesPerSecond_ = bytes;
+        if (unplugged())
+        {
+            return;
+        }
+
+        tPvErr returnCode = PvAttrUint32Set(handle(), "StreamBytesPerSecond", bytes);
+        assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+    }
+
+    unsigned long Camera::streamBytesPerSecond()
+    {
+        unsigned long bytes;
+        tPvErr returnCode = PvAttrUint32Get(handle(), "StreamBytesPerSecond", &bytes);
+        assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+        return bytes;
+    }
+
+    //Depends on the ROI and pixel format.
+    unsigned long Camera::totalBytesPerFrame()
+    {
+        if (unplugged())
+        {
+            return image_.ImageBufferSize;
+        }
+
+        unsigned long bytes;
+        tPvErr returnCode = PvAttrUint32Get(handle(), "TotalBytesPerFrame", &bytes);
+        assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+        return bytes;
+    }
+
+    //The network interface (NIC) the camera is attached to.
+    unsigned long Camera::interfaceID() const
+    {
+        return interfaceID_;
+    }
+
+    void Camera::setInterfaceID(unsigned long id)
+    {
+        interfaceID_ = id;
+    }
+
     ////////////////////////////////////////////////////////////////////////////////////////////////////
     ////////get camera information
     int Camera::uniqueID()
     {
-        unsigned long id;
-        tPvErr returnCode = PvAttrUint32Get(handle(), "UniqueId", &id);
-        assert(returnCode == 0 || returnCode == ePvErrUnplugged);
-        return id;
+        if (replay_)
+        {
+            return replayID_;
+        }
+
+        return uniqueID_;
     }
 
     void Camera::setCameraName(const wxString& cameraName)
     {
         tPvErr returnCode = PvAttrStringSet(handle(), "CameraName", cameraName.ToAscii());
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
+        cameraName_ = cameraName;
     }
 
     wxString Camera::cameraName()
     {
+        if (replay_)
+        {
+            return replayName_;
+        }
+
+        //The name given when the camera was opened or last named, while it can't be asked.
+        if (unplugged() || cameraName_ != "")
+        {
+            return cameraName_;
+        }
+
         char buffer[256];
         tPvErr returnCode = PvAttrStringGet(handle(), "CameraName", buffer, 256, NULL);
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
@@ -450,6 +1521,16 @@ namespace rics
     ////////get camera statistics
     float Camera::actualFrameRate()
     {
+        if (replay_)
+        {
+            return replayFrameRate_;
+        }
+
+        if (unplugged())
+        {
+            return 0.0f;
+        }
+
         float frameRate;
         tPvErr returnCode = PvAttrFloat32Get(handle(), "StatFrameRate", &frameRate);
         assert(returnCode == 0 || returnCode == ePvErrUnplugged);
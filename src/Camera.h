@@ -25,8 +25,18 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef CAMERA_H
 #define CAMERA_H
 
+#define USE_WRITE_BEHIND 1
+
 #include "vld.h"
 #include "JPEGWriter.h"
+#include "ThumbnailPack.h"
+#include "SessionReplay.h"
+#include "CameraSettings.h"
+#include "Sharpness.h"
+#include "Demosaic.h"
+#include "RawFormat.h"
+#include "CropRegion.h"
+#include "ImageWriter.h"
 
 #include <windows.h>
 #include <Winsock2.h>
@@ -35,6 +45,7 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 #include <PvApi.h>
 #include <PvRegIo.h>
 #include <boost/shared_array.hpp>
+#include <boost/shared_ptr.hpp>
 #include <wx/wx.h>
 #include <vector>
 
@@ -48,37 +59,98 @@ namespace rics
     {
     public:
         Camera(tPvHandle& hCamera, unsigned long streamBytesPerSecond);
+        Camera(FrameReplayPtr replay, const wxString& cameraName, int uniqueID);
         ~Camera();
 
         void startStream();
         void stopStream();
 
-        UCArray getNextFrame();
+        UCArray getNextFrame(unsigned long timeout = PVINFINITE);
+        void frameDone();
 
-        void saveImageWX();
-        void saveImageTurbo();
+        bool saveImageWX();
+        bool saveImageTurbo();
+        void saveThumbnails();
+        void saveRawImage();
+        void saveDone(double ms);
+        void flushImages();
+        std::string lastWriteFailure() const;
+        std::vector<std::string> failedWrites() const;
+        bool rewriteImage(const std::string& path, const std::string& newPath);
+        void discardImage(const std::string& path);
+        double measureSharpness();
 
         unsigned long height() const;
         void setHeight(unsigned long h);
         unsigned long width() const;
         void setWidth(unsigned long w);
+        unsigned long previewHeight() const;
+        unsigned long previewWidth() const;
+        unsigned long saveHeight() const;
+        unsigned long saveWidth() const;
+        unsigned long streamHeight(unsigned long scale) const;
+        unsigned long streamWidth(unsigned long scale) const;
+        void streamImage(unsigned char* image, unsigned long scale) const;
         long frameNumber() const;
+        unsigned long frameCount() const;
         void setFrameNumber(unsigned long fn);
         void incFrameNumber();
         void resetFrameNumber();
 
         void setROI(unsigned long left, unsigned long top, unsigned long height, unsigned long width);
+        void setCrop(const CropRegion& crop);
+        CropRegion crop() const;
         void setExposureTime(bool autoMode, unsigned long exposureTime);
         void setAutoMaxTime(unsigned long exposureMaxTime);
         float maxFrameRate();
         void setFrameRate(float frameRate);
+        float frameRate();
+        void setTriggerMode(char* mode);
+        void softwareTrigger();
         void setWhiteBalance(bool autoMode, char* colour, unsigned long value);
         void setGain(bool autoMode, unsigned long gain);
+        CameraSettings settings() const;
+        unsigned long applySettings(const CameraSettings& settings);
+        unsigned long applyExposure(bool autoExposure, unsigned long exposureTime, bool autoGain, unsigned long gain);
+        ColourSettings colour() const;
+        void setColour(const ColourSettings& colour);
+        void setPixelFormat(const wxString& format);
+        wxString pixelFormat() const;
+        void setToneGamma(double gamma);
+        double toneGamma() const;
+        void setArchiveRaw(bool archiveRaw);
+        bool archiveRaw() const;
+        double convertTime() const;
+        double saveTime() const;
+        double saveTimeTotal() const;
+        double bytesSaved() const;
+        double bytesWritten() const;
+        double writeBacklog() const;
+        double writeLatency(double percentile) const;
+        double savedBytesPerFrame() const;
         void adjustPacketSize(unsigned long packetSize);
+        unsigned long packetSize();
+        void requestPacketSize(unsigned long packetSize);
+        void applyPacketSize();
+        bool recover();
+        void setUnplugged();
+        bool unplugged() const;
+        void requestReconnect();
+        bool reconnectRequested() const;
+        bool reconnect();
+        void close();
+        unsigned long packetsMissed();
+        unsigned long packetsResent();
+        void setStreamBytesPerSecond(unsigned long bytes);
+        unsigned long streamBytesPerSecond();
+        unsigned long totalBytesPerFrame();
+        unsigned long interfaceID() const;
+        void setInterfaceID(unsigned long id);
         wxString sessionName();
         void setSessionName(const wxString& sn);
         inline wxString sessionPath() const;
         void setSessionPath(const wxString& sessionPath);
+        void setFramePath(const wxString& framePath);
 
         unsigned long exposureTime();
         int uniqueID();
@@ -86,10 +158,21 @@ namespace rics
         wxString cameraName();
         float actualFrameRate();
 
-        inline std::string frameName();
+        std::string frameName();
+
+        bool replaying() const;
+        bool replayFinished() const;
+        const std::vector<unsigned long>& latencies() const;
 
     private:
         HANDLE handle();
+        void configure();
+        void allocateImageBuffer();
+        void appendThumbnail(size_t level, unsigned long width, unsigned long height);
+        UCArray getNextReplayFrame(unsigned long timeout);
+        void resizePreview();
+        void fitCrop();
+        unsigned long writeSettings(const CameraSettings& settings);
 
     private:
         HANDLE hCamera_;
@@ -104,13 +187,66 @@ namespace rics
 
         long frameNumber_;
         wxString sessionPath_;
+        wxString framePath_;//where the JPEGs go, may be on another volume to sessionPath_
 
         UCArray frameBuffer_;
         UCArray resized_;
         UCArray imageBuffer_;
         tPvFrame image_;
+        bool frameQueued_;
 
         wxString sessionName_;
+        unsigned long interfaceID_;
+        volatile unsigned long pendingPacketSize_;
+
+        unsigned long thumbnailScale_;
+        wxString thumbnailPath_;
+        std::vector<boost::shared_ptr<ThumbnailPack> > thumbnailPacks_;//one per level, each half the size of the one before
+        std::vector<unsigned char> thumbnail_;
+        std::vector<unsigned char> thumbnailJPEG_;
+        Sharpness sharpness_;
+        boost::shared_ptr<Demosaic> demosaic_;
+        boost::shared_ptr<ImageWriter> writer_;//JPEGs are written behind the camera thread
+        RawFormat rawFormat_;
+        std::vector<unsigned char> bayer_;        //tone mapped 12 and 16 bit frames
+        std::vector<unsigned short> rawArchive_;  //12 bit frame, big endian
+        bool archiveRaw_;
+        double convertTime_;                      //ms from raw to RGB, smoothed
+        CropRegion crop_;                         //as requested, may be the whole frame
+        CropRegion saveRegion_;                   //crop_ fitted to the frame, what is saved
+        std::vector<unsigned char> frameJPEG_;
+        unsigned long frameBytes_;                //written so far for the frame being saved
+        double bytesSaved_;                       //since the camera was opened
+        double queuedBytes_;                      //of bytesSaved_, handed to the image writer
+        double saveTimeTotal_;                    //ms, since the camera was opened
+        double saveTime_;                         //ms per saved frame, smoothed
+        double savedBytesPerFrame_;               //smoothed
+
+        FrameReplayPtr replay_;
+        wxString replayName_;
+        int replayID_;
+        float replayFrameRate_;
+        wxLongLong replayStart_;
+        std::vector<unsigned char> replayImage_;
+
+        wxLongLong frameArrival_;
+        std::vector<unsigned long> latencies_;
+
+        unsigned long uniqueID_;
+        wxString cameraName_;
+        volatile LONG unplugged_;
+        volatile LONG reconnectRequested_;
+
+        //Last settings given to the camera, restored when it is re-opened.
+        unsigned long packetSize_;
+        unsigned long streamBytesPerSecond_;
+        std::string triggerMode_;
+        std::string pixelFormat_;
+        unsigned long roiLeft_;
+        unsigned long roiTop_;
+        float frameRate_;
+        CameraSettings settings_;
+        boost::shared_ptr<wxMutex> settingsMutex_;//settings_ is changed by the GUI, profile and camera threads
     };
 
     typedef std::vector<Camera> Cameras;
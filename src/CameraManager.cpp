@@ -0,0 +1,75 @@
+/*
+Author: Nariman Habili
+
+Description: Keeps capturing when a camera is unplugged. Link events from the
+             PvAPI mark the camera as unplugged, which pauses just its 
+             stream, and have it re-opened by its camera thread when it is
+             plugged back in.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CameraManager.h"
+
+namespace rics
+{
+    //Called by the PvAPI on its own thread.
+    static void __stdcall CameraLinkCB(void* context,
+                                       tPvInterface Interface,
+                                       tPvLinkEvent Event,
+                                       unsigned long UniqueId)
+    {
+        static_cast<CameraManager*>(context)->linkEvent(Event, UniqueId);
+    }
+
+    CameraManager::CameraManager(Cameras* cameras):
+    cameras_(cameras)
+    {
+        PvLinkCallbackRegister(CameraLinkCB, ePvLinkRemove, this);
+        PvLinkCallbackRegister(CameraLinkCB, ePvLinkAdd, this);
+    }
+
+    CameraManager::~CameraManager()
+    {
+        PvLinkCallbackUnRegister(CameraLinkCB, ePvLinkRemove);
+        PvLinkCallbackUnRegister(CameraLinkCB, ePvLinkAdd);
+    }
+
+    //Cameras that aren't ours (eg plugged in after start up) are ignored.
+    void CameraManager::linkEvent(tPvLinkEvent event, unsigned long uniqueID)
+    {
+        for (size_t i = 0; i < (*cameras_).size(); ++i)
+        {
+            Camera& camera = (*cameras_)[i];
+            if (static_cast<unsigned long>(camera.uniqueID()) != uniqueID)
+            {
+                continue;
+            }
+
+            if (event == ePvLinkRemove)
+            {
+                camera.setUnplugged();
+            }
+            else if (event == ePvLinkAdd)
+            {
+                camera.requestReconnect();
+            }
+        }
+    }
+
+} //namespace
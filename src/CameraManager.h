@@ -0,0 +1,48 @@
+/*
+Author: Nariman Habili
+
+Description: Keeps capturing when a camera is unplugged. Link events from the
+             PvAPI mark the camera as unplugged, which pauses just its 
+             stream, and have it re-opened by its camera thread when it is
+             plugged back in.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CAMERA_MANAGER_H
+#define CAMERA_MANAGER_H
+
+#include "Camera.h"
+
+namespace rics
+{
+    class CameraManager
+    {
+    public:
+        CameraManager(Cameras* cameras);
+        ~CameraManager();
+
+        void linkEvent(tPvLinkEvent event, unsigned long uniqueID);
+
+    private:
+        Cameras* cameras_;
+    };
+
+} //namespace
+
+#endif //CAMERA_MANAGER_H
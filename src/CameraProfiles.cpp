@@ -0,0 +1,212 @@
+/*
+Author: Nariman Habili
+
+Description: Named camera profiles (eg "overcast", "bright sun", "dusk")
+             kept in an ini file, and applied to all cameras at once.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CameraProfiles.h"
+#include <wx/fileconf.h>
+#include <wx/filename.h>
+#include <wx/stdpaths.h>
+
+namespace rics
+{
+    ProfileApplier::ProfileApplier(Camera* camera, const CameraSettings& settings):
+    wxThread(wxTHREAD_JOINABLE),
+    camera_(camera),
+    settings_(settings),
+    written_(0)
+    {
+    }
+
+    ProfileApplier::~ProfileApplier()
+    {
+    }
+
+    void* ProfileApplier::Entry()
+    {
+        written_ = camera_->applySettings(settings_);
+
+        return NULL;
+    }
+
+    unsigned long ProfileApplier::written() const
+    {
+        return written_;
+    }
+
+    CameraProfiles::CameraProfiles(const wxString& path):
+    path_(path)
+    {
+    }
+
+    CameraProfiles::~CameraProfiles()
+    {
+    }
+
+    //The file is read each time so profiles saved by another instance (eg the
+    //GUI while ricsd is running) are seen.
+    wxArrayString CameraProfiles::names() const
+    {
+        wxFileConfig config(wxEmptyString, wxEmptyString, path_, wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+        wxArrayString names;
+        wxString name;
+        long index;
+
+        bool more = config.GetFirstGroup(name, index);
+        while (more)
+        {
+            names.Add(name);
+            more = config.GetNextGroup(name, index);
+        }
+        names.Sort();
+
+        return names;
+    }
+
+    bool CameraProfiles::load(const wxString& name, CameraSettings* settings) const
+    {
+        wxFileConfig config(wxEmptyString, wxEmptyString, path_, wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+
+        if (!validName(name) || !config.HasGroup(name))
+        {
+            return false;
+        }
+
+        //Anything missing from the file keeps its default.
+        CameraSettings profile;
+        bool autoMode;
+        long value;
+        config.SetPath("/" + name);
+
+        if (config.Read("AutoExposure", &autoMode))
+        {
+            profile.setAutoExposure(autoMode);
+        }
+        if (config.Read("ExposureTime", &value) && value > 0)
+        {
+            profile.setExposureTime(value);
+        }
+        if (config.Read("AutoMaxTime", &value) && value > 0)
+        {
+            profile.setAutoMaxTime(value);
+        }
+        if (config.Read("AutoGain", &autoMode))
+        {
+            profile.setAutoGain(autoMode);
+        }
+        if (config.Read("Gain", &value) && value >= 0)
+        {
+            profile.setGain(value);
+        }
+        if (config.Read("AutoWhiteBalance", &autoMode))
+        {
+            profile.setAutoWhiteBalance(autoMode);
+        }
+        if (config.Read("WhiteBalanceRed", &value) && value > 0)
+        {
+            profile.setWhiteBalanceRed(value);
+        }
+        if (config.Read("WhiteBalanceBlue", &value) && value > 0)
+        {
+            profile.setWhiteBalanceBlue(value);
+        }
+
+        *settings = profile;
+        return true;
+    }
+
+    //Replaces the profile if it exists.
+    bool CameraProfiles::save(const wxString& name, const CameraSettings& settings)
+    {
+        if (!validName(name))
+        {
+            return false;
+        }
+
+        wxFileName::Mkdir(wxFileName(path_).GetPath(), 0777, wxPATH_MKDIR_FULL);
+        wxFileConfig config(wxEmptyString, wxEmptyString, path_, wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+        config.DeleteGroup(name);
+        config.SetPath("/" + name);
+        config.Write("AutoExposure", settings.autoExposure());
+        config.Write("ExposureTime", static_cast<long>(settings.exposureTime()));
+        config.Write("AutoMaxTime", static_cast<long>(settings.autoMaxTime()));
+        config.Write("AutoGain", settings.autoGain());
+        config.Write("Gain", static_cast<long>(settings.gain()));
+        config.Write("AutoWhiteBalance", settings.autoWhiteBalance());
+        config.Write("WhiteBalanceRed", static_cast<long>(settings.whiteBalanceRed()));
+        config.Write("WhiteBalanceBlue", static_cast<long>(settings.whiteBalanceBlue()));
+
+        return config.Flush();
+    }
+
+    bool CameraProfiles::remove(const wxString& name)
+    {
+        wxFileConfig config(wxEmptyString, wxEmptyString, path_, wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+
+        if (!validName(name) || !config.DeleteGroup(name))
+        {
+            return false;
+        }
+
+        return config.Flush();
+    }
+
+    //Profile names are ini groups, so can't contain path or group separators.
+    bool CameraProfiles::validName(const wxString& name)
+    {
+        return !name.IsEmpty() && name.find_first_of("/\\[]") == wxString::npos;
+    }
+
+    //<Application Data>\RICS\profiles.ini
+    wxString CameraProfiles::defaultPath()
+    {
+        return wxStandardPaths::Get().GetUserDataDir() + "\\profiles.ini";
+    }
+
+    //Each camera gets its own thread, so the whole set takes about as long as the
+    //slowest camera rather than the sum of all of them. Returns the total number
+    //of attributes written.
+    unsigned long CameraProfiles::apply(Cameras* cameras, const CameraSettings& settings)
+    {
+        std::vector<ProfileApplier*> appliers;
+
+        for (size_t i = 0; i < (*cameras).size(); ++i)
+        {
+            ProfileApplier* applier = new ProfileApplier(&(*cameras)[i], settings);
+            wxThreadError threadError = applier->Create();
+            assert(threadError == wxTHREAD_NO_ERROR);
+            applier->Run();
+            appliers.push_back(applier);
+        }
+
+        unsigned long written = 0;
+        for (size_t i = 0; i < appliers.size(); ++i)
+        {
+            appliers[i]->Wait();
+            written += appliers[i]->written();
+            delete appliers[i];
+        }
+
+        return written;
+    }
+
+}//namespace
@@ -0,0 +1,74 @@
+/*
+Author: Nariman Habili
+
+Description: Named camera profiles (eg "overcast", "bright sun", "dusk")
+             kept in an ini file, and applied to all cameras at once.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CAMERA_PROFILES_H
+#define CAMERA_PROFILES_H
+
+#include "Camera.h"
+#include "CameraSettings.h"
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <vector>
+
+namespace rics
+{
+    //Writes a profile to one camera.
+    class ProfileApplier : public wxThread
+    {
+    public:
+        ProfileApplier(Camera* camera, const CameraSettings& settings);
+        ~ProfileApplier();
+
+        void* Entry();
+
+        unsigned long written() const;
+
+    private:
+        Camera* camera_;
+        CameraSettings settings_;
+        unsigned long written_;//attributes written to the camera
+    };
+
+    class CameraProfiles
+    {
+    public:
+        CameraProfiles(const wxString& path = defaultPath());
+        ~CameraProfiles();
+
+        wxArrayString names() const;
+        bool load(const wxString& name, CameraSettings* settings) const;
+        bool save(const wxString& name, const CameraSettings& settings);
+        bool remove(const wxString& name);
+
+        static bool validName(const wxString& name);
+        static wxString defaultPath();
+        static unsigned long apply(Cameras* cameras, const CameraSettings& settings);
+
+    private:
+        wxString path_;
+    };
+
+}//namespace
+
+#endif //CAMERA_PROFILES_H
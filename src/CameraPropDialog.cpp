@@ -48,6 +48,8 @@ namespace rics
     whiteBalanceBlue_(std::vector<unsigned long>(numCameras_, 202)),
     autoWB_(std::vector<bool>(numCameras_, false)),
     frameRate_(4),
+    previewRate_(5),
+    syncMode_(SYNC_NONE),
     packetSize_(6000/*8228*/),
     play_(false),
     notebook_(new wxNotebook(this, wxID_ANY, wxDefaultPosition))
@@ -59,8 +61,13 @@ namespace rics
         createExposureTimePage(notebook_);
         createGainPage(notebook_);
         createWhiteBalancePage(notebook_);
+        createColourPage(notebook_);
+        createCropPage(notebook_);
+        createProfilePage(notebook_);
         createFrameRatePage(notebook_);
         createPacketSizePage(notebook_);
+        createTriggerPage(notebook_);
+        createStreamPage(notebook_);
         topSizer->Add(notebook_, 1, wxEXPAND);
 
         //Button
@@ -115,10 +122,21 @@ namespace rics
         if (!play())
         {
             val = txtCtrlPS() && val;
+            val = txtCtrlToneGamma() && val;
+            val = txtCtrlTrigger() && val;
+            val = txtCtrlKeepInterval() && val;
+            val = txtCtrlDeadline() && val;
+            val = txtCtrlBlurBudget() && val;
+            val = txtCtrlStream() && val;
         }
 
         if (val) //only end if valid number(s) entered in text box(es)
         {
+            if (!play())
+            {
+                adjustCameraPixelFormat();
+            }
+
             EndModal(wxID_OK);
         }
     }
@@ -217,6 +235,23 @@ namespace rics
                 (*cameras_)[2].setCameraName("R");
                 (*cameras_)[3].setCameraName("F");
                 break;
+            default:
+                {
+                    //Go round the vehicle, then number any cameras left over.
+                    char* positions[] = {"L", "LF", "F", "RF", "R", "RB", "B", "LB"};
+                    for (size_t i = 0; i < numCameras_; ++i)
+                    {
+                        if (i < 8)
+                        {
+                            (*cameras_)[i].setCameraName(positions[i]);
+                        }
+                        else
+                        {
+                            (*cameras_)[i].setCameraName("C" + boost::lexical_cast<std::string>(i + 1));
+                        }
+                    }
+                }
+                break;
         }
     }
 
@@ -1239,6 +1274,485 @@ namespace rics
         }
     }
 
+    ////////////////////////////////////////////////////////////////////////////////////////
+    ////Colour
+    //Colour correction done on the PC while converting each frame from Bayer to RGB, on
+    //top of the camera's white balance. Applies to the selected camera straight away, 
+    //even while capturing.
+    void CameraPropDialog::createColourPage(wxNotebook* notebook_)
+    {
+        wxSizer *panelSizer = new wxBoxSizer(wxVERTICAL);
+        wxPanel *panel = new wxPanel(notebook_, wxID_ANY);
+        notebook_->AddPage(panel, _T("Colour"));
+
+        //Camera select
+        wxStaticBox* cameraSelect = new wxStaticBox(panel, wxID_STATIC, wxT("Camera Select"));
+        wxStaticBoxSizer* cameraSelectSizer = new wxStaticBoxSizer(cameraSelect, wxHORIZONTAL);
+        cameraSelectSizer->SetMinSize(300, 0);
+
+        wxArrayString strings;
+
+        for (size_t i = 0; i < numCameras_; ++i)
+        {
+            strings.Add("Camera: " + boost::lexical_cast<std::string>((*cameras_)[i].uniqueID()));
+        }
+
+        cameraSelectChoiceColour_ = new wxComboBox(panel, 
+                                                   ID_ComboBoxColour, 
+                                                   strings[0], 
+                                                   wxDefaultPosition, 
+                                                   wxDefaultSize, 
+                                                   strings, 
+                                                   wxCB_READONLY);
+
+        cameraSelectSizer->Add(cameraSelectChoiceColour_, 0, wxALIGN_CENTER | wxALL, 10);
+
+        //Gains and gamma
+        wxStaticBox* gains = new wxStaticBox(panel, wxID_STATIC, wxT("Gains"));
+        wxStaticBoxSizer* gainsSizer = new wxStaticBoxSizer(gains, wxVERTICAL);
+        gainsSizer->SetMinSize(300, 0);
+
+        wxFlexGridSizer* gainsGridSizer = new wxFlexGridSizer(2, 4, 5, 5);
+        const char* channels[] = { "Red", "Green", "Blue" };
+
+        for (int i = 0; i < 3; ++i)
+        {
+            gainsGridSizer->Add(new wxStaticText(panel, wxID_STATIC, channels[i]), 0, wxALIGN_CENTER_HORIZONTAL);
+        }
+        gainsGridSizer->Add(new wxStaticText(panel, wxID_STATIC, wxT("Gamma")), 0, wxALIGN_CENTER_HORIZONTAL);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            textCtrlColourGains_[i] = new wxTextCtrl(panel, wxID_ANY, wxT(""), wxDefaultPosition, wxSize(50, -1));
+            gainsGridSizer->Add(textCtrlColourGains_[i], 0);
+        }
+        textCtrlGamma_ = new wxTextCtrl(panel, wxID_ANY, wxT(""), wxDefaultPosition, wxSize(50, -1));
+        gainsGridSizer->Add(textCtrlGamma_, 0);
+
+        gainsSizer->Add(gainsGridSizer, 0, wxALL, 5);
+
+        //Colour matrix
+        wxStaticBox* matrix = new wxStaticBox(panel, wxID_STATIC, wxT("Colour Matrix (rows are red, green and blue out)"));
+        wxStaticBoxSizer* matrixSizer = new wxStaticBoxSizer(matrix, wxVERTICAL);
+        matrixSizer->SetMinSize(300, 0);
+
+        wxFlexGridSizer* matrixGridSizer = new wxFlexGridSizer(3, 3, 5, 5);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                textCtrlColourMatrix_[i][j] = new wxTextCtrl(panel, wxID_ANY, wxT(""), wxDefaultPosition, wxSize(50, -1));
+                matrixGridSizer->Add(textCtrlColourMatrix_[i][j], 0);
+            }
+        }
+
+        wxButton* applyButton = new wxButton(panel, ID_ApplyColour, wxT("Apply"));
+
+        matrixSizer->Add(matrixGridSizer, 0, wxALL, 5);
+
+        //Add to top level
+        panelSizer->Add(cameraSelectSizer, 
+                        0,
+                        wxALIGN_CENTER_HORIZONTAL|wxALL, 
+                        5);
+        panelSizer->Add(gainsSizer, 
+                        0,
+                        wxALIGN_CENTER_HORIZONTAL|wxALL, 
+                        5);
+        panelSizer->Add(matrixSizer, 
+                        0,
+                        wxALIGN_CENTER_HORIZONTAL|wxALL, 
+                        5);
+        panelSizer->Add(applyButton, 
+                        0,
+                        wxALIGN_RIGHT|wxALL, 
+                        5);
+
+        panel->SetSizer(panelSizer);
+
+        showColour();
+    }
+
+    void CameraPropDialog::showColour()
+    {
+        int camera = cameraSelectChoiceColour_->GetCurrentSelection();
+        ColourSettings colour = (*cameras_)[camera < 0 ? 0 : camera].colour();
+
+        for (int i = 0; i < 3; ++i)
+        {
+            textCtrlColourGains_[i]->ChangeValue(wxString::Format("%g", colour.gain(i)));
+
+            for (int j = 0; j < 3; ++j)
+            {
+                textCtrlColourMatrix_[i][j]->ChangeValue(wxString::Format("%g", colour.matrix(i, j)));
+            }
+        }
+        textCtrlGamma_->ChangeValue(wxString::Format("%g", colour.gamma()));
+    }
+
+    void CameraPropDialog::onComboBoxColour(wxCommandEvent& WXUNUSED(event))
+    {
+        showColour();
+    }
+
+    void CameraPropDialog::onApplyColour(wxCommandEvent& WXUNUSED(event))
+    {
+        ColourSettings colour;
+        bool val = true;
+        double value;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            val = textCtrlColourGains_[i]->GetValue().ToDouble(&value) && value >= 0.0 && val;
+            colour.setGain(i, value);
+
+            for (int j = 0; j < 3; ++j)
+            {
+                val = textCtrlColourMatrix_[i][j]->GetValue().ToDouble(&value) && val;
+                colour.setMatrix(i, j, value);
+            }
+        }
+
+        val = textCtrlGamma_->GetValue().ToDouble(&value) && value >= 0.1 && val;
+        colour.setGamma(value);
+
+        if (!val)
+        {
+            wxMessageDialog(this, "Gains must be positive numbers and gamma at least 0.1.", "Colour", wxICON_HAND)
+            .ShowModal();
+            return;
+        }
+
+        int camera = cameraSelectChoiceColour_->GetCurrentSelection();
+        (*cameras_)[camera < 0 ? 0 : camera].setColour(colour);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////
+    ////Crop
+    //The part of each frame that is saved, per camera position. Kept in crops.ini and
+    //picked up the next time play is pressed. The preview still shows the whole frame.
+    void CameraPropDialog::createCropPage(wxNotebook* notebook_)
+    {
+        wxSizer *panelSizer = new wxBoxSizer(wxVERTICAL);
+        wxPanel *panel = new wxPanel(notebook_, wxID_ANY);
+        notebook_->AddPage(panel, _T("Crop"));
+
+        //Camera select
+        wxStaticBox* cameraSelect = new wxStaticBox(panel, wxID_STATIC, wxT("Camera Select"));
+        wxStaticBoxSizer* cameraSelectSizer = new wxStaticBoxSizer(cameraSelect, wxHORIZONTAL);
+        cameraSelectSizer->SetMinSize(300, 0);
+
+        wxArrayString strings;
+
+        for (size_t i = 0; i < numCameras_; ++i)
+        {
+            strings.Add("Camera: " + boost::lexical_cast<std::string>((*cameras_)[i].uniqueID()));
+        }
+
+        cameraSelectChoiceCrop_ = new wxComboBox(panel, 
+                                                 ID_ComboBoxCrop, 
+                                                 strings[0], 
+                                                 wxDefaultPosition, 
+                                                 wxDefaultSize, 
+                                                 strings, 
+                                                 wxCB_READONLY);
+
+        cameraSelectSizer->Add(cameraSelectChoiceCrop_, 0, wxALIGN_CENTER | wxALL, 10);
+
+        //Region
+        wxStaticBox* region = new wxStaticBox(panel, wxID_STATIC, wxT("Saved Region (pixels, 0 width for the whole frame)"));
+        wxStaticBoxSizer* regionSizer = new wxStaticBoxSizer(region, wxVERTICAL);
+        regionSizer->SetMinSize(300, 0);
+
+        wxFlexGridSizer* regionGridSizer = new wxFlexGridSizer(2, 4, 5, 5);
+        const char* labels[] = { "Left", "Top", "Width", "Height" };
+
+        for (int i = 0; i < 4; ++i)
+        {
+            regionGridSizer->Add(new wxStaticText(panel, wxID_STATIC, labels[i]), 0, wxALIGN_CENTER_HORIZONTAL);
+        }
+
+        for (int i = 0; i < 4; ++i)
+        {
+            textCtrlCrop_[i] = new wxTextCtrl(panel, wxID_ANY, wxT(""), wxDefaultPosition, wxSize(50, -1));
+            regionGridSizer->Add(textCtrlCrop_[i], 0);
+        }
+
+        textCropFrame_ = new wxStaticText(panel, wxID_STATIC, wxT(""));
+
+        regionSizer->Add(regionGridSizer, 0, wxALL, 5);
+        regionSizer->Add(textCropFrame_, 0, wxALL, 5);
+
+        wxButton* saveButton = new wxButton(panel, ID_SaveCrop, wxT("Save"));
+
+        //Add to top level
+        panelSizer->Add(cameraSelectSizer, 
+                        0,
+                        wxALIGN_CENTER_HORIZONTAL|wxALL, 
+                        5);
+        panelSizer->Add(regionSizer, 
+                        0,
+                        wxALIGN_CENTER_HORIZONTAL|wxALL, 
+                        5);
+        panelSizer->Add(saveButton, 
+                        0,
+                        wxALIGN_RIGHT|wxALL, 
+                        5);
+
+        panel->SetSizer(panelSizer);
+
+        showCrop();
+    }
+
+    void CameraPropDialog::showCrop()
+    {
+        int camera = cameraSelectChoiceCrop_->GetCurrentSelection();
+        Camera& cam = (*cameras_)[camera < 0 ? 0 : camera];
+        CropRegion crop = CropRegion::load(cam.cameraName());
+
+        textCtrlCrop_[0]->ChangeValue(wxString::Format("%lu", crop.left()));
+        textCtrlCrop_[1]->ChangeValue(wxString::Format("%lu", crop.top()));
+        textCtrlCrop_[2]->ChangeValue(wxString::Format("%lu", crop.width()));
+        textCtrlCrop_[3]->ChangeValue(wxString::Format("%lu", crop.height()));
+
+        CropRegion fitted = crop.fitted(cam.width(), cam.height());
+        textCropFrame_->SetLabel(wxString::Format("Frame %lux%lu, saved %lux%lu at (%lu, %lu)", 
+                                                  cam.width(), 
+                                                  cam.height(),
+                                                  fitted.width(),
+                                                  fitted.height(),
+                                                  fitted.left(),
+                                                  fitted.top()));
+    }
+
+    void CameraPropDialog::onComboBoxCrop(wxCommandEvent& WXUNUSED(event))
+    {
+        showCrop();
+    }
+
+    void CameraPropDialog::onSaveCrop(wxCommandEvent& WXUNUSED(event))
+    {
+        unsigned long values[4];
+        bool val = true;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            val = textCtrlCrop_[i]->GetValue().ToULong(&values[i]) && val;
+        }
+
+        int camera = cameraSelectChoiceCrop_->GetCurrentSelection();
+        wxString name = (*cameras_)[camera < 0 ? 0 : camera].cameraName();
+
+        if (!val || name == "")
+        {
+            wxMessageDialog(this, "Give the camera a position name, and the region in whole pixels.", "Crop", wxICON_HAND)
+            .ShowModal();
+            return;
+        }
+
+        if (!CropRegion::save(name, CropRegion(values[0], values[1], values[2], values[3])))
+        {
+            wxMessageDialog(this, "Could not write " + CropRegion::defaultPath() + ".", "Crop", wxICON_HAND)
+            .ShowModal();
+        }
+
+        showCrop();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////
+    ////Profiles
+    //A profile holds the exposure, gain and white balance for a lighting condition. 
+    //Applying one sets all cameras at once and only writes what has changed.
+    void CameraPropDialog::createProfilePage(wxNotebook* notebook_)
+    {
+        wxSizer *panelSizer = new wxBoxSizer(wxVERTICAL);
+        wxPanel *panel = new wxPanel(notebook_, wxID_ANY);
+        notebook_->AddPage(panel, _T("Profiles"));
+
+        wxStaticBox* profiles = new wxStaticBox(panel, wxID_STATIC, wxT("Camera Profiles"));
+        wxStaticBoxSizer* profilesSizer = new wxStaticBoxSizer(profiles, wxVERTICAL);
+        profilesSizer->SetMinSize(300, 0);
+
+        listBoxProfiles_ = new wxListBox(panel, ID_ListBoxProfiles, wxDefaultPosition, wxSize(250, 150), 0, NULL, wxLB_SINGLE | wxLB_SORT);
+
+        wxBoxSizer* nameSizer = new wxBoxSizer(wxHORIZONTAL);
+        wxStaticText* nameText = new wxStaticText(panel, wxID_STATIC, wxT("Name"));
+        textCtrlProfileName_ = new wxTextCtrl(panel, ID_TxtCtrlProfileName, wxT(""), wxDefaultPosition, wxSize(200, -1));
+        nameSizer->Add(nameText, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+        nameSizer->Add(textCtrlProfileName_, 1);
+
+        wxBoxSizer* buttonSizer = new wxBoxSizer(wxHORIZONTAL);
+        wxButton* applyButton = new wxButton(panel, ID_ApplyProfile, wxT("Apply"));
+        wxButton* saveButton = new wxButton(panel, ID_SaveProfile, wxT("Save Current"));
+        wxButton* deleteButton = new wxButton(panel, ID_DeleteProfile, wxT("Delete"));
+        buttonSizer->Add(applyButton, 0, wxRIGHT, 5);
+        buttonSizer->Add(saveButton, 0, wxRIGHT, 5);
+        buttonSizer->Add(deleteButton, 0);
+
+        wxStaticText* helpText = new wxStaticText(panel, 
+                                                  wxID_STATIC, 
+                                                  wxT("Saves the exposure, gain and white balance of the selected\ncamera. Applying a profile sets all cameras."));
+
+        profilesSizer->Add(listBoxProfiles_, 1, wxEXPAND | wxALL, 5);
+        profilesSizer->Add(nameSizer, 0, wxEXPAND | wxALL, 5);
+        profilesSizer->Add(buttonSizer, 0, wxALL, 5);
+        profilesSizer->Add(helpText, 0, wxALL, 5);
+
+        //Add to top level
+        panelSizer->Add(profilesSizer, 
+                        0,
+                        wxALIGN_CENTER_HORIZONTAL|wxALL, 
+                        5);
+
+        panel->SetSizer(panelSizer);
+
+        refreshProfiles();
+    }
+
+    void CameraPropDialog::refreshProfiles()
+    {
+        wxArrayString names = profiles_.names();
+
+        listBoxProfiles_->Clear();
+        for (size_t i = 0; i < names.GetCount(); ++i)
+        {
+            listBoxProfiles_->Append(names[i]);
+        }
+    }
+
+    void CameraPropDialog::onListBoxProfiles(wxCommandEvent& WXUNUSED(event))
+    {
+        textCtrlProfileName_->ChangeValue(listBoxProfiles_->GetStringSelection());
+    }
+
+    void CameraPropDialog::onApplyProfile(wxCommandEvent& WXUNUSED(event))
+    {
+        wxString name = listBoxProfiles_->GetStringSelection();
+
+        if (name == "" || !applyProfile(name))
+        {
+            wxMessageDialog(this, "Please select a profile to apply.", "Camera Profiles", wxICON_HAND)
+            .ShowModal();
+        }
+    }
+
+    void CameraPropDialog::onSaveProfile(wxCommandEvent& WXUNUSED(event))
+    {
+        wxString name = textCtrlProfileName_->GetValue().Trim().Trim(false);
+
+        if (!CameraProfiles::validName(name))
+        {
+            wxMessageDialog(this, "Please enter a profile name. It can't contain / \\ [ or ].", "Camera Profiles", wxICON_HAND)
+            .ShowModal();
+            return;
+        }
+
+        if (!profiles_.save(name, settings()))
+        {
+            wxMessageDialog(this, "The profile could not be saved to " + CameraProfiles::defaultPath(), "Camera Profiles", wxICON_HAND)
+            .ShowModal();
+            return;
+        }
+
+        refreshProfiles();
+        listBoxProfiles_->SetStringSelection(name);
+    }
+
+    void CameraPropDialog::onDeleteProfile(wxCommandEvent& WXUNUSED(event))
+    {
+        wxString name = listBoxProfiles_->GetStringSelection();
+
+        if (name != "")
+        {
+            profiles_.remove(name);
+            refreshProfiles();
+            textCtrlProfileName_->ChangeValue("");
+        }
+    }
+
+    wxArrayString CameraPropDialog::profileNames() const
+    {
+        return profiles_.names();
+    }
+
+    //Also called from the main frame, so the profile can be changed while driving
+    //without opening the dialog.
+    bool CameraPropDialog::applyProfile(const wxString& name)
+    {
+        CameraSettings profile;
+
+        if (!profiles_.load(name, &profile))
+        {
+            return false;
+        }
+
+        setSettings(profile);
+        showSettings();
+        CameraProfiles::apply(cameras_, profile);
+
+        return true;
+    }
+
+    //Settings of the camera selected on each page (all cameras share them if no camera
+    //is selected).
+    CameraSettings CameraPropDialog::settings()
+    {
+        //exposure time is in micros, therefore multiply by 1000
+        CameraSettings settings;
+        settings.setAutoExposure(autoET());
+        settings.setExposureTime(static_cast<unsigned long>(exposureTime()*1000));
+        settings.setAutoMaxTime(static_cast<unsigned long>(autoMaxTime()*1000));
+        settings.setAutoGain(autoGain());
+        settings.setGain(static_cast<unsigned long>(gain()));
+        settings.setAutoWhiteBalance(autoWB());
+        settings.setWhiteBalanceRed(static_cast<unsigned long>(whiteBalance("R")));
+        settings.setWhiteBalanceBlue(static_cast<unsigned long>(whiteBalance("B")));
+        return settings;
+    }
+
+    void CameraPropDialog::setSettings(const CameraSettings& settings)
+    {
+        exposureTimes_.assign(numCameras_, settings.exposureTime()/1000.0);
+        autoMaxTimes_.assign(numCameras_, settings.autoMaxTime()/1000.0);
+        autoET_.assign(numCameras_, settings.autoExposure());
+        gains_.assign(numCameras_, static_cast<int>(settings.gain()));
+        autoGain_.assign(numCameras_, settings.autoGain());
+        whiteBalanceRed_.assign(numCameras_, settings.whiteBalanceRed());
+        whiteBalanceBlue_.assign(numCameras_, settings.whiteBalanceBlue());
+        autoWB_.assign(numCameras_, settings.autoWhiteBalance());
+    }
+
+    //Updates the exposure, gain and white balance pages.
+    void CameraPropDialog::showSettings()
+    {
+        sliderET_->SetValue(static_cast<int>(exposureTime()));
+        textCtrlET_->ChangeValue(boost::lexical_cast<std::string>(exposureTime()));     
+        sliderAMT_->SetValue(static_cast<int>(autoMaxTime()));
+        textCtrlAMT_->ChangeValue(boost::lexical_cast<std::string>(autoMaxTime()));
+        checkBoxAutoET_->SetValue(autoET());
+        sliderET_->Enable(!autoET());
+        textCtrlET_->Enable(!autoET());
+        sliderAMT_->Enable(autoET());
+        textCtrlAMT_->Enable(autoET());
+
+        sliderGain_->SetValue(static_cast<int>(gain()));
+        textCtrlGain_->ChangeValue(boost::lexical_cast<std::string>(gain()));
+        checkBoxAutoGain_->SetValue(autoGain());
+        sliderGain_->Enable(!autoGain());
+        textCtrlGain_->Enable(!autoGain());
+
+        sliderWBRed_->SetValue(whiteBalance("R"));
+        textCtrlWBRed_->ChangeValue(boost::lexical_cast<std::string>(whiteBalance("R")));
+        sliderWBBlue_->SetValue(whiteBalance("B"));
+        textCtrlWBBlue_->ChangeValue(boost::lexical_cast<std::string>(whiteBalance("B")));
+        checkBoxAutoWB_->SetValue(autoWB());
+        sliderWBRed_->Enable(!autoWB());
+        sliderWBBlue_->Enable(!autoWB());
+        textCtrlWBRed_->Enable(!autoWB());
+        textCtrlWBBlue_->Enable(!autoWB());
+    }
+
     ////////////////////////////////////////////////////////////////////////////////////////
     ////Frame Rate
     void CameraPropDialog::createFrameRatePage(wxNotebook* notebook_)
@@ -1281,11 +1795,36 @@ namespace rics
         frameRateSizer->Add(sliderSizer, 0, wxALIGN_CENTRE_VERTICAL | wxALL, 5);
         frameRateSizer->Add(textSizer, 0, wxALIGN_LEFT);
         
+        //Preview rate. This is how often the display panels are refreshed and
+        //is independent of the camera frame rate.
+        wxStaticBox* previewRateSize = new wxStaticBox(panelFR_, wxID_STATIC, wxT("Preview Rate (refreshes/sec)"));                                   
+        wxStaticBoxSizer* previewRateSizer = new wxStaticBoxSizer(previewRateSize, wxVERTICAL);
+        previewRateSizer->SetMinSize(300, 0);
+
+        wxSizer *sliderSizerPR = new wxBoxSizer(wxHORIZONTAL);
+        sliderPR_ = new wxSlider(panelFR_,
+                                 ID_SliderPR, 
+                                 static_cast<double>(previewRate()), 
+                                 1, 
+                                 10, 
+                                 wxDefaultPosition,
+                                 wxSize(200, -1), 
+                                 wxSL_HORIZONTAL | wxSL_AUTOTICKS);
+        sliderPR_->SetTickFreq(1, 1);
+        textPR_ = new wxStaticText(panelFR_, wxID_STATIC, boost::lexical_cast<std::string>(previewRate()));
+        sliderSizerPR->Add(sliderPR_, 0, wxLEFT, 5);
+        sliderSizerPR->Add(textPR_, 0, wxLEFT, 5);
+        previewRateSizer->Add(sliderSizerPR, 0, wxALIGN_CENTRE_VERTICAL | wxALL, 5);
+
         //Add to top level
         panelSizer->Add(frameRateSizer, 
                         0,
                         wxALIGN_CENTER_HORIZONTAL|wxALL, 
                         5);
+        panelSizer->Add(previewRateSizer, 
+                        0,
+                        wxALIGN_CENTER_HORIZONTAL|wxALL, 
+                        5);
 
         panelFR_->SetSizer(panelSizer);
     }
@@ -1336,6 +1875,17 @@ namespace rics
         }
     }
 
+    void CameraPropDialog::onSliderPR(wxCommandEvent& WXUNUSED(event))
+    {
+        previewRate_ = sliderPR_->GetValue();
+        textPR_->SetLabel(boost::lexical_cast<std::string>(previewRate()));
+    }
+
+    unsigned long CameraPropDialog::previewRate() const
+    {
+        return previewRate_;
+    }
+
     //Get/Set frameRate size
     inline void CameraPropDialog::setFrameRate(unsigned long value)
     {
@@ -1359,6 +1909,9 @@ namespace rics
             }
             (*cameras_)[i].setFrameRate(fr);
         }       
+
+        //Bandwidth is shared according to frame rate.
+        BandwidthAllocator().allocate(cameras_);
     }
 
     ////////////////////////////////////////////////////////////////////////////////////////
@@ -1402,12 +1955,57 @@ namespace rics
      
         packetSizeSizer->Add(sliderSizer, 0, wxALIGN_CENTRE_VERTICAL | wxALL, 5);
         packetSizeSizer->Add(textSizer, 0, wxALIGN_LEFT);
+
+        //When checked, the bandwidth and packet size (up to the size above) are
+        //adjusted while streaming to avoid lost and resent packets.
+        checkBoxAdaptiveBandwidth_ = new wxCheckBox(panelPS_, wxID_ANY, wxT("Adjust bandwidth and packet size while streaming"));
+        checkBoxAdaptiveBandwidth_->SetValue(true);
+        packetSizeSizer->Add(checkBoxAdaptiveBandwidth_, 0, wxALL, 5);
+
+        //12 and 16 bit formats keep detail in scenes with both deep shadow and bright sky,
+        //at 1.5 and 2 times the bandwidth. They are tone mapped to 8 bits on the PC.
+        wxStaticBox* pixelFormat = new wxStaticBox(panelPS_, wxID_STATIC, wxT("Pixel Format"));
+        wxStaticBoxSizer* pixelFormatSizer = new wxStaticBoxSizer(pixelFormat, wxVERTICAL);
+        pixelFormatSizer->SetMinSize(300, 0);
+
+        wxArrayString formats;
+        formats.Add("Bayer8");
+        formats.Add("Bayer12Packed");
+        formats.Add("Bayer16");
+        comboBoxPixelFormat_ = new wxComboBox(panelPS_, 
+                                              wxID_ANY, 
+                                              (*cameras_)[0].pixelFormat(), 
+                                              wxDefaultPosition, 
+                                              wxDefaultSize, 
+                                              formats, 
+                                              wxCB_READONLY);
+
+        wxBoxSizer* toneSizer = new wxBoxSizer(wxHORIZONTAL);
+        wxStaticText* toneText = new wxStaticText(panelPS_, wxID_STATIC, wxT("Tone curve gamma (1 is linear)"));
+        textCtrlToneGamma_ = new wxTextCtrl(panelPS_, 
+                                            wxID_ANY, 
+                                            wxString::Format("%g", (*cameras_)[0].toneGamma()), 
+                                            wxDefaultPosition,
+                                            wxSize(50, -1));
+        toneSizer->Add(toneText, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+        toneSizer->Add(textCtrlToneGamma_, 0);
+
+        checkBoxArchiveRaw_ = new wxCheckBox(panelPS_, wxID_ANY, wxT("Also save the 12 bit data of each frame (.pgm)"));
+        checkBoxArchiveRaw_->SetValue((*cameras_)[0].archiveRaw());
+
+        pixelFormatSizer->Add(comboBoxPixelFormat_, 0, wxALL, 5);
+        pixelFormatSizer->Add(toneSizer, 0, wxALL, 5);
+        pixelFormatSizer->Add(checkBoxArchiveRaw_, 0, wxALL, 5);
         
         //Add to top level
         panelSizer->Add(packetSizeSizer, 
                         0,
                         wxALIGN_CENTER_HORIZONTAL|wxALL, 
                         5);
+        panelSizer->Add(pixelFormatSizer, 
+                        0,
+                        wxALIGN_CENTER_HORIZONTAL|wxALL, 
+                        5);
 
         panelPS_->SetSizer(panelSizer);
     }
@@ -1477,6 +2075,551 @@ namespace rics
         }       
     }
 
+    bool CameraPropDialog::txtCtrlToneGamma()
+    {
+        double gamma;
+
+        if (!textCtrlToneGamma_->GetValue().ToDouble(&gamma) || gamma < 0.1 || gamma > 10.0)
+        {
+            wxMessageDialog(notebook_, "Tone curve gamma must be between 0.1 and 10.", "Pixel Format Error", wxOK | wxICON_ERROR)
+            .ShowModal();
+            textCtrlToneGamma_->ChangeValue(wxString::Format("%g", (*cameras_)[0].toneGamma()));
+
+            return false;
+        }
+
+        return true;
+    }
+
+    //All cameras use the same pixel format. Changes the frame size, so only while not playing.
+    void CameraPropDialog::adjustCameraPixelFormat()
+    {
+        double gamma;
+        textCtrlToneGamma_->GetValue().ToDouble(&gamma);
+
+        for (size_t i = 0; i < numCameras_; ++i)
+        {
+            if ((*cameras_)[i].pixelFormat() != comboBoxPixelFormat_->GetValue())
+            {
+                (*cameras_)[i].setPixelFormat(comboBoxPixelFormat_->GetValue());
+            }
+            (*cameras_)[i].setToneGamma(gamma);
+            (*cameras_)[i].setArchiveRaw(checkBoxArchiveRaw_->IsChecked());
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////
+    ////Capture Trigger
+    //In distance based capture mode a frame is captured every "interval" metres 
+    //instead of at a fixed frame rate. 
+    void CameraPropDialog::createTriggerPage(wxNotebook* notebook_)
+    {
+        wxSizer *panelSizer = new wxBoxSizer(wxVERTICAL);
+        panelTrigger_ = new wxPanel(notebook_, wxID_ANY);
+        notebook_->AddPage(panelTrigger_, _T("Trigger"));
+
+        //Synchronised cameras are triggered together and their frames are grouped 
+        //into capture sets with one database row per set.
+        wxStaticBox* sync = new wxStaticBox(panelTrigger_, wxID_STATIC, wxT("Camera Synchronisation"));                                   
+        wxStaticBoxSizer* syncSizer = new wxStaticBoxSizer(sync, wxVERTICAL);
+        syncSizer->SetMinSize(300, 0);
+
+        wxArrayString syncStrings;
+        syncStrings.Add("Free run");
+        syncStrings.Add("Software broadcast trigger");
+        syncStrings.Add("Hardware trigger (SyncIn1)");
+        comboBoxSync_ = new wxComboBox(panelTrigger_, 
+                                       ID_ComboBoxSync, 
+                                       syncStrings[syncMode_], 
+                                       wxDefaultPosition, 
+                                       wxDefaultSize, 
+                                       syncStrings, 
+                                       wxCB_READONLY);
+        syncSizer->Add(comboBoxSync_, 0, wxALL, 5);
+
+        wxStaticBox* trigger = new wxStaticBox(panelTrigger_, wxID_STATIC, wxT("Distance Based Capture"));                                   
+        wxStaticBoxSizer* triggerSizer = new wxStaticBoxSizer(trigger, wxVERTICAL);
+        triggerSizer->SetMinSize(300, 0);
+
+        checkBoxDistance_ = new wxCheckBox(panelTrigger_, ID_CheckBoxDistance, wxT("Capture by distance travelled"));
+        checkBoxDistance_->SetValue(distanceTrigger_.enabled());
+
+        wxFlexGridSizer* gridSizer = new wxFlexGridSizer(3, 2, 5, 5);
+        
+        wxStaticText* intervalText = new wxStaticText(panelTrigger_, wxID_STATIC, wxT("Distance between frames (m)"));
+        textCtrlInterval_ = new wxTextCtrl(panelTrigger_, 
+                                           ID_TxtCtrlTrigger,
+                                           boost::lexical_cast<std::string>(distanceTrigger_.interval()), 
+                                           wxDefaultPosition,
+                                           wxSize(50, -1), 
+                                           wxTE_PROCESS_ENTER);
+        wxStaticText* minRateText = new wxStaticText(panelTrigger_, wxID_STATIC, wxT("Stationary frame rate (frames/sec)"));
+        textCtrlMinRate_ = new wxTextCtrl(panelTrigger_, 
+                                          ID_TxtCtrlTrigger,
+                                          boost::lexical_cast<std::string>(distanceTrigger_.minRate()), 
+                                          wxDefaultPosition,
+                                          wxSize(50, -1), 
+                                          wxTE_PROCESS_ENTER);
+        wxStaticText* maxRateText = new wxStaticText(panelTrigger_, wxID_STATIC, wxT("Maximum frame rate (frames/sec)"));
+        textCtrlMaxRate_ = new wxTextCtrl(panelTrigger_, 
+                                          ID_TxtCtrlTrigger,
+                                          boost::lexical_cast<std::string>(distanceTrigger_.maxRate()), 
+                                          wxDefaultPosition,
+                                          wxSize(50, -1), 
+                                          wxTE_PROCESS_ENTER);
+        gridSizer->Add(intervalText, 0, wxALIGN_CENTER_VERTICAL);
+        gridSizer->Add(textCtrlInterval_, 0);
+        gridSizer->Add(minRateText, 0, wxALIGN_CENTER_VERTICAL);
+        gridSizer->Add(textCtrlMinRate_, 0);
+        gridSizer->Add(maxRateText, 0, wxALIGN_CENTER_VERTICAL);
+        gridSizer->Add(textCtrlMaxRate_, 0);
+
+        triggerSizer->Add(checkBoxDistance_, 0, wxALL, 5);
+        triggerSizer->Add(gridSizer, 0, wxALL, 5);
+
+        //Frames are thinned while the vehicle is stationary or the scene is unchanged.
+        wxStaticBox* suppress = new wxStaticBox(panelTrigger_, wxID_STATIC, wxT("Stationary Frame Suppression"));                                   
+        wxStaticBoxSizer* suppressSizer = new wxStaticBoxSizer(suppress, wxVERTICAL);
+        suppressSizer->SetMinSize(300, 0);
+
+        checkBoxSuppress_ = new wxCheckBox(panelTrigger_, ID_CheckBoxSuppress, wxT("Thin frames when stationary or unchanged"));
+        checkBoxSuppress_->SetValue(framePolicy_.enabled());
+
+        wxBoxSizer* keepSizer = new wxBoxSizer(wxHORIZONTAL);
+        wxStaticText* keepText = new wxStaticText(panelTrigger_, wxID_STATIC, wxT("Keep one frame every (sec)"));
+        textCtrlKeepInterval_ = new wxTextCtrl(panelTrigger_, 
+                                               ID_TxtCtrlKeepInterval,
+                                               boost::lexical_cast<std::string>(framePolicy_.keepInterval()/1000.0), 
+                                               wxDefaultPosition,
+                                               wxSize(50, -1), 
+                                               wxTE_PROCESS_ENTER);
+        textCtrlKeepInterval_->Enable(framePolicy_.enabled());
+        keepSizer->Add(keepText, 0, wxALIGN_CENTER_VERTICAL);
+        keepSizer->Add(textCtrlKeepInterval_, 0, wxLEFT, 5);
+
+        suppressSizer->Add(checkBoxSuppress_, 0, wxALL, 5);
+        suppressSizer->Add(keepSizer, 0, wxALL, 5);
+
+        //Free running cameras that stop sending frames are restarted.
+        wxStaticBox* watchdog = new wxStaticBox(panelTrigger_, wxID_STATIC, wxT("Stalled Camera Recovery"));                                   
+        wxStaticBoxSizer* watchdogSizer = new wxStaticBoxSizer(watchdog, wxVERTICAL);
+        watchdogSizer->SetMinSize(300, 0);
+
+        checkBoxWatchdog_ = new wxCheckBox(panelTrigger_, ID_CheckBoxWatchdog, wxT("Restart cameras that stop sending frames"));
+        checkBoxWatchdog_->SetValue(watchdog_.enabled());
+
+        wxBoxSizer* deadlineSizer = new wxBoxSizer(wxHORIZONTAL);
+        wxStaticText* deadlineText = new wxStaticText(panelTrigger_, wxID_STATIC, wxT("No frames for (sec)"));
+        textCtrlDeadline_ = new wxTextCtrl(panelTrigger_, 
+                                           ID_TxtCtrlDeadline,
+                                           boost::lexical_cast<std::string>(watchdog_.deadline()/1000.0), 
+                                           wxDefaultPosition,
+                                           wxSize(50, -1), 
+                                           wxTE_PROCESS_ENTER);
+        textCtrlDeadline_->Enable(watchdog_.enabled());
+        deadlineSizer->Add(deadlineText, 0, wxALIGN_CENTER_VERTICAL);
+        deadlineSizer->Add(textCtrlDeadline_, 0, wxLEFT, 5);
+
+        watchdogSizer->Add(checkBoxWatchdog_, 0, wxALL, 5);
+        watchdogSizer->Add(deadlineSizer, 0, wxALL, 5);
+
+        //Exposure and gain set by the PC, with the exposure limited by the vehicle speed.
+        wxStaticBox* exposure = new wxStaticBox(panelTrigger_, wxID_STATIC, wxT("Speed Based Exposure"));                                   
+        wxStaticBoxSizer* exposureSizer = new wxStaticBoxSizer(exposure, wxVERTICAL);
+        exposureSizer->SetMinSize(300, 0);
+
+        checkBoxExposureControl_ = new wxCheckBox(panelTrigger_, ID_CheckBoxExposureControl, wxT("Set exposure and gain from the preview images"));
+        checkBoxExposureControl_->SetValue(exposureControl_.enabled());
+
+        wxBoxSizer* blurSizer = new wxBoxSizer(wxHORIZONTAL);
+        wxStaticText* blurText = new wxStaticText(panelTrigger_, wxID_STATIC, wxT("Travel during exposure (mm)"));
+        textCtrlBlurBudget_ = new wxTextCtrl(panelTrigger_, 
+                                             ID_TxtCtrlBlurBudget,
+                                             boost::lexical_cast<std::string>(exposureControl_.blurBudget()), 
+                                             wxDefaultPosition,
+                                             wxSize(50, -1), 
+                                             wxTE_PROCESS_ENTER);
+        textCtrlBlurBudget_->Enable(exposureControl_.enabled());
+        blurSizer->Add(blurText, 0, wxALIGN_CENTER_VERTICAL);
+        blurSizer->Add(textCtrlBlurBudget_, 0, wxLEFT, 5);
+
+        exposureSizer->Add(checkBoxExposureControl_, 0, wxALL, 5);
+        exposureSizer->Add(blurSizer, 0, wxALL, 5);
+
+        //Add to top level
+        panelSizer->Add(syncSizer, 
+                        0,
+                        wxALIGN_CENTER_HORIZONTAL|wxALL, 
+                        5);
+        panelSizer->Add(triggerSizer, 
+                        0,
+                        wxALIGN_CENTER_HORIZONTAL|wxALL, 
+                        5);
+        panelSizer->Add(suppressSizer, 
+                        0,
+                        wxALIGN_CENTER_HORIZONTAL|wxALL, 
+                        5);
+        panelSizer->Add(watchdogSizer, 
+                        0,
+                        wxALIGN_CENTER_HORIZONTAL|wxALL, 
+                        5);
+        panelSizer->Add(exposureSizer, 
+                        0,
+                        wxALIGN_CENTER_HORIZONTAL|wxALL, 
+                        5);
+
+        panelTrigger_->SetSizer(panelSizer);
+
+        textCtrlInterval_->Enable(distanceTrigger_.enabled());
+        textCtrlMinRate_->Enable(distanceTrigger_.enabled());
+        textCtrlMaxRate_->Enable(distanceTrigger_.enabled());
+    }
+
+    void CameraPropDialog::onCheckBoxDistance(wxCommandEvent& WXUNUSED(event))
+    {
+        bool enabled = checkBoxDistance_->IsChecked();
+        distanceTrigger_.setEnabled(enabled);
+        
+        textCtrlInterval_->Enable(enabled);
+        textCtrlMinRate_->Enable(enabled);
+        textCtrlMaxRate_->Enable(enabled);
+    }
+
+    void CameraPropDialog::onTxtCtrlTrigger(wxCommandEvent& WXUNUSED(event))
+    {
+        txtCtrlTrigger();
+    }
+
+    bool CameraPropDialog::txtCtrlTrigger()
+    {
+        double interval;
+        double minRate;
+        double maxRate;
+
+        if (textCtrlInterval_->GetValue().ToDouble(&interval) && 
+            textCtrlMinRate_->GetValue().ToDouble(&minRate) &&
+            textCtrlMaxRate_->GetValue().ToDouble(&maxRate))
+        {
+            if (interval < 0.5)
+            {
+                interval = 0.5;
+            }
+
+            if (maxRate > 10)
+            {
+                maxRate = 10;
+            }
+            else if (maxRate < 0.1)
+            {
+                maxRate = 0.1;
+            }
+
+            if (minRate < 0)
+            {
+                minRate = 0;
+            }
+            else if (minRate > maxRate)
+            {
+                minRate = maxRate;
+            }
+
+            distanceTrigger_.setInterval(interval);
+            distanceTrigger_.setMinRate(minRate);
+            distanceTrigger_.setMaxRate(maxRate);
+            
+            textCtrlInterval_->ChangeValue(boost::lexical_cast<std::string>(interval));
+            textCtrlMinRate_->ChangeValue(boost::lexical_cast<std::string>(minRate));
+            textCtrlMaxRate_->ChangeValue(boost::lexical_cast<std::string>(maxRate));
+
+            return true;
+        }
+        else
+        {
+            wxMessageDialog(notebook_, "Not a number!", "Trigger Error", wxOK | wxICON_ERROR)
+            .ShowModal();
+            textCtrlInterval_->ChangeValue(boost::lexical_cast<std::string>(distanceTrigger_.interval()));
+            textCtrlMinRate_->ChangeValue(boost::lexical_cast<std::string>(distanceTrigger_.minRate()));
+            textCtrlMaxRate_->ChangeValue(boost::lexical_cast<std::string>(distanceTrigger_.maxRate()));
+
+            return false;
+        }
+    }
+
+    DistanceTrigger CameraPropDialog::distanceTrigger() const
+    {
+        return distanceTrigger_;
+    }
+
+    void CameraPropDialog::onCheckBoxSuppress(wxCommandEvent& WXUNUSED(event))
+    {
+        framePolicy_.setEnabled(checkBoxSuppress_->IsChecked());
+        textCtrlKeepInterval_->Enable(framePolicy_.enabled());
+    }
+
+    void CameraPropDialog::onTxtCtrlKeepInterval(wxCommandEvent& WXUNUSED(event))
+    {
+        txtCtrlKeepInterval();
+    }
+
+    bool CameraPropDialog::txtCtrlKeepInterval()
+    {
+        double keep;
+
+        if (textCtrlKeepInterval_->GetValue().ToDouble(&keep))
+        {
+            if (keep < 0)
+            {
+                keep = 0;
+                textCtrlKeepInterval_->ChangeValue(boost::lexical_cast<std::string>(keep));
+            }
+
+            framePolicy_.setKeepInterval(static_cast<unsigned long>(keep*1000.0));
+
+            return true;
+        }
+        else
+        {
+            wxMessageDialog(notebook_, "Not a number!", "Frame Suppression Error", wxOK | wxICON_ERROR)
+            .ShowModal();
+            textCtrlKeepInterval_->ChangeValue(boost::lexical_cast<std::string>(framePolicy_.keepInterval()/1000.0));
+
+            return false;
+        }
+    }
+
+    FramePolicy CameraPropDialog::framePolicy() const
+    {
+        return framePolicy_;
+    }
+
+    void CameraPropDialog::onCheckBoxWatchdog(wxCommandEvent& WXUNUSED(event))
+    {
+        watchdog_.setEnabled(checkBoxWatchdog_->IsChecked());
+        textCtrlDeadline_->Enable(watchdog_.enabled());
+    }
+
+    void CameraPropDialog::onTxtCtrlDeadline(wxCommandEvent& WXUNUSED(event))
+    {
+        txtCtrlDeadline();
+    }
+
+    //Less than half a second would restart cameras between normal frames.
+    bool CameraPropDialog::txtCtrlDeadline()
+    {
+        double deadline;
+
+        if (textCtrlDeadline_->GetValue().ToDouble(&deadline))
+        {
+            if (deadline < 0.5)
+            {
+                deadline = 0.5;
+                textCtrlDeadline_->ChangeValue(boost::lexical_cast<std::string>(deadline));
+            }
+
+            watchdog_.setDeadline(static_cast<unsigned long>(deadline*1000.0));
+
+            return true;
+        }
+        else
+        {
+            wxMessageDialog(notebook_, "Not a number!", "Camera Recovery Error", wxOK | wxICON_ERROR)
+            .ShowModal();
+            textCtrlDeadline_->ChangeValue(boost::lexical_cast<std::string>(watchdog_.deadline()/1000.0));
+
+            return false;
+        }
+    }
+
+    Watchdog CameraPropDialog::watchdog() const
+    {
+        return watchdog_;
+    }
+
+    //Takes over from the exposure and gain set on their pages while capturing. The 
+    //auto max time is still the longest exposure used, eg when stationary.
+    void CameraPropDialog::onCheckBoxExposureControl(wxCommandEvent& WXUNUSED(event))
+    {
+        exposureControl_.setEnabled(checkBoxExposureControl_->IsChecked());
+        textCtrlBlurBudget_->Enable(exposureControl_.enabled());
+    }
+
+    void CameraPropDialog::onTxtCtrlBlurBudget(wxCommandEvent& WXUNUSED(event))
+    {
+        txtCtrlBlurBudget();
+    }
+
+    bool CameraPropDialog::txtCtrlBlurBudget()
+    {
+        double budget;
+
+        if (textCtrlBlurBudget_->GetValue().ToDouble(&budget) && budget > 0.0)
+        {
+            exposureControl_.setBlurBudget(budget);
+
+            return true;
+        }
+        else
+        {
+            wxMessageDialog(notebook_, "Not a positive number!", "Speed Based Exposure Error", wxOK | wxICON_ERROR)
+            .ShowModal();
+            textCtrlBlurBudget_->ChangeValue(boost::lexical_cast<std::string>(exposureControl_.blurBudget()));
+
+            return false;
+        }
+    }
+
+    ExposureControl CameraPropDialog::exposureControl() const
+    {
+        return exposureControl_;
+    }
+
+    void CameraPropDialog::onComboBoxSync(wxCommandEvent& WXUNUSED(event))
+    {
+        syncMode_ = static_cast<SyncMode>(comboBoxSync_->GetCurrentSelection());
+    }
+
+    SyncMode CameraPropDialog::syncMode() const
+    {
+        return syncMode_;
+    }
+
+    bool CameraPropDialog::adaptiveBandwidth() const
+    {
+        return checkBoxAdaptiveBandwidth_->IsChecked();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////
+    ////Network Preview
+    //Cameras are served as MJPEG over HTTP while playing, for a second operator or a 
+    //dashboard tablet. Open http://<computer>:<port>/ in a browser.
+    void CameraPropDialog::createStreamPage(wxNotebook* notebook_)
+    {
+        wxSizer *panelSizer = new wxBoxSizer(wxVERTICAL);
+        panelStream_ = new wxPanel(notebook_, wxID_ANY);
+        notebook_->AddPage(panelStream_, _T("Network Preview"));
+
+        wxStaticBox* stream = new wxStaticBox(panelStream_, wxID_STATIC, wxT("MJPEG Preview Stream"));                                   
+        wxStaticBoxSizer* streamSizer = new wxStaticBoxSizer(stream, wxVERTICAL);
+        streamSizer->SetMinSize(300, 0);
+
+        checkBoxStream_ = new wxCheckBox(panelStream_, ID_CheckBoxStream, wxT("Serve camera previews over HTTP"));
+        checkBoxStream_->SetValue(streamSettings_.enabled());
+        checkBoxStreamLan_ = new wxCheckBox(panelStream_, wxID_ANY, wxT("Allow other computers on the network"));
+        checkBoxStreamLan_->SetValue(streamSettings_.lan());
+
+        wxFlexGridSizer* gridSizer = new wxFlexGridSizer(3, 2, 5, 5);
+        
+        wxStaticText* portText = new wxStaticText(panelStream_, wxID_STATIC, wxT("Port"));
+        textCtrlStreamPort_ = new wxTextCtrl(panelStream_, 
+                                             ID_TxtCtrlStream,
+                                             boost::lexical_cast<std::string>(streamSettings_.port()), 
+                                             wxDefaultPosition,
+                                             wxSize(50, -1), 
+                                             wxTE_PROCESS_ENTER);
+        wxStaticText* rateText = new wxStaticText(panelStream_, wxID_STATIC, wxT("Frame rate (frames/sec)"));
+        textCtrlStreamRate_ = new wxTextCtrl(panelStream_, 
+                                             ID_TxtCtrlStream,
+                                             boost::lexical_cast<std::string>(streamSettings_.rate()), 
+                                             wxDefaultPosition,
+                                             wxSize(50, -1), 
+                                             wxTE_PROCESS_ENTER);
+
+        wxStaticText* scaleText = new wxStaticText(panelStream_, wxID_STATIC, wxT("Resolution"));
+        wxArrayString scaleStrings;
+        scaleStrings.Add("1/2");
+        scaleStrings.Add("1/4");
+        scaleStrings.Add("1/8");
+        scaleStrings.Add("1/16");
+        comboBoxStreamScale_ = new wxComboBox(panelStream_, 
+                                              ID_ComboBoxStreamScale, 
+                                              "1/" + boost::lexical_cast<std::string>(streamSettings_.scale()), 
+                                              wxDefaultPosition, 
+                                              wxDefaultSize, 
+                                              scaleStrings, 
+                                              wxCB_READONLY);
+
+        gridSizer->Add(portText, 0, wxALIGN_CENTER_VERTICAL);
+        gridSizer->Add(textCtrlStreamPort_, 0);
+        gridSizer->Add(rateText, 0, wxALIGN_CENTER_VERTICAL);
+        gridSizer->Add(textCtrlStreamRate_, 0);
+        gridSizer->Add(scaleText, 0, wxALIGN_CENTER_VERTICAL);
+        gridSizer->Add(comboBoxStreamScale_, 0);
+
+        streamSizer->Add(checkBoxStream_, 0, wxALL, 5);
+        streamSizer->Add(checkBoxStreamLan_, 0, wxALL, 5);
+        streamSizer->Add(gridSizer, 0, wxALL, 5);
+
+        //Add to top level
+        panelSizer->Add(streamSizer, 
+                        0,
+                        wxALIGN_CENTER_HORIZONTAL|wxALL, 
+                        5);
+
+        panelStream_->SetSizer(panelSizer);
+    }
+
+    void CameraPropDialog::onCheckBoxStream(wxCommandEvent& WXUNUSED(event))
+    {
+        streamSettings_.setEnabled(checkBoxStream_->IsChecked());
+    }
+
+    void CameraPropDialog::onTxtCtrlStream(wxCommandEvent& WXUNUSED(event))
+    {
+        txtCtrlStream();
+    }
+
+    bool CameraPropDialog::txtCtrlStream()
+    {
+        unsigned long port;
+        unsigned long rate;
+
+        if (textCtrlStreamPort_->GetValue().ToULong(&port) && 
+            textCtrlStreamRate_->GetValue().ToULong(&rate))
+        {
+            if (port < 1 || port > 65535)
+            {
+                port = streamSettings_.port();
+            }
+
+            if (rate < 1)
+            {
+                rate = 1;
+            }
+            else if (rate > 15)
+            {
+                rate = 15;
+            }
+
+            streamSettings_.setPort(static_cast<unsigned short>(port));
+            streamSettings_.setRate(rate);
+            streamSettings_.setLan(checkBoxStreamLan_->IsChecked());
+            
+            textCtrlStreamPort_->ChangeValue(boost::lexical_cast<std::string>(port));
+            textCtrlStreamRate_->ChangeValue(boost::lexical_cast<std::string>(rate));
+
+            return true;
+        }
+        else
+        {
+            wxMessageDialog(notebook_, "Not a number!", "Network Preview Error", wxOK | wxICON_ERROR)
+            .ShowModal();
+            textCtrlStreamPort_->ChangeValue(boost::lexical_cast<std::string>(streamSettings_.port()));
+            textCtrlStreamRate_->ChangeValue(boost::lexical_cast<std::string>(streamSettings_.rate()));
+
+            return false;
+        }
+    }
+
+    void CameraPropDialog::onComboBoxStreamScale(wxCommandEvent& WXUNUSED(event))
+    {
+        streamSettings_.setScale(2 << comboBoxStreamScale_->GetCurrentSelection());//1/2, 1/4, 1/8, 1/16
+    }
+
+    StreamSettings CameraPropDialog::streamSettings() const
+    {
+        return streamSettings_;
+    }
+
     void CameraPropDialog::disablePanelPS()
     {
         panelPS_->Disable();
@@ -1496,10 +2639,14 @@ namespace rics
         if (play_)
         {
             disablePanelPS();
+            panelTrigger_->Disable();//trigger mode is set when play is pressed
+            panelStream_->Disable();//as is the network preview
         }
         else
         {
             enablePanelPS();
+            panelTrigger_->Enable();
+            panelStream_->Enable();
         }
     }
 
@@ -1530,17 +2677,41 @@ namespace rics
 
         EVT_CHECKBOX(ID_CheckBoxCameraSelectWB, CameraPropDialog::onCheckBoxCameraSelectWB)
         EVT_COMBOBOX(ID_ComboBoxWB, CameraPropDialog::onComboBoxWB)
+        EVT_COMBOBOX(ID_ComboBoxColour, CameraPropDialog::onComboBoxColour)
+        EVT_BUTTON(ID_ApplyColour, CameraPropDialog::onApplyColour)
+        EVT_COMBOBOX(ID_ComboBoxCrop, CameraPropDialog::onComboBoxCrop)
+        EVT_BUTTON(ID_SaveCrop, CameraPropDialog::onSaveCrop)
         EVT_SLIDER(ID_SliderWBRed, CameraPropDialog::onSliderWBRed)
         EVT_TEXT_ENTER(ID_TxtCtrlWBRed, CameraPropDialog::onTxtCtrlWBRed)
         EVT_SLIDER(ID_SliderWBBlue, CameraPropDialog::onSliderWBBlue)
         EVT_TEXT_ENTER(ID_TxtCtrlWBBlue, CameraPropDialog::onTxtCtrlWBBlue)
         EVT_CHECKBOX(ID_CheckBoxWB, CameraPropDialog::onCheckBoxAutoWB)
 
+        EVT_LISTBOX(ID_ListBoxProfiles, CameraPropDialog::onListBoxProfiles)
+        EVT_LISTBOX_DCLICK(ID_ListBoxProfiles, CameraPropDialog::onApplyProfile)
+        EVT_BUTTON(ID_ApplyProfile, CameraPropDialog::onApplyProfile)
+        EVT_BUTTON(ID_SaveProfile, CameraPropDialog::onSaveProfile)
+        EVT_BUTTON(ID_DeleteProfile, CameraPropDialog::onDeleteProfile)
+
         EVT_SLIDER(ID_SliderFR, CameraPropDialog::onSliderFR)
         EVT_TEXT_ENTER(ID_TxtCtrlFR, CameraPropDialog::onTxtCtrlFR)
+        EVT_SLIDER(ID_SliderPR, CameraPropDialog::onSliderPR)
 
         EVT_SLIDER(ID_SliderPS, CameraPropDialog::onSliderPS)
         EVT_TEXT_ENTER(ID_TxtCtrlPS, CameraPropDialog::onTxtCtrlPS)
+
+        EVT_CHECKBOX(ID_CheckBoxDistance, CameraPropDialog::onCheckBoxDistance)
+        EVT_TEXT_ENTER(ID_TxtCtrlTrigger, CameraPropDialog::onTxtCtrlTrigger)
+        EVT_CHECKBOX(ID_CheckBoxSuppress, CameraPropDialog::onCheckBoxSuppress)
+        EVT_TEXT_ENTER(ID_TxtCtrlKeepInterval, CameraPropDialog::onTxtCtrlKeepInterval)
+        EVT_CHECKBOX(ID_CheckBoxWatchdog, CameraPropDialog::onCheckBoxWatchdog)
+        EVT_TEXT_ENTER(ID_TxtCtrlDeadline, CameraPropDialog::onTxtCtrlDeadline)
+        EVT_CHECKBOX(ID_CheckBoxExposureControl, CameraPropDialog::onCheckBoxExposureControl)
+        EVT_TEXT_ENTER(ID_TxtCtrlBlurBudget, CameraPropDialog::onTxtCtrlBlurBudget)
+        EVT_COMBOBOX(ID_ComboBoxSync, CameraPropDialog::onComboBoxSync)
+        EVT_CHECKBOX(ID_CheckBoxStream, CameraPropDialog::onCheckBoxStream)
+        EVT_TEXT_ENTER(ID_TxtCtrlStream, CameraPropDialog::onTxtCtrlStream)
+        EVT_COMBOBOX(ID_ComboBoxStreamScale, CameraPropDialog::onComboBoxStreamScale)
   
         EVT_CLOSE(CameraPropDialog::onClose)
    END_EVENT_TABLE()
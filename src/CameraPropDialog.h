@@ -26,6 +26,14 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 #define CAMERAPROPDIALOG_H
 
 #include "Camera.h"
+#include "BandwidthAllocator.h"
+#include "DistanceTrigger.h"
+#include "FramePolicy.h"
+#include "Watchdog.h"
+#include "ExposureControl.h"
+#include "CaptureSetCollector.h"
+#include "StreamSettings.h"
+#include "CameraProfiles.h"
 #include <wx/wx.h>
 #include <wx/notebook.h>
 #include <vector>
@@ -41,14 +49,30 @@ namespace rics
         void createExposureTimePage(wxNotebook* notebook);
         void createGainPage(wxNotebook* notebook);
         void createWhiteBalancePage(wxNotebook* notebook);
+        void createColourPage(wxNotebook* notebook);
+        void createCropPage(wxNotebook* notebook);
+        void createProfilePage(wxNotebook* notebook);
         void createFrameRatePage(wxNotebook* notebook_);
         void createPacketSizePage(wxNotebook* notebook_);
+        void createTriggerPage(wxNotebook* notebook_);
+        void createStreamPage(wxNotebook* notebook_);
 
         void disablePanelPS();
         void enablePanelPS();
     
         void setPlay(bool play);
 
+        unsigned long previewRate() const;
+        DistanceTrigger distanceTrigger() const;
+        FramePolicy framePolicy() const;
+        Watchdog watchdog() const;
+        ExposureControl exposureControl() const;
+        SyncMode syncMode() const;
+        bool adaptiveBandwidth() const;
+        StreamSettings streamSettings() const;
+        wxArrayString profileNames() const;
+        bool applyProfile(const wxString& name);
+
     private:
         void onOK(wxCommandEvent& WXUNUSED(event));
         
@@ -84,14 +108,49 @@ namespace rics
         bool txtCtrlWBBlue();
         void onCheckBoxAutoWB(wxCommandEvent& WXUNUSED(event));
 
+        void onComboBoxColour(wxCommandEvent& WXUNUSED(event));
+        void onApplyColour(wxCommandEvent& WXUNUSED(event));
+        void showColour();
+
+        void onComboBoxCrop(wxCommandEvent& WXUNUSED(event));
+        void onSaveCrop(wxCommandEvent& WXUNUSED(event));
+        void showCrop();
+
+        void onListBoxProfiles(wxCommandEvent& WXUNUSED(event));
+        void onApplyProfile(wxCommandEvent& WXUNUSED(event));
+        void onSaveProfile(wxCommandEvent& WXUNUSED(event));
+        void onDeleteProfile(wxCommandEvent& WXUNUSED(event));
+        void refreshProfiles();
+
         void onSliderFR(wxCommandEvent& WXUNUSED(event));
         void onTxtCtrlFR(wxCommandEvent& WXUNUSED(event));
         bool txtCtrlFR();
+        void onSliderPR(wxCommandEvent& WXUNUSED(event));
 
         void onSliderPS(wxCommandEvent& WXUNUSED(event));
         void onTxtCtrlPS(wxCommandEvent& WXUNUSED(event));
         bool txtCtrlPS();
 
+        void onCheckBoxDistance(wxCommandEvent& WXUNUSED(event));
+        void onTxtCtrlTrigger(wxCommandEvent& WXUNUSED(event));
+        bool txtCtrlTrigger();
+        void onCheckBoxSuppress(wxCommandEvent& WXUNUSED(event));
+        void onTxtCtrlKeepInterval(wxCommandEvent& WXUNUSED(event));
+        bool txtCtrlKeepInterval();
+        void onCheckBoxWatchdog(wxCommandEvent& WXUNUSED(event));
+        void onTxtCtrlDeadline(wxCommandEvent& WXUNUSED(event));
+        bool txtCtrlDeadline();
+        void onCheckBoxExposureControl(wxCommandEvent& WXUNUSED(event));
+        void onTxtCtrlBlurBudget(wxCommandEvent& WXUNUSED(event));
+        bool txtCtrlBlurBudget();
+        void onComboBoxSync(wxCommandEvent& WXUNUSED(event));
+        void onCheckBoxStream(wxCommandEvent& WXUNUSED(event));
+        void onTxtCtrlStream(wxCommandEvent& WXUNUSED(event));
+        bool txtCtrlStream();
+        void onComboBoxStreamScale(wxCommandEvent& WXUNUSED(event));
+        bool txtCtrlToneGamma();
+        void adjustCameraPixelFormat();
+
         void onClose(wxCloseEvent& WXUNUSED(event));
 
         void setExposureTime(double value);
@@ -115,6 +174,10 @@ namespace rics
         bool autoWB() const;
         void adjustCameraWB(char* colour);
 
+        CameraSettings settings();
+        void setSettings(const CameraSettings& settings);
+        void showSettings();
+
         void setFrameRate(unsigned long);
         unsigned long frameRate() const;
         void adjustCameraFR();
@@ -147,13 +210,26 @@ namespace rics
         std::vector<unsigned long> whiteBalanceBlue_;
         std::vector<bool> autoWB_;
         unsigned long frameRate_;
+        unsigned long previewRate_;
         unsigned long packetSize_;
+        DistanceTrigger distanceTrigger_;
+        FramePolicy framePolicy_;
+        Watchdog watchdog_;
+        ExposureControl exposureControl_;
+        SyncMode syncMode_;
+        StreamSettings streamSettings_;
+        CameraProfiles profiles_;
         bool play_;
         wxNotebook* notebook_;
 
         wxComboBox* cameraSelectChoiceET_;
         wxComboBox* cameraSelectChoiceGain_;
         wxComboBox* cameraSelectChoiceWB_;
+        wxComboBox* cameraSelectChoiceColour_;
+        wxComboBox* cameraSelectChoiceCrop_;
+        wxComboBox* comboBoxSync_;
+        wxComboBox* comboBoxStreamScale_;
+        wxComboBox* comboBoxPixelFormat_;
 
         wxSlider* sliderET_;
         wxSlider* sliderAMT_;
@@ -161,6 +237,7 @@ namespace rics
         wxSlider* sliderWBRed_;
         wxSlider* sliderWBBlue_;
         wxSlider* sliderFR_;
+        wxSlider* sliderPR_;
         wxSlider* sliderPS_;
         
         wxTextCtrl* textCtrlET_;
@@ -169,7 +246,17 @@ namespace rics
         wxTextCtrl* textCtrlWBRed_;
         wxTextCtrl* textCtrlWBBlue_;
         wxTextCtrl* textCtrlFR_;
+        wxStaticText* textPR_;
         wxTextCtrl* textCtrlPS_;
+        wxTextCtrl* textCtrlInterval_;
+        wxTextCtrl* textCtrlMinRate_;
+        wxTextCtrl* textCtrlMaxRate_;
+        wxTextCtrl* textCtrlKeepInterval_;
+        wxTextCtrl* textCtrlDeadline_;
+        wxTextCtrl* textCtrlBlurBudget_;
+        wxTextCtrl* textCtrlStreamPort_;
+        wxTextCtrl* textCtrlStreamRate_;
+        wxTextCtrl* textCtrlToneGamma_;
 
         wxCheckBox* checkBoxCameraSelectET_;
         wxCheckBox* checkBoxAutoET_;
@@ -177,11 +264,32 @@ namespace rics
         wxCheckBox* checkBoxAutoGain_;
         wxCheckBox* checkBoxCameraSelectWB_;
         wxCheckBox* checkBoxAutoWB_;
+        wxCheckBox* checkBoxDistance_;
+        wxCheckBox* checkBoxSuppress_;
+        wxCheckBox* checkBoxWatchdog_;
+        wxCheckBox* checkBoxExposureControl_;
+        wxCheckBox* checkBoxAdaptiveBandwidth_;
+        wxCheckBox* checkBoxStream_;
+        wxCheckBox* checkBoxStreamLan_;
+        wxCheckBox* checkBoxArchiveRaw_;
+
+        wxTextCtrl* textCtrlColourGains_[3];
+        wxTextCtrl* textCtrlColourMatrix_[3][3];
+        wxTextCtrl* textCtrlGamma_;
+        wxTextCtrl* textCtrlCrop_[4];//left, top, width, height
+        wxStaticText* textCropFrame_;
+
+        wxListBox* listBoxProfiles_;
+        wxTextCtrl* textCtrlProfileName_;
 
         wxPanel* panelFR_;
 
         wxPanel* panelPS_;
 
+        wxPanel* panelTrigger_;
+
+        wxPanel* panelStream_;
+
         enum
         {
             ID_OK = 1,
@@ -206,10 +314,32 @@ namespace rics
             ID_SliderWBBlue,
             ID_TxtCtrlWBBlue,
             ID_CheckBoxWB,
+            ID_ComboBoxColour,
+            ID_ApplyColour,
+            ID_ComboBoxCrop,
+            ID_SaveCrop,
+            ID_ListBoxProfiles,
+            ID_TxtCtrlProfileName,
+            ID_ApplyProfile,
+            ID_SaveProfile,
+            ID_DeleteProfile,
             ID_SliderFR,
             ID_TxtCtrlFR,
+            ID_SliderPR,
             ID_SliderPS,
-            ID_TxtCtrlPS
+            ID_TxtCtrlPS,
+            ID_CheckBoxDistance,
+            ID_TxtCtrlTrigger,
+            ID_CheckBoxSuppress,
+            ID_TxtCtrlKeepInterval,
+            ID_CheckBoxWatchdog,
+            ID_TxtCtrlDeadline,
+            ID_CheckBoxExposureControl,
+            ID_TxtCtrlBlurBudget,
+            ID_ComboBoxSync,
+            ID_CheckBoxStream,
+            ID_TxtCtrlStream,
+            ID_ComboBoxStreamScale
         };
 
         DECLARE_EVENT_TABLE()
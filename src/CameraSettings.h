@@ -0,0 +1,145 @@
+/*
+Author: Nariman Habili
+
+Description: Settings that change with the lighting conditions (exposure,
+             gain and white balance), as held by a camera profile.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CAMERA_SETTINGS_H
+#define CAMERA_SETTINGS_H
+
+namespace rics
+{
+    class CameraSettings
+    {
+    public:
+        CameraSettings():
+        autoExposure_(true),
+        exposureTime_(10000),
+        autoMaxTime_(5000),
+        autoGain_(false),
+        gain_(0),
+        autoWhiteBalance_(false),
+        whiteBalanceRed_(181),
+        whiteBalanceBlue_(202)
+        {
+        }
+
+        ~CameraSettings()
+        {
+        }
+
+        bool autoExposure() const
+        {
+            return autoExposure_;
+        }
+
+        void setAutoExposure(bool autoExposure)
+        {
+            autoExposure_ = autoExposure;
+        }
+
+        //Micro seconds, used when auto exposure is off
+        unsigned long exposureTime() const
+        {
+            return exposureTime_;
+        }
+
+        void setExposureTime(unsigned long exposureTime)
+        {
+            exposureTime_ = exposureTime;
+        }
+
+        //Micro seconds, the longest exposure auto exposure may choose
+        unsigned long autoMaxTime() const
+        {
+            return autoMaxTime_;
+        }
+
+        void setAutoMaxTime(unsigned long autoMaxTime)
+        {
+            autoMaxTime_ = autoMaxTime;
+        }
+
+        bool autoGain() const
+        {
+            return autoGain_;
+        }
+
+        void setAutoGain(bool autoGain)
+        {
+            autoGain_ = autoGain;
+        }
+
+        //dB, used when auto gain is off
+        unsigned long gain() const
+        {
+            return gain_;
+        }
+
+        void setGain(unsigned long gain)
+        {
+            gain_ = gain;
+        }
+
+        bool autoWhiteBalance() const
+        {
+            return autoWhiteBalance_;
+        }
+
+        void setAutoWhiteBalance(bool autoWhiteBalance)
+        {
+            autoWhiteBalance_ = autoWhiteBalance;
+        }
+
+        unsigned long whiteBalanceRed() const
+        {
+            return whiteBalanceRed_;
+        }
+
+        void setWhiteBalanceRed(unsigned long whiteBalanceRed)
+        {
+            whiteBalanceRed_ = whiteBalanceRed;
+        }
+
+        unsigned long whiteBalanceBlue() const
+        {
+            return whiteBalanceBlue_;
+        }
+
+        void setWhiteBalanceBlue(unsigned long whiteBalanceBlue)
+        {
+            whiteBalanceBlue_ = whiteBalanceBlue;
+        }
+
+    private:
+        bool autoExposure_;
+        unsigned long exposureTime_;
+        unsigned long autoMaxTime_;
+        bool autoGain_;
+        unsigned long gain_;
+        bool autoWhiteBalance_;
+        unsigned long whiteBalanceRed_;
+        unsigned long whiteBalanceBlue_;
+    };
+
+}//namespace
+
+#endif //CAMERA_SETTINGS_H
@@ -0,0 +1,203 @@
+/*
+Author: Nariman Habili
+
+Description: Finds the cameras attached to the computer and opens them. The
+             camera list is polled until it settles (or the expected number
+             of cameras appears), then each camera is opened and configured
+             on its own thread. The time taken by each step is kept for the
+             log.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CameraStartup.h"
+#include "BandwidthAllocator.h"
+#include <algorithm>
+
+namespace rics
+{
+    static const long settleTime = 500;//ms the camera count must stay the same
+    static const long pollInterval = 50;
+
+    CameraOpener::CameraOpener(unsigned long uniqueID, unsigned long streamBytesPerSecond):
+    wxThread(wxTHREAD_JOINABLE),
+    uniqueID_(uniqueID),
+    streamBytesPerSecond_(streamBytesPerSecond),
+    time_(0)
+    {
+    }
+
+    CameraOpener::~CameraOpener()
+    {
+    }
+
+    void* CameraOpener::Entry()
+    {
+        wxLongLong start = wxGetLocalTimeMillis();
+
+        tPvHandle handle;
+        if (!PvCameraOpen(uniqueID_, ePvAccessMaster, &handle))
+        {
+            camera_ = boost::shared_ptr<Camera>(new Camera(handle, streamBytesPerSecond_));
+        }
+
+        time_ = (wxGetLocalTimeMillis() - start).ToLong();
+
+        return NULL;
+    }
+
+    //Empty if the camera couldn't be opened.
+    boost::shared_ptr<Camera> CameraOpener::camera() const
+    {
+        return camera_;
+    }
+
+    long CameraOpener::time() const
+    {
+        return time_;
+    }
+
+    //For sorting the cameras based on their unique IDs
+    static bool uniqueIdSort(const tPvCameraInfoEx& camInfo0, const tPvCameraInfoEx& camInfo1)
+    {
+        return camInfo0.UniqueId < camInfo1.UniqueId;
+    }
+
+    CameraStartup::CameraStartup(unsigned long expected, unsigned long timeout):
+    expected_(expected),
+    timeout_(timeout),
+    found_(0),
+    discoveryTime_(0),
+    openTime_(0),
+    slowestCamera_(0),
+    allocateTime_(0)
+    {
+    }
+
+    CameraStartup::~CameraStartup()
+    {
+    }
+
+    //Searches for cameras that are attached to the computer and opens those, ordered
+    //by unique ID. This does not rely on any prior knowledge (ie IP addresses) of the
+    //cameras. The bandwidth is then shared out based on each camera's frame rate and 
+    //frame size. Returns the number of cameras opened.
+    unsigned long CameraStartup::open(Cameras* cameras)
+    {
+        wxLongLong start = wxGetLocalTimeMillis();
+        std::vector<tPvCameraInfoEx> cams = discover();
+        found_ = cams.size();
+        discoveryTime_ = (wxGetLocalTimeMillis() - start).ToLong();
+
+        if (cams.empty())
+        {
+            return 0;//No camera detected
+        }
+
+        //The cameras start with an even share of the bandwidth.
+        start = wxGetLocalTimeMillis();
+        unsigned long streamBytesPerSecond = BandwidthAllocator::maxBytesPerInterface_/cams.size();
+        std::vector<CameraOpener*> openers;
+
+        for (size_t i = 0; i < cams.size(); ++i)
+        {
+            CameraOpener* opener = new CameraOpener(cams[i].UniqueId, streamBytesPerSecond);
+            wxThreadError threadError = opener->Create();
+            assert(threadError == wxTHREAD_NO_ERROR);
+            opener->Run();
+            openers.push_back(opener);
+        }
+
+        unsigned long opened = 0;
+        for (size_t i = 0; i < openers.size(); ++i)
+        {
+            openers[i]->Wait();
+
+            if (openers[i]->camera())
+            {
+                (*cameras).push_back(*openers[i]->camera());
+                (*cameras).back().setInterfaceID(cams[i].InterfaceId);
+                ++opened;
+            }
+            slowestCamera_ = std::max(slowestCamera_, openers[i]->time());
+
+            delete openers[i];
+        }
+        openTime_ = (wxGetLocalTimeMillis() - start).ToLong();
+
+        start = wxGetLocalTimeMillis();
+        BandwidthAllocator().allocate(cameras);
+        allocateTime_ = (wxGetLocalTimeMillis() - start).ToLong();
+
+        return opened;
+    }
+
+    //Cameras announce themselves over a short time after the API is initialised. 
+    //Stops polling once the expected number has appeared, or, if that isn't known,
+    //once the count has stopped changing.
+    std::vector<tPvCameraInfoEx> CameraStartup::discover()
+    {
+        wxLongLong start = wxGetLocalTimeMillis();
+        wxLongLong lastChange = start;
+        unsigned long numCameras = 0;
+
+        while (true)
+        {
+            wxLongLong now = wxGetLocalTimeMillis();
+            unsigned long count = PvCameraCount();
+
+            if (count != numCameras)
+            {
+                numCameras = count;
+                lastChange = now;
+            }
+
+            if (expected_ > 0 && numCameras >= expected_)
+            {
+                break;
+            }
+            if (expected_ == 0 && numCameras > 0 && now - lastChange >= settleTime)
+            {
+                break;
+            }
+            if (now - start >= timeout_)
+            {
+                break;
+            }
+
+            Sleep(pollInterval);
+        }
+
+        std::vector<tPvCameraInfoEx> cams(numCameras);
+        if (numCameras)
+        {
+            numCameras = PvCameraListEx(&cams[0], numCameras, NULL, sizeof(tPvCameraInfoEx));
+            cams.resize(numCameras);
+            std::sort(cams.begin(), cams.end(), uniqueIdSort);
+        }
+
+        return cams;
+    }
+
+    wxString CameraStartup::timing() const
+    {
+        return wxString::Format(_("Camera startup: discovery %ld ms (%lu found), open and configure %ld ms (slowest camera %ld ms), bandwidth %ld ms."),
+                                discoveryTime_, found_, openTime_, slowestCamera_, allocateTime_);
+    }
+
+} //namespace
@@ -0,0 +1,83 @@
+/*
+Author: Nariman Habili
+
+Description: Finds the cameras attached to the computer and opens them. The
+             camera list is polled until it settles (or the expected number
+             of cameras appears), then each camera is opened and configured
+             on its own thread. The time taken by each step is kept for the
+             log.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CAMERA_STARTUP_H
+#define CAMERA_STARTUP_H
+
+#include "Camera.h"
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+namespace rics
+{
+    //Opens and configures one camera.
+    class CameraOpener : public wxThread
+    {
+    public:
+        CameraOpener(unsigned long uniqueID, unsigned long streamBytesPerSecond);
+        ~CameraOpener();
+
+        void* Entry();
+
+        boost::shared_ptr<Camera> camera() const;
+        long time() const;
+
+    private:
+        unsigned long uniqueID_;
+        unsigned long streamBytesPerSecond_;
+        boost::shared_ptr<Camera> camera_;
+        long time_;//ms
+    };
+
+    class CameraStartup
+    {
+    public:
+        CameraStartup(unsigned long expected = 0, unsigned long timeout = 5000);
+        ~CameraStartup();
+
+        unsigned long open(Cameras* cameras);
+        wxString timing() const;
+
+    private:
+        std::vector<tPvCameraInfoEx> discover();
+
+    private:
+        unsigned long expected_;//0 if not known
+        unsigned long timeout_;//ms
+
+        unsigned long found_;
+        long discoveryTime_;
+        long openTime_;
+        long slowestCamera_;
+        long allocateTime_;
+    };
+
+} //namespace
+
+#endif //CAMERA_STARTUP_H
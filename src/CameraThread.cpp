@@ -22,23 +22,37 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "CameraThread.h"
+#include <wx/filename.h>
+#include <algorithm>
 
 namespace rics
 {
+    static const long pixelFormatLogInterval = 60000;//ms
+
     CameraThread::CameraThread()
     {
     }
     
-    CameraThread::CameraThread(wxWindow* canvas, 
-                               Camera* camera, 
+    CameraThread::CameraThread(Camera* camera, 
                                SharedImageBufferPtr buffer, 
-                               int panel,
-                               Session* const session):
-    canvas_(canvas),
+                               SharedGPSDataPtr gpsData,
+                               Database* db,
+                               Session* const session,
+                               const FramePolicy& policy,
+                               CaptureSetCollectorPtr captureSets):
     camera_(camera),
     buffer_(buffer),
-    panel_(panel),
-    session_(session)
+    gpsData_(gpsData),
+    db_(db),
+    session_(session),
+    policy_(policy),
+    captureSets_(captureSets),
+    streamScale_(1),
+    streamInterval_(0),
+    lastStream_(0),
+    unpluggedSince_(0),
+    reconnectAttempts_(0),
+    lastPixelFormatLog_(0)
     {
     }
 
@@ -46,34 +60,433 @@ namespace rics
     {
     }
 
+    //Also feed the network preview stream, with images 1/scale of the camera
+    //resolution at up to "rate" frames/sec. Must be called before Run.
+    void CameraThread::setStream(SharedImageBufferPtr buffer, unsigned long scale, unsigned long rate)
+    {
+        streamBuffer_ = buffer;
+        streamScale_ = scale;
+        streamInterval_ = 1000/std::max(rate, 1UL);
+        streamImage_.resize(buffer->size());
+    }
+
+    //Restart the camera when it stops sending frames. Must be called before Run.
+    void CameraThread::setWatchdog(const Watchdog& watchdog)
+    {
+        watchdog_ = watchdog;
+    }
+
+    //Exposure and gain are set from the preview images. Must be called before Run.
+    void CameraThread::setExposureControl(const ExposureControl& exposureControl)
+    {
+        exposureControl_ = exposureControl;
+    }
+
+    //The thread never waits on the GUI. The preview image is left in buffer_
+    //and picked up by the canvas on its own refresh tick.
+    //The wait for a frame is bounded so the thread can still be deleted when
+    //no frames arrive, eg a stationary vehicle in distance based capture mode.
     void* CameraThread::Entry()
     {
+        watchdog_.start(wxGetLocalTimeMillis(), camera_->frameRate());
+
         while (!TestDestroy())
         {
-            buffer_->writeLock();
-            buffer_->setData(camera_->getNextFrame()); 
-            wxCommandEvent event(wxEVT_COMMAND_MENU_SELECTED, CAMERA_EVENT);
-            event.SetInt(panel_);
-            event.SetExtraLong(camera_->frameNumber());
-            wxPostEvent(canvas_, event);
-            buffer_->writeUnlock();
+            if (camera_->unplugged())
+            {
+                waitForCamera();
+                continue;
+            }
+
+            camera_->applyPacketSize();
+
+            UCArray frame = camera_->getNextFrame(500);
+            wxLongLong now = wxGetLocalTimeMillis();
+            if (!frame)
+            {
+                if (watchdog_.recoveryDue(now))
+                {
+                    watchdog_.recoveryAttempted(now, camera_->recover());
+                }
+                continue;
+            }
+
+            if (watchdog_.stalled())
+            {
+                writeRecovery(now, "recovered");
+            }
+            watchdog_.frameArrived(now);
+
+            if (now - lastPixelFormatLog_ >= pixelFormatLogInterval)
+            {
+                writePixelFormat();
+                lastPixelFormatLog_ = now;
+            }
+
+            buffer_->write(frame.get());
+
+            if (exposureControl_.enabled())
+            {
+                controlExposure(frame.get());
+            }
+
+            //Only as often as the stream needs it, so the full frame isn't walked every time.
+            if (streamBuffer_)
+            {
+                if (now - lastStream_ >= streamInterval_)
+                {
+                    camera_->streamImage(&streamImage_[0], streamScale_);
+                    streamBuffer_->write(&streamImage_[0]);
+                    lastStream_ = now;
+                }
+            }
 
             if (session_->saveImages())
             {
-#if USE_JPEG_TURBO
-                camera_->saveImageTurbo();
-#else
-                camera_->saveImageWX();
-#endif
+                //In synchronised mode the frame number is the capture set ID, so 
+                //frames from the same trigger share a number across cameras.
+                //Frames are not thinned as that would break up the sets.
+                long setID = 0;
+                if (captureSets_)
+                {
+                    setID = captureSets_->setID(camera_->uniqueID(), camera_->frameCount());
+                    camera_->setFrameNumber(setID);
+                }
+                else if (!keepFrame(frame.get()))
+                {
+                    camera_->frameDone();
+                    continue;
+                }
+
+                LARGE_INTEGER start;
+                QueryPerformanceCounter(&start);
+
+                bool saved = saveFrame();
+                camera_->saveThumbnails();
+
+                LARGE_INTEGER end;
+                LARGE_INTEGER frequency;
+                QueryPerformanceCounter(&end);
+                QueryPerformanceFrequency(&frequency);
+                camera_->saveDone(1000.0*(end.QuadPart - start.QuadPart)/frequency.QuadPart);
+
+                if (saved && session_->createDB())
+                {
+                    db_->databaseEnterFramePath(camera_->cameraName(), camera_->frameNumber(), camera_->frameName().c_str());
+                }
+                recoverWrites();
+
+                if (captureSets_)
+                {
+                    captureSets_->addFrame(setID, session_->createDB());
+                }
+                else if (session_->createDB())
+                {
+                    writeDatabase();
+                }
+
                 camera_->incFrameNumber();
             }
+
+            camera_->frameDone();
         }
 
         return NULL;
     }
 
+    //Log any frames dropped, or a stall still going on, just before the thread was stopped.
     void CameraThread::OnExit()
     {
+        //JPEGs that fail now are written again on another volume, until none are left.
+        camera_->flushImages();
+        while (recoverWrites())
+        {
+            camera_->flushImages();
+        }
+        writeDropped();
+
+        if (watchdog_.stalled())
+        {
+            writeRecovery(wxGetLocalTimeMillis(), "stopped while stalled");
+        }
+
+        if (camera_->unplugged() && unpluggedSince_ != 0)
+        {
+            writeUnplugged(wxGetLocalTimeMillis(), "stopped while unplugged");
+        }
+    }
+
+    //The other cameras, GPS and database carry on while this one is unplugged. 
+    //When it is plugged back in it is re-opened here, and frame numbers carry 
+    //on from the database.
+    void CameraThread::waitForCamera()
+    {
+        wxLongLong now = wxGetLocalTimeMillis();
+        if (unpluggedSince_ == 0)
+        {
+            unpluggedSince_ = now;
+            reconnectAttempts_ = 0;
+        }
+
+        if (!camera_->reconnectRequested())
+        {
+            Sleep(100);
+            return;
+        }
+
+        ++reconnectAttempts_;
+        if (!camera_->reconnect())
+        {
+            camera_->requestReconnect();//try again
+            Sleep(1000);
+            return;
+        }
+
+        now = wxGetLocalTimeMillis();
+        writeUnplugged(now, "reconnected");
+        unpluggedSince_ = 0;
+
+        if (!captureSets_ && session_->createDB())
+        {
+            camera_->setFrameNumber(db_->nextFrame(camera_->cameraName()));
+        }
+
+        //The camera's frame counter has started again. Its first frame joins the set
+        //after the newest one the other cameras have reached.
+        if (captureSets_)
+        {
+            captureSets_->resetCamera(camera_->uniqueID(), captureSets_->newestSet() + 1);
+        }
+
+        watchdog_.start(now, camera_->frameRate());
+    }
+
+    //Unplugged periods go in the same table as stalls.
+    void CameraThread::writeUnplugged(wxLongLong now, const wxString& result)
+    {
+        if (session_->createDB())
+        {
+            wxString cameraID = boost::lexical_cast<std::string>(camera_->uniqueID());
+            db_->databaseEnterRecovery(cameraID, 
+                                       (unpluggedSince_/1000).ToLong(),
+                                       (now/1000).ToLong(),
+                                       (now - unpluggedSince_).GetLo(),
+                                       reconnectAttempts_,
+                                       reconnectAttempts_ > 0 ? reconnectAttempts_ - 1 : 0,
+                                       "unplugged, " + result);
+        }
+    }
+
+    //Ask the frame policy whether this frame is saved. When saving resumes after
+    //a run of dropped frames, the run is logged to the database.
+    bool CameraThread::keepFrame(const unsigned char* preview)
+    {
+        if (!policy_.enabled())
+        {
+            return true;
+        }
+
+        gpsData_->readLock();
+        double speed = gpsData_->speed() == "--" ? -1.0 : gpsData_->speedKmh();
+        wxString timeStamp = gpsData_->timeStamp();
+        gpsData_->readUnlock();
+
+        if (!policy_.keepFrame(preview, buffer_->size(), speed, wxGetLocalTimeMillis()))
+        {
+            if (policy_.dropped() == 1)
+            {
+                dropStart_ = timeStamp;
+            }
+            dropEnd_ = timeStamp;
+
+            return false;
+        }
+
+        writeDropped();
+
+        return true;
+    }
+
+    //The new exposure is written to the camera straight away, between frames. Only
+    //the attributes that changed are written.
+    void CameraThread::controlExposure(const unsigned char* preview)
+    {
+        gpsData_->readLock();
+        double speed = gpsData_->speed() == "--" ? -1.0 : gpsData_->speedKmh();
+        gpsData_->readUnlock();
+
+        CameraSettings settings = camera_->settings();
+        if (settings.autoExposure())
+        {
+            //Start from where the camera's auto exposure left off.
+            settings.setExposureTime(std::max(camera_->exposureTime(), 1UL));
+        }
+
+        if (exposureControl_.update(preview, buffer_->size(), speed, &settings))
+        {
+            camera_->applyExposure(settings.autoExposure(), settings.exposureTime(), settings.autoGain(), settings.gain());
+        }
+    }
+
+    void CameraThread::writeDropped()
+    {
+        if (policy_.dropped() > 0 && session_->createDB())
+        {
+            wxString cameraID = boost::lexical_cast<std::string>(camera_->uniqueID());
+            db_->databaseEnterDropped(cameraID, dropStart_, dropEnd_, policy_.dropped(), policy_.dropReason());
+        }
+
+        policy_.clearDropped();
+    }
+
+    //One row per stall, written when frames resume (or capture stops).
+    void CameraThread::writeRecovery(wxLongLong now, const wxString& result)
+    {
+        if (session_->createDB())
+        {
+            wxString cameraID = boost::lexical_cast<std::string>(camera_->uniqueID());
+            db_->databaseEnterRecovery(cameraID, 
+                                       (watchdog_.lastFrame()/1000).ToLong(),
+                                       (now/1000).ToLong(),
+                                       watchdog_.downtime(now).GetLo(),
+                                       watchdog_.attempts(),
+                                       watchdog_.failures(),
+                                       result);
+        }
+    }
+
+    //So the bandwidth and PC time of each pixel format can be compared between deployments.
+    void CameraThread::writePixelFormat()
+    {
+        if (session_->createDB())
+        {
+            wxString cameraID = boost::lexical_cast<std::string>(camera_->uniqueID());
+            db_->databaseEnterPixelFormat(cameraID,
+                                          camera_->pixelFormat(),
+                                          camera_->totalBytesPerFrame(),
+                                          camera_->actualFrameRate(),
+                                          camera_->convertTime(),
+                                          camera_->archiveRaw());
+        }
+    }
+
+    //Write the JPEG (and PGM) of the frame to the next of the session's volumes. If 
+    //the write fails the volume is taken out of use and the next one is tried.
+    bool CameraThread::saveFrame()
+    {
+        SessionVolumesPtr volumes = session_->volumes();
+        size_t attempts = volumes ? volumes->numVolumes() : 1;
+
+        for (size_t i = 0; i < attempts; ++i)
+        {
+            size_t volume = SessionVolumes::npos;
+            if (volumes)
+            {
+                volume = volumes->next(camera_->cameraName());
+                if (volume == SessionVolumes::npos)
+                {
+                    return false;
+                }
+                camera_->setFramePath(volumes->cameraDir(volume, camera_->cameraName()));
+            }
+
+#if USE_JPEG_TURBO
+            bool saved = camera_->saveImageTurbo();
+#else
+            bool saved = camera_->saveImageWX();
+#endif
+            if (saved)
+            {
+                camera_->saveRawImage();
+                return true;
+            }
+
+            if (!volumes)
+            {
+                return false;
+            }
+            volumes->failed(volume, "write error " + wxString(camera_->lastWriteFailure().c_str()));
+        }
+
+        return false;
+    }
+
+    //JPEGs the image writer couldn't write are still in memory. The volume each was on
+    //is taken out of use and the JPEG is queued again in the camera's directory on 
+    //the next volume, and its frame_paths row moved with it. With no volume left the 
+    //JPEG is dropped and its row marked lost. True if any were queued again.
+    bool CameraThread::recoverWrites()
+    {
+        std::vector<std::string> paths = camera_->failedWrites();
+        SessionVolumesPtr volumes = session_->volumes();
+        bool requeued = false;
+
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            std::string newPath;
+            if (volumes)
+            {
+                wxString name = "\\" + wxFileName(paths[i].c_str()).GetFullName();
+                for (size_t v = 0; v < volumes->numVolumes(); ++v)
+                {
+                    if (wxString(paths[i].c_str()).StartsWith(volumes->cameraDir(v, camera_->cameraName()) + "\\"))
+                    {
+                        volumes->failed(v, "write error " + wxString(paths[i].c_str()));
+                    }
+                }
+
+                size_t volume = volumes->next(camera_->cameraName());
+                if (volume != SessionVolumes::npos)
+                {
+                    newPath = (volumes->cameraDir(volume, camera_->cameraName()) + name).c_str();
+                }
+            }
+
+            if (!newPath.empty() && camera_->rewriteImage(paths[i], newPath))
+            {
+                requeued = true;
+            }
+            else
+            {
+                camera_->discardImage(paths[i]);
+                newPath.clear();
+            }
+
+            if (session_->createDB())
+            {
+                db_->databaseMoveFramePath(camera_->cameraName(), paths[i].c_str(), newPath.c_str());
+            }
+        }
+
+        return requeued;
+    }
+
+    //Write the GPS data for the current frame to the database.
+    void CameraThread::writeDatabase()
+    {
+        gpsData_->readLock();
+        wxString timeStamp = gpsData_->timeStamp();
+        wxString lat = gpsData_->latitude();
+        wxString lon = gpsData_->longitude();
+        wxString speed = gpsData_->speed();
+        wxString bear = gpsData_->bearing();
+        wxString satellites = gpsData_->satellites();
+        wxString quality = gpsData_->quality();
+        gpsData_->readUnlock();
+
+        wxString cameraID = boost::lexical_cast<std::string>(camera_->uniqueID());
+        db_->databaseEnterData(camera_->cameraName(), 
+                               camera_->frameNumber(),
+                               timeStamp, 
+                               lat, 
+                               lon, 
+                               speed,
+                               bear,
+                               satellites,
+                               quality,
+                               cameraID,
+                               camera_->measureSharpness(),
+                               camera_->crop());
     }
 
 }//namespace
\ No newline at end of file
@@ -26,10 +26,17 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 #define USE_JPEG_TURBO 1
 
 #include "SharedImageBuffer.h"
+#include "SharedGPSData.h"
 #include "Camera.h"
 #include "Session.h"
+#include "Database.h"
+#include "FramePolicy.h"
+#include "Watchdog.h"
+#include "ExposureControl.h"
+#include "CaptureSetCollector.h"
 #include <wx/wx.h>
 #include <wx/thread.h>
+#include <vector>
 
 namespace rics
 {
@@ -37,29 +44,57 @@ namespace rics
     {
     public:
         CameraThread();
-        CameraThread(wxWindow* canvas, 
-                     Camera* camera, 
+        CameraThread(Camera* camera, 
                      SharedImageBufferPtr buffer, 
-                     int panel,
-                     Session* const session);
+                     SharedGPSDataPtr gpsData,
+                     Database* db,
+                     Session* const session,
+                     const FramePolicy& policy,
+                     CaptureSetCollectorPtr captureSets);
         ~CameraThread();
 
+        void setStream(SharedImageBufferPtr buffer, unsigned long scale, unsigned long rate);
+        void setWatchdog(const Watchdog& watchdog);
+        void setExposureControl(const ExposureControl& exposureControl);
+
         void* Entry();
 
         void OnExit();
 
-    public:
-        enum
-        {
-            CAMERA_EVENT = 0
-        };
+    private:
+        void writeDatabase();
+        bool saveFrame();
+        bool recoverWrites();
+        bool keepFrame(const unsigned char* preview);
+        void controlExposure(const unsigned char* preview);
+        void writeDropped();
+        void writeRecovery(wxLongLong now, const wxString& result);
+        void writePixelFormat();
+        void waitForCamera();
+        void writeUnplugged(wxLongLong now, const wxString& result);
     
     private:
-        wxWindow* canvas_;
         Camera* camera_;
         SharedImageBufferPtr buffer_;
-        int panel_;
+        SharedGPSDataPtr gpsData_;
+        Database* db_;
         Session* session_;
+        FramePolicy policy_;
+        CaptureSetCollectorPtr captureSets_;
+        wxString dropStart_;
+        wxString dropEnd_;
+
+        SharedImageBufferPtr streamBuffer_;
+        unsigned long streamScale_;
+        unsigned long streamInterval_;
+        wxLongLong lastStream_;
+        std::vector<unsigned char> streamImage_;
+
+        Watchdog watchdog_;
+        ExposureControl exposureControl_;
+        wxLongLong unpluggedSince_;
+        unsigned long reconnectAttempts_;
+        wxLongLong lastPixelFormatLog_;
 
     };
 } //namespace
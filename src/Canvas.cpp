@@ -45,10 +45,12 @@ namespace rics
     gps_(gps),
     session_(session),
     numCameras_((*cameras_).size()),
-    cameraBuffers_(boost::shared_array<SharedImageBufferPtr>(new SharedImageBufferPtr[numCameras_])),
-    cameraThreads_(boost::shared_array<CameraThread*>(new CameraThread*[numCameras_])),
-    gpsThread_(boost::shared_ptr<GPSThread*>(new GPSThread*)),
+    engine_(cameras, gps, session, db),
+    gpsData_(engine_.gpsData()),
     play_(false),
+    previewTimer_(this, ID_Timer),
+    previewRate_(5),
+    previewFrames_(numCameras_, 0),
     createDB_(false),
     firstTime_(true),
     latSexagesimal_("--"),
@@ -66,30 +68,26 @@ namespace rics
     {
         wxBoxSizer* topSizer = new wxBoxSizer(wxVERTICAL);
 
-        //Assigning camera names for the display panel based on their unique ID.
-        wxString cameraName[4] = {"Camera: None", "Camera: None", "Camera: None", "Camera: None"};
-        for (size_t i = 0; i < numCameras_; ++i)
+        //Panels where images are painted, one per camera. Unused places in the 
+        //grid are filled with empty panels.
+        wxSize grid = panelGrid(numCameras_);
+        wxGridSizer* panelSizer = new wxGridSizer(grid.GetHeight(), grid.GetWidth(), 1, 1); 
+        
+        for (int i = 0; i < grid.GetWidth()*grid.GetHeight(); ++i)
         {
-            cameraName[i] = "Camera: " + 
-                            boost::lexical_cast<std::string>((*cameras_)[i].uniqueID()) + 
-                            " (" + (*cameras_)[i].cameraName() + ")";
+            //Assigning camera names for the display panel based on their unique ID.
+            wxString cameraName = "Camera: None";
+            if (static_cast<size_t>(i) < numCameras_)
+            {
+                cameraName = "Camera: " + 
+                             boost::lexical_cast<std::string>((*cameras_)[i].uniqueID()) + 
+                             " (" + (*cameras_)[i].cameraName() + ")";
+            }
+
+            ImagePanel* panel = new ImagePanel(this, wxID_ANY, cameraName, wxDefaultPosition, wxSize(204, 170));
+            panels_.push_back(panel);
+            panelSizer->Add(panel, 0, wxFIXED_MINSIZE);
         }
-        
-        //Panel where images are painted
-        wxGridSizer* panelSizer = new wxGridSizer(2, 2, 0, 0); 
-        panel1_ = new ImagePanel(this, wxID_ANY, cameraName[0], wxDefaultPosition, wxSize(204, 170));
-        panel2_ = new ImagePanel(this, wxID_ANY, cameraName[1], wxDefaultPosition, wxSize(204, 170));
-        panel3_ = new ImagePanel(this, wxID_ANY, cameraName[2], wxDefaultPosition, wxSize(204, 170));
-        panel4_ = new ImagePanel(this, wxID_ANY, cameraName[3], wxDefaultPosition, wxSize(204, 170));       
-        
-        panels_.push_back(panel1_);
-        panels_.push_back(panel2_);
-        panels_.push_back(panel3_);
-        panels_.push_back(panel4_);
-        panelSizer->Add(panel1_, 0, wxFIXED_MINSIZE  | wxRIGHT | wxBOTTOM, 1);
-        panelSizer->Add(panel2_, 0, wxFIXED_MINSIZE);
-        panelSizer->Add(panel3_, 0, wxFIXED_MINSIZE);
-        panelSizer->Add(panel4_, 0, wxFIXED_MINSIZE);
 
         //gps data display
         wxStaticText* gpsText = new wxStaticText(this, wxID_ANY, wxT("Current GPS Data"), wxDefaultPosition, wxDefaultSize, 0);
@@ -204,72 +202,55 @@ namespace rics
 
         for (size_t i = 0; i < numCameras_; ++i)
         {
-            cameraBuffers_[i] = SharedImageBufferPtr(new SharedImageBuffer());
+            size_t previewSize = engine_.buffer(i)->size();
+            
+            if (previewSize > previewImage_.size())
+            {
+                previewImage_.resize(previewSize);
+            }
         }
 
-        gpsData_ = SharedGPSDataPtr(new SharedGPSData());
-
         //GPS thread creation and Run.
-        GPSThread* gpsThread = new GPSThread(this, gps_, gpsData_);
-        wxThreadError threadError = gpsThread->Create();
-        assert(threadError == wxTHREAD_NO_ERROR);
-        *gpsThread_ = gpsThread;
-        (*gpsThread_)->Run();
+        engine_.startGPS(this);
     }
 
     Canvas::~Canvas()
     {
     }
 
-    //Delete all camera threads.
-    inline void Canvas::deleteCameraThreads()
+    void Canvas::deleteAllThreads()
     {
-        if (play_)
+        engine_.deleteAllThreads();
+    }
+
+    //Refresh GUI images from streamed cameras. Runs at the preview rate regardless
+    //of the camera frame rate; only panels with a new frame are redrawn.
+    void Canvas::onPreviewTimer(wxTimerEvent& WXUNUSED(event))
+    {
+        for (size_t i = 0; i < numCameras_; ++i)
         {
-            for (size_t i = 0; i < numCameras_; ++i)
+            if (engine_.buffer(i)->read(&previewImage_[0], previewFrames_[i]))
             {
-                cameraThreads_[i]->Delete();
+                panels_[i]->updateImage(&previewImage_[0], 
+                                        (*cameras_)[i].previewWidth(), 
+                                        (*cameras_)[i].previewHeight());
             }
         }
     }
 
-    //Delete the GPS thread.
-    inline void Canvas::deleteGPSThread()
+    void Canvas::setPreviewRate(unsigned long rate)
     {
-        (*gpsThread_)->Delete();
-    }
+        if (rate == 0 || rate == previewRate_)
+        {
+            return;
+        }
 
-    void Canvas::deleteAllThreads()
-    {
-        deleteCameraThreads();
-        deleteGPSThread();
-    }
+        previewRate_ = rate;
 
-    //Refresh GUI image from streamed cameras and write GPS data to database
-    void Canvas::onCameraEvent(wxCommandEvent& event)
-    {
-        //write GPS data to database
-        if (session_->createDB())
+        if (play_)
         {
-            wxString cameraName = (*cameras_)[event.GetInt()].cameraName();
-            wxString cameraID = boost::lexical_cast<std::string>((*cameras_)[event.GetInt()].uniqueID());
-            db_->databaseEnterData(cameraName, 
-                                   event.GetExtraLong(),
-                                   timeStamp_, 
-                                   lat_, 
-                                   lon_, 
-                                   speed_,
-                                   bear_,
-                                   satellites_,
-                                   quality_,
-                                   cameraID);
+            previewTimer_.Start(1000/previewRate_);
         }
-
-        cameraBuffers_[event.GetInt()]->readLock();
-        UCArray bmpBuffer = cameraBuffers_[event.GetInt()]->data();
-        wxImage image(204, 170, (unsigned char*)bmpBuffer.get(), true);
-        panels_[event.GetInt()]->refreshImage(wxBitmap(image));
-        cameraBuffers_[event.GetInt()]->readUnlock();
     }
 
     //Refresh GPS data on GUI
@@ -299,6 +280,48 @@ namespace rics
         gpsData_->readUnlock();
     }
 
+    //Takes effect the next time play is pressed.
+    void Canvas::setDistanceTrigger(const DistanceTrigger& trigger)
+    {
+        engine_.setDistanceTrigger(trigger);
+    }
+
+    //Takes effect the next time play is pressed.
+    void Canvas::setFramePolicy(const FramePolicy& policy)
+    {
+        engine_.setFramePolicy(policy);
+    }
+
+    //Takes effect the next time play is pressed.
+    void Canvas::setWatchdog(const Watchdog& watchdog)
+    {
+        engine_.setWatchdog(watchdog);
+    }
+
+    //Takes effect the next time play is pressed.
+    void Canvas::setExposureControl(const ExposureControl& exposureControl)
+    {
+        engine_.setExposureControl(exposureControl);
+    }
+
+    //Takes effect the next time play is pressed.
+    void Canvas::setSyncMode(SyncMode mode)
+    {
+        engine_.setSyncMode(mode);
+    }
+
+    //Takes effect the next time play is pressed.
+    void Canvas::setAdaptiveBandwidth(bool adaptive)
+    {
+        engine_.setAdaptiveBandwidth(adaptive);
+    }
+
+    //Takes effect the next time play is pressed.
+    void Canvas::setStreamSettings(const StreamSettings& settings)
+    {
+        engine_.setStreamSettings(settings);
+    }
+
     ////////////////////////////////////////////////////////////////////////////////////////////////////    
     ////////Buttons appearing on canvas
     
@@ -322,15 +345,9 @@ namespace rics
                 return false;
             }
             
-            for (size_t i = 0; i < numCameras_; ++i)
-            {
-                CameraThread* cameraThread = new CameraThread(this, &((*cameras_)[i]), cameraBuffers_[i], (int)i, session_);
-                wxThreadError threadError = cameraThread->Create();
-                assert(threadError == wxTHREAD_NO_ERROR);
-                cameraThreads_[i] = cameraThread;
-                (*cameras_)[i].startStream();
-                cameraThreads_[i]->Run();
-            }
+            engine_.start();
+
+            previewTimer_.Start(1000/previewRate_);
 
             play_ = true;
 
@@ -345,18 +362,14 @@ namespace rics
     {
         if (play_)
         {
-            deleteCameraThreads();
+            engine_.stop();
+            previewTimer_.Stop();
             
-            panel1_->refreshImage(wxBitmap(204, 170, -1));
-            panel2_->refreshImage(wxBitmap(204, 170, -1));
-            panel3_->refreshImage(wxBitmap(204, 170, -1));
-            panel4_->refreshImage(wxBitmap(204, 170, -1));
-
-            for (size_t i = 0; i < numCameras_; ++i)
+            for (size_t i = 0; i < panels_.size(); ++i)
             {
-                (*cameras_)[i].stopStream();
+                panels_[i]->clearImage();
             }
-            
+
             play_ = false;
 
             return true;
@@ -365,6 +378,18 @@ namespace rics
         return false;
     }
 
+    //Columns (width) and rows (height) of the preview panel grid. Up to four cameras 
+    //are shown 2x2, more cameras are shown four to a row.
+    wxSize Canvas::panelGrid(size_t numCameras)
+    {
+        if (numCameras <= 4)
+        {
+            return wxSize(2, 2);
+        }
+
+        return wxSize(4, static_cast<int>((numCameras + 3)/4));
+    }
+
     ////////////////////////////////////////////////////////////////////////////////////////////////////    
     ////////Camera Names
     void Canvas::setCameraNames()
@@ -378,7 +403,7 @@ namespace rics
     }
 
    BEGIN_EVENT_TABLE(Canvas, wxPanel)
-        EVT_MENU(CameraThread::CAMERA_EVENT, Canvas::onCameraEvent)
+        EVT_TIMER(ID_Timer, Canvas::onPreviewTimer)
         EVT_MENU(GPSThread::GPS_EVENT, Canvas::onGPSEvent )
    END_EVENT_TABLE()
 
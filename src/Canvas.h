@@ -27,23 +27,17 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "ImagePanel.h"
 #include "Camera.h"
-#include "CameraThread.h"
-#include "GPSThread.h"
-#include "SharedImageBuffer.h"
-#include "SharedGPSData.h"
+#include "CaptureEngine.h"
 #include "Session.h"
 #include "Database.h"
 #include "NotePad.h"
 #include <wx/wx.h>
 #include <wx/file.h>
 #include <wx/thread.h>
-#include <boost/shared_array.hpp>
-#include <boost/shared_ptr.hpp>
+#include <wx/timer.h>
 
 namespace rics
 {
-    class CameraThread;
-
     class Canvas: public wxPanel
     {
     public:
@@ -63,6 +57,15 @@ namespace rics
         bool stop();
 
         void setCameraNames();
+        static wxSize panelGrid(size_t numCameras);
+        void setPreviewRate(unsigned long rate);
+        void setDistanceTrigger(const DistanceTrigger& trigger);
+        void setFramePolicy(const FramePolicy& policy);
+        void setWatchdog(const Watchdog& watchdog);
+        void setExposureControl(const ExposureControl& exposureControl);
+        void setSyncMode(SyncMode mode);
+        void setAdaptiveBandwidth(bool adaptive);
+        void setStreamSettings(const StreamSettings& settings);
         
     public:
         enum
@@ -72,12 +75,9 @@ namespace rics
         };
 
     private:
-        void onCameraEvent(wxCommandEvent& event);
+        void onPreviewTimer(wxTimerEvent& WXUNUSED(event));
         void onGPSEvent(wxCommandEvent& WXUNUSED(event));
 
-        inline void deleteCameraThreads();
-        inline void deleteGPSThread();
-    
     private:        
         Cameras* cameras_;
         size_t numCameras_;
@@ -85,24 +85,21 @@ namespace rics
         GPS* gps_;
         Session* session_;
 
-        boost::shared_array<SharedImageBufferPtr> cameraBuffers_;
-        boost::shared_array<CameraThread*> cameraThreads_;
-
+        CaptureEngine engine_;
         SharedGPSDataPtr gpsData_;
-        boost::shared_ptr<GPSThread*> gpsThread_;
         
         bool play_;
+
+        wxTimer previewTimer_;
+        unsigned long previewRate_;
+        std::vector<unsigned long> previewFrames_;
+        std::vector<unsigned char> previewImage_;
         
         bool createDB_;
         bool firstTime_;
 
         wxToolBar* playToolBar_;
         
-        ImagePanel* panel1_;
-        ImagePanel* panel2_;
-        ImagePanel* panel3_;
-        ImagePanel* panel4_;
-
         wxStaticText* latitudeValue_;
         wxStaticText* longitudeValue_;
         wxStaticText* bearValue_;
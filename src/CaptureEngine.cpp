@@ -0,0 +1,355 @@
+/*
+Author: Nariman Habili
+
+Description: The capture pipeline without any GUI: camera, GPS, trigger and
+             bandwidth threads, the preview buffers and the session database.
+             Used by the canvas in RICS and by the headless capture daemon.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CaptureEngine.h"
+#include <cassert>
+
+namespace rics
+{
+    CaptureEngine::CaptureEngine(Cameras* cameras, GPS* gps, Session* session, Database* db):
+    cameras_(cameras),
+    numCameras_((*cameras).size()),
+    gps_(gps),
+    session_(session),
+    db_(db),
+    cameraBuffers_(numCameras_),
+    cameraThreads_(numCameras_, static_cast<CameraThread*>(NULL)),
+    gpsData_(SharedGPSDataPtr(new SharedGPSData())),
+    gpsThread_(NULL),
+    triggerThread_(NULL),
+    syncMode_(SYNC_NONE),
+    adaptiveBandwidth_(true),
+    bandwidthController_(NULL),
+    mjpegServer_(NULL),
+    play_(false)
+    {
+        for (size_t i = 0; i < numCameras_; ++i)
+        {
+            size_t previewSize = 3*(*cameras_)[i].previewWidth()*(*cameras_)[i].previewHeight();
+            cameraBuffers_[i] = SharedImageBufferPtr(new SharedImageBuffer(previewSize));
+        }
+    }
+
+    CaptureEngine::~CaptureEngine()
+    {
+    }
+
+    //The GPS thread runs for the life of the program, not just while playing.
+    //A GPS event is posted to handler after every read; handler may be NULL
+    //when there is no GUI.
+    void CaptureEngine::startGPS(wxEvtHandler* handler)
+    {
+        gpsThread_ = new GPSThread(handler, gps_, gpsData_);
+        wxThreadError threadError = gpsThread_->Create();
+        assert(threadError == wxTHREAD_NO_ERROR);
+        gpsThread_->Run();
+    }
+
+    //Delete all camera threads.
+    inline void CaptureEngine::deleteCameraThreads()
+    {
+        if (play_)
+        {
+            for (size_t i = 0; i < numCameras_; ++i)
+            {
+                cameraThreads_[i]->Delete();
+                cameraThreads_[i] = NULL;
+            }
+        }
+    }
+
+    //Delete the GPS thread.
+    inline void CaptureEngine::deleteGPSThread()
+    {
+        if (gpsThread_ != NULL)
+        {
+            gpsThread_->Delete();
+            gpsThread_ = NULL;
+        }
+    }
+
+    //Delete the trigger thread (software triggered modes only).
+    inline void CaptureEngine::deleteTriggerThread()
+    {
+        if (triggerThread_ != NULL)
+        {
+            triggerThread_->Delete();
+            triggerThread_ = NULL;
+        }
+    }
+
+    //Delete the bandwidth controller.
+    inline void CaptureEngine::deleteBandwidthController()
+    {
+        if (bandwidthController_ != NULL)
+        {
+            bandwidthController_->Delete();
+            bandwidthController_ = NULL;
+        }
+    }
+
+    //Delete the network preview server.
+    inline void CaptureEngine::deleteMJPEGServer()
+    {
+        if (mjpegServer_ != NULL)
+        {
+            mjpegServer_->Delete();
+            mjpegServer_ = NULL;
+        }
+    }
+
+    void CaptureEngine::deleteAllThreads()
+    {
+        deleteMJPEGServer();
+        deleteBandwidthController();
+        deleteTriggerThread();
+        deleteCameraThreads();
+        deleteGPSThread();
+    }
+
+    //Camera threads are created and images are streamed. The caller checks
+    //the GPS and session first.
+    bool CaptureEngine::start()
+    {
+        if (play_)
+        {
+            return false;
+        }
+
+        //Frames are software triggered in distance based capture mode and in
+        //software synchronised mode. In synchronised modes frames are grouped
+        //into capture sets, numbered on from the highest camera frame number.
+        bool softwareTrigger = distanceTrigger_.enabled() || syncMode_ == SYNC_SOFTWARE;
+        char* triggerMode = "FixedRate";
+        if (syncMode_ == SYNC_HARDWARE)
+        {
+            triggerMode = "SyncIn1";
+        }
+        else if (softwareTrigger)
+        {
+            triggerMode = "Software";
+        }
+
+        streamBuffers_.assign(numCameras_, SharedImageBufferPtr());
+
+        //Only free running cameras are expected to send frames all the time. Triggered
+        //cameras legitimately go quiet, eg while the vehicle is stationary.
+        Watchdog watchdog = watchdog_;
+        if (softwareTrigger || syncMode_ == SYNC_HARDWARE)
+        {
+            watchdog.setEnabled(false);
+        }
+
+        captureSets_.reset();
+        if (syncMode_ != SYNC_NONE)
+        {
+            long firstSet = 0;
+            for (size_t i = 0; i < numCameras_; ++i)
+            {
+                if ((*cameras_)[i].frameNumber() > firstSet)
+                {
+                    firstSet = (*cameras_)[i].frameNumber();
+                }
+            }
+
+            captureSets_ = CaptureSetCollectorPtr(new CaptureSetCollector(numCameras_, gpsData_, db_));
+            captureSets_->start(firstSet);
+        }
+
+        for (size_t i = 0; i < numCameras_; ++i)
+        {
+            (*cameras_)[i].setTriggerMode(triggerMode);
+            //Crops are kept per camera position, so are picked up again each time capture starts.
+            (*cameras_)[i].setCrop(CropRegion::load((*cameras_)[i].cameraName()));
+
+            CameraThread* cameraThread = new CameraThread(&((*cameras_)[i]), 
+                                                          cameraBuffers_[i], 
+                                                          gpsData_, 
+                                                          db_, 
+                                                          session_, 
+                                                          framePolicy_, 
+                                                          captureSets_);
+            cameraThread->setWatchdog(watchdog);
+            cameraThread->setExposureControl(exposureControl_);
+            if (streamSettings_.enabled())
+            {
+                unsigned long scale = streamSettings_.scale();
+                size_t streamSize = 3*(*cameras_)[i].streamWidth(scale)*(*cameras_)[i].streamHeight(scale);
+                streamBuffers_[i] = SharedImageBufferPtr(new SharedImageBuffer(streamSize));
+                cameraThread->setStream(streamBuffers_[i], scale, streamSettings_.rate());
+            }
+
+            wxThreadError threadError = cameraThread->Create();
+            assert(threadError == wxTHREAD_NO_ERROR);
+            cameraThreads_[i] = cameraThread;
+            (*cameras_)[i].startStream();
+            cameraThreads_[i]->Run();
+        }
+
+        if (softwareTrigger)
+        {
+            triggerThread_ = new TriggerThread(cameras_, gpsData_, distanceTrigger_);
+            wxThreadError threadError = triggerThread_->Create();
+            assert(threadError == wxTHREAD_NO_ERROR);
+            triggerThread_->Run();
+        }
+
+        //Adjusts bandwidth and packet size from the packet statistics while streaming.
+        if (adaptiveBandwidth_)
+        {
+            bool fixedRate = !softwareTrigger && syncMode_ != SYNC_HARDWARE;
+            bandwidthController_ = new BandwidthController(cameras_, db_, session_, fixedRate);
+            wxThreadError threadError = bandwidthController_->Create();
+            assert(threadError == wxTHREAD_NO_ERROR);
+            bandwidthController_->Run();
+        }
+
+        if (streamSettings_.enabled())
+        {
+            startMJPEGServer();
+        }
+
+        //The NMEA stream is kept with the session so the drive can be replayed.
+        if (session_->createDB())
+        {
+            gps_->startRecording(session_->path() + "\\gps.nmea");
+        }
+
+        play_ = true;
+
+        return true;
+    }
+
+    //Camera threads are deleted and the cameras stop streaming.
+    bool CaptureEngine::stop()
+    {
+        if (!play_)
+        {
+            return false;
+        }
+
+        deleteMJPEGServer();
+        deleteBandwidthController();
+        deleteTriggerThread();
+        deleteCameraThreads();
+
+        if (captureSets_)
+        {
+            captureSets_->flush(session_->createDB());
+        }
+
+        for (size_t i = 0; i < numCameras_; ++i)
+        {
+            (*cameras_)[i].stopStream();
+        }
+
+        gps_->stopRecording();
+
+        play_ = false;
+
+        return true;
+    }
+
+    //Serves the stream buffers over HTTP. Sockets must be initialised on the
+    //main thread before the server thread uses them.
+    void CaptureEngine::startMJPEGServer()
+    {
+        wxSocketBase::Initialize();
+
+        std::vector<unsigned long> widths;
+        std::vector<unsigned long> heights;
+        std::vector<wxString> names;
+        unsigned long scale = streamSettings_.scale();
+
+        for (size_t i = 0; i < numCameras_; ++i)
+        {
+            widths.push_back((*cameras_)[i].streamWidth(scale));
+            heights.push_back((*cameras_)[i].streamHeight(scale));
+            names.push_back((*cameras_)[i].cameraName());
+        }
+
+        mjpegServer_ = new MJPEGServer(streamBuffers_, widths, heights, names, streamSettings_);
+        wxThreadError threadError = mjpegServer_->Create();
+        assert(threadError == wxTHREAD_NO_ERROR);
+        mjpegServer_->Run();
+    }
+
+    bool CaptureEngine::playing() const
+    {
+        return play_;
+    }
+
+    //Takes effect the next time capture is started.
+    void CaptureEngine::setDistanceTrigger(const DistanceTrigger& trigger)
+    {
+        distanceTrigger_ = trigger;
+    }
+
+    //Takes effect the next time capture is started.
+    void CaptureEngine::setFramePolicy(const FramePolicy& policy)
+    {
+        framePolicy_ = policy;
+    }
+
+    //Takes effect the next time capture is started.
+    void CaptureEngine::setWatchdog(const Watchdog& watchdog)
+    {
+        watchdog_ = watchdog;
+    }
+
+    void CaptureEngine::setExposureControl(const ExposureControl& exposureControl)
+    {
+        exposureControl_ = exposureControl;
+    }
+
+    //Takes effect the next time capture is started.
+    void CaptureEngine::setSyncMode(SyncMode mode)
+    {
+        syncMode_ = mode;
+    }
+
+    //Takes effect the next time capture is started.
+    void CaptureEngine::setAdaptiveBandwidth(bool adaptive)
+    {
+        adaptiveBandwidth_ = adaptive;
+    }
+
+    //Takes effect the next time capture is started.
+    void CaptureEngine::setStreamSettings(const StreamSettings& settings)
+    {
+        streamSettings_ = settings;
+    }
+
+    SharedImageBufferPtr CaptureEngine::buffer(size_t camera) const
+    {
+        return cameraBuffers_[camera];
+    }
+
+    SharedGPSDataPtr CaptureEngine::gpsData() const
+    {
+        return gpsData_;
+    }
+
+} //namespace
@@ -0,0 +1,117 @@
+/*
+Author: Nariman Habili
+
+Description: The capture pipeline without any GUI: camera, GPS, trigger and
+             bandwidth threads, the preview buffers and the session database.
+             Used by the canvas in RICS and by the headless capture daemon.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CAPTURE_ENGINE_H
+#define CAPTURE_ENGINE_H
+
+#include "Camera.h"
+#include "CameraThread.h"
+#include "GPSThread.h"
+#include "TriggerThread.h"
+#include "BandwidthController.h"
+#include "MJPEGServer.h"
+#include "StreamSettings.h"
+#include "DistanceTrigger.h"
+#include "FramePolicy.h"
+#include "Watchdog.h"
+#include "ExposureControl.h"
+#include "CaptureSetCollector.h"
+#include "SharedImageBuffer.h"
+#include "SharedGPSData.h"
+#include "Session.h"
+#include "Database.h"
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <vector>
+
+namespace rics
+{
+    class CaptureEngine
+    {
+    public:
+        CaptureEngine(Cameras* cameras, GPS* gps, Session* session, Database* db);
+        ~CaptureEngine();
+
+        void startGPS(wxEvtHandler* handler);
+        bool start();
+        bool stop();
+        bool playing() const;
+        void deleteAllThreads();
+
+        void setDistanceTrigger(const DistanceTrigger& trigger);
+        void setFramePolicy(const FramePolicy& policy);
+        void setWatchdog(const Watchdog& watchdog);
+        void setExposureControl(const ExposureControl& exposureControl);
+        void setSyncMode(SyncMode mode);
+        void setAdaptiveBandwidth(bool adaptive);
+        void setStreamSettings(const StreamSettings& settings);
+
+        SharedImageBufferPtr buffer(size_t camera) const;
+        SharedGPSDataPtr gpsData() const;
+
+    private:
+        inline void deleteCameraThreads();
+        inline void deleteGPSThread();
+        inline void deleteTriggerThread();
+        inline void deleteBandwidthController();
+        inline void deleteMJPEGServer();
+        void startMJPEGServer();
+
+    private:
+        Cameras* cameras_;
+        size_t numCameras_;
+
+        GPS* gps_;
+        Session* session_;
+        Database* db_;
+
+        std::vector<SharedImageBufferPtr> cameraBuffers_;
+        std::vector<CameraThread*> cameraThreads_;
+
+        SharedGPSDataPtr gpsData_;
+        GPSThread* gpsThread_;
+
+        DistanceTrigger distanceTrigger_;
+        TriggerThread* triggerThread_;
+
+        FramePolicy framePolicy_;
+        Watchdog watchdog_;
+        ExposureControl exposureControl_;
+
+        SyncMode syncMode_;
+        CaptureSetCollectorPtr captureSets_;
+
+        bool adaptiveBandwidth_;
+        BandwidthController* bandwidthController_;
+
+        StreamSettings streamSettings_;
+        std::vector<SharedImageBufferPtr> streamBuffers_;
+        MJPEGServer* mjpegServer_;
+
+        bool play_;
+    };
+} //namespace
+
+#endif //CAPTURE_ENGINE_H
@@ -0,0 +1,220 @@
+/*
+Author: Nariman Habili
+
+Description: Groups the frames of all cameras taken on the same trigger into
+             a capture set. Each set has one ID, used as the frame number by
+             every camera, and one database row with the GPS data.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CaptureSetCollector.h"
+#include <algorithm>
+
+namespace rics
+{
+    //Sets still waiting for frames this many sets behind the newest are written
+    //as they are, eg if a camera missed a trigger.
+    static const long maxPendingSets = 8;
+
+    //The camera's FrameCount is 16 bits and goes from 65535 back to 1 (0 is skipped).
+    static const unsigned long frameCountWrap = 0xFFFF;
+
+    CaptureSetCollector::CaptureSetCollector(size_t numCameras, SharedGPSDataPtr gpsData, Database* db):
+    numCameras_(numCameras),
+    gpsData_(gpsData),
+    db_(db),
+    firstSet_(0),
+    newestSet_(0),
+    closedBelow_(0)
+    {
+    }
+
+    CaptureSetCollector::~CaptureSetCollector()
+    {
+    }
+
+    //Called when play is pressed. "firstSet" is the ID given to the first trigger.
+    void CaptureSetCollector::start(long firstSet)
+    {
+        wxMutexLocker lock(mutex_);
+        firstSet_ = firstSet;
+        cameraCounts_.clear();
+        resets_.clear();
+        newestSet_ = firstSet - 1;
+        sets_.clear();
+        closedBelow_ = firstSet;
+        completed_.clear();
+    }
+
+    //Map a camera's own frame counter to the set ID. The camera counts every
+    //trigger it receives, even if the frame is lost on the way to the PC, so
+    //the cameras stay in step after dropped frames. The counter starts again at 1 
+    //when the stream is started (see Camera::startStream()), so count 1 is the first
+    //set, even for a camera whose first frames were lost. The counter wraps after 
+    //65535 triggers, so the set ID is advanced by the steps between frames rather
+    //than taken from the count.
+    long CaptureSetCollector::setID(int cameraID, unsigned long frameCount)
+    {
+        wxMutexLocker lock(mutex_);
+
+        std::map<int, long>::iterator reset = resets_.find(cameraID);
+        if (reset != resets_.end())
+        {
+            CameraCount count;
+            count.frameCount = frameCount;
+            count.setID = reset->second;
+            cameraCounts_[cameraID] = count;
+            resets_.erase(reset);
+        }
+        else
+        {
+            std::map<int, CameraCount>::iterator it = cameraCounts_.find(cameraID);
+            if (it == cameraCounts_.end())
+            {
+                //Where the counter was before the first trigger.
+                CameraCount count;
+                count.frameCount = 0;
+                count.setID = firstSet_ - 1;
+                it = cameraCounts_.insert(std::make_pair(cameraID, count)).first;
+            }
+
+            unsigned long step = frameCount >= it->second.frameCount ? 
+                                 frameCount - it->second.frameCount : 
+                                 frameCount + frameCountWrap - it->second.frameCount;
+
+            it->second.frameCount = frameCount;
+            it->second.setID += static_cast<long>(step);
+        }
+
+        long id = cameraCounts_[cameraID].setID;
+        newestSet_ = std::max(newestSet_, id);
+
+        return id;
+    }
+
+    //The camera has been re-opened (eg after being unplugged) and its frame counter
+    //has started again. Its next frame belongs to set "nextSet".
+    void CaptureSetCollector::resetCamera(int cameraID, long nextSet)
+    {
+        wxMutexLocker lock(mutex_);
+        resets_[cameraID] = nextSet;
+    }
+
+    //The highest set ID given to any camera's frame so far.
+    long CaptureSetCollector::newestSet()
+    {
+        wxMutexLocker lock(mutex_);
+        return newestSet_;
+    }
+
+    //A camera has saved its frame of set "setID". The GPS data is taken when the
+    //first frame of the set arrives and the row is written once every camera has
+    //delivered its frame.
+    void CaptureSetCollector::addFrame(long setID, bool writeDB)
+    {
+        wxMutexLocker lock(mutex_);
+
+        //A late frame of a set that has been written already: counted in its row 
+        //rather than written as a second row with the same ID.
+        if (setID < closedBelow_ || completed_.find(setID) != completed_.end())
+        {
+            if (writeDB)
+            {
+                db_->databaseAddToCaptureSet(setID);
+            }
+            return;
+        }
+
+        std::map<long, CaptureSet>::iterator it = sets_.find(setID);
+        if (it == sets_.end())
+        {
+            CaptureSet set;
+            set.frames = 0;
+
+            gpsData_->readLock();
+            set.timeStamp = gpsData_->timeStamp();
+            set.lat = gpsData_->latitude();
+            set.lon = gpsData_->longitude();
+            set.speed = gpsData_->speed();
+            set.bearing = gpsData_->bearing();
+            set.satellites = gpsData_->satellites();
+            set.quality = gpsData_->quality();
+            gpsData_->readUnlock();
+
+            it = sets_.insert(std::make_pair(setID, set)).first;
+        }
+
+        ++it->second.frames;
+
+        if (it->second.frames == numCameras_)
+        {
+            if (writeDB)
+            {
+                writeSet(setID, it->second);
+            }
+            sets_.erase(it);
+            completed_.insert(setID);
+        }
+
+        //Write incomplete sets that are too old to be completed. Every set before 
+        //them is closed from now on.
+        while (!sets_.empty() && sets_.begin()->first < setID - maxPendingSets)
+        {
+            if (writeDB)
+            {
+                writeSet(sets_.begin()->first, sets_.begin()->second);
+            }
+            sets_.erase(sets_.begin());
+        }
+
+        closedBelow_ = std::max(closedBelow_, setID - maxPendingSets);
+        completed_.erase(completed_.begin(), completed_.lower_bound(closedBelow_));
+    }
+
+    //Write all incomplete sets, eg when stop is pressed.
+    void CaptureSetCollector::flush(bool writeDB)
+    {
+        wxMutexLocker lock(mutex_);
+
+        for (std::map<long, CaptureSet>::iterator it = sets_.begin(); it != sets_.end(); ++it)
+        {
+            if (writeDB)
+            {
+                writeSet(it->first, it->second);
+            }
+        }
+        sets_.clear();
+        closedBelow_ = std::max(closedBelow_, newestSet_ + 1);
+        completed_.clear();
+    }
+
+    void CaptureSetCollector::writeSet(long setID, CaptureSet& set)
+    {
+        db_->databaseEnterCaptureSet(setID,
+                                     set.timeStamp,
+                                     set.lat,
+                                     set.lon,
+                                     set.speed,
+                                     set.bearing,
+                                     set.satellites,
+                                     set.quality,
+                                     static_cast<unsigned long>(set.frames));
+    }
+
+}//namespace
\ No newline at end of file
@@ -0,0 +1,102 @@
+/*
+Author: Nariman Habili
+
+Description: Groups the frames of all cameras taken on the same trigger into
+             a capture set. Each set has one ID, used as the frame number by
+             every camera, and one database row with the GPS data.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CAPTURE_SET_COLLECTOR_H
+#define CAPTURE_SET_COLLECTOR_H
+
+#include "SharedGPSData.h"
+#include "Database.h"
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <boost/shared_ptr.hpp>
+#include <map>
+#include <set>
+
+namespace rics
+{
+    //How the cameras are synchronised.
+    enum SyncMode
+    {
+        SYNC_NONE = 0,  //each camera free runs
+        SYNC_SOFTWARE,  //software trigger broadcast to all cameras
+        SYNC_HARDWARE   //external pulse on the SyncIn1 input of every camera
+    };
+
+    class CaptureSetCollector
+    {
+    public:
+        CaptureSetCollector(size_t numCameras, SharedGPSDataPtr gpsData, Database* db);
+        ~CaptureSetCollector();
+
+        void start(long firstSet);
+        long setID(int cameraID, unsigned long frameCount);
+        void resetCamera(int cameraID, long nextSet);
+        long newestSet();
+        void addFrame(long setID, bool writeDB);
+        void flush(bool writeDB);
+
+    private:
+        struct CaptureSet
+        {
+            size_t frames;
+            wxString timeStamp;
+            wxString lat;
+            wxString lon;
+            wxString speed;
+            wxString bearing;
+            wxString satellites;
+            wxString quality;
+        };
+
+        //Where a camera's frame counter was at its last frame.
+        struct CameraCount
+        {
+            unsigned long frameCount;
+            long setID;
+        };
+
+        void writeSet(long setID, CaptureSet& set);
+
+    private:
+        size_t numCameras_;
+        SharedGPSDataPtr gpsData_;
+        Database* db_;
+
+        long firstSet_;
+        std::map<int, CameraCount> cameraCounts_;
+        std::map<int, long> resets_;//cameras whose counter restarted, and the set of their next frame
+        long newestSet_;
+        std::map<long, CaptureSet> sets_;
+        long closedBelow_;       //sets before this have been written or given up on
+        std::set<long> completed_;//sets from closedBelow_ on already written complete
+
+        wxMutex mutex_;
+    };
+
+    typedef boost::shared_ptr<CaptureSetCollector> CaptureSetCollectorPtr;
+
+}//namespace
+
+#endif //CAPTURE_SET_COLLECTOR_H
\ No newline at end of file
@@ -0,0 +1,115 @@
+/*
+Author: Nariman Habili
+
+Description: Colour correction done on the PC: a gain per channel (white
+             balance), a 3x3 colour matrix and a gamma.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COLOUR_SETTINGS_H
+#define COLOUR_SETTINGS_H
+
+namespace rics
+{
+    //Channels are 0 (red), 1 (green) and 2 (blue). The defaults leave the image as
+    //the camera sent it.
+    class ColourSettings
+    {
+    public:
+        ColourSettings():
+        gamma_(1.0)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                gains_[i] = 1.0;
+
+                for (int j = 0; j < 3; ++j)
+                {
+                    matrix_[i][j] = i == j ? 1.0 : 0.0;
+                }
+            }
+        }
+
+        ~ColourSettings()
+        {
+        }
+
+        double gain(int channel) const
+        {
+            return gains_[channel];
+        }
+
+        void setGain(int channel, double gain)
+        {
+            gains_[channel] = gain;
+        }
+
+        //Output channel "row" takes matrix(row, column) of input channel "column",
+        //after the gains.
+        double matrix(int row, int column) const
+        {
+            return matrix_[row][column];
+        }
+
+        void setMatrix(int row, int column, double value)
+        {
+            matrix_[row][column] = value;
+        }
+
+        //2.2 brightens the mid tones, 1.0 leaves them alone
+        double gamma() const
+        {
+            return gamma_;
+        }
+
+        void setGamma(double gamma)
+        {
+            gamma_ = gamma;
+        }
+
+        bool diagonal() const
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    if (matrix_[i][j] != (i == j ? 1.0 : 0.0))
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        bool neutral() const
+        {
+            return diagonal() && gamma_ == 1.0 && gains_[0] == 1.0 && gains_[1] == 1.0 && gains_[2] == 1.0;
+        }
+
+    private:
+        double gains_[3];
+        double matrix_[3][3];
+        double gamma_;
+    };
+
+}//namespace
+
+#endif //COLOUR_SETTINGS_H
@@ -0,0 +1,561 @@
+/*
+Author: Nariman Habili
+
+Description: Line based control protocol for the headless capture daemon.
+             Listens on the loopback interface only; one client at a time.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ControlServer.h"
+#include "StorageBenchmark.h"
+#include <wx/filefn.h>
+#include <boost/lexical_cast.hpp>
+
+namespace rics
+{
+    ControlServer::ControlServer(Cameras* cameras, GPS* gps, Session* session, Database* db, CaptureEngine* engine):
+    cameras_(cameras),
+    gps_(gps),
+    session_(session),
+    db_(db),
+    engine_(engine),
+    volumeMode_(SessionVolumes::PER_CAMERA),
+    quit_(false)
+    {
+    }
+
+    ControlServer::~ControlServer()
+    {
+    }
+
+    //Only the loopback interface is used so the daemon can't be controlled
+    //from the camera network.
+    bool ControlServer::listen(unsigned short port)
+    {
+        wxIPV4address address;
+        address.Hostname("127.0.0.1");
+        address.Service(port);
+
+        server_ = boost::shared_ptr<wxSocketServer>(new wxSocketServer(address, wxSOCKET_BLOCK | wxSOCKET_REUSEADDR));
+
+        return server_->IsOk();
+    }
+
+    //Serves clients until a quit command is received or quit is requested.
+    //Waits are bounded so a quit request is noticed within a second.
+    void ControlServer::run()
+    {
+        while (!quit_)
+        {
+            if (!server_->WaitForAccept(1, 0))
+            {
+                continue;
+            }
+
+            wxSocketBase* client = server_->Accept(false);
+            if (client != NULL)
+            {
+                client->SetFlags(wxSOCKET_BLOCK);
+                serve(client);
+                client->Destroy();
+            }
+        }
+    }
+
+    //May be called from another thread, eg when a camera is unplugged.
+    void ControlServer::requestQuit()
+    {
+        quit_ = true;
+    }
+
+    void ControlServer::serve(wxSocketBase* client)
+    {
+        pending_.Clear();
+        wxString line;
+
+        while (!quit_ && readLine(client, line))
+        {
+            writeLine(client, execute(line, client));
+        }
+    }
+
+    //Returns false when the client disconnects.
+    bool ControlServer::readLine(wxSocketBase* client, wxString& line)
+    {
+        while (pending_.Find('\n') == wxNOT_FOUND)
+        {
+            if (quit_ || !client->IsConnected())
+            {
+                return false;
+            }
+
+            if (!client->WaitForRead(1, 0))
+            {
+                continue;
+            }
+
+            char buffer[256];
+            client->Read(buffer, sizeof(buffer));
+            if (client->LastCount() == 0)
+            {
+                return false;//closed by the client
+            }
+
+            pending_ += wxString(buffer, client->LastCount());
+        }
+
+        int end = pending_.Find('\n');
+        line = pending_.Left(end);
+        pending_ = pending_.Mid(end + 1);
+        line.Trim().Trim(false);
+
+        return true;
+    }
+
+    void ControlServer::writeLine(wxSocketBase* client, const wxString& line)
+    {
+        wxString reply = line + "\r\n";
+        client->Write(reply.c_str(), reply.Length());
+    }
+
+    wxString ControlServer::execute(const wxString& line, wxSocketBase* client)
+    {
+        wxStringTokenizer tokens(line, " \t");
+        wxString command = tokens.GetNextToken().Lower();
+
+        if (command == "")
+        {
+            return "ERR empty command";
+        }
+        else if (command == "session")
+        {
+            wxString dir = tokens.GetNextToken();
+            wxString name = tokens.GetNextToken();
+            return openSession(dir, name);
+        }
+        else if (command == "start")
+        {
+            return start();
+        }
+        else if (command == "stop")
+        {
+            return stop();
+        }
+        else if (command == "exposure")
+        {
+            wxString camera = tokens.GetNextToken();
+            wxString value = tokens.GetNextToken();
+            return setExposure(camera, value);
+        }
+        else if (command == "profile")
+        {
+            //Profile names may contain spaces.
+            return applyProfile(tokens.GetString().Trim().Trim(false));
+        }
+        else if (command == "colour")
+        {
+            wxString camera = tokens.GetNextToken();
+            return setColour(camera, tokens);
+        }
+        else if (command == "stats")
+        {
+            stats(client);
+            return "OK";
+        }
+        else if (command == "benchmark")
+        {
+            wxString seconds = tokens.GetNextToken();
+            return benchmark(seconds, tokens.GetNextToken().Lower() == "compare", client);
+        }
+        else if (command == "volumes")
+        {
+            wxString mode = tokens.GetNextToken();
+            return setVolumes(mode, tokens);
+        }
+        else if (command == "quit")
+        {
+            engine_->stop();
+            quit_ = true;
+            return "OK";
+        }
+
+        return "ERR unknown command " + command;
+    }
+
+    //Same as creating a session from the GUI, except the session name is used as given.
+    //If the session exists it is opened and frame numbers carry on from the database.
+    wxString ControlServer::openSession(const wxString& dir, const wxString& name)
+    {
+        if (engine_->playing())
+        {
+            return "ERR stop capture first";
+        }
+
+        if (dir == "" || name == "")
+        {
+            return "ERR usage: session <directory> <name>";
+        }
+
+        if (!gps_->gpsActive())
+        {
+            return "ERR no GPS data detected";
+        }
+
+        session_->setSaveImages(false);
+        session_->setCreateDB(false);
+        session_->initCurrentFrame();
+
+        if (!wxDirExists(dir))
+        {
+            wxMkdir(dir);
+        }
+
+        wxString sessionDir = dir + "\\" + name;
+        bool sessionExists = wxDirExists(sessionDir);
+        if (!sessionExists)
+        {
+            wxMkdir(sessionDir);
+        }
+
+        wxString filename = sessionDir + "\\" + name + ".sdb";
+
+        if (wxFileExists(filename))
+        {
+            db_->databaseClose();
+            db_->openDatabase(filename);
+
+            for (size_t i = 0; i < (*cameras_).size(); ++i)
+            {
+                wxString cameraName = (*cameras_)[i].cameraName();
+                db_->createTable(cameraName);
+                session_->setCurrentFrame(i, db_->nextFrame(cameraName));
+            }
+        }
+        else if (sessionExists)
+        {
+            return "ERR database " + name + ".sdb does not exist";
+        }
+        else
+        {
+            db_->databaseClose();
+            db_->openDatabase(filename);
+
+            for (size_t i = 0; i < (*cameras_).size(); ++i)
+            {
+                db_->createTable((*cameras_)[i].cameraName());
+            }
+        }
+
+        //A new session is spread over the volumes given by the "volumes" command, an 
+        //existing one keeps the volumes it was created with.
+        SessionVolumesPtr volumes = sessionExists ? 
+                                    SessionVolumes::open(sessionDir, db_) : 
+                                    SessionVolumes::create(sessionDir, name, volumeRoots_, volumeMode_, db_);
+
+        std::vector<wxString> cameraNames;
+        for (size_t i = 0; i < (*cameras_).size(); ++i)
+        {
+            cameraNames.push_back((*cameras_)[i].cameraName());
+        }
+        volumes->createDirs(cameraNames);
+        volumes->balance(cameraNames);
+        session_->setVolumes(volumes);
+
+        for (size_t i = 0; i < (*cameras_).size(); ++i)
+        {
+            (*cameras_)[i].setSessionPath(volumes->cameraDir(0, cameraNames[i]));
+            (*cameras_)[i].setSessionName(name);
+            (*cameras_)[i].setFrameNumber(session_->currentFrame(i));
+        }
+
+        session_->setSaveImages(true);
+        session_->setCreateDB(true);
+        session_->setSessionName(name);
+        session_->setPath(sessionDir);
+
+        return "OK";
+    }
+
+    //"volumes per-camera|round-robin <directory>..." Extra volumes for the next new session,
+    //which gets a directory of its name on each. "volumes" on its own goes back to one volume.
+    wxString ControlServer::setVolumes(const wxString& mode, wxStringTokenizer& roots)
+    {
+        if (mode != "" && mode != "per-camera" && mode != "round-robin")
+        {
+            return "ERR usage: volumes per-camera|round-robin <directory>...";
+        }
+
+        volumeRoots_.clear();
+        volumeMode_ = SessionVolumes::mode(mode);
+
+        while (roots.HasMoreTokens())
+        {
+            wxString root = roots.GetNextToken();
+            if (!wxDirExists(root))
+            {
+                volumeRoots_.clear();
+                return "ERR no directory " + root;
+            }
+            volumeRoots_.push_back(root);
+        }
+
+        return "OK";
+    }
+
+    wxString ControlServer::start()
+    {
+        if (!gps_->gpsActive() && session_->createDB())
+        {
+            return "ERR no GPS data detected";
+        }
+
+        if (!engine_->start())
+        {
+            return "ERR already capturing";
+        }
+
+        return "OK";
+    }
+
+    wxString ControlServer::stop()
+    {
+        if (!engine_->stop())
+        {
+            return "ERR not capturing";
+        }
+
+        return "OK";
+    }
+
+    //Camera is the index in unique ID order, as listed by stats.
+    wxString ControlServer::setExposure(const wxString& camera, const wxString& value)
+    {
+        unsigned long index;
+        if (!camera.ToULong(&index) || index >= (*cameras_).size())
+        {
+            return "ERR no camera " + camera;
+        }
+
+        if (value.Lower() == "auto")
+        {
+            (*cameras_)[index].setExposureTime(true, 0);
+            return "OK";
+        }
+
+        unsigned long exposureTime;
+        if (!value.ToULong(&exposureTime) || exposureTime == 0)
+        {
+            return "ERR usage: exposure <camera> auto|<microseconds>";
+        }
+
+        (*cameras_)[index].setExposureTime(false, exposureTime);
+
+        return "OK";
+    }
+
+    //Profiles are saved from RICS (camera properties) for the same Windows user.
+    wxString ControlServer::applyProfile(const wxString& name)
+    {
+        if (name == "")
+        {
+            return "ERR usage: profile <name>";
+        }
+
+        CameraSettings profile;
+        if (!CameraProfiles().load(name, &profile))
+        {
+            return "ERR no profile " + name;
+        }
+
+        CameraProfiles::apply(cameras_, profile);
+
+        return "OK";
+    }
+
+    //Takes effect from the next frame of that camera, while capturing or not. The
+    //colour matrix is kept as it is.
+    wxString ControlServer::setColour(const wxString& camera, wxStringTokenizer& values)
+    {
+        unsigned long index;
+        if (!camera.ToULong(&index) || index >= (*cameras_).size())
+        {
+            return "ERR no camera " + camera;
+        }
+
+        ColourSettings colour = (*cameras_)[index].colour();
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            double gain;
+            if (!values.GetNextToken().ToDouble(&gain) || gain < 0.0)
+            {
+                return "ERR usage: colour <camera> <red> <green> <blue> [gamma]";
+            }
+            colour.setGain(channel, gain);
+        }
+
+        wxString gammaValue = values.GetNextToken();
+        double gamma;
+        if (gammaValue != "")
+        {
+            if (!gammaValue.ToDouble(&gamma) || gamma < 0.1)
+            {
+                return "ERR gamma must be at least 0.1";
+            }
+            colour.setGamma(gamma);
+        }
+
+        (*cameras_)[index].setColour(colour);
+
+        return "OK";
+    }
+
+    //One line per camera, then one line of GPS data.
+    void ControlServer::stats(wxSocketBase* client)
+    {
+        for (size_t i = 0; i < (*cameras_).size(); ++i)
+        {
+            Camera& camera = (*cameras_)[i];
+            writeLine(client, "camera " + boost::lexical_cast<std::string>(i) +
+                              " id " + boost::lexical_cast<std::string>(camera.uniqueID()) +
+                              " name " + camera.cameraName() +
+                              " frame " + boost::lexical_cast<std::string>(camera.frameNumber()) +
+                              " fps " + wxString::Format("%.2f", camera.actualFrameRate()) +
+                              " exposure " + boost::lexical_cast<std::string>(camera.exposureTime()) +
+                              " missed " + boost::lexical_cast<std::string>(camera.packetsMissed()) +
+                              " resent " + boost::lexical_cast<std::string>(camera.packetsResent()) +
+                              " format " + camera.pixelFormat() +
+                              " frame_bytes " + boost::lexical_cast<std::string>(camera.totalBytesPerFrame()) +
+                              " convert_ms " + wxString::Format("%.1f", camera.convertTime()) +
+                              (camera.unplugged() ? " unplugged" : ""));
+        }
+
+        SharedGPSDataPtr gpsData = engine_->gpsData();
+        gpsData->readLock();
+        wxString gps = "gps time " + gpsData->timeStamp() +
+                       " lat " + gpsData->latitude() +
+                       " lon " + gpsData->longitude() +
+                       " speed " + gpsData->speed() +
+                       " satellites " + gpsData->satellites() +
+                       " quality " + gpsData->quality();
+        gpsData->readUnlock();
+        writeLine(client, gps);
+
+        //Rates are measured between stats requests at least StorageForecast::sampleInterval_ apart.
+        SessionVolumesPtr volumes = session_->volumes();
+        forecast_.setPaths(session_->saveImages() && volumes ? volumes->sessionDirs() : std::vector<wxString>());
+        forecast_.update(cameras_, wxGetLocalTimeMillis());
+        writeLine(client, "storage bytes_per_sec " + wxString::Format("%.0f", forecast_.bytesPerSecond()) +
+                          " free_bytes " + wxString::Format("%.0f", forecast_.freeBytes()) +
+                          " seconds_left " + wxString::Format("%.0f", forecast_.secondsToFull()) +
+                          " load " + wxString::Format("%.2f", forecast_.load()) +
+                          (forecast_.warning() ? " warning" : ""));
+
+        if (session_->saveImages() && volumes)
+        {
+            wxStringTokenizer lines(volumes->status(), "\n");
+            while (lines.HasMoreTokens())
+            {
+                writeLine(client, "volume " + lines.GetNextToken());
+            }
+        }
+
+        writeLine(client, wxString("capturing ") + (engine_->playing() ? "yes" : "no") + 
+                          " session " + (session_->sessionNameIsEmpty() ? wxString("--") : session_->sessionName()));
+    }
+
+    //Blocks the server for the length of the test. Best run before capture starts, 
+    //as the test frames compete with the cameras for the drive.
+    //With "compare" each volume is also tested with the other way of writing the JPEGs
+    //(write-behind or fopen/fwrite), for a "compare" line.
+    wxString ControlServer::benchmark(const wxString& seconds, bool compare, wxSocketBase* client)
+    {
+        if (session_->path() == "")
+        {
+            return "ERR open a session first";
+        }
+
+        long s = 10;
+        if (seconds != "" && (!seconds.ToLong(&s) || s < 1 || s > 600))
+        {
+            return "ERR usage: benchmark [seconds] [compare]";
+        }
+
+        //Each of the session's volumes in turn. The cameras are then shared between the
+        //volumes by the speeds measured.
+        SessionVolumesPtr volumes = session_->volumes();
+        std::vector<wxString> dirs = volumes ? volumes->sessionDirs() : std::vector<wxString>(1, session_->path());
+        double total = 0.0;
+
+        for (size_t v = 0; v < dirs.size(); ++v)
+        {
+            StorageBenchmark benchmark(dirs[v]);
+            benchmark.setCameras((*cameras_).size());
+            benchmark.setFrameBytes(StorageBenchmark::frameBytes(cameras_));
+            benchmark.setDuration(1000*s);
+
+            if (!benchmark.run())
+            {
+                return "ERR could not write to " + dirs[v];
+            }
+
+            if (volumes)
+            {
+                for (size_t i = 0; i < volumes->numVolumes(); ++i)
+                {
+                    if (volumes->sessionDir(i) == dirs[v])
+                    {
+                        volumes->setThroughput(i, benchmark.bytesPerSecond());
+                    }
+                }
+            }
+
+            total += benchmark.bytesPerSecond();
+            writeLine(client, "benchmark " + (dirs.size() > 1 ? dirs[v] + " " : wxString()) + benchmark.report());
+
+            if (compare)
+            {
+                StorageBenchmark other(dirs[v]);
+                other.setCameras((*cameras_).size());
+                other.setFrameBytes(benchmark.frameBytes());
+                other.setDuration(1000*s);
+                other.setWriteBehind(!benchmark.writeBehind());
+
+                if (other.run())
+                {
+                    writeLine(client, "compare " + (dirs.size() > 1 ? dirs[v] + " " : wxString()) + other.report());
+                }
+            }
+        }
+
+        forecast_.setThroughput(total);
+
+        if (volumes && !engine_->playing())
+        {
+            std::vector<wxString> cameraNames;
+            for (size_t i = 0; i < (*cameras_).size(); ++i)
+            {
+                cameraNames.push_back((*cameras_)[i].cameraName());
+            }
+            volumes->balance(cameraNames);
+        }
+
+        return "OK";
+    }
+
+} //namespace
@@ -0,0 +1,96 @@
+/*
+Author: Nariman Habili
+
+Description: Line based control protocol for the headless capture daemon.
+             Listens on the loopback interface only; one client at a time.
+
+             Commands (one per line, replies end with "OK" or "ERR <reason>"):
+                 session <directory> <name>      create or open a session
+                 start                           start capture
+                 stop                            stop capture
+                 exposure <camera> auto|<us>     set the exposure of a camera
+                 profile <name>                  apply a camera profile to all cameras
+                 colour <camera> <r> <g> <b> [gamma]
+                                                 set the colour gains (and gamma) of a camera
+                 stats                           camera, GPS and storage statistics
+                 benchmark [seconds]             write test frames to the session drive (default 10s)
+                 quit                            stop capture and exit
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CONTROL_SERVER_H
+#define CONTROL_SERVER_H
+
+#include "CaptureEngine.h"
+#include "Camera.h"
+#include "CameraProfiles.h"
+#include "GPS.h"
+#include "Session.h"
+#include "Database.h"
+#include "StorageForecast.h"
+#include <wx/wx.h>
+#include <wx/socket.h>
+#include <wx/tokenzr.h>
+#include <boost/shared_ptr.hpp>
+
+namespace rics
+{
+    class ControlServer
+    {
+    public:
+        ControlServer(Cameras* cameras, GPS* gps, Session* session, Database* db, CaptureEngine* engine);
+        ~ControlServer();
+
+        bool listen(unsigned short port);
+        void run();
+        void requestQuit();
+
+    private:
+        void serve(wxSocketBase* client);
+        bool readLine(wxSocketBase* client, wxString& line);
+        void writeLine(wxSocketBase* client, const wxString& line);
+        wxString execute(const wxString& line, wxSocketBase* client);
+
+        wxString openSession(const wxString& dir, const wxString& name);
+        wxString start();
+        wxString stop();
+        wxString setExposure(const wxString& camera, const wxString& value);
+        wxString applyProfile(const wxString& name);
+        wxString setColour(const wxString& camera, wxStringTokenizer& values);
+        void stats(wxSocketBase* client);
+        wxString benchmark(const wxString& seconds, bool compare, wxSocketBase* client);
+        wxString setVolumes(const wxString& mode, wxStringTokenizer& roots);
+
+    private:
+        Cameras* cameras_;
+        GPS* gps_;
+        Session* session_;
+        Database* db_;
+        CaptureEngine* engine_;
+        StorageForecast forecast_;
+        std::vector<wxString> volumeRoots_;//extra volumes for the next new session
+        SessionVolumes::Mode volumeMode_;
+
+        boost::shared_ptr<wxSocketServer> server_;
+        wxString pending_;//received data not yet returned by readLine
+        volatile bool quit_;
+    };
+} //namespace
+
+#endif //CONTROL_SERVER_H
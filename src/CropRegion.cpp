@@ -0,0 +1,155 @@
+/*
+Author: Nariman Habili
+
+Description: The part of each frame that is saved, per camera. Side facing
+             cameras can leave out sky and road surface, so less is
+             demosaiced, encoded and written. Kept in crops.ini by camera
+             name.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CropRegion.h"
+#include <wx/fileconf.h>
+#include <wx/filename.h>
+#include <wx/stdpaths.h>
+#include <algorithm>
+
+namespace rics
+{
+    CropRegion::CropRegion():
+    left_(0),
+    top_(0),
+    width_(0),
+    height_(0)
+    {
+    }
+
+    CropRegion::CropRegion(unsigned long left, unsigned long top, unsigned long width, unsigned long height):
+    left_(left),
+    top_(top),
+    width_(width),
+    height_(height)
+    {
+    }
+
+    CropRegion::~CropRegion()
+    {
+    }
+
+    unsigned long CropRegion::left() const
+    {
+        return left_;
+    }
+
+    unsigned long CropRegion::top() const
+    {
+        return top_;
+    }
+
+    unsigned long CropRegion::width() const
+    {
+        return width_;
+    }
+
+    unsigned long CropRegion::height() const
+    {
+        return height_;
+    }
+
+    bool CropRegion::whole() const
+    {
+        return width_ == 0 || height_ == 0;
+    }
+
+    bool CropRegion::operator==(const CropRegion& other) const
+    {
+        return left_ == other.left_ && top_ == other.top_ && width_ == other.width_ && height_ == other.height_;
+    }
+
+    //The region moved inside the frame, with an even left and top so the Bayer pattern
+    //is unchanged, and a width and height that are multiples of 16 (whole JPEG blocks).
+    //The whole frame if there is no region.
+    CropRegion CropRegion::fitted(unsigned long frameWidth, unsigned long frameHeight) const
+    {
+        if (whole())
+        {
+            return CropRegion(0, 0, frameWidth, frameHeight);
+        }
+
+        unsigned long width = std::min(std::max((width_ + 8) & ~15UL, 16UL), frameWidth);
+        unsigned long height = std::min(std::max((height_ + 8) & ~15UL, 16UL), frameHeight);
+        unsigned long left = std::min(left_, frameWidth - width) & ~1UL;
+        unsigned long top = std::min(top_, frameHeight - height) & ~1UL;
+
+        return CropRegion(left, top, width, height);
+    }
+
+    //The whole frame if the camera has no crop saved.
+    CropRegion CropRegion::load(const wxString& camera, const wxString& path)
+    {
+        wxFileConfig config(wxEmptyString, wxEmptyString, path, wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+        long left = 0;
+        long top = 0;
+        long width = 0;
+        long height = 0;
+
+        config.Read("/" + camera + "/Left", &left);
+        config.Read("/" + camera + "/Top", &top);
+        config.Read("/" + camera + "/Width", &width);
+        config.Read("/" + camera + "/Height", &height);
+
+        if (left < 0 || top < 0 || width <= 0 || height <= 0)
+        {
+            return CropRegion();
+        }
+
+        return CropRegion(left, top, width, height);
+    }
+
+    //Saving the whole frame removes the camera's crop.
+    bool CropRegion::save(const wxString& camera, const CropRegion& crop, const wxString& path)
+    {
+        if (camera == "")
+        {
+            return false;
+        }
+
+        wxFileName::Mkdir(wxFileName(path).GetPath(), 0777, wxPATH_MKDIR_FULL);
+        wxFileConfig config(wxEmptyString, wxEmptyString, path, wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+        config.DeleteGroup(camera);
+
+        if (!crop.whole())
+        {
+            config.SetPath("/" + camera);
+            config.Write("Left", static_cast<long>(crop.left()));
+            config.Write("Top", static_cast<long>(crop.top()));
+            config.Write("Width", static_cast<long>(crop.width()));
+            config.Write("Height", static_cast<long>(crop.height()));
+        }
+
+        return config.Flush();
+    }
+
+    //Next to the camera profiles.
+    wxString CropRegion::defaultPath()
+    {
+        return wxStandardPaths::Get().GetUserDataDir() + "\\crops.ini";
+    }
+
+}//namespace
@@ -0,0 +1,65 @@
+/*
+Author: Nariman Habili
+
+Description: The part of each frame that is saved, per camera. Side facing
+             cameras can leave out sky and road surface, so less is
+             demosaiced, encoded and written. Kept in crops.ini by camera
+             name.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CROP_REGION_H
+#define CROP_REGION_H
+
+#include <wx/wx.h>
+
+namespace rics
+{
+    //Pixels of the image sent by the camera (inside the sensor ROI). A width or 
+    //height of 0 means the whole frame.
+    class CropRegion
+    {
+    public:
+        CropRegion();
+        CropRegion(unsigned long left, unsigned long top, unsigned long width, unsigned long height);
+        ~CropRegion();
+
+        unsigned long left() const;
+        unsigned long top() const;
+        unsigned long width() const;
+        unsigned long height() const;
+        bool whole() const;
+        bool operator==(const CropRegion& other) const;
+
+        CropRegion fitted(unsigned long frameWidth, unsigned long frameHeight) const;
+
+        static CropRegion load(const wxString& camera, const wxString& path = defaultPath());
+        static bool save(const wxString& camera, const CropRegion& crop, const wxString& path = defaultPath());
+        static wxString defaultPath();
+
+    private:
+        unsigned long left_;
+        unsigned long top_;
+        unsigned long width_;
+        unsigned long height_;
+    };
+
+}//namespace
+
+#endif //CROP_REGION_H
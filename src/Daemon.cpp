@@ -0,0 +1,212 @@
+/*
+Author: Nariman Habili
+
+Description: Headless capture daemon (ricsd). Runs the camera, GPS and
+             database pipeline without the GUI and is controlled through
+             the line protocol in ControlServer.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Daemon.h"
+#include "CameraStartup.h"
+#include <wx/cmdline.h>
+#include <algorithm>
+#include <cassert>
+
+namespace rics
+{
+    static const long defaultControlPort = 7450;
+
+    Daemon::Daemon():
+    name_(wxString::Format(wxT("ricsd-%s"), wxGetUserId().c_str())),
+    instanceChecker_(boost::shared_ptr<wxSingleInstanceChecker>(new wxSingleInstanceChecker(name_)))
+    {
+    }
+
+    Daemon::~Daemon()
+    {
+        cameraManager_.reset();
+
+        //uninitialise the cameras (a camera re-opened after being unplugged has a new handle)
+        for (size_t i = 0; i < cameras_.size(); ++i)
+        {
+            cameras_[i].close();
+        }
+        
+        PvUnInitialize();
+    }
+
+    bool Daemon::OnInit()
+    {
+        static const wxCmdLineEntryDesc cmdLineDesc[] =
+        {
+            { wxCMD_LINE_OPTION, "p", "port", "control port (loopback only)", wxCMD_LINE_VAL_NUMBER },
+            { wxCMD_LINE_OPTION, "g", "gps", "GPS COM port number, searched for if not given", wxCMD_LINE_VAL_NUMBER },
+            { wxCMD_LINE_OPTION, "s", "stream", "serve MJPEG previews on this HTTP port", wxCMD_LINE_VAL_NUMBER },
+            { wxCMD_LINE_SWITCH, "l", "stream-lan", "allow other computers to view the previews" },
+            { wxCMD_LINE_OPTION, "c", "cameras", "number of cameras expected, to start as soon as they are found", wxCMD_LINE_VAL_NUMBER },
+            { wxCMD_LINE_OPTION, "w", "watchdog", "restart cameras with no frames for this many ms, 0 to disable (default 2000)", wxCMD_LINE_VAL_NUMBER },
+            { wxCMD_LINE_OPTION, "f", "pixel-format", "Bayer8 (default), Bayer12Packed or Bayer16" },
+            { wxCMD_LINE_SWITCH, "r", "archive-raw", "save the 12 bit Bayer data of each frame as well (12 and 16 bit formats)" },
+            { wxCMD_LINE_OPTION, "b", "blur", "set exposure and gain from the previews, allowing this many mm of travel during the exposure", wxCMD_LINE_VAL_NUMBER },
+            { wxCMD_LINE_NONE }
+        };
+
+        wxCmdLineParser parser(cmdLineDesc, argc, argv);
+        if (parser.Parse() != 0)
+        {
+            return false;
+        }
+
+        long port = defaultControlPort;
+        parser.Found("port", &port);
+        long gpsPort = 0;
+        parser.Found("gps", &gpsPort);
+        long expectedCameras = 0;
+        parser.Found("cameras", &expectedCameras);
+
+        StreamSettings streamSettings;
+        long streamPort = 0;
+        if (parser.Found("stream", &streamPort))
+        {
+            streamSettings.setEnabled(true);
+            streamSettings.setPort(static_cast<unsigned short>(streamPort));
+            streamSettings.setLan(parser.Found("stream-lan"));
+        }
+
+        Watchdog watchdog;
+        long deadline;
+        if (parser.Found("watchdog", &deadline))
+        {
+            watchdog.setEnabled(deadline > 0);
+            watchdog.setDeadline(std::max(deadline, 500L));
+        }
+
+        ExposureControl exposureControl;
+        long blurBudget;
+        if (parser.Found("blur", &blurBudget) && blurBudget > 0)
+        {
+            exposureControl.setEnabled(true);
+            exposureControl.setBlurBudget(blurBudget);
+        }
+
+        //make sure only one instance of the process is running
+        if (instanceChecker_->IsAnotherRunning())
+        {
+            wxLogError(_("ricsd already running, aborting."));
+            return false;
+        }
+
+        if (PvInitialize())
+        {
+            wxLogError(_("Failed to initialise the API, aborting."));
+            return false;
+        }
+
+        CameraStartup startup(expectedCameras > 0 ? expectedCameras : 0);
+        if (!startup.open(&cameras_))
+        {
+            wxLogError(_("No cameras attached, aborting."));
+            return false; 
+        }
+        wxLogMessage("%s", startup.timing().c_str());
+
+        wxString pixelFormat;
+        if (parser.Found("pixel-format", &pixelFormat))
+        {
+            if (pixelFormat != "Bayer8" && pixelFormat != "Bayer12Packed" && pixelFormat != "Bayer16")
+            {
+                wxLogError(_("Unknown pixel format %s, aborting."), pixelFormat.c_str());
+                return false;
+            }
+        }
+        for (size_t i = 0; i < cameras_.size(); ++i)
+        {
+            if (pixelFormat != "")
+            {
+                cameras_[i].setPixelFormat(pixelFormat);
+            }
+            cameras_[i].setArchiveRaw(parser.Found("archive-raw"));
+        }
+
+        //An unplugged camera pauses just its own stream until it is plugged back in.
+        cameraManager_ = boost::shared_ptr<CameraManager>(new CameraManager(&cameras_));
+
+        if (!openGPS(gpsPort))
+        {
+            wxLogWarning(_("No GPS device detected. Sessions can't be created."));
+        }
+
+        session_ = boost::shared_ptr<Session>(new Session(cameras_.size()));
+        engine_ = boost::shared_ptr<CaptureEngine>(new CaptureEngine(&cameras_, &gps_, session_.get(), &db_));
+        engine_->setStreamSettings(streamSettings);
+        engine_->setWatchdog(watchdog);
+        engine_->setExposureControl(exposureControl);
+        engine_->startGPS(NULL);
+
+        wxSocketBase::Initialize();
+        server_ = boost::shared_ptr<ControlServer>(new ControlServer(&cameras_, &gps_, session_.get(), &db_, engine_.get()));
+        if (!server_->listen(static_cast<unsigned short>(port)))
+        {
+            wxLogError(_("Could not listen on control port %ld, aborting."), port);
+            engine_->deleteAllThreads();
+            return false;
+        }
+
+        wxLogMessage(_("ricsd: %lu camera(s), listening on 127.0.0.1:%ld"), (unsigned long)cameras_.size(), port);
+
+        return true;
+    }
+
+    //The control server runs on the main thread until told to quit.
+    int Daemon::OnRun()
+    {
+        server_->run();
+        return 0;
+    }
+
+    int Daemon::OnExit()
+    {
+        engine_->stop();
+        engine_->deleteAllThreads();
+        db_.databaseClose();
+        return 0;
+    }
+
+    //Open the given COM port, or search the ports as the GPS properties dialog does.
+    bool Daemon::openGPS(long port)
+    {
+        int first = port > 0 ? port : 1;
+        int last = port > 0 ? port : 64;
+
+        for (int i = first; i <= last; ++i)
+        {
+            gps_.close();
+            if (gps_.openPort(i))
+            {
+                gps_.setGPSActive(true);
+                return true;
+            }
+        }
+
+        gps_.setGPSActive(false);
+        return false;
+    }
+
+} //namespace
@@ -0,0 +1,76 @@
+/*
+Author: Nariman Habili
+
+Description: Headless capture daemon (ricsd). Runs the camera, GPS and
+             database pipeline without the GUI and is controlled through
+             the line protocol in ControlServer.
+
+             Usage: ricsd [--port <tcp port>] [--gps <COM port number>]
+                          [--stream <http port> [--stream-lan]]
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "Camera.h"
+#include "CameraManager.h"
+#include "CaptureEngine.h"
+#include "ControlServer.h"
+#include "GPS.h"
+#include "Session.h"
+#include "Database.h"
+#include <wx/wx.h>
+#include <wx/app.h>
+#include <wx/snglinst.h>
+#include <boost/shared_ptr.hpp>
+
+namespace rics
+{
+    class Daemon: public wxAppConsole
+    {
+    public:
+        Daemon();
+        ~Daemon();
+
+    private:
+        virtual bool OnInit();
+        virtual int OnRun();
+        virtual int OnExit();
+        bool openGPS(long port);
+
+    private:
+        Cameras cameras_;
+        boost::shared_ptr<CameraManager> cameraManager_;
+
+        GPS gps_;
+        Database db_;
+        boost::shared_ptr<Session> session_;
+        boost::shared_ptr<CaptureEngine> engine_;
+        boost::shared_ptr<ControlServer> server_;
+
+        const wxString name_;
+        boost::shared_ptr<wxSingleInstanceChecker> instanceChecker_;
+    };
+
+    IMPLEMENT_APP_CONSOLE(Daemon)
+
+} //namespace
+
+#endif //DAEMON_H
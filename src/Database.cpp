@@ -22,6 +22,9 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "Database.h"
+#include <wx/utils.h>
+#include <algorithm>
+#include <cstdlib>
 
 namespace rics
 {
@@ -44,9 +47,67 @@ namespace rics
         int code = sqlite3_exec(db_, "PRAGMA synchronous=OFF", NULL, 0, &errMsg1);
         sqlite3_free(errMsg1);
 
-        //char *errMsg2 = 0;
-        //code = sqlite3_exec(db_, "PRAGMA journal_mode=OFF", NULL, 0, &errMsg2);
-        //sqlite3_free(errMsg2);
+        //Frames not saved while stationary are logged here, one row per run of dropped frames.
+        char *errMsg2 = 0;
+        code = sqlite3_exec(db_, 
+                            "create table if not exists dropped_frames(camera_ID, start_time, end_time, dropped, reason)", 
+                            NULL, 0, &errMsg2);
+        sqlite3_free(errMsg2);
+
+        //In synchronised mode there is one row per capture set instead of one row per camera frame.
+        char *errMsg3 = 0;
+        code = sqlite3_exec(db_, 
+                            "create table if not exists capture_sets(set_ID, time, latitude, longitude, speed, bearing, satellites, fix_quality, cameras)", 
+                            NULL, 0, &errMsg3);
+        sqlite3_free(errMsg3);
+
+        //Decisions of the bandwidth controller, one row per camera per sample.
+        char *errMsg4 = 0;
+        code = sqlite3_exec(db_, 
+                            "create table if not exists bandwidth_log(time, camera_ID, packets_missed, packets_resent, frame_rate, stream_bytes_per_second, packet_size, action)", 
+                            NULL, 0, &errMsg4);
+        sqlite3_free(errMsg4);
+
+        //Frames already processed by the batch tool, so an interrupted job can be resumed.
+        char *errMsg5 = 0;
+        code = sqlite3_exec(db_, 
+                            "create table if not exists batch_progress(job, camera, frame, time)", 
+                            NULL, 0, &errMsg5);
+        sqlite3_free(errMsg5);
+
+        //Cameras restarted by the watchdog after they stopped sending frames.
+        char *errMsg6 = 0;
+        code = sqlite3_exec(db_, 
+                            "create table if not exists camera_recovery(camera_ID, stall_time, end_time, downtime_ms, attempts, failed_attempts, result)", 
+                            NULL, 0, &errMsg6);
+        sqlite3_free(errMsg6);
+
+        //Cost of the pixel format of each camera (bandwidth and PC time), once a minute.
+        char *errMsg7 = 0;
+        code = sqlite3_exec(db_, 
+                            "create table if not exists pixel_format_log(time, camera_ID, pixel_format, bytes_per_frame, frame_rate, convert_ms, archive_raw)", 
+                            NULL, 0, &errMsg7);
+        sqlite3_free(errMsg7);
+
+        //Where each saved frame was written. Frames may be on any of the session's volumes.
+        char *errMsg8 = 0;
+        code = sqlite3_exec(db_, 
+                            "create table if not exists frame_paths(camera, frame, path)", 
+                            NULL, 0, &errMsg8);
+        sqlite3_free(errMsg8);
+
+        //The session directory on each volume (the first is where the database is), and
+        //volumes taken out of use while saving.
+        char *errMsg9 = 0;
+        code = sqlite3_exec(db_, 
+                            "create table if not exists session_volumes(dir, mode);"
+                            "create table if not exists volume_log(time, dir, event, free_bytes)", 
+                            NULL, 0, &errMsg9);
+        sqlite3_free(errMsg9);
+
+        //char *errMsg10 = 0;
+        //code = sqlite3_exec(db_, "PRAGMA journal_mode=OFF", NULL, 0, &errMsg10);
+        //sqlite3_free(errMsg10);
 
         //This avoids each new SQL statement having a new
         //transaction started for it, which is very expensive.
@@ -62,11 +123,23 @@ namespace rics
     {
         wxString tb = "create table " +
                       table + 
-                      "(frame, time, latitude, longitude, speed, bearing, satellites, fix_quality, camera_ID)";
+                      "(frame, time, latitude, longitude, speed, bearing, satellites, fix_quality, camera_ID, sharpness, "
+                      "crop_left, crop_top, crop_width, crop_height)";
         
         char *errMsg = 0;
         int code = sqlite3_exec(db_, tb.ToAscii(), NULL, 0, &errMsg);//can't create the same table twice!!
         sqlite3_free(errMsg);
+
+        //Tables of sessions recorded by older versions don't have the sharpness or crop 
+        //columns. Fails harmlessly if they're already there.
+        const char* columns[] = {"sharpness", "crop_left", "crop_top", "crop_width", "crop_height"};
+        for (size_t i = 0; i < sizeof(columns)/sizeof(columns[0]); ++i)
+        {
+            wxString alter = "alter table " + table + " add column " + columns[i];
+            char *errMsg2 = 0;
+            code = sqlite3_exec(db_, alter.ToAscii(), NULL, 0, &errMsg2);
+            sqlite3_free(errMsg2);
+        }
     }
     
     void Database::databaseEnterData(const wxString& table,
@@ -78,7 +151,9 @@ namespace rics
                                      wxString& bearing,
                                      wxString& satellites,
                                      wxString& fixQuality,
-                                     wxString& cameraID)
+                                     wxString& cameraID,
+                                     double sharpness,
+                                     const CropRegion& crop)
     {
         wxString data = "insert into " + table + " values(" +
                         boost::lexical_cast<std::string>(frame) + "," +
@@ -89,30 +164,487 @@ namespace rics
                         bearing + "," +
                         satellites + "," +
                         fixQuality  + "," +
-                        cameraID +
+                        cameraID + "," +
+                        wxString::Format("%.1f", sharpness) + "," +
+                        wxString::Format("%lu,%lu,%lu,%lu", crop.left(), crop.top(), crop.width(), crop.height()) +
                         ")";
         
+        wxMutexLocker lock(mutex_);
         char *errMsg = 0;
         int code = sqlite3_exec(db_, data.ToAscii(), NULL, 0, &errMsg);
         sqlite3_free(errMsg);
     }
  
-    //Maximum frame number recorded in the database.
-    long int Database::maxFrame(const wxString& table)
+    void Database::databaseEnterDropped(const wxString& cameraID,
+                                        const wxString& startTime,
+                                        const wxString& endTime,
+                                        unsigned long dropped,
+                                        const wxString& reason)
     {
-        wxString sql = "select count(frame) from " + table;
+        wxString data = "insert into dropped_frames values(" +
+                        cameraID + "," +
+                        startTime + "," +
+                        endTime + "," +
+                        boost::lexical_cast<std::string>(dropped) + "," +
+                        "'" + reason + "'" +
+                        ")";
+        
+        wxMutexLocker lock(mutex_);
+        char *errMsg = 0;
+        int code = sqlite3_exec(db_, data.ToAscii(), NULL, 0, &errMsg);
+        sqlite3_free(errMsg);
+    }
+
+    void Database::databaseEnterCaptureSet(long setID,
+                                           const wxString& timeStamp,
+                                           const wxString& lat,
+                                           const wxString& lon,
+                                           const wxString& speed,
+                                           const wxString& bearing,
+                                           const wxString& satellites,
+                                           const wxString& fixQuality,
+                                           unsigned long cameras)
+    {
+        wxString data = "insert into capture_sets values(" +
+                        boost::lexical_cast<std::string>(setID) + "," +
+                        timeStamp + "," +
+                        lat + "," +
+                        lon + "," +
+                        speed + "," +
+                        bearing + "," +
+                        satellites + "," +
+                        fixQuality + "," +
+                        boost::lexical_cast<std::string>(cameras) +
+                        ")";
+        
+        wxMutexLocker lock(mutex_);
+        char *errMsg = 0;
+        int code = sqlite3_exec(db_, data.ToAscii(), NULL, 0, &errMsg);
+        sqlite3_free(errMsg);
+    }
+
+    //A frame that arrived after its capture set was written, counted in the set's row.
+    void Database::databaseAddToCaptureSet(long setID)
+    {
+        wxString data = "update capture_sets set cameras = cameras + 1 where set_ID = " + 
+                        boost::lexical_cast<std::string>(setID);
+
+        wxMutexLocker lock(mutex_);
+        char *errMsg = 0;
+        int code = sqlite3_exec(db_, data.ToAscii(), NULL, 0, &errMsg);
+        sqlite3_free(errMsg);
+    }
+
+    //"time" is the PC clock in seconds as the controller also runs without GPS.
+    void Database::databaseEnterBandwidth(const wxString& cameraID,
+                                          unsigned long packetsMissed,
+                                          unsigned long packetsResent,
+                                          float frameRate,
+                                          unsigned long streamBytesPerSecond,
+                                          unsigned long packetSize,
+                                          const wxString& action)
+    {
+        wxString data = "insert into bandwidth_log values(" +
+                        boost::lexical_cast<std::string>(wxGetLocalTime()) + "," +
+                        cameraID + "," +
+                        boost::lexical_cast<std::string>(packetsMissed) + "," +
+                        boost::lexical_cast<std::string>(packetsResent) + "," +
+                        boost::lexical_cast<std::string>(frameRate) + "," +
+                        boost::lexical_cast<std::string>(streamBytesPerSecond) + "," +
+                        boost::lexical_cast<std::string>(packetSize) + "," +
+                        "'" + action + "'" +
+                        ")";
+        
+        wxMutexLocker lock(mutex_);
+        char *errMsg = 0;
+        int code = sqlite3_exec(db_, data.ToAscii(), NULL, 0, &errMsg);
+        sqlite3_free(errMsg);
+    }
+
+    //"stallTime" and "endTime" are the PC clock in seconds, "downtime" is in milliseconds.
+    void Database::databaseEnterRecovery(const wxString& cameraID,
+                                         long stallTime,
+                                         long endTime,
+                                         unsigned long downtime,
+                                         unsigned long attempts,
+                                         unsigned long failedAttempts,
+                                         const wxString& result)
+    {
+        wxString data = "insert into camera_recovery values(" +
+                        cameraID + "," +
+                        boost::lexical_cast<std::string>(stallTime) + "," +
+                        boost::lexical_cast<std::string>(endTime) + "," +
+                        boost::lexical_cast<std::string>(downtime) + "," +
+                        boost::lexical_cast<std::string>(attempts) + "," +
+                        boost::lexical_cast<std::string>(failedAttempts) + "," +
+                        "'" + result + "'" +
+                        ")";
+        
+        wxMutexLocker lock(mutex_);
+        char *errMsg = 0;
+        int code = sqlite3_exec(db_, data.ToAscii(), NULL, 0, &errMsg);
+        sqlite3_free(errMsg);
+    }
+
+    //"convertTime" is the ms taken to turn a frame into RGB on the PC.
+    void Database::databaseEnterPixelFormat(const wxString& cameraID,
+                                            const wxString& pixelFormat,
+                                            unsigned long bytesPerFrame,
+                                            float frameRate,
+                                            double convertTime,
+                                            bool archiveRaw)
+    {
+        wxString data = "insert into pixel_format_log values(" +
+                        boost::lexical_cast<std::string>(wxGetLocalTime()) + "," +
+                        cameraID + "," +
+                        "'" + pixelFormat + "'," +
+                        boost::lexical_cast<std::string>(bytesPerFrame) + "," +
+                        boost::lexical_cast<std::string>(frameRate) + "," +
+                        wxString::Format("%.2f", convertTime) + "," +
+                        (archiveRaw ? "1" : "0") +
+                        ")";
+        
+        wxMutexLocker lock(mutex_);
+        char *errMsg = 0;
+        int code = sqlite3_exec(db_, data.ToAscii(), NULL, 0, &errMsg);
+        sqlite3_free(errMsg);
+    }
+
+    //Record frames finished by the batch tool, in one transaction.
+    void Database::databaseEnterBatchDone(const wxString& job,
+                                          const std::vector<wxString>& cameras,
+                                          const std::vector<long>& frames)
+    {
+        wxString time = boost::lexical_cast<std::string>(wxGetLocalTime());
+        wxString data = "BEGIN;";
+        
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            data += "insert into batch_progress values('" + 
+                    job + "','" + 
+                    cameras[i] + "'," + 
+                    boost::lexical_cast<std::string>(frames[i]) + "," +
+                    time + 
+                    ");";
+        }
+        data += "END;";
+
+        wxMutexLocker lock(mutex_);
+        char *errMsg = 0;
+        int code = sqlite3_exec(db_, data.ToAscii(), NULL, 0, &errMsg);
+        sqlite3_free(errMsg);
+    }
+
+    static int callbackBatchDone(void* frames, int argc, char **argv, char **azColName)
+    {
+        if (argv[0])
+        {
+            static_cast<std::set<long>*>(frames)->insert(boost::lexical_cast<long>(argv[0]));
+        }
+        return 0;
+    }
+
+    //Frames of "camera" already finished by batch job "job".
+    std::set<long> Database::batchDone(const wxString& job, const wxString& camera)
+    {
+        std::set<long> frames;
+        wxString sql = "select frame from batch_progress where job = '" + job + "' and camera = '" + camera + "'";
+
+        wxMutexLocker lock(mutex_);
         char* errMsg = 0;
-        int code = sqlite3_exec(db_, sql.ToAscii(), callbackCount, 0, &errMsg);//get number of rows in db.
+        int code = sqlite3_exec(db_, sql.ToAscii(), callbackBatchDone, &frames, &errMsg);
         sqlite3_free(errMsg);
 
-        if (!countFrames)
+        return frames;
+    }
+
+    static int callbackTables(void* tables, int argc, char **argv, char **azColName)
+    {
+        if (argv[0])
+        {
+            static_cast<std::vector<wxString>*>(tables)->push_back(argv[0]);
+        }
+        return 0;
+    }
+
+    //Text as an SQL string literal
+    static wxString quoted(const wxString& text)
+    {
+        wxString escaped = text;
+        escaped.Replace("'", "''");
+        return "'" + escaped + "'";
+    }
+
+    //"path" is the full path of the JPEG.
+    void Database::databaseEnterFramePath(const wxString& camera, long frame, const wxString& path)
+    {
+        wxString data = "insert into frame_paths values(" +
+                        quoted(camera) + "," +
+                        boost::lexical_cast<std::string>(frame) + "," +
+                        quoted(path) +
+                        ")";
+
+        wxMutexLocker lock(mutex_);
+        char *errMsg = 0;
+        int code = sqlite3_exec(db_, data.ToAscii(), NULL, 0, &errMsg);
+        sqlite3_free(errMsg);
+    }
+
+    //The JPEG at "path" was written to "newPath" instead. An empty "newPath" marks the 
+    //frame as lost.
+    void Database::databaseMoveFramePath(const wxString& camera, const wxString& path, const wxString& newPath)
+    {
+        wxString data = "update frame_paths set path = " + quoted(newPath) + 
+                        " where camera = " + quoted(camera) + 
+                        " and path = " + quoted(path);
+
+        wxMutexLocker lock(mutex_);
+        char *errMsg = 0;
+        int code = sqlite3_exec(db_, data.ToAscii(), NULL, 0, &errMsg);
+        sqlite3_free(errMsg);
+    }
+
+    static int callbackFramePaths(void* paths, int argc, char **argv, char **azColName)
+    {
+        if (argv[0] && argv[1])
+        {
+            (*static_cast<std::map<long, wxString>*>(paths))[boost::lexical_cast<long>(argv[0])] = argv[1];
+        }
+        return 0;
+    }
+
+    //Frame number to JPEG path, for the frames of "camera". Sessions recorded by older 
+    //versions have none; their frames are all in <session>\<camera>.
+    std::map<long, wxString> Database::framePaths(const wxString& camera)
+    {
+        std::map<long, wxString> paths;
+        wxString sql = "select frame, path from frame_paths where camera = " + quoted(camera) + " order by rowid";
+
+        wxMutexLocker lock(mutex_);
+        char* errMsg = 0;
+        int code = sqlite3_exec(db_, sql.ToAscii(), callbackFramePaths, &paths, &errMsg);
+        sqlite3_free(errMsg);
+
+        return paths;
+    }
+
+    void Database::databaseEnterSessionVolume(const wxString& dir, const wxString& mode)
+    {
+        wxString data = "insert into session_volumes values(" + quoted(dir) + "," + quoted(mode) + ")";
+
+        wxMutexLocker lock(mutex_);
+        char *errMsg = 0;
+        int code = sqlite3_exec(db_, data.ToAscii(), NULL, 0, &errMsg);
+        sqlite3_free(errMsg);
+    }
+
+    static int callbackSessionVolumes(void* volumes, int argc, char **argv, char **azColName)
+    {
+        std::pair<std::vector<wxString>, wxString>* result = static_cast<std::pair<std::vector<wxString>, wxString>*>(volumes);
+        if (argv[0])
+        {
+            result->first.push_back(argv[0]);
+            result->second = argv[1] ? argv[1] : "";
+        }
+        return 0;
+    }
+
+    //The session directory on each volume, in the order given when the session was
+    //created. Empty for single volume sessions.
+    std::vector<wxString> Database::sessionVolumes(wxString& mode)
+    {
+        std::pair<std::vector<wxString>, wxString> volumes;
+
+        wxMutexLocker lock(mutex_);
+        char* errMsg = 0;
+        int code = sqlite3_exec(db_, "select dir, mode from session_volumes order by rowid", callbackSessionVolumes, &volumes, &errMsg);
+        sqlite3_free(errMsg);
+
+        mode = volumes.second;
+        return volumes.first;
+    }
+
+    //"freeBytes" is -1 if not known.
+    void Database::databaseEnterVolumeEvent(const wxString& dir, const wxString& event, double freeBytes)
+    {
+        wxString data = "insert into volume_log values(" +
+                        boost::lexical_cast<std::string>(wxGetLocalTime()) + "," +
+                        quoted(dir) + "," +
+                        quoted(event) + "," +
+                        wxString::Format("%.0f", freeBytes) +
+                        ")";
+
+        wxMutexLocker lock(mutex_);
+        char *errMsg = 0;
+        int code = sqlite3_exec(db_, data.ToAscii(), NULL, 0, &errMsg);
+        sqlite3_free(errMsg);
+    }
+
+    //Names of all tables in the database.
+    std::vector<wxString> Database::tables()
+    {
+        std::vector<wxString> tables;
+
+        wxMutexLocker lock(mutex_);
+        char* errMsg = 0;
+        int code = sqlite3_exec(db_, "select name from sqlite_master where type = 'table'", callbackTables, &tables, &errMsg);
+        sqlite3_free(errMsg);
+
+        return tables;
+    }
+
+    //GPS values are "--" when there was no fix.
+    static bool parseDouble(const char* text, double& value)
+    {
+        if (text == NULL)
+        {
+            return false;
+        }
+
+        char* end;
+        value = strtod(text, &end);
+        return end != text;
+    }
+
+    static int callbackFrameRecords(void* records, int argc, char **argv, char **azColName)
+    {
+        FrameRecord record;
+        double frame;
+        if (!parseDouble(argv[0], frame))
         {
             return 0;
         }
-        else
+
+        record.frame = static_cast<long>(frame);
+        if (!parseDouble(argv[1], record.time))
+        {
+            record.time = 0.0;
+        }
+        record.hasFix = parseDouble(argv[2], record.latitude) && parseDouble(argv[3], record.longitude);
+        if (!parseDouble(argv[4], record.speed))
+        {
+            record.speed = 0.0;
+        }
+        if (argc < 6 || !parseDouble(argv[5], record.sharpness))
+        {
+            record.sharpness = -1.0;
+        }
+
+        static_cast<std::vector<FrameRecord>*>(records)->push_back(record);
+        return 0;
+    }
+
+    //Every frame of a camera table, in frame order.
+    std::vector<FrameRecord> Database::frameRecords(const wxString& table)
+    {
+        std::vector<FrameRecord> records;
+        wxString sql = "select frame, time, latitude, longitude, speed, sharpness from " + table + " order by frame";
+
+        wxMutexLocker lock(mutex_);
+        char* errMsg = 0;
+        int code = sqlite3_exec(db_, sql.ToAscii(), callbackFrameRecords, &records, &errMsg);
+        sqlite3_free(errMsg);
+
+        //Older sessions, without the sharpness column.
+        if (code != SQLITE_OK)
+        {
+            records.clear();
+            sql = "select frame, time, latitude, longitude, speed from " + table + " order by frame";
+            char* errMsg2 = 0;
+            code = sqlite3_exec(db_, sql.ToAscii(), callbackFrameRecords, &records, &errMsg2);
+            sqlite3_free(errMsg2);
+        }
+
+        return records;
+    }
+
+    //The frames of "camera" in a synchronised session, which are numbered by capture 
+    //set and leave the camera's table empty: the capture sets it saved a frame of, 
+    //with the set's GPS data. No sharpness is recorded for them.
+    std::vector<FrameRecord> Database::captureSetRecords(const wxString& camera)
+    {
+        std::vector<FrameRecord> records;
+        wxString sql = "select set_ID, time, latitude, longitude, speed from capture_sets "
+                       "where set_ID in (select frame from frame_paths where camera = " + quoted(camera) + ") "
+                       "group by set_ID order by set_ID";
+
+        wxMutexLocker lock(mutex_);
+        char* errMsg = 0;
+        int code = sqlite3_exec(db_, sql.ToAscii(), callbackFrameRecords, &records, &errMsg);
+        sqlite3_free(errMsg);
+
+        return records;
+    }
+
+    static int callbackFrameCrops(void* crops, int argc, char **argv, char **azColName)
+    {
+        double values[5];
+        for (int i = 0; i < 5; ++i)
+        {
+            if (!parseDouble(argv[i], values[i]) || values[i] < 0.0)
+            {
+                return 0;
+            }
+        }
+
+        (*static_cast<std::map<long, CropRegion>*>(crops))[static_cast<long>(values[0])] = 
+            CropRegion(static_cast<unsigned long>(values[1]), 
+                       static_cast<unsigned long>(values[2]),
+                       static_cast<unsigned long>(values[3]),
+                       static_cast<unsigned long>(values[4]));
+        return 0;
+    }
+
+    //The region of the camera's frame each frame was saved from. Frames recorded by 
+    //older versions, without the crop columns, are missing; they are whole frames.
+    std::map<long, CropRegion> Database::frameCrops(const wxString& table)
+    {
+        std::map<long, CropRegion> crops;
+        wxString sql = "select frame, crop_left, crop_top, crop_width, crop_height from " + table;
+
+        wxMutexLocker lock(mutex_);
+        char* errMsg = 0;
+        int code = sqlite3_exec(db_, sql.ToAscii(), callbackFrameCrops, &crops, &errMsg);
+        sqlite3_free(errMsg);
+
+        return crops;
+    }
+
+    static int callbackMax(void* highest, int argc, char **argv, char **azColName)
+    {
+        double value;
+        if (parseDouble(argv[0], value))
+        {
+            long* max = static_cast<long*>(highest);
+            *max = std::max(*max, static_cast<long>(value));
+        }
+        return 0;
+    }
+
+    //The number for the next frame of "camera", one past the highest recorded. Frames
+    //are numbered by capture set in synchronised sessions, which leave the camera's 
+    //table empty, so capture_sets and frame_paths are looked at too. 0 for a new session.
+    long int Database::nextFrame(const wxString& camera)
+    {
+        const wxString queries[] = 
+        {
+            "select max(frame) from " + camera,
+            "select max(frame) from frame_paths where camera = " + quoted(camera),
+            "select max(set_ID) from capture_sets"
+        };
+
+        long highest = -1;
+
+        //Also called from the camera threads when a camera is plugged back in.
+        wxMutexLocker lock(mutex_);
+        for (size_t i = 0; i < sizeof(queries)/sizeof(queries[0]); ++i)
         {
-            return countFrames - 1;
+            char* errMsg = 0;
+            int code = sqlite3_exec(db_, queries[i].ToAscii(), callbackMax, &highest, &errMsg);
+            sqlite3_free(errMsg);
         }
+
+        return highest + 1;
     }
 
     //Begin and transaction are the begin and end of a sqlite sentence used to write
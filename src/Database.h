@@ -25,18 +25,28 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 #define Database_H
 
 #include "sqlite3.h"
+#include "CropRegion.h"
 #include <wx/string.h>
+#include <wx/thread.h>
 #include <boost/lexical_cast.hpp>
 #include <boost/shared_array.hpp>
+#include <map>
+#include <set>
+#include <vector>
 
 namespace rics
 {
-    static long int countFrames;
-    static int callbackCount(void* maxFrame, int argc, char **argv, char **azColName)
-    {  
-        countFrames = boost::lexical_cast<long int>(argv[0] ? argv[0] : "NULL");
-        return 0;
-    }
+    //One row of a camera table, as read back for review.
+    struct FrameRecord
+    {
+        long frame;
+        double time;
+        double latitude;
+        double longitude;
+        double speed;
+        bool hasFix;//latitude and longitude are valid
+        double sharpness;//-1 if not recorded (sessions from older versions)
+    };
 
     class Database
     {
@@ -55,14 +65,66 @@ namespace rics
                                wxString& bearing,
                                wxString& satellites,
                                wxString& fixQuality,
-                               wxString& cameraID);
-        long int maxFrame(const wxString& table);
+                               wxString& cameraID,
+                               double sharpness,
+                               const CropRegion& crop);
+        void databaseEnterDropped(const wxString& cameraID,
+                                  const wxString& startTime,
+                                  const wxString& endTime,
+                                  unsigned long dropped,
+                                  const wxString& reason);
+        void databaseEnterCaptureSet(long setID,
+                                     const wxString& timeStamp,
+                                     const wxString& lat,
+                                     const wxString& lon,
+                                     const wxString& speed,
+                                     const wxString& bearing,
+                                     const wxString& satellites,
+                                     const wxString& fixQuality,
+                                     unsigned long cameras);
+        void databaseAddToCaptureSet(long setID);
+        void databaseEnterBandwidth(const wxString& cameraID,
+                                    unsigned long packetsMissed,
+                                    unsigned long packetsResent,
+                                    float frameRate,
+                                    unsigned long streamBytesPerSecond,
+                                    unsigned long packetSize,
+                                    const wxString& action);
+        void databaseEnterRecovery(const wxString& cameraID,
+                                   long stallTime,
+                                   long endTime,
+                                   unsigned long downtime,
+                                   unsigned long attempts,
+                                   unsigned long failedAttempts,
+                                   const wxString& result);
+        void databaseEnterPixelFormat(const wxString& cameraID,
+                                      const wxString& pixelFormat,
+                                      unsigned long bytesPerFrame,
+                                      float frameRate,
+                                      double convertTime,
+                                      bool archiveRaw);
+        void databaseEnterBatchDone(const wxString& job,
+                                    const std::vector<wxString>& cameras,
+                                    const std::vector<long>& frames);
+        std::set<long> batchDone(const wxString& job, const wxString& camera);
+        void databaseEnterFramePath(const wxString& camera, long frame, const wxString& path);
+        void databaseMoveFramePath(const wxString& camera, const wxString& path, const wxString& newPath);
+        std::map<long, wxString> framePaths(const wxString& camera);
+        void databaseEnterSessionVolume(const wxString& dir, const wxString& mode);
+        std::vector<wxString> sessionVolumes(wxString& mode);
+        void databaseEnterVolumeEvent(const wxString& dir, const wxString& event, double freeBytes);
+        std::vector<wxString> tables();
+        std::vector<FrameRecord> frameRecords(const wxString& table);
+        std::vector<FrameRecord> captureSetRecords(const wxString& camera);
+        std::map<long, CropRegion> frameCrops(const wxString& table);
+        long int nextFrame(const wxString& camera);
         void beginTransaction();
         void endTransaction();
         void databaseClose();
 
     private:
         sqlite3 *db_;
+        wxMutex mutex_;//camera threads write concurrently
     };
 
     typedef boost::shared_array<wxString> TableNames;
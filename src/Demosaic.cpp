@@ -0,0 +1,243 @@
+/*
+Author: Nariman Habili
+
+Description: Turns the raw Bayer8 image from the camera into RGB by bilinear
+             interpolation, applying the colour settings (gains, colour
+             matrix and gamma) through lookup tables in the same pass.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Demosaic.h"
+#include <algorithm>
+#include <cmath>
+
+namespace rics
+{
+    static const int fixedScale = 16;   //matrix table units per 8 bit level
+    static const int maxFixed = 4095;
+
+    Demosaic::Demosaic():
+    changed_(true),
+    matrixTables_(9*256),
+    gammaTable_(maxFixed + 1)
+    {
+    }
+
+    Demosaic::~Demosaic()
+    {
+    }
+
+    //Can be called while streaming; the tables are rebuilt before the next frame.
+    void Demosaic::setColour(const ColourSettings& colour)
+    {
+        wxMutexLocker lock(mutex_);
+        colour_ = colour;
+        changed_ = true;
+    }
+
+    ColourSettings Demosaic::colour() const
+    {
+        wxMutexLocker lock(mutex_);
+        return colour_;
+    }
+
+    //The gains are applied before the matrix, and the gamma last, so a colour matrix
+    //measured on linear data still holds.
+    void Demosaic::buildTables()
+    {
+        double exponent = 1.0/std::max(tableColour_.gamma(), 0.1);
+        for (int i = 0; i <= maxFixed; ++i)
+        {
+            double level = std::min(1.0, i/(255.0*fixedScale));
+            gammaTable_[i] = static_cast<unsigned char>(255.0*pow(level, exponent) + 0.5);
+        }
+
+        for (int c = 0; c < 3; ++c)
+        {
+            for (int v = 0; v < 256; ++v)
+            {
+                int level = static_cast<int>(tableColour_.gain(c)*v*fixedScale + 0.5);
+                channelTables_[c][v] = gammaTable_[std::min(std::max(level, 0), maxFixed)];
+
+                for (int j = 0; j < 3; ++j)
+                {
+                    double value = tableColour_.matrix(c, j)*tableColour_.gain(j)*v*fixedScale;
+                    value = std::min(std::max(value, -32767.0), 32767.0);
+                    matrixTables_[(3*c + j)*256 + v] = static_cast<short>(floor(value + 0.5));
+                }
+            }
+        }
+    }
+
+    void Demosaic::updateTables()
+    {
+        wxMutexLocker lock(mutex_);
+        if (changed_)
+        {
+            tableColour_ = colour_;
+            changed_ = false;
+            buildTables();
+        }
+    }
+
+    //Bayer8 (one byte per pixel) to RGB. Each row is coloured straight after it is
+    //interpolated, while it is still in the cache, so colour correction doesn't cost
+    //another pass over the frame. "bayer" may point into a larger frame ("stride" 
+    //bytes per row) to convert only part of it, from an even row and column.
+    void Demosaic::interpolate(const unsigned char* bayer, 
+                               unsigned long stride, 
+                               unsigned long width, 
+                               unsigned long height, 
+                               tPvBayerPattern pattern, 
+                               unsigned char* rgb)
+    {
+        updateTables();
+
+        //Position of the red pixel in each 2x2 block.
+        int redColumn = pattern == ePvBayerGRBG || pattern == ePvBayerBGGR ? 1 : 0;
+        unsigned long redRow = pattern == ePvBayerGBRG || pattern == ePvBayerBGGR ? 1 : 0;
+        bool neutral = tableColour_.neutral();
+
+        for (unsigned long y = 0; y < height; ++y)
+        {
+            unsigned char* row = rgb + 3*y*width;
+            interpolateRow(bayer, stride, width, height, y, (y & 1) == redRow, redColumn, row);
+
+            if (!neutral)
+            {
+                colourRow(row, width);
+            }
+        }
+    }
+
+    //A small RGB image of the whole frame, one pixel from every factor'th 2x2 block of
+    //every factor'th row, without interpolating the rest. Colour corrected like the frame.
+    //"rgb" is (width/factor) x (height/factor).
+    void Demosaic::preview(const unsigned char* bayer, 
+                           unsigned long width, 
+                           unsigned long height, 
+                           tPvBayerPattern pattern, 
+                           unsigned long factor, 
+                           unsigned char* rgb)
+    {
+        updateTables();
+
+        unsigned long redColumn = pattern == ePvBayerGRBG || pattern == ePvBayerBGGR ? 1 : 0;
+        unsigned long redRow = pattern == ePvBayerGBRG || pattern == ePvBayerBGGR ? 1 : 0;
+        unsigned long w = width/factor;
+        unsigned long h = height/factor;
+        bool neutral = tableColour_.neutral();
+
+        for (unsigned long j = 0; j < h; ++j)
+        {
+            unsigned char* row = rgb + 3*j*w;
+            const unsigned char* top = bayer + (factor*j & ~1UL)*width;
+            const unsigned char* bottom = top + width;
+            const unsigned char* red = redRow ? bottom : top;
+            const unsigned char* blue = redRow ? top : bottom;
+            unsigned char* out = row;
+
+            for (unsigned long i = 0; i < w; ++i, out += 3)
+            {
+                unsigned long x = factor*i & ~1UL;
+                out[0] = red[x + redColumn];
+                out[1] = static_cast<unsigned char>((red[x + 1 - redColumn] + blue[x + redColumn] + 1) >> 1);
+                out[2] = blue[x + 1 - redColumn];
+            }
+
+            if (!neutral)
+            {
+                colourRow(row, w);
+            }
+        }
+    }
+
+    //Missing colours are the mean of the nearest pixels of that colour. Edges are
+    //mirrored (row -1 is row 1), which keeps the Bayer pattern.
+    void Demosaic::interpolateRow(const unsigned char* bayer, 
+                                  unsigned long stride, 
+                                  unsigned long width, 
+                                  unsigned long height, 
+                                  unsigned long y, 
+                                  bool redRow, 
+                                  int redColumn,
+                                  unsigned char* rgb) const
+    {
+        const unsigned char* c = bayer + y*stride;
+        const unsigned char* n = y > 0 ? c - stride : c + stride;
+        const unsigned char* s = y + 1 < height ? c + stride : c - stride;
+
+        //In a red row red is on the columns with redColumn's parity, in a blue row
+        //green is.
+        int first = redRow ? redColumn : 1 - redColumn;//parity of the red or blue columns
+        int mine = redRow ? 0 : 2;                     //channel of those columns
+        int other = 2 - mine;                          //channel found on the rows above and below
+
+        for (unsigned long x = 0; x < width; ++x, rgb += 3)
+        {
+            unsigned long l = x > 0 ? x - 1 : 1;
+            unsigned long r = x + 1 < width ? x + 1 : width - 2;
+
+            if (static_cast<int>(x & 1) == first)
+            {
+                rgb[mine] = c[x];
+                rgb[1] = static_cast<unsigned char>((n[x] + s[x] + c[l] + c[r] + 2) >> 2);
+                rgb[other] = static_cast<unsigned char>((n[l] + n[r] + s[l] + s[r] + 2) >> 2);
+            }
+            else
+            {
+                rgb[mine] = static_cast<unsigned char>((c[l] + c[r] + 1) >> 1);
+                rgb[1] = c[x];
+                rgb[other] = static_cast<unsigned char>((n[x] + s[x] + 1) >> 1);
+            }
+        }
+    }
+
+    void Demosaic::colourRow(unsigned char* rgb, unsigned long width) const
+    {
+        if (tableColour_.diagonal())
+        {
+            for (unsigned long x = 0; x < width; ++x, rgb += 3)
+            {
+                rgb[0] = channelTables_[0][rgb[0]];
+                rgb[1] = channelTables_[1][rgb[1]];
+                rgb[2] = channelTables_[2][rgb[2]];
+            }
+            return;
+        }
+
+        const short* m = &matrixTables_[0];
+        const unsigned char* gamma = &gammaTable_[0];
+
+        for (unsigned long x = 0; x < width; ++x, rgb += 3)
+        {
+            int r = rgb[0];
+            int g = rgb[1] + 256;
+            int b = rgb[2] + 512;
+
+            for (int c = 0; c < 3; ++c)
+            {
+                const short* t = m + 3*c*256;
+                int level = t[r] + t[g] + t[b];
+                rgb[c] = gamma[std::min(std::max(level, 0), maxFixed)];
+            }
+        }
+    }
+
+}//namespace
@@ -0,0 +1,86 @@
+/*
+Author: Nariman Habili
+
+Description: Turns the raw Bayer8 image from the camera into RGB by bilinear
+             interpolation, applying the colour settings (gains, colour
+             matrix and gamma) through lookup tables in the same pass.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DEMOSAIC_H
+#define DEMOSAIC_H
+
+#include "ColourSettings.h"
+#include <windows.h>
+#include <PvApi.h>
+#include <wx/thread.h>
+#include <vector>
+
+namespace rics
+{
+    class Demosaic
+    {
+    public:
+        Demosaic();
+        ~Demosaic();
+
+        void setColour(const ColourSettings& colour);
+        ColourSettings colour() const;
+
+        void interpolate(const unsigned char* bayer, 
+                         unsigned long stride, 
+                         unsigned long width, 
+                         unsigned long height, 
+                         tPvBayerPattern pattern, 
+                         unsigned char* rgb);
+        void preview(const unsigned char* bayer, 
+                     unsigned long width, 
+                     unsigned long height, 
+                     tPvBayerPattern pattern, 
+                     unsigned long factor, 
+                     unsigned char* rgb);
+
+    private:
+        void updateTables();
+        void buildTables();
+        void interpolateRow(const unsigned char* bayer, 
+                            unsigned long stride, 
+                            unsigned long width, 
+                            unsigned long height, 
+                            unsigned long y, 
+                            bool redRow, 
+                            int redColumn,
+                            unsigned char* rgb) const;
+        void colourRow(unsigned char* rgb, unsigned long width) const;
+
+    private:
+        mutable wxMutex mutex_;
+        ColourSettings colour_;//set from any thread
+        bool changed_;
+
+        //Used by the camera thread only.
+        ColourSettings tableColour_;
+        unsigned char channelTables_[3][256];//gain and gamma, when there's no colour matrix
+        std::vector<short> matrixTables_;    //9 x 256, matrix x gain x 16, for each input level
+        std::vector<unsigned char> gammaTable_;//4096 levels (1/16 of an 8 bit level) to 8 bit
+    };
+
+}//namespace
+
+#endif //DEMOSAIC_H
@@ -0,0 +1,159 @@
+/*
+Author: Nariman Habili
+
+Description: Decides when to capture a frame in distance based capture mode.
+             The distance travelled is accumulated from the GPS speed and a
+             frame is triggered every "interval" metres, bounded by a minimum
+             and maximum frame rate.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DISTANCE_TRIGGER_H
+#define DISTANCE_TRIGGER_H
+
+#include <wx/longlong.h>
+
+namespace rics
+{
+    class DistanceTrigger
+    {
+    public:
+        DistanceTrigger():
+        enabled_(false),
+        interval_(5.0),
+        minRate_(0.2),
+        maxRate_(4.0),
+        distance_(0.0),
+        lastTime_(0),
+        lastTrigger_(0)
+        {
+        }
+
+        ~DistanceTrigger()
+        {
+        }
+
+        bool enabled() const
+        {
+            return enabled_;
+        }
+
+        void setEnabled(bool enabled)
+        {
+            enabled_ = enabled;
+        }
+
+        //Distance between frames (metres)
+        double interval() const
+        {
+            return interval_;
+        }
+
+        void setInterval(double interval)
+        {
+            interval_ = interval;
+        }
+
+        //Frame rate while stationary (frames/sec). 0 means no frames when stationary.
+        double minRate() const
+        {
+            return minRate_;
+        }
+
+        void setMinRate(double rate)
+        {
+            minRate_ = rate;
+        }
+
+        //Upper limit on the frame rate (frames/sec), eg at highway speed.
+        double maxRate() const
+        {
+            return maxRate_;
+        }
+
+        void setMaxRate(double rate)
+        {
+            maxRate_ = rate;
+        }
+
+        //Start counting from "now" (milliseconds). The first frame is triggered straight away.
+        void reset(wxLongLong now)
+        {
+            distance_ = interval_;
+            lastTime_ = now;
+            lastTrigger_ = now - 1000000;
+        }
+
+        //Advance the distance travelled to time "now" (milliseconds) at the given
+        //speed (km/h). Returns true if a frame should be triggered.
+        bool update(double speed, wxLongLong now)
+        {
+            double dt = (now - lastTime_).ToDouble()/1000.0;
+            lastTime_ = now;
+
+            if (speed > 0.0)
+            {
+                distance_ += speed/3.6*dt;
+            }
+
+            double sinceTrigger = (now - lastTrigger_).ToDouble()/1000.0;
+
+            if (maxRate_ > 0.0 && sinceTrigger < 1.0/maxRate_)
+            {
+                return false;
+            }
+
+            bool moved = distance_ >= interval_;
+            bool timeout = minRate_ > 0.0 && sinceTrigger >= 1.0/minRate_;
+
+            if (!moved && !timeout)
+            {
+                return false;
+            }
+
+            //Keep the remainder so frames stay evenly spaced. If the maximum rate
+            //held us back by more than an interval, the backlog is dropped.
+            if (moved && distance_ < 2.0*interval_)
+            {
+                distance_ -= interval_;
+            }
+            else
+            {
+                distance_ = 0.0;
+            }
+
+            lastTrigger_ = now;
+
+            return true;
+        }
+
+    private:
+        bool enabled_;
+        double interval_;
+        double minRate_;
+        double maxRate_;
+
+        double distance_;
+        wxLongLong lastTime_;
+        wxLongLong lastTrigger_;
+    };
+
+}//namespace
+
+#endif //DISTANCE_TRIGGER_H
\ No newline at end of file
@@ -0,0 +1,196 @@
+/*
+Author: Nariman Habili
+
+Description: Exposure and gain set by the PC from the luminance histogram
+             of the preview image, instead of the camera's auto exposure.
+             The exposure is capped by a motion blur budget: the distance
+             the vehicle may travel while the shutter is open.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ExposureControl.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace rics
+{
+    static const unsigned long minExposure = 25;  //micro seconds, as in the camera properties
+    static const unsigned long maxGain = 24;      //dB, as used by the camera's auto gain
+    static const unsigned long settleFrames = 2;  //a new exposure shows up a frame or two later
+    static const double deadband = 0.08;          //fraction of the target left alone
+    static const double maxStep = 4.0;            //largest change in one step
+    static const double maxSaturated = 0.02;      //fraction of clipped pixels allowed
+    static const unsigned char clipLevel = 250;
+
+    ExposureControl::ExposureControl():
+    enabled_(false),
+    blurBudget_(10.0),
+    target_(110),
+    settle_(0),
+    brightness_(0.0),
+    saturated_(0.0)
+    {
+        memset(histogram_, 0, sizeof(histogram_));
+    }
+
+    ExposureControl::~ExposureControl()
+    {
+    }
+
+    bool ExposureControl::enabled() const
+    {
+        return enabled_;
+    }
+
+    void ExposureControl::setEnabled(bool enabled)
+    {
+        enabled_ = enabled;
+    }
+
+    //Millimetres the vehicle may move while the shutter is open. 10mm is 360us at 
+    //100km/h and 3.6ms at 10km/h.
+    double ExposureControl::blurBudget() const
+    {
+        return blurBudget_;
+    }
+
+    void ExposureControl::setBlurBudget(double mm)
+    {
+        blurBudget_ = mm;
+    }
+
+    unsigned long ExposureControl::target() const
+    {
+        return target_;
+    }
+
+    void ExposureControl::setTarget(unsigned long target)
+    {
+        target_ = target;
+    }
+
+    //Longest exposure (micro seconds) at this speed (km/h). "cap" is used when stationary
+    //or the speed isn't known (speed < 0).
+    unsigned long ExposureControl::maxExposure(double speed, unsigned long cap) const
+    {
+        if (speed <= 0.0)
+        {
+            return std::max(cap, minExposure);
+        }
+
+        double exposure = blurBudget_*1000.0/(speed/3.6);
+        return std::max(minExposure, std::min(cap, static_cast<unsigned long>(exposure)));
+    }
+
+    void ExposureControl::reset()
+    {
+        settle_ = 0;
+        brightness_ = 0.0;
+        saturated_ = 0.0;
+    }
+
+    //Works out the exposure for the next frames from this frame's preview. The exposure
+    //is used up to the blur limit and gain makes up the rest. The settings are changed
+    //to manual exposure and gain. Returns true if they changed.
+    bool ExposureControl::update(const unsigned char* preview, size_t size, double speed, CameraSettings* settings)
+    {
+        if (settle_ > 0)
+        {
+            --settle_;
+            return false;
+        }
+
+        double brightness = measure(preview, size);
+        unsigned long limit = maxExposure(speed, settings->autoMaxTime());
+        unsigned long exposure = settings->exposureTime();
+        unsigned long gain = settings->autoGain() ? 0 : settings->gain();
+
+        double ratio = target_/std::max(brightness, 1.0);
+        if (saturated_ > maxSaturated)
+        {
+            ratio = std::min(ratio, 0.8);//highlights clipped, whatever the mean says
+        }
+        else if (fabs(ratio - 1.0) < deadband && exposure <= limit)
+        {
+            return false;
+        }
+        ratio = std::max(1.0/maxStep, std::min(maxStep, ratio));
+
+        //Total light as exposure x linear gain, split again under the new limit.
+        double light = exposure*pow(10.0, gain/20.0)*ratio;
+        double newExposure = std::max(static_cast<double>(minExposure), std::min(static_cast<double>(limit), light));
+        double newGain = 20.0*log10(light/newExposure);
+        newGain = std::max(0.0, std::min(static_cast<double>(maxGain), newGain));
+
+        CameraSettings next = *settings;
+        next.setAutoExposure(false);
+        next.setExposureTime(static_cast<unsigned long>(newExposure + 0.5));
+        next.setAutoGain(false);
+        next.setGain(static_cast<unsigned long>(newGain + 0.5));
+
+        if (next.exposureTime() == exposure && next.gain() == gain && 
+            !settings->autoExposure() && !settings->autoGain())
+        {
+            return false;
+        }
+
+        *settings = next;
+        settle_ = settleFrames;
+
+        return true;
+    }
+
+    //Mean luminance of the last frame measured.
+    double ExposureControl::brightness() const
+    {
+        return brightness_;
+    }
+
+    //Luminance histogram of the (RGB) preview, which is about 1/150 of the frame, so
+    //costs next to nothing.
+    double ExposureControl::measure(const unsigned char* preview, size_t size)
+    {
+        memset(histogram_, 0, sizeof(histogram_));
+
+        size_t pixels = size/3;
+        for (size_t i = 0; i < pixels; ++i)
+        {
+            const unsigned char* p = preview + 3*i;
+            ++histogram_[(77*p[0] + 150*p[1] + 29*p[2]) >> 8];
+        }
+
+        double sum = 0.0;
+        unsigned long clipped = 0;
+        for (int level = 0; level < 256; ++level)
+        {
+            sum += static_cast<double>(level)*histogram_[level];
+            if (level >= clipLevel)
+            {
+                clipped += histogram_[level];
+            }
+        }
+
+        brightness_ = pixels ? sum/pixels : 0.0;
+        saturated_ = pixels ? static_cast<double>(clipped)/pixels : 0.0;
+
+        return brightness_;
+    }
+
+}//namespace
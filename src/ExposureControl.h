@@ -0,0 +1,70 @@
+/*
+Author: Nariman Habili
+
+Description: Exposure and gain set by the PC from the luminance histogram
+             of the preview image, instead of the camera's auto exposure.
+             The exposure is capped by a motion blur budget: the distance
+             the vehicle may travel while the shutter is open.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EXPOSURE_CONTROL_H
+#define EXPOSURE_CONTROL_H
+
+#include "CameraSettings.h"
+#include <cstddef>
+
+namespace rics
+{
+    class ExposureControl
+    {
+    public:
+        ExposureControl();
+        ~ExposureControl();
+
+        bool enabled() const;
+        void setEnabled(bool enabled);
+        double blurBudget() const;
+        void setBlurBudget(double mm);
+        unsigned long target() const;
+        void setTarget(unsigned long target);
+
+        unsigned long maxExposure(double speed, unsigned long cap) const;
+        void reset();
+        bool update(const unsigned char* preview, size_t size, double speed, CameraSettings* settings);
+
+        double brightness() const;
+
+    private:
+        double measure(const unsigned char* preview, size_t size);
+
+    private:
+        bool enabled_;
+        double blurBudget_;    //mm travelled during the exposure
+        unsigned long target_; //mean luminance (0-255)
+
+        unsigned long settle_; //frames left before the last change shows in the preview
+        double brightness_;
+        double saturated_;     //fraction of the preview that is clipped
+        unsigned long histogram_[256];
+    };
+
+}//namespace
+
+#endif //EXPOSURE_CONTROL_H
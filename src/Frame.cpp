@@ -35,10 +35,13 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 #include "film.xpm"
 #include "CameraPropDialog.h"
 #include "CameraThread.h"
+#include "ReviewFrame.h"
+#include "StorageBenchmark.h"
 #include "version.h"
 #include <wx/animate.h>
 #include <wx/mimetype.h>
 #include <boost/lexical_cast.hpp>
+#include <algorithm>
 #include <windows.h> 
 #include <tchar.h> 
 
@@ -64,6 +67,8 @@ namespace rics
         menuFile->Append(ID_OpenSession, _T("&Open Session\tCtrl-O"), _T("Open Session"));
         menuFile->Append(ID_Test, _T("&Test\tCtrl-T"), _T("Test"));
         menuFile->AppendSeparator();
+        menuFile->Append(ID_ReviewSession, _T("&Review Session...\tCtrl-R"), _T("Review Session..."));
+        menuFile->AppendSeparator();
         menuFile->Append(ID_Quit, _T("E&xit\tCtrl-X"), _T("Exit"));
 
         //Play item
@@ -81,6 +86,8 @@ namespace rics
         menuOptions->Append(ID_GPSProperties, _T("&GPS Properties...\tCtrl-G"), _T("GPS Properties..."));
         menuOptions->AppendSeparator();
         menuOptions->Append(ID_NotePadSettings, _T("&Damage Level Settings...\tCtrl-D"), _T("Damage Level Settings..."));
+        menuOptions->AppendSeparator();
+        menuOptions->Append(ID_StorageBenchmark, _T("&Storage Benchmark..."), _T("Storage Benchmark..."));
  
         //Help item
         wxMenu *menuHelp = new wxMenu;
@@ -113,6 +120,11 @@ namespace rics
         toolBar->AddSeparator();
         toolBar->AddTool(ID_CameraProperties_Icon, bmpCamera, wxT("Camera Properties"), wxT("Camera Properties"));
         toolBar->AddTool(ID_GPSProperties_Icon, bmpGPS, wxT("GPS Properties"), wxT("GPS Properties"));
+        toolBar->AddSeparator();
+        profileChoice_ = new wxChoice(toolBar, ID_ProfileChoice, wxDefaultPosition, wxSize(150, -1));
+        profileChoice_->SetToolTip(wxT("Camera Profile"));
+        refreshProfileChoice();
+        toolBar->AddControl(profileChoice_);
         toolBar->Realize();
         frameSizer->Add(toolBar, 0, wxEXPAND, 5);
 
@@ -140,9 +152,9 @@ namespace rics
 
         //Set the status bar
         statusBar_ = new wxStatusBar(this, wxID_ANY, wxFULL_REPAINT_ON_RESIZE, "statusBar");
-        statusBar_->SetFieldsCount(3);
-        int widths[] = {100, 200, -1};
-        statusBar_->SetStatusWidths(3, widths);
+        statusBar_->SetFieldsCount(4);
+        int widths[] = {100, 330, 100, -1};
+        statusBar_->SetStatusWidths(4, widths);
         statusBar_->SetStatusText("Ready", 0);
         statusBar_->SetStatusText("Test Mode", 2);
         SetStatusBar(statusBar_);
@@ -183,42 +195,6 @@ namespace rics
         Destroy();
     }
 
-    //Called if the cameras are unplugged before the application is closed.
-    //Differences to onClose: (1) threads deleted after cameras closed; and
-    //(2) all dialogs explicitly closed.
-    void Frame::unpluggedClose()
-    {
-        np_->saveFile();
-
-        for (size_t i = 0; i < numCameras_; ++i)
-        {
-            camera(i).stopStream();
-        }
-
-        canvas_->deleteAllThreads();
-
-        //These dialogs are modal, therefore need to be closed before application is existed  by user.
-        //However, in case cameras are unplugged, and any dialog is ShowModal, they need to be closed explicitly here. 
-        if (sessionPropDialog_.IsModal())
-        {
-            sessionPropDialog_.Close();
-        }
-        if (cameraPropDialog_.IsModal())
-        {
-            cameraPropDialog_.Close();
-        }
-        if (gpsPropDialog_.IsModal())
-        {
-            gpsPropDialog_.Close();
-        }
-        if (notePadSetDialog_.IsModal())
-        {
-            notePadSetDialog_.Close();
-        }
-
-        Destroy();
-    }
-
     //This is a wx timer event that executes the commands below
     //at set times (set by timer_)
     void Frame::onTimer(wxTimerEvent& WXUNUSED(event))
@@ -228,12 +204,26 @@ namespace rics
         for (size_t i = 0; i < numCameras_; ++i)
         {
             wxString fr;
-            fr.Printf("%.2f ", camera(i).actualFrameRate());
+            if (camera(i).unplugged())
+            {
+                fr = "unplugged ";
+            }
+            else
+            {
+                //and the PC time taken to turn each frame into RGB
+                fr.Printf("%.2f/%.0fms ", camera(i).actualFrameRate(), camera(i).convertTime());
+            }
             frameRateText += fr;
         }
         
         statusBar_->SetStatusText(frameRateText, 1);
 
+        //How long the session drive(s) last at the current write rate
+        SessionVolumesPtr volumes = session_.volumes();
+        forecast_.setPaths(session_.saveImages() && volumes ? volumes->sessionDirs() : std::vector<wxString>());
+        forecast_.update(cameras_, wxGetLocalTimeMillis());
+        statusBar_->SetStatusText(forecast_.status(), 3);
+
         if (play_ && session_.saveImages())
         {
             if (playToolBar_->GetToolEnabled(ID_Record))
@@ -267,6 +257,15 @@ namespace rics
         {
             SetTitle(session_.sessionName() + " - RICS (Session Mode)");
             statusBar_->SetStatusText("Session Mode", 2);
+
+            //A short benchmark of the new session's drive(s), so the forecast can warn 
+            //before the drive's limit is reached.
+            wxString report;
+            if (session_.saveImages() && benchmarkSession(5000, false, report))
+            {
+                report.Replace("\n", "; ");
+                statusBar_->SetStatusText(report, 3);
+            }
         }
     }
     
@@ -297,6 +296,7 @@ namespace rics
                 session_.setCreateDB(false);
                 session_.setSessionName("");
                 session_.setPath("");
+                session_.setVolumes(SessionVolumesPtr());
                 np_->openFile();
                 SetTitle("RICS (Test Mode)");
                 statusBar_->SetStatusText("Test Mode", 2);
@@ -308,6 +308,27 @@ namespace rics
         }
     }
 
+    //Open a saved session in a review window. Capture carries on while reviewing.
+    void Frame::onReviewSession(wxCommandEvent& WXUNUSED(event))
+    {
+        wxDirDialog dialog(this, "Choose a Session Directory", "C:\\RICS Sessions", wxDD_DIR_MUST_EXIST);
+        if (dialog.ShowModal() == wxID_OK)
+        {
+            wxString sessionDir = dialog.GetPath();
+            wxString sessionName = sessionDir.Mid(sessionDir.Find('\\', true) + 1);
+
+            if (!wxFileExists(sessionDir + "\\" + sessionName + ".sdb"))
+            {
+                wxMessageDialog(this, "Database \"" + sessionName + ".sdb\" does not exist. Cannot review session.", "Session Database Error", wxICON_HAND)
+                .ShowModal();
+                return;
+            }
+
+            ReviewFrame* review = new ReviewFrame(this, sessionDir);
+            review->Show(true);
+        }
+    }
+
     void Frame::onTextPlay(wxCommandEvent& WXUNUSED(event))
     {
         doPlay();
@@ -329,6 +350,7 @@ namespace rics
             playToolBar_->EnableTool(ID_Icon_Stop, true);
 
             play_ = true;
+            forecast_.reset();
         }
     }
 
@@ -361,6 +383,46 @@ namespace rics
         cameraPropDialog_.setPlay(play());
         cameraPropDialog_.ShowModal();
         canvas_->setCameraNames();
+        canvas_->setPreviewRate(cameraPropDialog_.previewRate());
+        canvas_->setDistanceTrigger(cameraPropDialog_.distanceTrigger());
+        canvas_->setFramePolicy(cameraPropDialog_.framePolicy());
+        canvas_->setWatchdog(cameraPropDialog_.watchdog());
+        canvas_->setExposureControl(cameraPropDialog_.exposureControl());
+        canvas_->setSyncMode(cameraPropDialog_.syncMode());
+        canvas_->setAdaptiveBandwidth(cameraPropDialog_.adaptiveBandwidth());
+        canvas_->setStreamSettings(cameraPropDialog_.streamSettings());
+        refreshProfileChoice();
+    }
+
+    //Switching profiles from the tool bar, eg when driving out of the sun. 
+    void Frame::onProfileChoice(wxCommandEvent& WXUNUSED(event))
+    {
+        wxString name = profileChoice_->GetStringSelection();
+        wxLongLong start = wxGetLocalTimeMillis();
+
+        if (cameraPropDialog_.applyProfile(name))
+        {
+            long time = (wxGetLocalTimeMillis() - start).ToLong();
+            statusBar_->SetStatusText(wxString::Format("Profile %s (%ld ms)", name.c_str(), time), 0);
+        }
+    }
+
+    //The profiles may have been changed in the camera properties dialog.
+    void Frame::refreshProfileChoice()
+    {
+        wxString selected = profileChoice_->GetStringSelection();
+        wxArrayString names = cameraPropDialog_.profileNames();
+
+        profileChoice_->Clear();
+        for (size_t i = 0; i < names.GetCount(); ++i)
+        {
+            profileChoice_->Append(names[i]);
+        }
+
+        if (selected != "")
+        {
+            profileChoice_->SetStringSelection(selected);
+        }
     }
 
     void Frame::onGPSProperties(wxCommandEvent& WXUNUSED(event))
@@ -373,6 +435,135 @@ namespace rics
         notePadSetDialog_.ShowModal();
     }
 
+    //Write frames to the session drive (or a chosen directory) as the cameras would, 
+    //and show whether it keeps up.
+    void Frame::onStorageBenchmark(wxCommandEvent& WXUNUSED(event))
+    {
+        wxString report;
+
+        if (session_.volumes())
+        {
+            if (!benchmarkSession(10000, true, report))
+            {
+                wxMessageBox("Could not write to the session drive(s).", "Storage Benchmark", wxOK | wxICON_ERROR, this);
+                return;
+            }
+
+            wxMessageBox(report, "Storage Benchmark", wxOK | wxICON_INFORMATION, this);
+            return;
+        }
+
+        wxDirDialog dialog(this, "Choose a Directory on the Drive to Test", "C:\\RICS Sessions");
+        if (dialog.ShowModal() != wxID_OK)
+        {
+            return;
+        }
+        wxString dir = dialog.GetPath();
+
+        double bytesPerSecond;
+        if (!runStorageBenchmark(dir, 10000, true, report, bytesPerSecond))
+        {
+            wxMessageBox("Could not write to " + dir + ".", "Storage Benchmark", wxOK | wxICON_ERROR, this);
+            return;
+        }
+
+        forecast_.setThroughput(bytesPerSecond);
+        wxMessageBox(report, "Storage Benchmark", wxOK | wxICON_INFORMATION, this);
+    }
+
+    //Each of the session's volumes in turn. The total is used by the forecast, and
+    //the cameras are shared between the volumes by the speeds measured. A volume 
+    //that can't be written to is taken out of use.
+    bool Frame::benchmarkSession(unsigned long ms, bool compare, wxString& report)
+    {
+        SessionVolumesPtr volumes = session_.volumes();
+        if (!volumes)
+        {
+            return false;
+        }
+
+        double total = 0.0;
+        for (size_t v = 0; v < volumes->numVolumes(); ++v)
+        {
+            wxString text;
+            double bytesPerSecond;
+            if (!runStorageBenchmark(volumes->sessionDir(v), ms, compare, text, bytesPerSecond))
+            {
+                volumes->failed(v, "benchmark failed");
+                continue;
+            }
+
+            volumes->setThroughput(v, bytesPerSecond);
+            total += bytesPerSecond;
+            report += (volumes->numVolumes() > 1 ? volumes->sessionDir(v) + ": " : wxString()) + text + "\n";
+        }
+
+        if (total == 0.0)
+        {
+            return false;
+        }
+
+        forecast_.setThroughput(total);
+        report.Trim();
+
+        //Not while capturing, the cameras would all change drive at once.
+        if (!play_)
+        {
+            std::vector<wxString> cameraNames;
+            for (size_t i = 0; i < numCameras_; ++i)
+            {
+                cameraNames.push_back(camera(i).cameraName());
+            }
+            volumes->balance(cameraNames);
+        }
+
+        return true;
+    }
+
+    //With "compare" the other way of writing the JPEGs (write-behind or fopen/fwrite) is
+    //run as well, and added to the report.
+    bool Frame::runStorageBenchmark(const wxString& dir, unsigned long ms, bool compare, wxString& report, double& bytesPerSecond)
+    {
+        float frameRate = 0.0f;
+        for (size_t i = 0; i < numCameras_; ++i)
+        {
+            frameRate = std::max(frameRate, camera(i).frameRate());
+        }
+
+        StorageBenchmark benchmark(dir);
+        benchmark.setCameras(numCameras_);
+        benchmark.setFrameBytes(StorageBenchmark::frameBytes(cameras_));
+        benchmark.setDuration(ms);
+
+        {
+            wxBusyCursor wait;
+            if (!benchmark.run())
+            {
+                return false;
+            }
+        }
+
+        bytesPerSecond = benchmark.bytesPerSecond();
+        report = benchmark.report() + wxString::Format(" (%.1f frames/sec needed)", frameRate);
+
+        if (compare)
+        {
+            StorageBenchmark other(dir);
+            other.setCameras(numCameras_);
+            other.setFrameBytes(benchmark.frameBytes());
+            other.setDuration(ms);
+            other.setWriteBehind(!benchmark.writeBehind());
+
+            wxBusyCursor wait;
+            if (other.run())
+            {
+                report += "\n" + other.report();
+            }
+        }
+
+        return true;
+    }
+
     //Will open the pdf user manual 
     void Frame::onHelp(wxCommandEvent& WXUNUSED(event))
     {
@@ -442,6 +633,7 @@ namespace rics
         EVT_MENU(ID_NewSession, Frame::onNewSession)
         EVT_MENU(ID_OpenSession, Frame::onOpenSession)
         EVT_MENU(ID_Test, Frame::onTest)
+        EVT_MENU(ID_ReviewSession, Frame::onReviewSession)
         EVT_MENU(ID_Quit, Frame::onQuit)
         EVT_MENU(ID_Help, Frame::onHelp)
         EVT_MENU(ID_About, Frame::onAbout)
@@ -452,6 +644,7 @@ namespace rics
         EVT_MENU(ID_CameraProperties, Frame::onCameraProperties)
         EVT_MENU(ID_GPSProperties, Frame::onGPSProperties)
         EVT_MENU(ID_NotePadSettings, Frame::onNotePadSet)
+        EVT_MENU(ID_StorageBenchmark, Frame::onStorageBenchmark)
 
         EVT_CLOSE(Frame::onClose)
 
@@ -460,6 +653,7 @@ namespace rics
         EVT_TOOL(ID_Test_Icon, Frame::onTestIcon)
         EVT_TOOL(ID_CameraProperties_Icon, Frame::onCameraPropertiesIcon)
         EVT_TOOL(ID_GPSProperties_Icon, Frame::onGPSPropertiesIcon)
+        EVT_CHOICE(ID_ProfileChoice, Frame::onProfileChoice)
 
         EVT_TIMER(ID_Timer, Frame::onTimer)
     END_EVENT_TABLE()
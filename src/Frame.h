@@ -35,6 +35,7 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 #include "Camera.h"
 #include "Session.h"
 #include "Database.h"
+#include "StorageForecast.h"
 #include <wx/wx.h>
 #include <wx/help.h>
 #include <boost/shared_ptr.hpp>
@@ -52,9 +53,9 @@ namespace rics
         void onNewSession(wxCommandEvent& WXUNUSED(event));
         void onOpenSession(wxCommandEvent& WXUNUSED(event));
         void onTest(wxCommandEvent& WXUNUSED(event));
+        void onReviewSession(wxCommandEvent& WXUNUSED(event));
 
         void onClose(wxCloseEvent& WXUNUSED(event));
-        void unpluggedClose();
 
         void doPlay();
         void doStop();
@@ -68,12 +69,17 @@ namespace rics
         void onCameraProperties(wxCommandEvent& event);
         void onGPSProperties(wxCommandEvent& event);
         void onNotePadSet(wxCommandEvent& WXUNUSED(event));
+        void onStorageBenchmark(wxCommandEvent& WXUNUSED(event));
+        bool runStorageBenchmark(const wxString& dir, unsigned long ms, bool compare, wxString& report, double& bytesPerSecond);
+        bool benchmarkSession(unsigned long ms, bool compare, wxString& report);
 
         void onNewSessionIcon(wxCommandEvent& WXUNUSED(event));
         void onOpenSessionIcon(wxCommandEvent& WXUNUSED(event));
         void onTestIcon(wxCommandEvent& WXUNUSED(event));
         void onCameraPropertiesIcon(wxCommandEvent& WXUNUSED(event));
         void onGPSPropertiesIcon(wxCommandEvent& WXUNUSED(event));
+        void onProfileChoice(wxCommandEvent& WXUNUSED(event));
+        void refreshProfileChoice();
 
         void onTimer(wxTimerEvent& event);
 
@@ -102,9 +108,11 @@ namespace rics
         OpenSessionDialog openSessionDialog_;
         NotePadSetDialog notePadSetDialog_;
         wxToolBar* playToolBar_; 
+        wxChoice* profileChoice_;
         wxStatusBar* statusBar_;
 
         wxTimer timer_;
+        StorageForecast forecast_;
 
         bool play_;
 
@@ -120,12 +128,14 @@ namespace rics
             ID_NewSession = 1,
             ID_OpenSession,
             ID_Test,
+            ID_ReviewSession,
             ID_Quit,
             ID_Help,
             ID_About,
             ID_CameraProperties,
             ID_GPSProperties,
             ID_NotePadSettings,
+            ID_StorageBenchmark,
             ID_Text_Play,
             ID_Text_Stop,
             ID_Icon_Play,
@@ -137,6 +147,7 @@ namespace rics
             ID_Test_Icon,
             ID_CameraProperties_Icon,
             ID_GPSProperties_Icon,
+            ID_ProfileChoice,
 
             ID_Timer
         };
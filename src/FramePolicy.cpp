@@ -0,0 +1,193 @@
+/*
+Author: Nariman Habili
+
+Description: Decides whether a captured frame is saved. Frames are thinned
+             while the vehicle is stationary or while the scene is unchanged,
+             using the GPS speed and a cheap difference of the preview images.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FramePolicy.h"
+#include <cstdlib>
+
+namespace rics
+{
+    FramePolicy::FramePolicy():
+    enabled_(false),
+    keepInterval_(5000),
+    stopSpeed_(1.0),
+    resumeSpeed_(3.0),
+    stillThreshold_(1.5),
+    changedThreshold_(3.0),
+    stopped_(false),
+    sceneStill_(false),
+    lastKept_(0),
+    dropped_(0)
+    {
+    }
+
+    FramePolicy::~FramePolicy()
+    {
+    }
+
+    bool FramePolicy::enabled() const
+    {
+        return enabled_;
+    }
+
+    void FramePolicy::setEnabled(bool enabled)
+    {
+        enabled_ = enabled;
+    }
+
+    //While stationary one frame is kept every "keepInterval" milliseconds.
+    //0 drops all stationary frames.
+    unsigned long FramePolicy::keepInterval() const
+    {
+        return keepInterval_;
+    }
+
+    void FramePolicy::setKeepInterval(unsigned long ms)
+    {
+        keepInterval_ = ms;
+    }
+
+    //The vehicle is stopped below "stopSpeed" and moving again above "resumeSpeed" (km/h).
+    void FramePolicy::setSpeedThresholds(double stopSpeed, double resumeSpeed)
+    {
+        stopSpeed_ = stopSpeed;
+        resumeSpeed_ = resumeSpeed;
+    }
+
+    //The scene is still below "still" and has changed above "changed"
+    //(mean absolute difference of the preview images, 0-255).
+    void FramePolicy::setSceneThresholds(double still, double changed)
+    {
+        stillThreshold_ = still;
+        changedThreshold_ = changed;
+    }
+
+    void FramePolicy::reset()
+    {
+        stopped_ = false;
+        sceneStill_ = false;
+        lastKept_ = 0;
+        reference_.clear();
+        clearDropped();
+    }
+
+    //Returns true if the frame should be saved. "speed" is in km/h and is
+    //negative if unknown (no GPS), in which case only the scene difference is used.
+    bool FramePolicy::keepFrame(const unsigned char* preview, size_t size, double speed, wxLongLong now)
+    {
+        if (!enabled_)
+        {
+            return true;
+        }
+
+        //Hysteresis stops GPS speed noise around walking pace toggling the state.
+        if (speed < 0.0)
+        {
+            stopped_ = false;
+        }
+        else if (stopped_ && speed > resumeSpeed_)
+        {
+            stopped_ = false;
+        }
+        else if (!stopped_ && speed < stopSpeed_)
+        {
+            stopped_ = true;
+        }
+
+        //The difference is taken against the last saved frame, so slow changes
+        //accumulate until a frame is saved.
+        if (reference_.size() != size)
+        {
+            sceneStill_ = false;
+        }
+        else
+        {
+            double diff = sceneDifference(preview, size);
+
+            if (sceneStill_ && diff > changedThreshold_)
+            {
+                sceneStill_ = false;
+            }
+            else if (!sceneStill_ && diff < stillThreshold_)
+            {
+                sceneStill_ = true;
+            }
+        }
+
+        bool thin = stopped_ || sceneStill_;
+
+        if (thin && (keepInterval_ == 0 || (now - lastKept_) < wxLongLong(keepInterval_)))
+        {
+            if (dropped_ == 0)
+            {
+                dropReason_ = stopped_ ? "stationary" : "unchanged";
+            }
+            ++dropped_;
+
+            return false;
+        }
+
+        lastKept_ = now;
+        reference_.assign(preview, preview + size);
+
+        return true;
+    }
+
+    //Number of frames dropped since the last clearDropped().
+    unsigned long FramePolicy::dropped() const
+    {
+        return dropped_;
+    }
+
+    wxString FramePolicy::dropReason() const
+    {
+        return dropReason_;
+    }
+
+    void FramePolicy::clearDropped()
+    {
+        dropped_ = 0;
+        dropReason_ = "";
+    }
+
+    //Mean absolute difference to the reference image. Only every 4th pixel is
+    //sampled, which is plenty at preview resolution.
+    double FramePolicy::sceneDifference(const unsigned char* preview, size_t size) const
+    {
+        const unsigned char* ref = &reference_[0];
+        unsigned long sum = 0;
+        unsigned long count = 0;
+
+        for (size_t i = 0; i + 2 < size; i += 12)
+        {
+            sum += abs(preview[i] - ref[i]) +
+                   abs(preview[i + 1] - ref[i + 1]) +
+                   abs(preview[i + 2] - ref[i + 2]);
+            count += 3;
+        }
+
+        return count ? static_cast<double>(sum)/count : 0.0;
+    }
+
+}//namespace
\ No newline at end of file
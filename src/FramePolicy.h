@@ -0,0 +1,77 @@
+/*
+Author: Nariman Habili
+
+Description: Decides whether a captured frame is saved. Frames are thinned
+             while the vehicle is stationary or while the scene is unchanged,
+             using the GPS speed and a cheap difference of the preview images.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FRAME_POLICY_H
+#define FRAME_POLICY_H
+
+#include <wx/string.h>
+#include <wx/longlong.h>
+#include <vector>
+
+namespace rics
+{
+    class FramePolicy
+    {
+    public:
+        FramePolicy();
+        ~FramePolicy();
+
+        bool enabled() const;
+        void setEnabled(bool enabled);
+        unsigned long keepInterval() const;
+        void setKeepInterval(unsigned long ms);
+        void setSpeedThresholds(double stopSpeed, double resumeSpeed);
+        void setSceneThresholds(double still, double changed);
+
+        void reset();
+        bool keepFrame(const unsigned char* preview, size_t size, double speed, wxLongLong now);
+
+        unsigned long dropped() const;
+        wxString dropReason() const;
+        void clearDropped();
+
+    private:
+        double sceneDifference(const unsigned char* preview, size_t size) const;
+
+    private:
+        bool enabled_;
+        unsigned long keepInterval_;
+        double stopSpeed_;
+        double resumeSpeed_;
+        double stillThreshold_;
+        double changedThreshold_;
+
+        bool stopped_;
+        bool sceneStill_;
+        wxLongLong lastKept_;
+        std::vector<unsigned char> reference_;
+
+        unsigned long dropped_;
+        wxString dropReason_;
+    };
+
+}//namespace
+
+#endif //FRAME_POLICY_H
\ No newline at end of file
@@ -134,21 +134,50 @@ namespace rics
         return gpsActive_;
     }
 
-    //Read GPS buffer.
+    //Read GPS buffer. When replaying, the recorded sentences that are due are 
+    //read instead of the COM port.
     bool GPS::readBuffer(unsigned char* buffer, 
                          const int bufSize, 
                          unsigned long* bytesRead)
     {
+        if (replay_)
+        {
+            *bytesRead = replay_->read(buffer, bufSize);
+            return false;
+        }
+
         long error = serial_.Read((void *)buffer, bufSize, bytesRead);
                 
         if (error == ERROR_SUCCESS)
         {
+            wxMutexLocker lock(recorderMutex_);
+            recorder_.write(buffer, *bytesRead);
             return false;
         }
 
         return true;
     }
 
+    //Keep the raw NMEA stream in "path" (appended), so the session can be replayed.
+    bool GPS::startRecording(const wxString& path)
+    {
+        wxMutexLocker lock(recorderMutex_);
+        return recorder_.open(path);
+    }
+
+    void GPS::stopRecording()
+    {
+        wxMutexLocker lock(recorderMutex_);
+        recorder_.close();
+    }
+
+    //Read from a recorded NMEA stream instead of the COM port.
+    void GPS::setReplay(NMEAReplayPtr replay)
+    {
+        replay_ = replay;
+        setGPSActive(replay_.get() != NULL);
+    }
+
     //Send current buffer to NMEA parser.
     void GPS::parse(const unsigned char *buffer, const int bufSize)
     {
@@ -292,6 +321,12 @@ namespace rics
         return s;
     }
 
+    //Return current speed in km/h as a number.
+    double GPS::speedKmh()
+    {
+        return nmeaParser_.speed();
+    }
+
     //Return formatted speed with km/h added.
     wxString GPS::formatSpeed()
     {
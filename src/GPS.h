@@ -26,8 +26,10 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 #define GPS_H
 
 #include "NMEAParser.h"
+#include "NMEALog.h"
 #include "Serial.h"
 #include "wx/string.h"
+#include "wx/thread.h"
 
 namespace rics
 {
@@ -46,6 +48,9 @@ namespace rics
         bool gpsActive() const;
         bool readBuffer(unsigned char* buffer, const int bufSize, unsigned long* bytesRead);
         void parse(const unsigned char *buffer, const int bufSize);
+        bool startRecording(const wxString& path);
+        void stopRecording();
+        void setReplay(NMEAReplayPtr replay);
         wxString latitude();
         wxString longitude();
         wxString latSexagesimal();
@@ -57,6 +62,7 @@ namespace rics
         wxString date();
         wxString speed();
         wxString formatSpeed();
+        double speedKmh();
         wxString satellites();
         wxString altitude();
         wxString formatAltitude();
@@ -69,6 +75,10 @@ namespace rics
         int currentPort_;
         bool gpsActive_;
         int bearing_;
+
+        NMEARecorder recorder_;
+        wxMutex recorderMutex_;
+        NMEAReplayPtr replay_;
     };
 
 } //namespace rics
@@ -30,8 +30,8 @@ namespace rics
     {
     }
     
-    GPSThread::GPSThread(wxWindow* canvas, GPS* gps, SharedGPSDataPtr buffer):
-    canvas_(canvas),
+    GPSThread::GPSThread(wxEvtHandler* handler, GPS* gps, SharedGPSDataPtr buffer):
+    handler_(handler),
     gps_(gps),
     buffer_(buffer)
     {
@@ -95,6 +95,8 @@ namespace rics
                 wxString formatSpeed = gps_->formatSpeed();
                 buffer_->setFormatSpeed(formatSpeed);
 
+                buffer_->setSpeedKmh(gps_->speedKmh());
+
                 wxString sats = gps_->satellites();
                 buffer_->setSatellites(sats);
 
@@ -114,16 +116,24 @@ namespace rics
                 buffer_->setFormatTime("--");
                 buffer_->setSpeed("--");
                 buffer_->setFormatSpeed("--");
+                buffer_->setSpeedKmh(0.0);
                 buffer_->setSatellites("--");
                 buffer_->setAltitude("--");
                 buffer_->setFormatAltitude("--");
                 buffer_->setQuality("--");
             }
             
-            wxCommandEvent event(wxEVT_COMMAND_MENU_SELECTED, GPS_EVENT);
-            wxPostEvent(canvas_, event);
-            
-            buffer_->writeUnlock();
+            //No one to notify when running headless, nor to wait for.
+            if (handler_ != NULL)
+            {
+                wxCommandEvent event(wxEVT_COMMAND_MENU_SELECTED, GPS_EVENT);
+                wxPostEvent(handler_, event);
+                buffer_->writeUnlock();
+            }
+            else
+            {
+                buffer_->writeUnlockNoWait();
+            }
 
             Sleep(100);//Thread is put to sleep to avoid thread starvation.
         }
@@ -36,7 +36,7 @@ namespace rics
     {
     public:
         GPSThread();
-        GPSThread(wxWindow* canvas, GPS* gps, SharedGPSDataPtr buffer);
+        GPSThread(wxEvtHandler* handler, GPS* gps, SharedGPSDataPtr buffer);
         ~GPSThread();
 
         void* Entry();
@@ -46,11 +46,11 @@ namespace rics
     public:
         enum
         {
-            GPS_EVENT = 1 //must be a different number to CAMERA_EVENT
+            GPS_EVENT = 1 //must be a different number to Canvas::ID_Timer
         };
     
     private:
-        wxWindow* canvas_;
+        wxEvtHandler* handler_;
         GPS* gps_;
         SharedGPSDataPtr buffer_;
     };
@@ -24,7 +24,9 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 #include "ImagePanel.h"
 #include "wx/statline.h"
 #include "wx/dcbuffer.h"
+#include "wx/rawbmp.h"
 #include "boost/lexical_cast.hpp"
+#include <algorithm>
 
 namespace rics
 {
@@ -32,7 +34,8 @@ namespace rics
     ImagePanel::ImagePanel(wxPanel *parent, wxWindowID id, wxString &camera, const wxPoint &pos, const wxSize &size):
     wxPanel(parent,  id, pos, size),
     camera_(camera),
-    font_(8, -1, wxNORMAL, wxLIGHT, false)
+    font_(8, -1, wxNORMAL, wxLIGHT, false),
+    fit_(false)
     {
         SetBackgroundStyle(wxBG_STYLE_CUSTOM);
         image_ = wxBitmap(306, 256, -1);
@@ -46,16 +49,74 @@ namespace rics
     void ImagePanel::onPaint(wxPaintEvent &WXUNUSED(event))
     {
         wxBufferedPaintDC dc(this);
-        dc.DrawBitmap(image_, 0, 0);
+        if (fit_)
+        {
+            //Scale the image to fill the panel, keeping its aspect ratio.
+            wxSize size = GetClientSize();
+            dc.SetBackground(*wxBLACK_BRUSH);
+            dc.Clear();
+            double scale = std::min(static_cast<double>(size.GetWidth())/image_.GetWidth(),
+                                    static_cast<double>(size.GetHeight())/image_.GetHeight());
+            dc.SetUserScale(scale, scale);
+            dc.DrawBitmap(image_, 0, 0);
+            dc.SetUserScale(1.0, 1.0);
+        }
+        else
+        {
+            dc.DrawBitmap(image_, 0, 0);
+        }
         dc.SetTextForeground(*wxRED);
         dc.SetFont(font_);
         dc.DrawText(camera_, 10, 10);
     }
 
-    //Draw a new camera image on a panel - will envoke onPaint
-    void ImagePanel::refreshImage(wxBitmap& image)
+    //Copy an RGB image straight into the panel's bitmap. The bitmap is only
+    //(re)allocated if the image size changes, so the memory is reused on every
+    //refresh instead of building a new wxImage and wxBitmap per frame.
+    void ImagePanel::updateImage(const unsigned char* rgb, int width, int height)
     {
-        image_ = image;
+        if (image_.GetWidth() != width || image_.GetHeight() != height || image_.GetDepth() != 24)
+        {
+            image_ = wxBitmap(width, height, 24);
+        }
+
+        wxNativePixelData data(image_);
+        if (!data)
+        {
+            return;
+        }
+
+        wxNativePixelData::Iterator p(data);
+        for (int j = 0; j < height; ++j)
+        {
+            wxNativePixelData::Iterator rowStart = p;
+
+            for (int i = 0; i < width; ++i, ++p)
+            {
+                p.Red() = rgb[0];
+                p.Green() = rgb[1];
+                p.Blue() = rgb[2];
+                rgb += 3;
+            }
+
+            p = rowStart;
+            p.OffsetY(data, 1);
+        }
+
+        if (fit_)
+        {
+            Refresh(false);
+        }
+        else
+        {
+            RefreshRect(wxRect(0, 0, width, height));
+        }
+    }
+
+    //Blank the panel, eg when the cameras are stopped.
+    void ImagePanel::clearImage()
+    {
+        image_ = wxBitmap(image_.GetWidth(), image_.GetHeight(), -1);
         RefreshRect(wxRect(0, 0, 306, 256));
     }
 
@@ -66,6 +127,13 @@ namespace rics
         RefreshRect(wxRect(0, 0, 306, 256));
     }
 
+    //Draw the image scaled to the size of the panel, instead of at its own size.
+    void ImagePanel::setFitToPanel(bool fit)
+    {
+        fit_ = fit;
+        Refresh(false);
+    }
+
     BEGIN_EVENT_TABLE(ImagePanel, wxPanel)
         EVT_PAINT(ImagePanel::onPaint)
     END_EVENT_TABLE()
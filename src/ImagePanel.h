@@ -41,8 +41,10 @@ namespace rics
         ~ImagePanel();
 
         void drawMyImage(wxPaintDC& dc);
-        void refreshImage(wxBitmap& image);
+        void updateImage(const unsigned char* rgb, int width, int height);
+        void clearImage();
         void setCameraName(wxString& camera);
+        void setFitToPanel(bool fit);
 
     private:
         void onPaint(wxPaintEvent &WXUNUSED(event));
@@ -51,6 +53,7 @@ namespace rics
         wxBitmap image_;
         wxString camera_;
         wxFont font_;
+        bool fit_;
 
         DECLARE_EVENT_TABLE()
 
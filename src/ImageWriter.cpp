@@ -0,0 +1,546 @@
+/*
+Author: Nariman Habili
+
+Description: Write-behind for the saved JPEGs. Files are queued by the camera
+             thread and written by one thread per drive, which keeps a few
+             overlapped writes going at once. Files are written unbuffered
+             (FILE_FLAG_NO_BUFFERING) from sector aligned buffers, so long
+             sessions don't fill the file cache and push out the files being
+             reviewed. Drives that can't do unbuffered writes (eg network
+             drives) fall back to buffered writes.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ImageWriter.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace rics
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////Writer thread
+    ImageWriterThread::ImageWriterThread(ImageWriter* writer, size_t device):
+    wxThread(wxTHREAD_JOINABLE),
+    writer_(writer),
+    device_(device)
+    {
+    }
+
+    ImageWriterThread::~ImageWriterThread()
+    {
+    }
+
+    //Keeps up to ImageWriter::inFlight() files being written. New files are opened and 
+    //their writes started as they are queued, and the oldest write is finished (file 
+    //truncated and closed) before more are taken. Only waits for the queue when 
+    //nothing is being written.
+    void* ImageWriterThread::Entry()
+    {
+        std::deque<ImageWriteJob*> inFlight;
+
+        while (true)
+        {
+            std::vector<ImageWriteJob*> jobs;
+            if (!writer_->take(device_, jobs, writer_->inFlight() - inFlight.size(), inFlight.empty()))
+            {
+                break;
+            }
+
+            for (size_t i = 0; i < jobs.size(); ++i)
+            {
+                if (writer_->begin(device_, jobs[i]))
+                {
+                    inFlight.push_back(jobs[i]);
+                }
+                else
+                {
+                    writer_->done(device_, jobs[i], false);
+                }
+            }
+
+            if (!inFlight.empty())
+            {
+                ImageWriteJob* job = inFlight.front();
+                inFlight.pop_front();
+                writer_->done(device_, job, writer_->finish(job));
+            }
+        }
+
+        return NULL;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////Writer
+    //"inFlight" writes are kept going on each drive. write() waits once "queued" files
+    //are waiting or being written on the drive.
+    ImageWriter::ImageWriter(size_t inFlight, size_t queued):
+    inFlight_(std::max(inFlight, static_cast<size_t>(1))),
+    queued_(std::max(queued, inFlight)),
+    condition_(mutex_),
+    stopping_(false),
+    bytesWritten_(0.0),
+    filesWritten_(0),
+    failures_(0),
+    nextLatency_(0)
+    {
+    }
+
+    //Everything queued is written first.
+    ImageWriter::~ImageWriter()
+    {
+        flush();
+
+        {
+            wxMutexLocker lock(mutex_);
+            stopping_ = true;
+            condition_.Broadcast();
+        }
+
+        for (size_t i = 0; i < devices_.size(); ++i)
+        {
+            devices_[i].thread->Wait();
+            delete devices_[i].thread;
+        }
+
+        free_.insert(free_.end(), failed_.begin(), failed_.end());
+        for (size_t i = 0; i < free_.size(); ++i)
+        {
+            VirtualFree(free_[i]->buffer, 0, MEM_RELEASE);
+            delete free_[i];
+        }
+    }
+
+    //Copies "data" and queues it to be written to "path". Returns false, without 
+    //queuing, if a write to the same drive has failed since the last call; the 
+    //caller should write the file somewhere else. The file that failed is kept (see 
+    //failedWrites()) until it is queued again or discarded.
+    bool ImageWriter::write(const std::string& path, const unsigned char* data, size_t size)
+    {
+        wxMutexLocker lock(mutex_);
+
+        size_t d = device(path);
+        if (devices_[d].failed)
+        {
+            devices_[d].failed = false;
+            return false;
+        }
+
+        while (devices_[d].pending >= queued_)
+        {
+            condition_.Wait();
+        }
+
+        ImageWriteJob* job = allocate(size, devices_[d].alignment);
+        job->path = path;
+        job->size = size;
+        memcpy(job->buffer, data, size);
+        memset(job->buffer + size, 0, job->capacity - size);
+        QueryPerformanceCounter(&job->queued);
+
+        devices_[d].queue.push_back(job);
+        ++devices_[d].pending;
+        condition_.Broadcast();
+
+        return true;
+    }
+
+    //Waits until everything queued has been written, eg before the session is closed.
+    void ImageWriter::flush()
+    {
+        wxMutexLocker lock(mutex_);
+
+        bool pending = true;
+        while (pending)
+        {
+            pending = false;
+            for (size_t i = 0; i < devices_.size(); ++i)
+            {
+                pending = pending || devices_[i].pending > 0;
+            }
+
+            if (pending)
+            {
+                condition_.Wait();
+            }
+        }
+    }
+
+    double ImageWriter::bytesWritten() const
+    {
+        wxMutexLocker lock(mutex_);
+        return bytesWritten_;
+    }
+
+    unsigned long ImageWriter::filesWritten() const
+    {
+        wxMutexLocker lock(mutex_);
+        return filesWritten_;
+    }
+
+    unsigned long ImageWriter::failures() const
+    {
+        wxMutexLocker lock(mutex_);
+        return failures_;
+    }
+
+    //Path of the last file that couldn't be written.
+    std::string ImageWriter::lastFailure() const
+    {
+        wxMutexLocker lock(mutex_);
+        return lastFailure_;
+    }
+
+    //ms from being queued to being closed, eg latency(99) for the 99th percentile
+    //of recent files.
+    double ImageWriter::latency(double percentile) const
+    {
+        std::vector<double> latencies;
+        {
+            wxMutexLocker lock(mutex_);
+            latencies = latencies_;
+        }
+
+        if (latencies.empty())
+        {
+            return 0.0;
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        return latencies[static_cast<size_t>((latencies.size() - 1)*percentile/100.0)];
+    }
+
+    //Paths of the files that couldn't be written, oldest first. Their data is kept 
+    //until requeue() or discard().
+    std::vector<std::string> ImageWriter::failedWrites() const
+    {
+        wxMutexLocker lock(mutex_);
+
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < failed_.size(); ++i)
+        {
+            paths.push_back(failed_[i]->path);
+        }
+
+        return paths;
+    }
+
+    //Queue the failed file "path" again, to be written to "newPath" (eg on another 
+    //volume). False if there is no such failed file.
+    bool ImageWriter::requeue(const std::string& path, const std::string& newPath)
+    {
+        wxMutexLocker lock(mutex_);
+
+        std::deque<ImageWriteJob*>::iterator it = failed_.begin();
+        while (it != failed_.end() && (*it)->path != path)
+        {
+            ++it;
+        }
+
+        if (it == failed_.end())
+        {
+            return false;
+        }
+
+        ImageWriteJob* job = *it;
+        failed_.erase(it);
+
+        size_t d = device(newPath);
+        while (devices_[d].pending >= queued_)
+        {
+            condition_.Wait();
+        }
+
+        //The new drive may have bigger sectors.
+        if (job->capacity % devices_[d].alignment != 0)
+        {
+            ImageWriteJob* copy = allocate(job->size, devices_[d].alignment);
+            memcpy(copy->buffer, job->buffer, job->size);
+            memset(copy->buffer + job->size, 0, copy->capacity - job->size);
+            copy->size = job->size;
+            copy->queued = job->queued;
+            free_.push_back(job);
+            job = copy;
+        }
+
+        job->path = newPath;
+        devices_[d].queue.push_back(job);
+        ++devices_[d].pending;
+        condition_.Broadcast();
+
+        return true;
+    }
+
+    //Give up on the failed file "path"; its buffer goes back to the pool.
+    void ImageWriter::discard(const std::string& path)
+    {
+        wxMutexLocker lock(mutex_);
+
+        for (std::deque<ImageWriteJob*>::iterator it = failed_.begin(); it != failed_.end(); ++it)
+        {
+            if ((*it)->path == path)
+            {
+                free_.push_back(*it);
+                failed_.erase(it);
+                return;
+            }
+        }
+    }
+
+    //The fullest drive's files queued or being written, as a share of the files 
+    //allowed before write() waits. Near 1 the drive isn't keeping up.
+    double ImageWriter::backlog() const
+    {
+        wxMutexLocker lock(mutex_);
+
+        size_t pending = 0;
+        for (size_t i = 0; i < devices_.size(); ++i)
+        {
+            pending = std::max(pending, devices_[i].pending);
+        }
+
+        return static_cast<double>(pending)/queued_;
+    }
+
+    size_t ImageWriter::inFlight() const
+    {
+        return inFlight_;
+    }
+
+    //Up to "max" queued files of "device". If "wait", blocks until there is at least
+    //one. False once stopping with nothing left.
+    bool ImageWriter::take(size_t device, std::vector<ImageWriteJob*>& jobs, size_t max, bool wait)
+    {
+        wxMutexLocker lock(mutex_);
+
+        std::deque<ImageWriteJob*>& queue = devices_[device].queue;
+        while (wait && queue.empty() && !stopping_)
+        {
+            condition_.Wait();
+        }
+
+        if (wait && queue.empty())
+        {
+            return false;
+        }
+
+        while (!queue.empty() && jobs.size() < max)
+        {
+            jobs.push_back(queue.front());
+            queue.pop_front();
+        }
+
+        return true;
+    }
+
+    //Open the file and start the write.
+    bool ImageWriter::begin(size_t device, ImageWriteJob* job)
+    {
+        bool unbuffered;
+        size_t alignment;
+        {
+            wxMutexLocker lock(mutex_);
+            unbuffered = devices_[device].unbuffered;
+            alignment = devices_[device].alignment;
+        }
+
+        DWORD flags = FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN;
+        job->file = CreateFile(job->path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 
+                               flags | (unbuffered ? FILE_FLAG_NO_BUFFERING : 0), NULL);
+
+        //Not every file system can write unbuffered.
+        if (job->file == INVALID_HANDLE_VALUE && unbuffered)
+        {
+            job->file = CreateFile(job->path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, flags, NULL);
+            if (job->file != INVALID_HANDLE_VALUE)
+            {
+                unbuffered = false;
+                wxMutexLocker lock(mutex_);
+                devices_[device].unbuffered = false;
+            }
+        }
+
+        if (job->file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        job->length = unbuffered ? (job->size + alignment - 1)/alignment*alignment : job->size;
+        memset(&job->overlapped, 0, sizeof(job->overlapped));
+
+        if (!WriteFile(job->file, job->buffer, static_cast<DWORD>(job->length), NULL, &job->overlapped) && 
+            GetLastError() != ERROR_IO_PENDING)
+        {
+            CloseHandle(job->file);
+            DeleteFile(job->path.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    //Wait for the write, cut off the padding to the sector size and close the file.
+    //A file that wasn't written in full is removed.
+    bool ImageWriter::finish(ImageWriteJob* job)
+    {
+        DWORD written = 0;
+        bool ok = GetOverlappedResult(job->file, &job->overlapped, &written, TRUE) && written == job->length;
+
+        if (ok && job->length != job->size)
+        {
+            LARGE_INTEGER end;
+            end.QuadPart = job->size;
+            ok = SetFilePointerEx(job->file, end, NULL, FILE_BEGIN) && SetEndOfFile(job->file);
+        }
+
+        ok = CloseHandle(job->file) && ok;
+        if (!ok)
+        {
+            DeleteFile(job->path.c_str());
+        }
+
+        return ok;
+    }
+
+    //The buffer goes back to the pool, or is kept if the file couldn't be written.
+    void ImageWriter::done(size_t device, ImageWriteJob* job, bool written)
+    {
+        LARGE_INTEGER end;
+        LARGE_INTEGER frequency;
+        QueryPerformanceCounter(&end);
+        QueryPerformanceFrequency(&frequency);
+        double ms = 1000.0*(end.QuadPart - job->queued.QuadPart)/frequency.QuadPart;
+
+        wxMutexLocker lock(mutex_);
+
+        if (written)
+        {
+            bytesWritten_ += job->size;
+            ++filesWritten_;
+
+            if (latencies_.size() < latencySamples_)
+            {
+                latencies_.push_back(ms);
+            }
+            else
+            {
+                latencies_[nextLatency_] = ms;
+            }
+            nextLatency_ = (nextLatency_ + 1) % latencySamples_;
+
+            free_.push_back(job);
+        }
+        else
+        {
+            ++failures_;
+            lastFailure_ = job->path;
+            devices_[device].failed = true;
+            failed_.push_back(job);
+        }
+
+        --devices_[device].pending;
+        condition_.Broadcast();
+    }
+
+    //The drive of "path" (eg "D:\\" or "\\\\server\\share\\"), added the first time it is 
+    //seen, with its own thread. Called with the mutex locked.
+    size_t ImageWriter::device(const std::string& path)
+    {
+        std::string root;
+        if (path.size() > 1 && path[1] == ':')
+        {
+            root = path.substr(0, 2) + "\\";
+        }
+        else if (path.compare(0, 2, "\\\\") == 0)
+        {
+            size_t share = path.find('\\', 2);
+            size_t end = share == std::string::npos ? std::string::npos : path.find('\\', share + 1);
+            root = end == std::string::npos ? path : path.substr(0, end + 1);
+        }
+
+        for (size_t i = 0; i < devices_.size(); ++i)
+        {
+            if (_stricmp(devices_[i].root.c_str(), root.c_str()) == 0)
+            {
+                return i;
+            }
+        }
+
+        Device device;
+        device.root = root;
+        device.pending = 0;
+        device.alignment = 4096;
+        device.unbuffered = true;
+        device.failed = false;
+
+        //Unbuffered writes must be whole sectors, from sector aligned memory.
+        DWORD sectorsPerCluster, bytesPerSector, freeClusters, clusters;
+        if (GetDiskFreeSpace(root.empty() ? NULL : root.c_str(), &sectorsPerCluster, &bytesPerSector, &freeClusters, &clusters) &&
+            bytesPerSector > device.alignment)
+        {
+            device.alignment = bytesPerSector;
+        }
+
+        device.thread = new ImageWriterThread(this, devices_.size());
+        devices_.push_back(device);
+
+        wxThreadError threadError = device.thread->Create();
+        assert(threadError == wxTHREAD_NO_ERROR);
+        device.thread->Run();
+
+        return devices_.size() - 1;
+    }
+
+    //A buffer of at least "size" bytes, rounded up to "alignment". Reused from the pool 
+    //if one is big enough. Called with the mutex locked.
+    ImageWriteJob* ImageWriter::allocate(size_t size, size_t alignment)
+    {
+        size_t capacity = (size + alignment - 1)/alignment*alignment;
+
+        for (size_t i = 0; i < free_.size(); ++i)
+        {
+            if (free_[i]->capacity >= capacity)
+            {
+                ImageWriteJob* job = free_[i];
+                free_.erase(free_.begin() + i);
+                return job;
+            }
+        }
+
+        //Frames have got bigger, replace a small buffer rather than keep it.
+        ImageWriteJob* job;
+        if (!free_.empty())
+        {
+            job = free_.back();
+            free_.pop_back();
+            VirtualFree(job->buffer, 0, MEM_RELEASE);
+        }
+        else
+        {
+            job = new ImageWriteJob;
+        }
+
+        //VirtualAlloc memory is page aligned.
+        job->buffer = static_cast<char*>(VirtualAlloc(NULL, capacity, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+        job->capacity = capacity;
+
+        return job;
+    }
+
+}//namespace
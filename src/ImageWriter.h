@@ -0,0 +1,139 @@
+/*
+Author: Nariman Habili
+
+Description: Write-behind for the saved JPEGs. Files are queued by the camera
+             thread and written by one thread per drive, which keeps a few
+             overlapped writes going at once. Files are written unbuffered
+             (FILE_FLAG_NO_BUFFERING) from sector aligned buffers, so long
+             sessions don't fill the file cache and push out the files being
+             reviewed. Drives that can't do unbuffered writes (eg network
+             drives) fall back to buffered writes.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <windows.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace rics
+{
+    class ImageWriter;
+
+    //A file waiting to be written, or being written.
+    struct ImageWriteJob
+    {
+        std::string path;
+        char* buffer;   //sector aligned
+        size_t capacity;
+        size_t size;    //bytes of file data
+        size_t length;  //bytes written, size rounded up to whole sectors if unbuffered
+        LARGE_INTEGER queued;
+        HANDLE file;
+        OVERLAPPED overlapped;
+    };
+
+    //Writes the files queued for one drive.
+    class ImageWriterThread : public wxThread
+    {
+    public:
+        ImageWriterThread(ImageWriter* writer, size_t device);
+        ~ImageWriterThread();
+
+        void* Entry();
+
+    private:
+        ImageWriter* writer_;
+        size_t device_;
+    };
+
+    class ImageWriter
+    {
+    public:
+        ImageWriter(size_t inFlight = 4, size_t queued = 8);
+        ~ImageWriter();
+
+        bool write(const std::string& path, const unsigned char* data, size_t size);
+        void flush();
+
+        double bytesWritten() const;
+        unsigned long filesWritten() const;
+        unsigned long failures() const;
+        std::string lastFailure() const;
+        double latency(double percentile) const;
+        double backlog() const;
+
+        std::vector<std::string> failedWrites() const;
+        bool requeue(const std::string& path, const std::string& newPath);
+        void discard(const std::string& path);
+
+        //Used by the writer threads
+        size_t inFlight() const;
+        bool take(size_t device, std::vector<ImageWriteJob*>& jobs, size_t max, bool wait);
+        bool begin(size_t device, ImageWriteJob* job);
+        bool finish(ImageWriteJob* job);
+        void done(size_t device, ImageWriteJob* job, bool written);
+
+    private:
+        ImageWriter(const ImageWriter&);
+        ImageWriter& operator=(const ImageWriter&);
+
+        size_t device(const std::string& path);
+        ImageWriteJob* allocate(size_t size, size_t alignment);
+
+    private:
+        struct Device
+        {
+            std::string root;
+            std::deque<ImageWriteJob*> queue;
+            size_t pending;   //queued or being written
+            size_t alignment; //bytes per sector, at least a page
+            bool unbuffered;
+            bool failed;      //a write failed, reported by the next write()
+            ImageWriterThread* thread;
+        };
+
+        size_t inFlight_;//writes going at once on each drive
+        size_t queued_;  //files queued or in flight on each drive before write() waits
+
+        mutable wxMutex mutex_;
+        wxCondition condition_;
+        std::deque<Device> devices_;//a deque, so the drive threads' references stay valid as drives are added
+        std::vector<ImageWriteJob*> free_;//buffers for reuse
+        std::deque<ImageWriteJob*> failed_;//files that couldn't be written, kept until requeue() or discard()
+        bool stopping_;
+
+        double bytesWritten_;
+        unsigned long filesWritten_;
+        unsigned long failures_;
+        std::string lastFailure_;
+        std::vector<double> latencies_;//ms from queued to closed, the last latencySamples_ files
+        size_t nextLatency_;
+
+        static const size_t latencySamples_ = 1000;
+    };
+
+}//namespace
+
+#endif //IMAGE_WRITER_H
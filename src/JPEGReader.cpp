@@ -0,0 +1,152 @@
+/*
+Author: Nariman Habili
+
+Description: Decodes JPEG files with libjpeg-turbo. Images can be scaled
+             down by 1/2, 1/4 or 1/8 while decoding (DCT scaling), which
+             is much faster than decoding at full size and resizing.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "JPEGReader.h"
+#include <stdexcept>
+
+namespace rics
+{
+    //libjpeg would otherwise exit the program on a corrupt file.
+    static void jpegErrorExit(j_common_ptr cinfo)
+    {
+        char buffer[JMSG_LENGTH_MAX];
+        (*cinfo->err->format_message)(cinfo, buffer);
+        throw std::runtime_error(std::string("libjpeg error: ") + buffer);
+    }
+
+    JPEGReader::JPEGReader()
+    {
+        cinfo_.err = jpeg_std_error(&jerr_);
+        jerr_.error_exit = jpegErrorExit;
+        jpeg_create_decompress(&cinfo_);
+    }
+
+    JPEGReader::~JPEGReader()
+    {
+        jpeg_destroy_decompress(&cinfo_);
+    }
+
+    //The whole file is read in one go and decoded from memory, which keeps the
+    //disk busy with large sequential reads when several readers run at once.
+    void JPEGReader::read(const std::string& path, 
+                          unsigned long scale, 
+                          std::vector<unsigned char>& image, 
+                          unsigned long& width, 
+                          unsigned long& height)
+    {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file == NULL)
+        {
+            throw std::runtime_error("Cannot open " + path);
+        }
+
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        if (size <= 0)
+        {
+            fclose(file);
+            throw std::runtime_error("Empty file " + path);
+        }
+
+        file_.resize(size);
+        size_t bytesRead = fread(&file_[0], 1, size, file);
+        fclose(file);
+
+        if (bytesRead != static_cast<size_t>(size))
+        {
+            throw std::runtime_error("Cannot read " + path);
+        }
+
+        decode(&file_[0], file_.size(), scale, image, width, height);
+    }
+
+    void JPEGReader::decode(const unsigned char* jpeg, 
+                            size_t size,
+                            unsigned long scale, 
+                            std::vector<unsigned char>& image, 
+                            unsigned long& width, 
+                            unsigned long& height)
+    {
+        try
+        {
+            jpeg_mem_src(&cinfo_, const_cast<unsigned char*>(jpeg), static_cast<unsigned long>(size));
+            jpeg_read_header(&cinfo_, TRUE);
+
+            cinfo_.out_color_space = JCS_RGB;
+            cinfo_.scale_num = 1;
+            cinfo_.scale_denom = scale;
+            cinfo_.dct_method = JDCT_ISLOW;
+            jpeg_start_decompress(&cinfo_);
+
+            width = cinfo_.output_width;
+            height = cinfo_.output_height;
+            unsigned long stride = 3*width;
+            image.resize(stride*height);
+
+            while (cinfo_.output_scanline < cinfo_.output_height)
+            {
+                unsigned char* row = &image[0] + cinfo_.output_scanline*stride;
+                jpeg_read_scanlines(&cinfo_, &row, 1);
+            }
+
+            jpeg_finish_decompress(&cinfo_);
+        }
+        catch (std::runtime_error&)
+        {
+            jpeg_abort_decompress(&cinfo_);
+            throw;
+        }
+    }
+
+    //Only the start of the file is read.
+    void JPEGReader::size(const std::string& path, unsigned long& width, unsigned long& height)
+    {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file == NULL)
+        {
+            throw std::runtime_error("Cannot open " + path);
+        }
+
+        try
+        {
+            jpeg_stdio_src(&cinfo_, file);
+            jpeg_read_header(&cinfo_, TRUE);
+            width = cinfo_.image_width;
+            height = cinfo_.image_height;
+            jpeg_abort_decompress(&cinfo_);
+        }
+        catch (std::runtime_error&)
+        {
+            jpeg_abort_decompress(&cinfo_);
+            fclose(file);
+            throw;
+        }
+
+        fclose(file);
+    }
+
+} //namespace
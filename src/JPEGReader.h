@@ -0,0 +1,79 @@
+/*
+Author: Nariman Habili
+
+Description: Decodes JPEG files with libjpeg-turbo. Images can be scaled
+             down by 1/2, 1/4 or 1/8 while decoding (DCT scaling), which
+             is much faster than decoding at full size and resizing.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef JPEG_READER_H
+#define JPEG_READER_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+extern "C" 
+{
+    #include <jpeglib.h>
+    #include <jerror.h>
+}
+
+namespace rics
+{
+    class JPEGReader
+    {
+    public:
+        JPEGReader();
+        ~JPEGReader();
+
+        //Decode "path" into "image" (RGB, top to bottom) at 1/scale of its size.
+        //Throws std::runtime_error if the file can't be read or decoded.
+        void read(const std::string& path, 
+                  unsigned long scale, 
+                  std::vector<unsigned char>& image, 
+                  unsigned long& width, 
+                  unsigned long& height);
+
+        //As above, from a JPEG already in memory.
+        void decode(const unsigned char* jpeg, 
+                    size_t size,
+                    unsigned long scale, 
+                    std::vector<unsigned char>& image, 
+                    unsigned long& width, 
+                    unsigned long& height);
+
+        //Size of the image in "path", from its header.
+        void size(const std::string& path, unsigned long& width, unsigned long& height);
+
+    private:
+        //Disallow copying
+        JPEGReader(const JPEGReader& other);
+        JPEGReader& operator=(const JPEGReader& other);
+
+    private:
+        struct jpeg_decompress_struct cinfo_;
+        struct jpeg_error_mgr jerr_;
+
+        std::vector<unsigned char> file_;//compressed file, reused between reads
+    };
+} //namespace
+
+#endif //JPEG_READER_H
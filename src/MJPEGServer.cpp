@@ -0,0 +1,361 @@
+/*
+Author: Nariman Habili
+
+Description: Serves the cameras as MJPEG over HTTP for secondary displays.
+             Each camera is encoded once per tick and the same JPEG is
+             sent to every client watching it. Clients that can't keep
+             up skip frames; the camera threads never wait on them.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "MJPEGServer.h"
+#include <boost/lexical_cast.hpp>
+#include <algorithm>
+
+namespace rics
+{
+    static const char* boundary = "ricsframe";
+    static const size_t maxRequest = 4096;
+
+    MJPEGServer::MJPEGServer()
+    {
+    }
+
+    MJPEGServer::MJPEGServer(const std::vector<SharedImageBufferPtr>& buffers,
+                             const std::vector<unsigned long>& widths,
+                             const std::vector<unsigned long>& heights,
+                             const std::vector<wxString>& names,
+                             const StreamSettings& settings):
+    buffers_(buffers),
+    widths_(widths),
+    heights_(heights),
+    names_(names),
+    settings_(settings),
+    lastFrames_(buffers.size(), 0),
+    jpegs_(buffers.size()),
+    jpegCounts_(buffers.size(), 0),
+    server_(NULL)
+    {
+        size_t size = 0;
+        for (size_t i = 0; i < buffers_.size(); ++i)
+        {
+            size = std::max(size, buffers_[i]->size());
+        }
+        image_.resize(size);
+    }
+
+    MJPEGServer::~MJPEGServer()
+    {
+    }
+
+    //The socket is created and used in this thread only, with wxSOCKET_BLOCK so
+    //wxWidgets never tries to yield to the GUI from here.
+    void* MJPEGServer::Entry()
+    {
+        wxIPV4address address;
+        if (settings_.lan())
+        {
+            address.AnyAddress();
+        }
+        else
+        {
+            address.Hostname("127.0.0.1");
+        }
+        address.Service(settings_.port());
+
+        server_ = new wxSocketServer(address, wxSOCKET_NOWAIT | wxSOCKET_BLOCK | wxSOCKET_REUSEADDR);
+        if (!server_->IsOk())
+        {
+            wxLogError(_("Preview stream: could not listen on port %d."), settings_.port());
+            return NULL;
+        }
+
+        unsigned long interval = 1000/std::max(settings_.rate(), 1UL);
+        wxLongLong lastEncode = 0;
+
+        while (!TestDestroy())
+        {
+            accept();
+
+            wxLongLong now = wxGetLocalTimeMillis();
+            if (now - lastEncode >= interval)
+            {
+                encode();
+                lastEncode = now;
+            }
+
+            std::list<Client>::iterator it = clients_.begin();
+            while (it != clients_.end())
+            {
+                if (serve(*it))
+                {
+                    ++it;
+                }
+                else
+                {
+                    it->socket->Destroy();
+                    it = clients_.erase(it);
+                }
+            }
+
+            Sleep(10);
+        }
+
+        return NULL;
+    }
+
+    void MJPEGServer::OnExit()
+    {
+        for (std::list<Client>::iterator it = clients_.begin(); it != clients_.end(); ++it)
+        {
+            it->socket->Destroy();
+        }
+        clients_.clear();
+
+        if (server_ != NULL)
+        {
+            server_->Destroy();
+            server_ = NULL;
+        }
+    }
+
+    void MJPEGServer::accept()
+    {
+        while (server_->WaitForAccept(0, 0))
+        {
+            wxSocketBase* socket = server_->Accept(false);
+            if (socket == NULL)
+            {
+                return;
+            }
+
+            socket->SetFlags(wxSOCKET_NOWAIT | wxSOCKET_BLOCK);
+
+            Client client;
+            client.socket = socket;
+            client.camera = -1;
+            client.closeWhenSent = false;
+            client.lastFrame = 0;
+            client.offset = 0;
+            clients_.push_back(client);
+        }
+    }
+
+    //Only cameras that someone is watching are encoded. The JPEG is shared by
+    //all of that camera's clients; nothing is copied per client.
+    void MJPEGServer::encode()
+    {
+        std::vector<bool> watched(buffers_.size(), false);
+        for (std::list<Client>::iterator it = clients_.begin(); it != clients_.end(); ++it)
+        {
+            if (it->camera >= 0)
+            {
+                watched[it->camera] = true;
+            }
+        }
+
+        for (size_t i = 0; i < buffers_.size(); ++i)
+        {
+            if (!watched[i] || !buffers_[i]->read(&image_[0], lastFrames_[i]))
+            {
+                continue;
+            }
+
+            boost::shared_ptr<std::vector<unsigned char> > jpeg(new std::vector<unsigned char>);
+            writer_.header(widths_[i], heights_[i], 3, JPEG::COLOR_RGB);
+            writer_.setQuality(settings_.quality());
+            writer_.setTradeoff(JPEG::FASTER);
+            writer_.write(*jpeg, &image_[0]);
+
+            jpegs_[i] = jpeg;
+            ++jpegCounts_[i];
+        }
+    }
+
+    //Returns false when the client is finished with or has gone away.
+    bool MJPEGServer::serve(Client& client)
+    {
+        if (!client.socket->IsConnected())
+        {
+            return false;
+        }
+
+        //Waiting for the HTTP request
+        if (client.camera < 0 && !client.closeWhenSent)
+        {
+            return readRequest(client);
+        }
+
+        if (!send(client))
+        {
+            return false;
+        }
+
+        bool sent = client.offset >= client.header.size() + (client.jpeg ? client.jpeg->size() : 0);
+        if (!sent)
+        {
+            return true;
+        }
+
+        if (client.closeWhenSent)
+        {
+            return false;
+        }
+
+        //Start on the latest frame. Frames encoded while the client was still
+        //busy with the last one are skipped.
+        if (client.lastFrame != jpegCounts_[client.camera] && jpegs_[client.camera])
+        {
+            client.jpeg = jpegs_[client.camera];
+            client.lastFrame = jpegCounts_[client.camera];
+            client.header = std::string("\r\n--") + boundary + "\r\n" +
+                            "Content-Type: image/jpeg\r\n" +
+                            "Content-Length: " + boost::lexical_cast<std::string>(client.jpeg->size()) + "\r\n\r\n";
+            client.offset = 0;
+        }
+
+        return true;
+    }
+
+    bool MJPEGServer::readRequest(Client& client)
+    {
+        char buffer[512];
+        client.socket->Read(buffer, sizeof(buffer));
+        client.request.append(buffer, client.socket->LastCount());
+
+        if (client.request.find("\r\n\r\n") == std::string::npos)
+        {
+            return client.request.size() < maxRequest;
+        }
+
+        //Only the path of the request line is used, eg "GET /camera/1 HTTP/1.1"
+        std::string path;
+        size_t start = client.request.find(' ');
+        if (start != std::string::npos)
+        {
+            size_t end = client.request.find(' ', start + 1);
+            path = client.request.substr(start + 1, end == std::string::npos ? std::string::npos : end - start - 1);
+        }
+
+        client.offset = 0;
+        client.jpeg.reset();
+
+        int camera = -1;
+        if (path.compare(0, 8, "/camera/") == 0)
+        {
+            try
+            {
+                camera = boost::lexical_cast<int>(path.substr(8));
+            }
+            catch (boost::bad_lexical_cast&)
+            {
+                camera = -1;
+            }
+        }
+
+        if (path == "/")
+        {
+            std::string page = indexPage();
+            client.header = "HTTP/1.0 200 OK\r\n"
+                            "Content-Type: text/html\r\n"
+                            "Content-Length: " + boost::lexical_cast<std::string>(page.size()) + "\r\n"
+                            "Connection: close\r\n\r\n" + page;
+            client.closeWhenSent = true;
+        }
+        else if (camera >= 0 && static_cast<size_t>(camera) < buffers_.size())
+        {
+            client.header = std::string("HTTP/1.0 200 OK\r\n") +
+                            "Cache-Control: no-cache\r\n" +
+                            "Pragma: no-cache\r\n" +
+                            "Connection: close\r\n" +
+                            "Content-Type: multipart/x-mixed-replace; boundary=" + boundary + "\r\n";
+            client.camera = camera;
+        }
+        else
+        {
+            client.header = "HTTP/1.0 404 Not Found\r\n"
+                            "Content-Type: text/plain\r\n"
+                            "Connection: close\r\n\r\n"
+                            "Not found\r\n";
+            client.closeWhenSent = true;
+        }
+
+        return true;
+    }
+
+    //Write as much as the socket will take without waiting.
+    bool MJPEGServer::send(Client& client)
+    {
+        while (client.offset < client.header.size())
+        {
+            client.socket->Write(client.header.data() + client.offset, client.header.size() - client.offset);
+            if (client.socket->Error() && client.socket->LastError() != wxSOCKET_WOULDBLOCK)
+            {
+                return false;
+            }
+
+            if (client.socket->LastCount() == 0)
+            {
+                return true;
+            }
+
+            client.offset += client.socket->LastCount();
+        }
+
+        if (!client.jpeg)
+        {
+            return true;
+        }
+
+        size_t end = client.header.size() + client.jpeg->size();
+        while (client.offset < end)
+        {
+            size_t offset = client.offset - client.header.size();
+            client.socket->Write(&(*client.jpeg)[offset], client.jpeg->size() - offset);
+            if (client.socket->Error() && client.socket->LastError() != wxSOCKET_WOULDBLOCK)
+            {
+                return false;
+            }
+
+            if (client.socket->LastCount() == 0)
+            {
+                return true;
+            }
+
+            client.offset += client.socket->LastCount();
+        }
+
+        return true;
+    }
+
+    std::string MJPEGServer::indexPage() const
+    {
+        std::string page = "<html><head><title>RICS</title></head><body>\n";
+        for (size_t i = 0; i < buffers_.size(); ++i)
+        {
+            std::string camera = boost::lexical_cast<std::string>(i);
+            page += "<div style=\"display:inline-block;margin:4px\"><img src=\"/camera/" + camera + "\"><br>" +
+                    std::string(names_[i].c_str()) + "</div>\n";
+        }
+        page += "</body></html>\n";
+
+        return page;
+    }
+
+} //namespace
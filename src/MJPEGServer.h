@@ -0,0 +1,105 @@
+/*
+Author: Nariman Habili
+
+Description: Serves the cameras as MJPEG over HTTP for secondary displays.
+             Each camera is encoded once per tick and the same JPEG is
+             sent to every client watching it. Clients that can't keep
+             up skip frames; the camera threads never wait on them.
+
+             http://<host>:<port>/          index page
+             http://<host>:<port>/camera/N  MJPEG stream of camera N
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MJPEG_SERVER_H
+#define MJPEG_SERVER_H
+
+#include "SharedImageBuffer.h"
+#include "StreamSettings.h"
+#include "JPEGWriter.h"
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <wx/socket.h>
+#include <boost/shared_ptr.hpp>
+#include <windows.h>
+#include <list>
+#include <string>
+#include <vector>
+
+namespace rics
+{
+    class MJPEGServer : public wxThread
+    {
+    public:
+        MJPEGServer();
+        MJPEGServer(const std::vector<SharedImageBufferPtr>& buffers,
+                    const std::vector<unsigned long>& widths,
+                    const std::vector<unsigned long>& heights,
+                    const std::vector<wxString>& names,
+                    const StreamSettings& settings);
+        ~MJPEGServer();
+
+        void* Entry();
+
+        void OnExit();
+
+    private:
+        typedef boost::shared_ptr<const std::vector<unsigned char> > JPEGPtr;
+
+        //A connected client. What is being sent is "header" followed by "jpeg",
+        //"offset" bytes of which have gone.
+        struct Client
+        {
+            wxSocketBase* socket;
+            std::string request;
+            int camera;
+            bool closeWhenSent;
+            unsigned long lastFrame;
+            std::string header;
+            JPEGPtr jpeg;
+            size_t offset;
+        };
+
+    private:
+        void accept();
+        void encode();
+        bool serve(Client& client);
+        bool readRequest(Client& client);
+        bool send(Client& client);
+        std::string indexPage() const;
+
+    private:
+        std::vector<SharedImageBufferPtr> buffers_;
+        std::vector<unsigned long> widths_;
+        std::vector<unsigned long> heights_;
+        std::vector<wxString> names_;
+        StreamSettings settings_;
+
+        std::vector<unsigned long> lastFrames_;//last frame read from each buffer
+        std::vector<JPEGPtr> jpegs_;//latest JPEG of each camera
+        std::vector<unsigned long> jpegCounts_;//incremented when a new JPEG is encoded
+        std::vector<unsigned char> image_;
+        JPEGWriter writer_;
+
+        wxSocketServer* server_;
+        std::list<Client> clients_;
+    };
+} //namespace
+
+#endif //MJPEG_SERVER_H
@@ -0,0 +1,155 @@
+/*
+Author: Nariman Habili
+
+Description: Records the raw NMEA stream from the GPS receiver during a 
+             session, one sentence per line with the time it arrived, and
+             plays it back paced by a replay clock.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "NMEALog.h"
+#include <wx/datetime.h>
+#include <wx/textfile.h>
+#include <algorithm>
+#include <cstring>
+
+namespace rics
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////Recorder
+    NMEARecorder::NMEARecorder()
+    {
+    }
+
+    NMEARecorder::~NMEARecorder()
+    {
+        close();
+    }
+
+    //Appends, so a session that is stopped and started again keeps one log.
+    bool NMEARecorder::open(const wxString& path)
+    {
+        close();
+        return file_.Open(path, wxFile::write_append);
+    }
+
+    void NMEARecorder::close()
+    {
+        file_.Close();
+        line_.clear();
+    }
+
+    bool NMEARecorder::isOpened() const
+    {
+        return file_.IsOpened();
+    }
+
+    //"data" is whatever came off the serial port, so sentences can be split
+    //across reads. Each complete sentence is written as "<UTC ms>\t<sentence>".
+    void NMEARecorder::write(const unsigned char* data, unsigned long size)
+    {
+        if (!file_.IsOpened())
+        {
+            return;
+        }
+
+        for (unsigned long i = 0; i < size; ++i)
+        {
+            char c = static_cast<char>(data[i]);
+            if (c == '\n')
+            {
+                if (!line_.empty())
+                {
+                    wxString record = wxDateTime::UNow().GetValue().ToString() + "\t" + line_.c_str() + "\r\n";
+                    file_.Write(record);
+                    line_.clear();
+                }
+            }
+            else if (c != '\r')
+            {
+                line_ += c;
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////Replay
+    NMEAReplay::NMEAReplay(ReplayClockPtr clock):
+    clock_(clock),
+    next_(0)
+    {
+    }
+
+    NMEAReplay::~NMEAReplay()
+    {
+    }
+
+    bool NMEAReplay::open(const wxString& path)
+    {
+        wxTextFile file;
+        if (!wxFileExists(path) || !file.Open(path))
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < file.GetLineCount(); ++i)
+        {
+            wxString line = file[i];
+            wxLongLong_t time;
+            if (line.BeforeFirst('\t').ToLongLong(&time))
+            {
+                times_.push_back(wxLongLong(time));
+                sentences_.push_back(std::string(line.AfterFirst('\t').c_str()) + "\r\n");
+            }
+        }
+
+        return !sentences_.empty();
+    }
+
+    bool NMEAReplay::finished() const
+    {
+        return next_ >= sentences_.size() && pending_.empty();
+    }
+
+    wxLongLong NMEAReplay::firstTime() const
+    {
+        return times_.empty() ? wxLongLong(0) : times_[0];
+    }
+
+    //Copy the sentences that are due by the replay clock into "buffer", as they
+    //would have come off the serial port. Returns the number of bytes copied.
+    unsigned long NMEAReplay::read(unsigned char* buffer, unsigned long size)
+    {
+        wxLongLong now = clock_->now();
+        while (next_ < sentences_.size() && times_[next_] <= now)
+        {
+            pending_ += sentences_[next_++];
+        }
+
+        unsigned long bytes = std::min(size, static_cast<unsigned long>(pending_.size()));
+        if (bytes > 0)
+        {
+            memcpy(buffer, pending_.data(), bytes);
+            pending_.erase(0, bytes);
+        }
+
+        return bytes;
+    }
+
+} //namespace
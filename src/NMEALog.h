@@ -0,0 +1,77 @@
+/*
+Author: Nariman Habili
+
+Description: Records the raw NMEA stream from the GPS receiver during a 
+             session, one sentence per line with the time it arrived, and
+             plays it back paced by a replay clock.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NMEA_LOG_H
+#define NMEA_LOG_H
+
+#include "SessionReplay.h"
+#include <wx/wx.h>
+#include <wx/file.h>
+#include <wx/longlong.h>
+#include <string>
+#include <vector>
+
+namespace rics
+{
+    class NMEARecorder
+    {
+    public:
+        NMEARecorder();
+        ~NMEARecorder();
+
+        bool open(const wxString& path);
+        void close();
+        bool isOpened() const;
+        void write(const unsigned char* data, unsigned long size);
+
+    private:
+        wxFile file_;
+        std::string line_;//partial sentence, waiting for its end of line
+    };
+
+    class NMEAReplay
+    {
+    public:
+        NMEAReplay(ReplayClockPtr clock);
+        ~NMEAReplay();
+
+        bool open(const wxString& path);
+        bool finished() const;
+        wxLongLong firstTime() const;
+        unsigned long read(unsigned char* buffer, unsigned long size);
+
+    private:
+        ReplayClockPtr clock_;
+        std::vector<wxLongLong> times_;
+        std::vector<std::string> sentences_;
+        size_t next_;
+        std::string pending_;//due, but didn't fit in the last read
+    };
+
+    typedef boost::shared_ptr<NMEAReplay> NMEAReplayPtr;
+
+} //namespace
+
+#endif //NMEA_LOG_H
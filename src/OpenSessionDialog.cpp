@@ -72,15 +72,7 @@ namespace rics
                 {
                     wxString cameraName = camera(i).cameraName();
                     db_->createTable(cameraName);//In case extra camera(s) are attached, new tables need to be created. 
-                    long int currentFrame = db_->maxFrame(cameraName);              
-                    if (!currentFrame)
-                    {
-                        session_->setCurrentFrame(i, currentFrame);//Table is empty
-                    }
-                    else
-                    {
-                        session_->setCurrentFrame(i, currentFrame + 1);//1 + max frame number in database
-                    }
+                    session_->setCurrentFrame(i, db_->nextFrame(cameraName));//1 + max frame number in database
                 }
             }
             else //if not, error
@@ -98,19 +90,20 @@ namespace rics
                 frame_->doStop();
             }
 
-            //Create directories for saved image
+            //Create directories for saved image, on each of the volumes the session was created with
+            SessionVolumesPtr volumes = SessionVolumes::open(sessionDir, db_);
+            std::vector<wxString> cameraNames;
             for (size_t i = 0; i < numCameras_; ++i)
             {
-                wxString dir = sessionDir + 
-                               "\\" +
-                                boost::lexical_cast<std::string>(camera(i).cameraName());
-
-                if (!wxDirExists(dir))
-                {
-                    wxMkdir(dir);                   
-                }
+                cameraNames.push_back(camera(i).cameraName());
+            }
+            volumes->createDirs(cameraNames);
+            volumes->balance(cameraNames);
+            session_->setVolumes(volumes);
 
-                camera(i).setSessionPath(dir);
+            for (size_t i = 0; i < numCameras_; ++i)
+            {
+                camera(i).setSessionPath(volumes->cameraDir(0, cameraNames[i]));
             }
 
             session_->setSaveImages(true);
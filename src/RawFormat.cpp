@@ -0,0 +1,181 @@
+/*
+Author: Nariman Habili
+
+Description: Unpacks the 12 and 16 bit Bayer formats sent by the camera and
+             tone maps them down to 8 bits for the demosaic, preview and
+             JPEG. The 12 bit data can also be kept for a raw archive.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "RawFormat.h"
+#include <algorithm>
+#include <cmath>
+#if USE_SSSE3
+#include <tmmintrin.h>
+#endif
+
+namespace rics
+{
+    static const size_t block = 16;//pixels unpacked at a time
+
+    RawFormat::RawFormat():
+    toneGamma_(0.0),
+    toneTable_(4096)
+    {
+        setToneGamma(2.2);
+    }
+
+    RawFormat::~RawFormat()
+    {
+    }
+
+    //The curve from 12 bits to 8. 1.0 keeps the top 8 bits, as in Bayer8. Higher values
+    //give more of the 8 bit levels to the shadows, so a dark interior and a bright sky
+    //both keep some detail.
+    void RawFormat::setToneGamma(double gamma)
+    {
+        toneGamma_ = std::max(gamma, 0.1);
+
+        for (int i = 0; i < 4096; ++i)
+        {
+            toneTable_[i] = static_cast<unsigned char>(255.0*pow(i/4095.0, 1.0/toneGamma_) + 0.5);
+        }
+    }
+
+    double RawFormat::toneGamma() const
+    {
+        return toneGamma_;
+    }
+
+    bool RawFormat::highBitDepth(tPvImageFormat format)
+    {
+        return format == ePvFmtBayer12Packed || format == ePvFmtBayer16;
+    }
+
+    //"bayer" gets one tone mapped byte per pixel. If "archive" isn't NULL it gets the
+    //12 bit levels, big endian as in a 16 bit PGM file.
+    void RawFormat::unpack(const unsigned char* raw, 
+                           tPvImageFormat format, 
+                           unsigned long bitDepth, 
+                           size_t pixels, 
+                           unsigned char* bayer, 
+                           unsigned short* archive) const
+    {
+        if (format == ePvFmtBayer12Packed)
+        {
+            unpack12Packed(raw, pixels, bayer, archive);
+        }
+        else if (format == ePvFmtBayer16)
+        {
+            unpack16(reinterpret_cast<const unsigned short*>(raw), bitDepth, pixels, bayer, archive);
+        }
+    }
+
+    //Two pixels in three bytes: the high 8 bits of the first, the low 4 bits of both
+    //(first in the low nibble), then the high 8 bits of the second.
+    void RawFormat::unpack12Packed(const unsigned char* raw, size_t pixels, unsigned char* bayer, unsigned short* archive) const
+    {
+        unsigned short levels[block];
+        size_t i = 0;
+
+#if USE_SSSE3
+        //Each 16 byte load covers 8 pixels (12 bytes). Bytes 1, 0 / 1, 2 of each 
+        //3 byte group go to the 16 bit lanes of the even / odd pixels.
+        const __m128i even = _mm_setr_epi8(1, 0, -1, -1, 4, 3, -1, -1, 7, 6, -1, -1, 10, 9, -1, -1);
+        const __m128i odd = _mm_setr_epi8(-1, -1, 1, 2, -1, -1, 4, 5, -1, -1, 7, 8, -1, -1, 10, 11);
+        const __m128i highBits = _mm_set1_epi16(0x0FF0);
+        const __m128i lowBits = _mm_set1_epi16(0x000F);
+
+        //The second load reads 4 bytes past the pixels it uses.
+        for (; (i + block)*3/2 + 4 <= pixels*3/2; i += block)
+        {
+            for (int half = 0; half < 2; ++half)
+            {
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(raw + (i + 8*half)*3/2));
+
+                //Even: (B0 << 8 | B1) -> B0 << 4 | (B1 & 0xF)
+                __m128i e = _mm_shuffle_epi8(bytes, even);
+                e = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(e, 4), highBits), _mm_and_si128(e, lowBits));
+
+                //Odd: (B2 << 8 | B1) -> B2 << 4 | B1 >> 4
+                __m128i o = _mm_srli_epi16(_mm_shuffle_epi8(bytes, odd), 4);
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(levels + 8*half), _mm_or_si128(e, o));
+            }
+
+            toneMap(levels, block, bayer + i, archive ? archive + i : NULL);
+        }
+#endif
+
+        for (; i < pixels; i += 2)
+        {
+            const unsigned char* b = raw + i*3/2;
+            levels[0] = static_cast<unsigned short>((b[0] << 4) | (b[1] & 0x0F));
+            levels[1] = static_cast<unsigned short>((b[2] << 4) | (b[1] >> 4));
+            toneMap(levels, std::min<size_t>(2, pixels - i), bayer + i, archive ? archive + i : NULL);
+        }
+    }
+
+    //Little endian, with "bitDepth" significant bits.
+    void RawFormat::unpack16(const unsigned short* raw, unsigned long bitDepth, size_t pixels, unsigned char* bayer, unsigned short* archive) const
+    {
+        unsigned short levels[block];
+        int shift = bitDepth > 12 ? bitDepth - 12 : 0;
+        size_t i = 0;
+
+#if USE_SSSE3
+        const __m128i count = _mm_cvtsi32_si128(shift);
+        const __m128i maxLevel = _mm_set1_epi16(0x0FFF);
+
+        for (; i + block <= pixels; i += block)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(raw + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(raw + i + 8));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(levels), _mm_and_si128(_mm_srl_epi16(a, count), maxLevel));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(levels + 8), _mm_and_si128(_mm_srl_epi16(b, count), maxLevel));
+
+            toneMap(levels, block, bayer + i, archive ? archive + i : NULL);
+        }
+#endif
+
+        for (; i < pixels; ++i)
+        {
+            levels[0] = static_cast<unsigned short>((raw[i] >> shift) & 0x0FFF);
+            toneMap(levels, 1, bayer + i, archive ? archive + i : NULL);
+        }
+    }
+
+    inline void RawFormat::toneMap(const unsigned short* levels, size_t count, unsigned char* bayer, unsigned short* archive) const
+    {
+        const unsigned char* table = &toneTable_[0];
+        for (size_t j = 0; j < count; ++j)
+        {
+            bayer[j] = table[levels[j]];
+        }
+
+        if (archive)
+        {
+            for (size_t j = 0; j < count; ++j)
+            {
+                archive[j] = static_cast<unsigned short>((levels[j] << 8) | (levels[j] >> 8));
+            }
+        }
+    }
+
+}//namespace
@@ -0,0 +1,64 @@
+/*
+Author: Nariman Habili
+
+Description: Unpacks the 12 and 16 bit Bayer formats sent by the camera and
+             tone maps them down to 8 bits for the demosaic, preview and
+             JPEG. The 12 bit data can also be kept for a raw archive.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RAW_FORMAT_H
+#define RAW_FORMAT_H
+
+#include <windows.h>
+#include <PvApi.h>
+#include <vector>
+
+namespace rics
+{
+    class RawFormat
+    {
+    public:
+        RawFormat();
+        ~RawFormat();
+
+        void setToneGamma(double gamma);
+        double toneGamma() const;
+
+        static bool highBitDepth(tPvImageFormat format);
+        void unpack(const unsigned char* raw, 
+                    tPvImageFormat format, 
+                    unsigned long bitDepth, 
+                    size_t pixels, 
+                    unsigned char* bayer, 
+                    unsigned short* archive) const;
+
+    private:
+        void unpack12Packed(const unsigned char* raw, size_t pixels, unsigned char* bayer, unsigned short* archive) const;
+        void unpack16(const unsigned short* raw, unsigned long bitDepth, size_t pixels, unsigned char* bayer, unsigned short* archive) const;
+        void toneMap(const unsigned short* levels, size_t count, unsigned char* bayer, unsigned short* archive) const;
+
+    private:
+        double toneGamma_;
+        std::vector<unsigned char> toneTable_;//12 bit level to 8 bit
+    };
+
+}//namespace
+
+#endif //RAW_FORMAT_H
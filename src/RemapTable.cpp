@@ -0,0 +1,311 @@
+/*
+Author: Nariman Habili
+
+Description: Lens distortion and orientation correction. A calibration model
+             (radial and tangential distortion plus a rotation) is turned
+             once into a fixed point remap table, which is then applied to
+             each frame with a bilinear lookup.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "RemapTable.h"
+#include <wx/fileconf.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#if USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace rics
+{
+    static const unsigned long outside = 0xFFFFFFFF;//no source pixel, output is black
+    static const unsigned long tileWidth = 128;     //output columns per tile
+    static const unsigned long tileHeight = 32;     //output rows per tile
+    static const double degrees = 3.14159265358979/180.0;
+
+    LensModel::LensModel():
+    width(0),
+    height(0),
+    fx(0.0),
+    fy(0.0),
+    cx(0.0),
+    cy(0.0),
+    k1(0.0),
+    k2(0.0),
+    k3(0.0),
+    p1(0.0),
+    p2(0.0),
+    roll(0.0),
+    pitch(0.0),
+    yaw(0.0)
+    {
+    }
+
+    RemapTable::RemapTable():
+    width_(0),
+    height_(0)
+    {
+    }
+
+    RemapTable::~RemapTable()
+    {
+    }
+
+    //One group per camera name, eg
+    //  [Left]
+    //  Width=2448
+    //  Height=2048
+    //  fx=2480.5
+    //  ...
+    //fy defaults to fx and the principal point to the centre of the frame.
+    bool RemapTable::loadModels(const wxString& filename, LensModels& models)
+    {
+        wxFileConfig config(wxEmptyString, wxEmptyString, filename, wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
+        wxString camera;
+        long index;
+
+        bool more = config.GetFirstGroup(camera, index);
+        while (more)
+        {
+            LensModel model;
+            long width = 0;
+            long height = 0;
+            config.Read("/" + camera + "/Width", &width);
+            config.Read("/" + camera + "/Height", &height);
+            config.Read("/" + camera + "/fx", &model.fx);
+            model.fy = model.fx;
+            model.cx = width/2.0;
+            model.cy = height/2.0;
+            config.Read("/" + camera + "/fy", &model.fy);
+            config.Read("/" + camera + "/cx", &model.cx);
+            config.Read("/" + camera + "/cy", &model.cy);
+            config.Read("/" + camera + "/k1", &model.k1);
+            config.Read("/" + camera + "/k2", &model.k2);
+            config.Read("/" + camera + "/k3", &model.k3);
+            config.Read("/" + camera + "/p1", &model.p1);
+            config.Read("/" + camera + "/p2", &model.p2);
+            config.Read("/" + camera + "/Roll", &model.roll);
+            config.Read("/" + camera + "/Pitch", &model.pitch);
+            config.Read("/" + camera + "/Yaw", &model.yaw);
+
+            if (width <= 0 || height <= 0 || model.fx <= 0.0 || model.fy <= 0.0)
+            {
+                return false;
+            }
+            model.width = width;
+            model.height = height;
+            models[camera] = model;
+
+            more = config.GetNextGroup(camera, index);
+        }
+
+        return true;
+    }
+
+    //For each pixel of the corrected (width x height) image, find where it comes from
+    //in the original. The model is scaled to the frame size, so it also works on 
+    //frames decoded at 1/2, 1/4 or 1/8 size. A frame saved cropped covers "crop" 
+    //(pixels of the model's frame); the centre is moved to the crop's origin and
+    //the model scaled by the crop's size rather than the whole frame's.
+    void RemapTable::build(const LensModel& model, unsigned long width, unsigned long height, const CropRegion& crop)
+    {
+        width_ = width;
+        height_ = height;
+        crop_ = crop;
+        offsets_.resize(width*height);
+        weights_.resize(width*height);
+
+        CropRegion region = crop.whole() ? CropRegion(0, 0, model.width, model.height) : crop;
+        double sx = static_cast<double>(width)/region.width();
+        double sy = static_cast<double>(height)/region.height();
+        double fx = model.fx*sx;
+        double fy = model.fy*sy;
+        double cx = (model.cx - region.left())*sx;
+        double cy = (model.cy - region.top())*sy;
+
+        //Rotation of the view, yaw about y, then pitch about x, then roll about the optical axis.
+        double cr = cos(model.roll*degrees), sr = sin(model.roll*degrees);
+        double cp = cos(model.pitch*degrees), sp = sin(model.pitch*degrees);
+        double cw = cos(model.yaw*degrees), sw = sin(model.yaw*degrees);
+        double r[3][3] = 
+        {
+            { cr*cw + sr*sp*sw, -sr*cp, -cr*sw + sr*sp*cw },
+            { sr*cw - cr*sp*sw,  cr*cp, -sr*sw - cr*sp*cw },
+            { cp*sw,             sp,     cp*cw            }
+        };
+
+        unsigned long stride = 3*width;
+        for (unsigned long v = 0; v < height; ++v)
+        {
+            for (unsigned long u = 0; u < width; ++u)
+            {
+                size_t i = v*width + u;
+
+                //Ray through the corrected pixel, turned into the camera's view.
+                double x0 = (u - cx)/fx;
+                double y0 = (v - cy)/fy;
+                double X = r[0][0]*x0 + r[0][1]*y0 + r[0][2];
+                double Y = r[1][0]*x0 + r[1][1]*y0 + r[1][2];
+                double Z = r[2][0]*x0 + r[2][1]*y0 + r[2][2];
+
+                if (Z <= 0.0)
+                {
+                    offsets_[i] = outside;
+                    weights_[i] = 0;
+                    continue;
+                }
+
+                double x = X/Z;
+                double y = Y/Z;
+                double r2 = x*x + y*y;
+                double radial = 1.0 + r2*(model.k1 + r2*(model.k2 + r2*model.k3));
+                double xd = x*radial + 2.0*model.p1*x*y + model.p2*(r2 + 2.0*x*x);
+                double yd = y*radial + model.p1*(r2 + 2.0*y*y) + 2.0*model.p2*x*y;
+                double sourceX = fx*xd + cx;
+                double sourceY = fy*yd + cy;
+
+                //In 1/256 of a pixel. Both neighbours must be inside the frame.
+                double fixedX = floor(sourceX*256.0 + 0.5);
+                double fixedY = floor(sourceY*256.0 + 0.5);
+                if (fixedX < 0.0 || fixedY < 0.0 || fixedX >= (width - 1)*256.0 || fixedY >= (height - 1)*256.0)
+                {
+                    offsets_[i] = outside;
+                    weights_[i] = 0;
+                    continue;
+                }
+
+                unsigned long column = static_cast<unsigned long>(fixedX);
+                unsigned long row = static_cast<unsigned long>(fixedY);
+
+                offsets_[i] = (row >> 8)*stride + 3*(column >> 8);
+                weights_[i] = static_cast<unsigned short>((column & 0xFF) | ((row & 0xFF) << 8));
+            }
+        }
+    }
+
+    bool RemapTable::empty() const
+    {
+        return offsets_.empty();
+    }
+
+    unsigned long RemapTable::width() const
+    {
+        return width_;
+    }
+
+    unsigned long RemapTable::height() const
+    {
+        return height_;
+    }
+
+    //The crop the table was built for, whole if the frames weren't cropped.
+    CropRegion RemapTable::crop() const
+    {
+        return crop_;
+    }
+
+    //Both images are RGB, width() x height(). "size" is the size of "image" in bytes.
+    void RemapTable::apply(const unsigned char* image, size_t size, unsigned char* corrected) const
+    {
+        apply(image, size, corrected, 0, height_);
+    }
+
+    //Only rows firstRow to lastRow - 1 are written, so a frame can be split between threads.
+    //The rows are done in tiles: neighbouring output pixels come from neighbouring source
+    //pixels, so a tile's source lines stay in the cache while it is worked on.
+    void RemapTable::apply(const unsigned char* image, size_t size, unsigned char* corrected, 
+                           unsigned long firstRow, unsigned long lastRow) const
+    {
+        unsigned long stride = 3*width_;
+
+#if USE_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi16(128);
+#endif
+
+        for (unsigned long tileTop = firstRow; tileTop < lastRow; tileTop += tileHeight)
+        {
+            unsigned long tileBottom = std::min(tileTop + tileHeight, lastRow);
+
+            for (unsigned long tileLeft = 0; tileLeft < width_; tileLeft += tileWidth)
+            {
+                unsigned long tileRight = std::min(tileLeft + tileWidth, width_);
+
+                for (unsigned long v = tileTop; v < tileBottom; ++v)
+                {
+                    size_t i = v*width_ + tileLeft;
+                    unsigned char* out = corrected + 3*i;
+
+                    for (unsigned long u = tileLeft; u < tileRight; ++u, ++i, out += 3)
+                    {
+                        unsigned long offset = offsets_[i];
+                        if (offset == outside)
+                        {
+                            out[0] = out[1] = out[2] = 0;
+                            continue;
+                        }
+
+                        int wx = weights_[i] & 0xFF;
+                        int wy = weights_[i] >> 8;
+                        const unsigned char* top = image + offset;
+                        const unsigned char* bottom = top + stride;
+
+#if USE_SSE2
+                        //Each load takes the two source pixels of a row (6 bytes) and 2 more,
+                        //so the last pixels of the frame are done below.
+                        if (offset + stride + 8 <= size)
+                        {
+                            __m128i weightX = _mm_setr_epi16(256 - wx, 256 - wx, 256 - wx, wx, wx, wx, 0, 0);
+                            __m128i t = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(top)), zero);
+                            __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bottom)), zero);
+
+                            //left*(256 - wx) + right*wx, in the first 3 lanes
+                            t = _mm_mullo_epi16(t, weightX);
+                            b = _mm_mullo_epi16(b, weightX);
+                            t = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(t, _mm_srli_si128(t, 6)), round), 8);
+                            b = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(b, _mm_srli_si128(b, 6)), round), 8);
+
+                            //top*(256 - wy) + bottom*wy
+                            __m128i p = _mm_add_epi16(_mm_mullo_epi16(t, _mm_set1_epi16(static_cast<short>(256 - wy))),
+                                                      _mm_mullo_epi16(b, _mm_set1_epi16(static_cast<short>(wy))));
+                            p = _mm_srli_epi16(_mm_add_epi16(p, round), 8);
+                            p = _mm_packus_epi16(p, p);
+
+                            unsigned int rgb = static_cast<unsigned int>(_mm_cvtsi128_si32(p));
+                            out[0] = static_cast<unsigned char>(rgb);
+                            out[1] = static_cast<unsigned char>(rgb >> 8);
+                            out[2] = static_cast<unsigned char>(rgb >> 16);
+                            continue;
+                        }
+#endif
+
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            int t = (top[c]*(256 - wx) + top[c + 3]*wx + 128) >> 8;
+                            int b = (bottom[c]*(256 - wx) + bottom[c + 3]*wx + 128) >> 8;
+                            out[c] = static_cast<unsigned char>((t*(256 - wy) + b*wy + 128) >> 8);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+}//namespace
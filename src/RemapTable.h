@@ -0,0 +1,91 @@
+/*
+Author: Nariman Habili
+
+Description: Lens distortion and orientation correction. A calibration model
+             (radial and tangential distortion plus a rotation) is turned
+             once into a fixed point remap table, which is then applied to
+             each frame with a bilinear lookup.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REMAP_TABLE_H
+#define REMAP_TABLE_H
+
+#include "CropRegion.h"
+#include <wx/string.h>
+#include <map>
+#include <vector>
+
+namespace rics
+{
+    //Calibration of one camera, in pixels of a width x height frame, with the
+    //distortion coefficients of the usual Brown-Conrady model. The angles (degrees)
+    //turn the corrected view, eg to level a camera mounted at a slant.
+    struct LensModel
+    {
+        LensModel();
+
+        unsigned long width;
+        unsigned long height;
+        double fx;
+        double fy;
+        double cx;
+        double cy;
+        double k1;
+        double k2;
+        double k3;
+        double p1;
+        double p2;
+        double roll;
+        double pitch;
+        double yaw;
+    };
+
+    typedef std::map<wxString, LensModel> LensModels;//by camera name
+
+    class RemapTable
+    {
+    public:
+        RemapTable();
+        ~RemapTable();
+
+        static bool loadModels(const wxString& filename, LensModels& models);
+
+        void build(const LensModel& model, unsigned long width, unsigned long height, 
+                   const CropRegion& crop = CropRegion());
+        bool empty() const;
+        unsigned long width() const;
+        unsigned long height() const;
+        CropRegion crop() const;
+
+        void apply(const unsigned char* image, size_t size, unsigned char* corrected) const;
+        void apply(const unsigned char* image, size_t size, unsigned char* corrected, 
+                   unsigned long firstRow, unsigned long lastRow) const;
+
+    private:
+        unsigned long width_;
+        unsigned long height_;
+        CropRegion crop_;
+        std::vector<unsigned long> offsets_;//byte offset of the top left source pixel, per output pixel
+        std::vector<unsigned short> weights_;//fractions (1/256) of the source position, x in the low byte
+    };
+
+}//namespace
+
+#endif //REMAP_TABLE_H
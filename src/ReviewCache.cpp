@@ -0,0 +1,243 @@
+/*
+Author: Nariman Habili
+
+Description: Decoded frame cache for session review. Recently shown frames
+             are kept in a least recently used cache, and a pool of threads
+             decodes the frames the viewer is about to show, ahead of the
+             scrub direction, using DCT scaling so only a fraction of each
+             full size JPEG is reconstructed.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReviewCache.h"
+#include <cassert>
+#include <stdexcept>
+
+namespace rics
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////Prefetch thread
+    ReviewPrefetcher::ReviewPrefetcher(ReviewCache* cache):
+    wxThread(wxTHREAD_JOINABLE),
+    cache_(cache)
+    {
+    }
+
+    ReviewPrefetcher::~ReviewPrefetcher()
+    {
+    }
+
+    //Each thread has its own decoder, reused for every frame.
+    void* ReviewPrefetcher::Entry()
+    {
+        JPEGReader reader;
+        ReviewKey key;
+
+        while (cache_->next(key))
+        {
+            cache_->decode(key, reader);
+        }
+
+        return NULL;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////Cache
+    ReviewCache::ReviewCache(const std::vector<wxString>& cameraDirs, unsigned long scale, size_t capacity):
+    cameraDirs_(cameraDirs),
+    framePaths_(cameraDirs.size()),
+    scale_(scale),
+    capacity_(capacity),
+    condition_(mutex_),
+    stopping_(false),
+    handler_(NULL)
+    {
+    }
+
+    ReviewCache::~ReviewCache()
+    {
+        stop();
+    }
+
+    //"handler" is sent a DECODED_EVENT (camera in GetInt, frame in GetExtraLong)
+    //whenever a frame has been decoded.
+    void ReviewCache::start(size_t threads, wxEvtHandler* handler)
+    {
+        handler_ = handler;
+        stopping_ = false;
+
+        for (size_t i = 0; i < threads; ++i)
+        {
+            ReviewPrefetcher* thread = new ReviewPrefetcher(this);
+            wxThreadError threadError = thread->Create();
+            assert(threadError == wxTHREAD_NO_ERROR);
+            thread->Run();
+            threads_.push_back(thread);
+        }
+    }
+
+    void ReviewCache::stop()
+    {
+        {
+            wxMutexLocker lock(mutex_);
+            stopping_ = true;
+            queue_.clear();
+            condition_.Broadcast();
+        }
+
+        for (size_t i = 0; i < threads_.size(); ++i)
+        {
+            threads_[i]->Wait();
+            delete threads_[i];
+        }
+        threads_.clear();
+    }
+
+    //Returns an empty pointer if the frame hasn't been decoded (yet).
+    ReviewImagePtr ReviewCache::find(size_t camera, long frame)
+    {
+        wxMutexLocker lock(mutex_);
+        ImageMap::iterator it = images_.find(ReviewKey(camera, frame));
+        if (it == images_.end())
+        {
+            return ReviewImagePtr();
+        }
+
+        lru_.splice(lru_.begin(), lru_, it->second.second);
+
+        return it->second.first;
+    }
+
+    //Replace the frames waiting to be decoded. "keys" is in order of urgency, ie
+    //the frames on screen first, then the frames ahead in the scrub direction.
+    //Frames no longer wanted are dropped from the queue, so a fast scrub never
+    //leaves the threads working through a backlog of frames already passed.
+    void ReviewCache::request(const std::vector<ReviewKey>& keys)
+    {
+        wxMutexLocker lock(mutex_);
+        queue_.clear();
+
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            ImageMap::iterator it = images_.find(keys[i]);
+            if (it != images_.end())
+            {
+                //Keep it from being evicted by the frames about to be decoded.
+                lru_.splice(lru_.begin(), lru_, it->second.second);
+            }
+            else if (inFlight_.find(keys[i]) == inFlight_.end())
+            {
+                queue_.push_back(keys[i]);
+            }
+        }
+
+        if (!queue_.empty())
+        {
+            condition_.Broadcast();
+        }
+    }
+
+    //Called by the prefetch threads. Blocks until there is a frame to decode.
+    //Returns false when the cache is stopping.
+    bool ReviewCache::next(ReviewKey& key)
+    {
+        wxMutexLocker lock(mutex_);
+        while (queue_.empty() && !stopping_)
+        {
+            condition_.Wait();
+        }
+
+        if (stopping_)
+        {
+            return false;
+        }
+
+        key = queue_.front();
+        queue_.pop_front();
+        inFlight_.insert(key);
+
+        return true;
+    }
+
+    //Where each frame of "camera" was saved, from the session database. Must be set 
+    //before start(). Frames not in "paths" are looked for in the camera's directory.
+    void ReviewCache::setFramePaths(size_t camera, const std::map<long, wxString>& paths)
+    {
+        framePaths_[camera] = paths;
+    }
+
+    //Same naming as Camera::frameName
+    void ReviewCache::decode(const ReviewKey& key, JPEGReader& reader)
+    {
+        wxString path = cameraDirs_[key.first] + wxString::Format("\\%07ld.jpg", key.second);
+
+        std::map<long, wxString>::const_iterator saved = framePaths_[key.first].find(key.second);
+        if (saved != framePaths_[key.first].end() && wxFileExists(saved->second))
+        {
+            path = saved->second;
+        }
+
+        boost::shared_ptr<ReviewImage> image(new ReviewImage);
+
+        try
+        {
+            reader.read(path.c_str(), scale_, image->rgb, image->width, image->height);
+        }
+        catch (std::runtime_error&)
+        {
+            //Cached anyway, so a missing frame isn't read again on every pass.
+            image->rgb.clear();
+            image->width = 0;
+            image->height = 0;
+        }
+
+        insert(key, image);
+
+        if (handler_ != NULL)
+        {
+            wxCommandEvent event(wxEVT_COMMAND_MENU_SELECTED, DECODED_EVENT);
+            event.SetInt(static_cast<int>(key.first));
+            event.SetExtraLong(key.second);
+            wxPostEvent(handler_, event);
+        }
+    }
+
+    void ReviewCache::insert(const ReviewKey& key, ReviewImagePtr image)
+    {
+        wxMutexLocker lock(mutex_);
+        inFlight_.erase(key);
+
+        ImageMap::iterator it = images_.find(key);
+        if (it != images_.end())
+        {
+            lru_.erase(it->second.second);
+            images_.erase(it);
+        }
+
+        lru_.push_front(key);
+        images_[key] = std::make_pair(image, lru_.begin());
+
+        while (images_.size() > capacity_)
+        {
+            images_.erase(lru_.back());
+            lru_.pop_back();
+        }
+    }
+
+} //namespace
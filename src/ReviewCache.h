@@ -0,0 +1,115 @@
+/*
+Author: Nariman Habili
+
+Description: Decoded frame cache for session review. Recently shown frames
+             are kept in a least recently used cache, and a pool of threads
+             decodes the frames the viewer is about to show, ahead of the
+             scrub direction, using DCT scaling so only a fraction of each
+             full size JPEG is reconstructed.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REVIEW_CACHE_H
+#define REVIEW_CACHE_H
+
+#include "JPEGReader.h"
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <boost/shared_ptr.hpp>
+#include <deque>
+#include <list>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace rics
+{
+    struct ReviewImage
+    {
+        std::vector<unsigned char> rgb;
+        unsigned long width;
+        unsigned long height;//0 if the frame couldn't be read
+    };
+
+    typedef boost::shared_ptr<const ReviewImage> ReviewImagePtr;
+    typedef std::pair<size_t, long> ReviewKey;//camera, frame
+
+    class ReviewCache;
+
+    class ReviewPrefetcher : public wxThread
+    {
+    public:
+        ReviewPrefetcher(ReviewCache* cache);
+        ~ReviewPrefetcher();
+
+        void* Entry();
+
+    private:
+        ReviewCache* cache_;
+    };
+
+    class ReviewCache
+    {
+    public:
+        ReviewCache(const std::vector<wxString>& cameraDirs, unsigned long scale, size_t capacity);
+        ~ReviewCache();
+
+        void setFramePaths(size_t camera, const std::map<long, wxString>& paths);
+        void start(size_t threads, wxEvtHandler* handler);
+        void stop();
+
+        ReviewImagePtr find(size_t camera, long frame);
+        void request(const std::vector<ReviewKey>& keys);
+
+        bool next(ReviewKey& key);
+        void decode(const ReviewKey& key, JPEGReader& reader);
+
+    public:
+        enum
+        {
+            DECODED_EVENT = 2 //must be a different number to the review frame's IDs
+        };
+
+    private:
+        void insert(const ReviewKey& key, ReviewImagePtr image);
+
+    private:
+        typedef std::list<ReviewKey> LRUList;
+        typedef std::map<ReviewKey, std::pair<ReviewImagePtr, LRUList::iterator> > ImageMap;
+
+        std::vector<wxString> cameraDirs_;
+        std::vector<std::map<long, wxString> > framePaths_;//from the session database, if saved to several volumes
+        unsigned long scale_;
+        size_t capacity_;
+
+        wxMutex mutex_;
+        wxCondition condition_;
+        LRUList lru_;//most recently used first
+        ImageMap images_;
+        std::deque<ReviewKey> queue_;//wanted frames, most urgent first
+        std::set<ReviewKey> inFlight_;
+        bool stopping_;
+
+        wxEvtHandler* handler_;
+        std::vector<ReviewPrefetcher*> threads_;
+    };
+} //namespace
+
+#endif //REVIEW_CACHE_H
@@ -0,0 +1,359 @@
+/*
+Author: Nariman Habili
+
+Description: Session review window. Steps through the frames of a saved 
+             session on a timeline, with the images of all cameras shown 
+             side by side and the position shown on a map of the GPS track.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReviewFrame.h"
+#include "Canvas.h"
+#include <wx/dir.h>
+#include <wx/filename.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace rics
+{
+    static const unsigned long decodeScale = 4;   //1/4 size, 612x512 at full resolution
+    static const unsigned long thumbnailScale = 8;//thumbnail pack shown until the decode is done
+    static const size_t prefetchAhead = 24;       //timeline positions decoded ahead of the scrub direction
+    static const size_t prefetchBehind = 4;
+
+    static bool frameLess(const FrameRecord& a, const FrameRecord& b)
+    {
+        return a.frame < b.frame;
+    }
+
+    ReviewFrame::ReviewFrame(wxWindow* parent, const wxString& sessionDir):
+    wxFrame(parent, wxID_ANY, "Review Session - " + wxFileName(sessionDir).GetFullName(), wxDefaultPosition, wxSize(1000, 760)),
+    sessionDir_(sessionDir),
+    position_(0)
+    {
+        loadSession();
+
+        wxBoxSizer* topSizer = new wxBoxSizer(wxVERTICAL);
+        wxPanel* mainPanel = new wxPanel(this, wxID_ANY);
+        wxBoxSizer* mainSizer = new wxBoxSizer(wxVERTICAL);
+        wxBoxSizer* viewSizer = new wxBoxSizer(wxHORIZONTAL);
+
+        wxSize grid = Canvas::panelGrid(cameraNames_.size());
+        wxGridSizer* panelSizer = new wxGridSizer(grid.GetHeight(), grid.GetWidth(), 1, 1);
+        for (size_t i = 0; i < cameraNames_.size(); ++i)
+        {
+            wxString name = "Camera: " + cameraNames_[i];
+            ImagePanel* panel = new ImagePanel(mainPanel, wxID_ANY, name, wxDefaultPosition, wxSize(306, 256));
+            panel->setFitToPanel(true);
+            panels_.push_back(panel);
+            panelSizer->Add(panel, 1, wxEXPAND);
+        }
+        viewSizer->Add(panelSizer, 3, wxEXPAND | wxALL, 2);
+
+        map_ = new ReviewMap(mainPanel, ID_Map, wxDefaultPosition, wxSize(250, 250));
+        map_->setTrack(track_);
+        viewSizer->Add(map_, 1, wxEXPAND | wxALL, 2);
+        mainSizer->Add(viewSizer, 1, wxEXPAND);
+
+        slider_ = new wxSlider(mainPanel, ID_Slider, 0, 0, std::max(static_cast<int>(track_.size()) - 1, 1));
+        slider_->Enable(track_.size() > 1);
+        mainSizer->Add(slider_, 0, wxEXPAND | wxALL, 5);
+
+        statusText_ = new wxStaticText(mainPanel, wxID_ANY, wxEmptyString);
+        mainSizer->Add(statusText_, 0, wxEXPAND | wxLEFT | wxBOTTOM, 5);
+
+        mainPanel->SetSizer(mainSizer);
+        topSizer->Add(mainPanel, 1, wxEXPAND);
+        SetSizer(topSizer);
+
+        //Leave a core for the GUI.
+        size_t threads = std::min(std::max(wxThread::GetCPUCount() - 1, 1), 4);
+        size_t capacity = 2*(prefetchAhead + prefetchBehind + 1)*std::max(cameraNames_.size(), static_cast<size_t>(1));
+        std::vector<wxString> dirs;
+        for (size_t i = 0; i < cameraNames_.size(); ++i)
+        {
+            dirs.push_back(sessionDir_ + "\\" + cameraNames_[i]);
+        }
+        cache_ = boost::shared_ptr<ReviewCache>(new ReviewCache(dirs, decodeScale, capacity));
+        for (size_t i = 0; i < framePaths_.size(); ++i)
+        {
+            cache_->setFramePaths(i, framePaths_[i]);
+        }
+        cache_->start(threads, this);
+
+        if (!track_.empty())
+        {
+            showPosition(0);
+            prefetch(1);
+        }
+        else
+        {
+            statusText_->SetLabel(_("No frames recorded in this session."));
+        }
+    }
+
+    ReviewFrame::~ReviewFrame()
+    {
+        cache_->stop();
+        db_.databaseClose();
+    }
+
+    //Cameras are the tables of the session database that have an image directory.
+    //The camera with the most frames sets the timeline. The other cameras show 
+    //their frame with the same number, or the nearest earlier one. Synchronised 
+    //sessions leave the camera tables empty; each camera's frames are then the 
+    //capture sets it saved a frame of, numbered by set ID, so the cameras' frames 
+    //of a set are shown together.
+    void ReviewFrame::loadSession()
+    {
+        wxString sessionName = wxFileName(sessionDir_).GetFullName();
+        db_.openDatabase(sessionDir_ + "\\" + sessionName + ".sdb");
+
+        std::vector<wxString> tables = db_.tables();
+        std::vector<std::vector<FrameRecord> > records;
+        size_t reference = 0;
+
+        for (size_t i = 0; i < tables.size(); ++i)
+        {
+            wxString dir = sessionDir_ + "\\" + tables[i];
+            if (!wxDirExists(dir))
+            {
+                continue;
+            }
+
+            std::vector<FrameRecord> cameraRecords = db_.frameRecords(tables[i]);
+            if (cameraRecords.empty())
+            {
+                cameraRecords = db_.captureSetRecords(tables[i]);
+            }
+            if (cameraRecords.empty())
+            {
+                continue;
+            }
+
+            cameraNames_.push_back(tables[i]);
+            framePaths_.push_back(db_.framePaths(tables[i]));
+            records.push_back(cameraRecords);
+            if (cameraRecords.size() > records[reference].size())
+            {
+                reference = records.size() - 1;
+            }
+
+            boost::shared_ptr<ThumbnailPack> pack(new ThumbnailPack);
+            pack->open(dir, thumbnailScale);
+            thumbnails_.push_back(pack);
+        }
+
+        if (records.empty())
+        {
+            return;
+        }
+
+        track_ = records[reference];
+        frames_.resize(cameraNames_.size());
+        shown_.assign(cameraNames_.size(), -1);
+
+        for (size_t c = 0; c < cameraNames_.size(); ++c)
+        {
+            frames_[c].resize(track_.size(), -1);
+
+            for (size_t p = 0; p < track_.size(); ++p)
+            {
+                std::vector<FrameRecord>::const_iterator it = 
+                    std::upper_bound(records[c].begin(), records[c].end(), track_[p], frameLess);
+                if (it != records[c].begin())
+                {
+                    frames_[c][p] = (it - 1)->frame;
+                }
+            }
+        }
+    }
+
+    void ReviewFrame::showPosition(size_t position)
+    {
+        position_ = position;
+
+        for (size_t i = 0; i < panels_.size(); ++i)
+        {
+            showCamera(i);
+        }
+
+        map_->setPosition(position_);
+        updateStatus();
+    }
+
+    //The decoded frame if it's in the cache, otherwise its thumbnail until the
+    //decode arrives. The thumbnail is a single small read from the pack, so the
+    //panels keep up with the slider even when the disk can't.
+    void ReviewFrame::showCamera(size_t camera)
+    {
+        long frame = frames_[camera][position_];
+        if (frame < 0)
+        {
+            panels_[camera]->clearImage();
+            shown_[camera] = -1;
+            return;
+        }
+
+        ReviewImagePtr image = cache_->find(camera, frame);
+        if (image && image->height > 0)
+        {
+            if (shown_[camera] != frame)
+            {
+                panels_[camera]->updateImage(&image->rgb[0], image->width, image->height);
+                shown_[camera] = frame;
+            }
+            return;
+        }
+
+        shown_[camera] = -1;
+        if (thumbnails_[camera]->read(frame, thumbnailJPEG_))
+        {
+            try
+            {
+                unsigned long width;
+                unsigned long height;
+                thumbnailReader_.decode(&thumbnailJPEG_[0], thumbnailJPEG_.size(), 1, thumbnailImage_, width, height);
+                panels_[camera]->updateImage(&thumbnailImage_[0], width, height);
+                return;
+            }
+            catch (std::runtime_error&)
+            {
+            }
+        }
+
+        if (!image)
+        {
+            return;//keep the last image until the decode arrives
+        }
+
+        panels_[camera]->clearImage();
+    }
+
+    //Ask for the frames on screen first, then those ahead in the scrub direction,
+    //then a few behind in case the user turns back.
+    void ReviewFrame::prefetch(int direction)
+    {
+        std::vector<ReviewKey> keys;
+        long last = static_cast<long>(track_.size()) - 1;
+
+        for (size_t k = 0; k <= prefetchAhead + prefetchBehind; ++k)
+        {
+            long step = k <= prefetchAhead ? static_cast<long>(k) : -static_cast<long>(k - prefetchAhead);
+            long p = static_cast<long>(position_) + direction*step;
+            if (p < 0 || p > last)
+            {
+                continue;
+            }
+
+            for (size_t c = 0; c < frames_.size(); ++c)
+            {
+                if (frames_[c][p] >= 0)
+                {
+                    keys.push_back(ReviewKey(c, frames_[c][p]));
+                }
+            }
+        }
+
+        cache_->request(keys);
+    }
+
+    void ReviewFrame::updateStatus()
+    {
+        const FrameRecord& record = track_[position_];
+        long t = static_cast<long>(record.time);
+
+        wxString status = wxString::Format("Frame %ld of %lu    Time %02ld:%02ld:%02ld", 
+                                           record.frame, 
+                                           (unsigned long)track_.size(),
+                                           t/10000, 
+                                           (t/100)%100, 
+                                           t%100);
+        if (record.hasFix)
+        {
+            status += wxString::Format("    Lat %.6f    Lon %.6f    %.1f km/h", record.latitude, record.longitude, record.speed);
+        }
+        else
+        {
+            status += "    No GPS fix";
+        }
+
+        statusText_->SetLabel(status);
+    }
+
+    void ReviewFrame::onScroll(wxScrollEvent& event)
+    {
+        size_t position = static_cast<size_t>(event.GetPosition());
+        if (position >= track_.size() || position == position_)
+        {
+            return;
+        }
+
+        int direction = position > position_ ? 1 : -1;
+        showPosition(position);
+        prefetch(direction);
+    }
+
+    //A prefetch thread finished a frame. Show it if it's on screen.
+    void ReviewFrame::onDecoded(wxCommandEvent& event)
+    {
+        size_t camera = static_cast<size_t>(event.GetInt());
+        if (camera < frames_.size() && !track_.empty() && frames_[camera][position_] == event.GetExtraLong())
+        {
+            showCamera(camera);
+        }
+    }
+
+    void ReviewFrame::onMapClick(wxCommandEvent& event)
+    {
+        size_t position = static_cast<size_t>(event.GetInt());
+        if (position < track_.size())
+        {
+            int direction = position >= position_ ? 1 : -1;
+            slider_->SetValue(static_cast<int>(position));
+            showPosition(position);
+            prefetch(direction);
+        }
+    }
+
+    //The panels scale their images to fit, so they're redrawn at the new size.
+    void ReviewFrame::onSize(wxSizeEvent& event)
+    {
+        for (size_t i = 0; i < panels_.size(); ++i)
+        {
+            panels_[i]->Refresh(false);
+        }
+        event.Skip();
+    }
+
+    void ReviewFrame::onClose(wxCloseEvent& WXUNUSED(event))
+    {
+        cache_->stop();
+        Destroy();
+    }
+
+    BEGIN_EVENT_TABLE(ReviewFrame, wxFrame)
+        EVT_COMMAND_SCROLL(ID_Slider, ReviewFrame::onScroll)
+        EVT_MENU(ReviewCache::DECODED_EVENT, ReviewFrame::onDecoded)
+        EVT_MENU(ID_Map, ReviewFrame::onMapClick)
+        EVT_SIZE(ReviewFrame::onSize)
+        EVT_CLOSE(ReviewFrame::onClose)
+    END_EVENT_TABLE()
+
+} //namespace
@@ -0,0 +1,93 @@
+/*
+Author: Nariman Habili
+
+Description: Session review window. Steps through the frames of a saved 
+             session on a timeline, with the images of all cameras shown 
+             side by side and the position shown on a map of the GPS track.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REVIEW_FRAME_H
+#define REVIEW_FRAME_H
+
+#include "Database.h"
+#include "ImagePanel.h"
+#include "JPEGReader.h"
+#include "ReviewCache.h"
+#include "ReviewMap.h"
+#include "ThumbnailPack.h"
+#include <wx/wx.h>
+#include <wx/slider.h>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+namespace rics
+{
+    class ReviewFrame: public wxFrame
+    {
+    public:
+        ReviewFrame(wxWindow* parent, const wxString& sessionDir);
+        ~ReviewFrame();
+
+    private:
+        void loadSession();
+        void showPosition(size_t position);
+        void showCamera(size_t camera);
+        void prefetch(int direction);
+        void updateStatus();
+
+        void onScroll(wxScrollEvent& event);
+        void onDecoded(wxCommandEvent& event);
+        void onMapClick(wxCommandEvent& event);
+        void onSize(wxSizeEvent& event);
+        void onClose(wxCloseEvent& WXUNUSED(event));
+
+    private:
+        wxString sessionDir_;
+        Database db_;
+
+        std::vector<wxString> cameraNames_;
+        std::vector<std::map<long, wxString> > framePaths_;//frames saved to other volumes
+        std::vector<FrameRecord> track_;//reference camera, one record per timeline position
+        std::vector<std::vector<long> > frames_;//frame of each camera at each timeline position, -1 if none
+        size_t position_;
+
+        boost::shared_ptr<ReviewCache> cache_;
+        std::vector<boost::shared_ptr<ThumbnailPack> > thumbnails_;
+        JPEGReader thumbnailReader_;
+        std::vector<unsigned char> thumbnailJPEG_;
+        std::vector<unsigned char> thumbnailImage_;
+        std::vector<long> shown_;//frame shown at full quality by each panel, -1 if none
+
+        std::vector<ImagePanel*> panels_;
+        wxSlider* slider_;
+        ReviewMap* map_;
+        wxStaticText* statusText_;
+
+        DECLARE_EVENT_TABLE()
+
+        enum
+        {
+            ID_Slider = 100,
+            ID_Map
+        };
+    };
+} //namespace
+
+#endif //REVIEW_FRAME_H
@@ -0,0 +1,204 @@
+/*
+Author: Nariman Habili
+
+Description: Map of the GPS track of a session, for session review. The track
+             is drawn once into a bitmap and the current position is drawn
+             over it. Clicking on the track selects the nearest frame.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReviewMap.h"
+#include <wx/dcbuffer.h>
+#include <algorithm>
+#include <cmath>
+
+namespace rics
+{
+    static const int margin = 10;
+    static const size_t npos = static_cast<size_t>(-1);
+
+    ReviewMap::ReviewMap(wxWindow* parent, wxWindowID id, const wxPoint &pos, const wxSize &size):
+    wxPanel(parent, id, pos, size, wxSUNKEN_BORDER),
+    position_(0),
+    minLat_(0.0),
+    maxLat_(0.0),
+    minLon_(0.0),
+    maxLon_(0.0),
+    lonScale_(1.0),
+    scale_(1.0)
+    {
+        SetBackgroundStyle(wxBG_STYLE_CUSTOM);
+    }
+
+    ReviewMap::~ReviewMap()
+    {
+    }
+
+    //One record per timeline position. Records without a GPS fix are left off the map.
+    void ReviewMap::setTrack(const std::vector<FrameRecord>& records)
+    {
+        latitudes_.clear();
+        longitudes_.clear();
+        positions_.clear();
+        points_.assign(records.size(), npos);
+
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            if (records[i].hasFix)
+            {
+                points_[i] = latitudes_.size();
+                latitudes_.push_back(records[i].latitude);
+                longitudes_.push_back(records[i].longitude);
+                positions_.push_back(i);
+            }
+        }
+
+        if (!latitudes_.empty())
+        {
+            minLat_ = *std::min_element(latitudes_.begin(), latitudes_.end());
+            maxLat_ = *std::max_element(latitudes_.begin(), latitudes_.end());
+            minLon_ = *std::min_element(longitudes_.begin(), longitudes_.end());
+            maxLon_ = *std::max_element(longitudes_.begin(), longitudes_.end());
+            lonScale_ = cos((minLat_ + maxLat_)/2.0*3.14159265358979/180.0);
+        }
+
+        drawTrack();
+    }
+
+    void ReviewMap::setPosition(size_t position)
+    {
+        position_ = position;
+        Refresh(false);
+    }
+
+    //Equirectangular projection, scaled to fit the panel.
+    wxPoint ReviewMap::toScreen(double latitude, double longitude) const
+    {
+        return wxPoint(margin + static_cast<int>((longitude - minLon_)*lonScale_*scale_),
+                       margin + static_cast<int>((maxLat_ - latitude)*scale_));
+    }
+
+    //Points closer than a pixel to the last one drawn are skipped, so a long
+    //session doesn't draw hundreds of thousands of line segments.
+    void ReviewMap::drawTrack()
+    {
+        wxSize size = GetClientSize();
+        if (size.GetWidth() <= 2*margin || size.GetHeight() <= 2*margin)
+        {
+            return;
+        }
+
+        double width = std::max((maxLon_ - minLon_)*lonScale_, 1e-6);
+        double height = std::max(maxLat_ - minLat_, 1e-6);
+        scale_ = std::min((size.GetWidth() - 2*margin)/width, (size.GetHeight() - 2*margin)/height);
+
+        track_ = wxBitmap(size.GetWidth(), size.GetHeight());
+        wxMemoryDC dc(track_);
+        dc.SetBackground(*wxWHITE_BRUSH);
+        dc.Clear();
+
+        std::vector<wxPoint> points;
+        for (size_t i = 0; i < latitudes_.size(); ++i)
+        {
+            wxPoint p = toScreen(latitudes_[i], longitudes_[i]);
+            if (points.empty() || p != points.back())
+            {
+                points.push_back(p);
+            }
+        }
+
+        dc.SetPen(wxPen(wxColour(38, 111, 198), 2));
+        if (points.size() > 1)
+        {
+            dc.DrawLines(static_cast<int>(points.size()), &points[0]);
+        }
+        else if (points.size() == 1)
+        {
+            dc.DrawPoint(points[0]);
+        }
+
+        dc.SelectObject(wxNullBitmap);
+        Refresh(false);
+    }
+
+    void ReviewMap::onPaint(wxPaintEvent& WXUNUSED(event))
+    {
+        wxBufferedPaintDC dc(this);
+        dc.SetBackground(*wxWHITE_BRUSH);
+        dc.Clear();
+
+        if (track_.Ok())
+        {
+            dc.DrawBitmap(track_, 0, 0);
+        }
+
+        if (position_ < points_.size() && points_[position_] != npos)
+        {
+            size_t i = points_[position_];
+            dc.SetPen(*wxBLACK_PEN);
+            dc.SetBrush(*wxRED_BRUSH);
+            dc.DrawCircle(toScreen(latitudes_[i], longitudes_[i]), 5);
+        }
+        else if (latitudes_.empty())
+        {
+            dc.DrawText(_("No GPS track"), margin, margin);
+        }
+    }
+
+    void ReviewMap::onSize(wxSizeEvent& event)
+    {
+        drawTrack();
+        event.Skip();
+    }
+
+    //Tell the parent which timeline position was clicked on: a menu event 
+    //with this panel's ID and the position in GetInt.
+    void ReviewMap::onLeftDown(wxMouseEvent& event)
+    {
+        if (latitudes_.empty())
+        {
+            return;
+        }
+
+        size_t nearest = 0;
+        long nearestDistance = -1;
+        for (size_t i = 0; i < latitudes_.size(); ++i)
+        {
+            wxPoint p = toScreen(latitudes_[i], longitudes_[i]);
+            long dx = p.x - event.GetX();
+            long dy = p.y - event.GetY();
+            if (nearestDistance < 0 || dx*dx + dy*dy < nearestDistance)
+            {
+                nearestDistance = dx*dx + dy*dy;
+                nearest = i;
+            }
+        }
+
+        wxCommandEvent command(wxEVT_COMMAND_MENU_SELECTED, GetId());
+        command.SetInt(static_cast<int>(positions_[nearest]));
+        wxPostEvent(GetParent(), command);
+    }
+
+    BEGIN_EVENT_TABLE(ReviewMap, wxPanel)
+        EVT_PAINT(ReviewMap::onPaint)
+        EVT_SIZE(ReviewMap::onSize)
+        EVT_LEFT_DOWN(ReviewMap::onLeftDown)
+    END_EVENT_TABLE()
+
+} //namespace
@@ -0,0 +1,74 @@
+/*
+Author: Nariman Habili
+
+Description: Map of the GPS track of a session, for session review. The track
+             is drawn once into a bitmap and the current position is drawn
+             over it. Clicking on the track selects the nearest frame.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REVIEW_MAP_H
+#define REVIEW_MAP_H
+
+#include "Database.h"
+#include <wx/wx.h>
+#include <vector>
+
+namespace rics
+{
+    class ReviewMap: public wxPanel
+    {
+    public:
+        ReviewMap(wxWindow* parent,
+                  wxWindowID id,
+                  const wxPoint &pos = wxDefaultPosition,
+                  const wxSize &size = wxDefaultSize);
+        ~ReviewMap();
+
+        void setTrack(const std::vector<FrameRecord>& records);
+        void setPosition(size_t position);
+
+    private:
+        void onPaint(wxPaintEvent& WXUNUSED(event));
+        void onSize(wxSizeEvent& event);
+        void onLeftDown(wxMouseEvent& event);
+        void drawTrack();
+        wxPoint toScreen(double latitude, double longitude) const;
+
+    private:
+        std::vector<double> latitudes_;
+        std::vector<double> longitudes_;
+        std::vector<size_t> positions_;//timeline position of each point with a fix
+        std::vector<size_t> points_;//index into the above for each timeline position, or npos
+        size_t position_;
+
+        double minLat_;
+        double maxLat_;
+        double minLon_;
+        double maxLon_;
+        double lonScale_;//shortens longitude with distance from the equator
+        double scale_;//pixels per degree of latitude
+
+        wxBitmap track_;
+
+        DECLARE_EVENT_TABLE()
+    };
+} //namespace
+
+#endif //REVIEW_MAP_H
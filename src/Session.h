@@ -24,6 +24,7 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef SESSION_H
 #define SESSION_H
 
+#include "SessionVolumes.h"
 #include <wx/string.h>
 #include <vector>
 
@@ -96,6 +97,17 @@ namespace rics
             path_ = path;
         }
 
+        //The volumes the frames are saved to. NULL until a session is opened.
+        SessionVolumesPtr volumes() const
+        {
+            return volumes_;
+        }
+
+        void setVolumes(SessionVolumesPtr volumes)
+        {
+            volumes_ = volumes;
+        }
+
         void setCurrentFrame(size_t camera, long int cf)
         {
             currentFrame_[camera] = cf;
@@ -122,6 +134,7 @@ namespace rics
 
         wxString sessionName_;
         wxString path_;
+        SessionVolumesPtr volumes_;
     };
 }
 
@@ -50,6 +50,9 @@ namespace rics
         createSessionName();
         topSizer->Add(sessionNameSizer_, 0, wxALL, 10);
 
+        createVolumes();
+        topSizer->Add(volumesSizer_, 0, wxLEFT | wxRIGHT | wxEXPAND, 10);
+
         //Button
         wxBoxSizer *buttonSizer = new wxBoxSizer(wxHORIZONTAL);
         okButton_ = new wxButton(this, ID_OK, _T("OK"));
@@ -104,6 +107,46 @@ namespace rics
         sessionNameSizer_->Add(boxSizer, 0, wxALIGN_CENTRE_VERTICAL | wxALL, 5);
     }
 
+    //Other volumes (disks) the frames can be spread over, one directory per line.
+    void SessionPropDialog::createVolumes()
+    {
+        wxStaticBox* volumes = new wxStaticBox(this, wxID_STATIC, "Extra Storage Volumes");
+        volumesSizer_ = new wxStaticBoxSizer(volumes, wxVERTICAL);
+
+        textCtrlVolumes_ = new wxTextCtrl(this,
+                                          wxID_ANY,
+                                          "",
+                                          wxDefaultPosition,
+                                          wxSize(300, 60),
+                                          wxTE_MULTILINE);
+
+        wxBoxSizer* modeSizer = new wxBoxSizer(wxHORIZONTAL);
+        wxStaticText* textMode = new wxStaticText(this, wxID_ANY, "Spread Frames:", wxDefaultPosition, wxDefaultSize, 0);
+        wxString modes[] = {"One volume per camera", "Round robin"};
+        choiceVolumeMode_ = new wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, 2, modes);
+        choiceVolumeMode_->SetSelection(0);
+        modeSizer->Add(textMode, 0, wxALL | wxALIGN_CENTRE_VERTICAL, 5);
+        modeSizer->Add(choiceVolumeMode_, 0, wxALL | wxALIGN_CENTRE_VERTICAL, 5);
+
+        volumesSizer_->Add(textCtrlVolumes_, 0, wxALL | wxEXPAND, 5);
+        volumesSizer_->Add(modeSizer, 0, wxALL, 5);
+    }
+
+    std::vector<wxString> SessionPropDialog::volumeRoots() const
+    {
+        std::vector<wxString> roots;
+        for (int i = 0; i < textCtrlVolumes_->GetNumberOfLines(); ++i)
+        {
+            wxString root = textCtrlVolumes_->GetLineText(i).Trim().Trim(false);
+            if (root != "")
+            {
+                roots.push_back(root);
+            }
+        }
+
+        return roots;
+    }
+
     //////OK/Close Buttons
     void SessionPropDialog::onOK(wxCommandEvent& WXUNUSED(event))
     {
@@ -197,15 +240,7 @@ namespace rics
                 {
                     wxString cameraName = camera(i).cameraName();
                     db_->createTable(cameraName);//In case extra camera(s) are attached, new tables need to be created. 
-                    long int currentFrame = db_->maxFrame(cameraName);              
-                    if (!currentFrame)
-                    {
-                        session_->setCurrentFrame(i, currentFrame);//Table is empty
-                    }
-                    else
-                    {
-                        session_->setCurrentFrame(i, currentFrame + 1);//1 + max frame number in database
-                    }
+                    session_->setCurrentFrame(i, db_->nextFrame(cameraName));//1 + max frame number in database
                 }
             }
             else
@@ -238,21 +273,33 @@ namespace rics
                 frame_->doStop();
             }
 
+            //An existing session keeps the volumes it was created with.
+            SessionVolumesPtr volumes;
+            if (sessionExists)
+            {
+                volumes = SessionVolumes::open(sessionDir, db_);
+            }
+            else
+            {
+                SessionVolumes::Mode mode = choiceVolumeMode_->GetSelection() == 1 ? 
+                                            SessionVolumes::ROUND_ROBIN : 
+                                            SessionVolumes::PER_CAMERA;
+                volumes = SessionVolumes::create(sessionDir, sessionName_, volumeRoots(), mode, db_);
+            }
+
             //Create directories for saved images
+            std::vector<wxString> cameraNames;
             for (size_t i = 0; i < numCameras_; ++i)
             {
-                wxString dir = dir_ + 
-                               "\\" + 
-                               sessionName_ + 
-                               "\\" +
-                               boost::lexical_cast<std::string>(camera(i).cameraName());
-
-                if (!wxDirExists(dir))
-                {
-                    wxMkdir(dir);                   
-                }
+                cameraNames.push_back(camera(i).cameraName());
+            }
+            volumes->createDirs(cameraNames);
+            volumes->balance(cameraNames);
+            session_->setVolumes(volumes);
 
-                camera(i).setSessionPath(dir);
+            for (size_t i = 0; i < numCameras_; ++i)
+            {
+                camera(i).setSessionPath(volumes->cameraDir(0, cameraNames[i]));
             }
 
             session_->setSaveImages(true);
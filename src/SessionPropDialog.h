@@ -50,6 +50,8 @@ namespace rics
 
     private:
         void createSessionName();
+        void createVolumes();
+        std::vector<wxString> volumeRoots() const;
 
         void onOK(wxCommandEvent& WXUNUSED(event));
         void onClose(wxCloseEvent& WXUNUSED(event));
@@ -69,12 +71,15 @@ namespace rics
         size_t numCameras_;
 
         wxStaticBoxSizer* sessionNameSizer_;
+        wxStaticBoxSizer* volumesSizer_;
 
         wxButton* okButton_;
 
         wxTextCtrl* textCtrlSN_;
         wxCheckBox* checkBoxSN_;
         wxTextCtrl* textCtrlLoc_;
+        wxTextCtrl* textCtrlVolumes_;
+        wxChoice* choiceVolumeMode_;
 
         wxDirPickerCtrl directory_;
 
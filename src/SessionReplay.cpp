@@ -0,0 +1,234 @@
+/*
+Author: Nariman Habili
+
+Description: Replays a recorded session. A replay clock paces the recorded
+             frames and NMEA sentences at real time, at a multiple of real 
+             time, or as fast as the pipeline takes them. Frame times come
+             from the modification times of the saved images.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SessionReplay.h"
+#include <wx/dir.h>
+#include <wx/filename.h>
+#include <wx/datetime.h>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace rics
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////Replay clock
+    ReplayClock::ReplayClock(double speed):
+    speed_(speed),
+    origin_(0),
+    start_(0),
+    progress_(0)
+    {
+    }
+
+    ReplayClock::~ReplayClock()
+    {
+    }
+
+    //The recorded time of the first frame or sentence. Must be set before start.
+    void ReplayClock::setOrigin(wxLongLong recorded)
+    {
+        origin_ = recorded;
+        progress_ = recorded;
+    }
+
+    void ReplayClock::start()
+    {
+        start_ = wxGetLocalTimeMillis();
+    }
+
+    //Wait until "recorded" is due, for at most "timeout" ms. Returns true if it's due.
+    bool ReplayClock::wait(wxLongLong recorded, unsigned long timeout)
+    {
+        if (speed_ <= 0.0)
+        {
+            return true;
+        }
+
+        wxLongLong due = start_ + wxLongLong(static_cast<long>((recorded - origin_).ToDouble()/speed_));
+        wxLongLong remaining = due - wxGetLocalTimeMillis();
+        if (remaining <= 0)
+        {
+            return true;
+        }
+
+        if (remaining > static_cast<long>(timeout))
+        {
+            Sleep(timeout);
+            return false;
+        }
+
+        Sleep(remaining.GetLo());
+        return true;
+    }
+
+    //As fast as possible, the clock is as far as the frames delivered so far.
+    void ReplayClock::advance(wxLongLong recorded)
+    {
+        wxMutexLocker lock(mutex_);
+        if (recorded > progress_)
+        {
+            progress_ = recorded;
+        }
+    }
+
+    //The recorded time reached.
+    wxLongLong ReplayClock::now()
+    {
+        if (speed_ <= 0.0)
+        {
+            wxMutexLocker lock(mutex_);
+            return progress_;
+        }
+
+        return origin_ + wxLongLong(static_cast<long>((wxGetLocalTimeMillis() - start_).ToDouble()*speed_));
+    }
+
+    double ReplayClock::speed() const
+    {
+        return speed_;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////Frame replay
+    static bool timeLess(const std::pair<wxLongLong, long>& a, const std::pair<wxLongLong, long>& b)
+    {
+        return a.first < b.first || (a.first == b.first && a.second < b.second);
+    }
+
+    //Frames are replayed in the order they were saved. The size is taken from the first frame.
+    FrameReplay::FrameReplay(const wxString& cameraDir, ReplayClockPtr clock):
+    cameraDir_(cameraDir),
+    clock_(clock),
+    next_(0),
+    width_(0),
+    height_(0)
+    {
+        std::vector<std::pair<wxLongLong, long> > frames;
+        wxDir dir(cameraDir_);
+        wxString file;
+
+        bool more = dir.IsOpened() && dir.GetFirst(&file, "*.jpg", wxDIR_FILES);
+        while (more)
+        {
+            long frame;
+            if (file.BeforeFirst('.').ToLong(&frame))
+            {
+                wxDateTime modified = wxFileName(cameraDir_ + "\\" + file).GetModificationTime();
+                frames.push_back(std::make_pair(modified.IsValid() ? modified.GetValue() : wxLongLong(0), frame));
+            }
+            more = dir.GetNext(&file);
+        }
+
+        std::sort(frames.begin(), frames.end(), timeLess);
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            times_.push_back(frames[i].first);
+            frames_.push_back(frames[i].second);
+        }
+
+        if (!frames_.empty())
+        {
+            try
+            {
+                reader_.size((cameraDir_ + wxString::Format("\\%07ld.jpg", frames_[0])).c_str(), width_, height_);
+            }
+            catch (std::runtime_error&)
+            {
+                frames_.clear();
+                times_.clear();
+            }
+        }
+    }
+
+    FrameReplay::~FrameReplay()
+    {
+    }
+
+    size_t FrameReplay::size() const
+    {
+        return frames_.size();
+    }
+
+    bool FrameReplay::finished() const
+    {
+        return next_ >= frames_.size();
+    }
+
+    wxLongLong FrameReplay::firstTime() const
+    {
+        return times_.empty() ? wxLongLong(0) : times_[0];
+    }
+
+    unsigned long FrameReplay::width() const
+    {
+        return width_;
+    }
+
+    unsigned long FrameReplay::height() const
+    {
+        return height_;
+    }
+
+    //Decode the next frame into "image" once it's due. Returns false if it isn't 
+    //due within "timeout" ms, or there are no frames left. Frames that can't be 
+    //read, or are a different size to the first, are skipped.
+    bool FrameReplay::next(unsigned long timeout, std::vector<unsigned char>& image, long& frame)
+    {
+        while (next_ < frames_.size())
+        {
+            if (!clock_->wait(times_[next_], timeout))
+            {
+                return false;
+            }
+
+            size_t i = next_++;
+            wxString path = cameraDir_ + wxString::Format("\\%07ld.jpg", frames_[i]);
+
+            try
+            {
+                unsigned long width;
+                unsigned long height;
+                reader_.read(path.c_str(), 1, image, width, height);
+                if (width != width_ || height != height_)
+                {
+                    continue;
+                }
+            }
+            catch (std::runtime_error&)
+            {
+                continue;
+            }
+
+            clock_->advance(times_[i]);
+            frame = frames_[i];
+            return true;
+        }
+
+        return false;
+    }
+
+} //namespace
@@ -0,0 +1,93 @@
+/*
+Author: Nariman Habili
+
+Description: Replays a recorded session. A replay clock paces the recorded
+             frames and NMEA sentences at real time, at a multiple of real 
+             time, or as fast as the pipeline takes them. Frame times come
+             from the modification times of the saved images.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SESSION_REPLAY_H
+#define SESSION_REPLAY_H
+
+#include "JPEGReader.h"
+#include <wx/wx.h>
+#include <wx/longlong.h>
+#include <wx/thread.h>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+namespace rics
+{
+    //Times are milliseconds since 1970 (UTC), as recorded.
+    class ReplayClock
+    {
+    public:
+        ReplayClock(double speed);
+        ~ReplayClock();
+
+        void setOrigin(wxLongLong recorded);
+        void start();
+        bool wait(wxLongLong recorded, unsigned long timeout);
+        void advance(wxLongLong recorded);
+        wxLongLong now();
+        double speed() const;
+
+    private:
+        double speed_;//0 for as fast as possible
+        wxLongLong origin_;
+        wxLongLong start_;
+        wxLongLong progress_;
+        wxMutex mutex_;
+    };
+
+    typedef boost::shared_ptr<ReplayClock> ReplayClockPtr;
+
+    //The saved frames of one camera.
+    class FrameReplay
+    {
+    public:
+        FrameReplay(const wxString& cameraDir, ReplayClockPtr clock);
+        ~FrameReplay();
+
+        size_t size() const;
+        bool finished() const;
+        wxLongLong firstTime() const;
+        unsigned long width() const;
+        unsigned long height() const;
+
+        bool next(unsigned long timeout, std::vector<unsigned char>& image, long& frame);
+
+    private:
+        wxString cameraDir_;
+        ReplayClockPtr clock_;
+        std::vector<long> frames_;
+        std::vector<wxLongLong> times_;
+        size_t next_;
+        unsigned long width_;
+        unsigned long height_;
+        JPEGReader reader_;
+    };
+
+    typedef boost::shared_ptr<FrameReplay> FrameReplayPtr;
+
+} //namespace
+
+#endif //SESSION_REPLAY_H
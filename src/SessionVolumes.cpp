@@ -0,0 +1,419 @@
+/*
+Author: Nariman Habili
+
+Description: Spreads the frames of a session over several volumes (disks). The
+             session directory on each volume has the same layout, with a
+             sub-directory per camera. Either each camera is given a volume,
+             balanced by the measured write throughput of the volumes, or
+             frames go round robin, weighted by throughput. A volume that
+             is nearly full or fails a write is taken out of use and the
+             frames go to the others.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SessionVolumes.h"
+#include "Database.h"
+#include <wx/filename.h>
+#include <algorithm>
+
+namespace rics
+{
+    const double SessionVolumes::reserveBytes_ = 1e9;
+
+    //The first directory is the primary session directory (database, thumbnails).
+    SessionVolumes::SessionVolumes(const std::vector<wxString>& sessionDirs, Mode mode):
+    dirs_(sessionDirs),
+    mode_(mode),
+    db_(NULL),
+    throughputs_(sessionDirs.size(), 0.0),
+    failed_(sessionDirs.size(), false),
+    full_(sessionDirs.size(), false),
+    freeBytes_(sessionDirs.size(), -1.0),
+    lastChecked_(sessionDirs.size(), 0),
+    credits_(sessionDirs.size(), 0.0)
+    {
+    }
+
+    SessionVolumes::~SessionVolumes()
+    {
+    }
+
+    //A new session. "roots" are the other volumes, the session gets a directory of
+    //the same name on each. The volumes are saved in the database so the session
+    //can be reopened and its frames found.
+    SessionVolumesPtr SessionVolumes::create(const wxString& sessionDir,
+                                             const wxString& sessionName,
+                                             const std::vector<wxString>& roots,
+                                             Mode mode,
+                                             Database* db)
+    {
+        std::vector<wxString> dirs(1, sessionDir);
+
+        for (size_t i = 0; i < roots.size(); ++i)
+        {
+            wxString root = roots[i];
+            root.Trim().Trim(false);
+            while (root.EndsWith("\\") || root.EndsWith("/"))
+            {
+                root.RemoveLast();
+            }
+
+            if (root.IsEmpty())
+            {
+                continue;
+            }
+
+            wxString dir = root + "\\" + sessionName;
+            if (std::find(dirs.begin(), dirs.end(), dir) != dirs.end())
+            {
+                continue;
+            }
+
+            if (!wxDirExists(dir))
+            {
+                wxMkdir(dir);
+            }
+            dirs.push_back(dir);
+        }
+
+        SessionVolumesPtr volumes(new SessionVolumes(dirs, mode));
+        volumes->setDatabase(db);
+
+        if (db && dirs.size() > 1)
+        {
+            for (size_t i = 0; i < dirs.size(); ++i)
+            {
+                db->databaseEnterSessionVolume(dirs[i], modeName(mode));
+            }
+        }
+
+        return volumes;
+    }
+
+    //An existing session, with the volumes it was created with. The primary is 
+    //always "sessionDir", in case the session has been moved.
+    SessionVolumesPtr SessionVolumes::open(const wxString& sessionDir, Database* db)
+    {
+        std::vector<wxString> dirs(1, sessionDir);
+        wxString name = modeName(PER_CAMERA);
+
+        if (db)
+        {
+            std::vector<wxString> saved = db->sessionVolumes(name);
+            for (size_t i = 1; i < saved.size(); ++i)
+            {
+                dirs.push_back(saved[i]);
+            }
+        }
+
+        SessionVolumesPtr volumes(new SessionVolumes(dirs, mode(name)));
+        volumes->setDatabase(db);
+
+        return volumes;
+    }
+
+    SessionVolumes::Mode SessionVolumes::mode(const wxString& name)
+    {
+        return name == "round-robin" ? ROUND_ROBIN : PER_CAMERA;
+    }
+
+    wxString SessionVolumes::modeName(Mode mode)
+    {
+        return mode == ROUND_ROBIN ? "round-robin" : "per-camera";
+    }
+
+    //A directory per camera on every volume. A volume that can't be written to is
+    //taken out of use; false if that leaves none.
+    bool SessionVolumes::createDirs(const std::vector<wxString>& cameraNames)
+    {
+        wxMutexLocker lock(mutex_);
+
+        bool any = false;
+        for (size_t v = 0; v < dirs_.size(); ++v)
+        {
+            for (size_t i = 0; i < cameraNames.size() && !failed_[v]; ++i)
+            {
+                wxString dir = dirs_[v] + "\\" + cameraNames[i];
+                if (!wxDirExists(dir) && !wxMkdir(dir))
+                {
+                    failed_[v] = true;
+                    log(v, "failed to create " + dir);
+                }
+            }
+
+            any |= !failed_[v];
+        }
+
+        return any;
+    }
+
+    //Where volume events are logged. May be NULL.
+    void SessionVolumes::setDatabase(Database* db)
+    {
+        wxMutexLocker lock(mutex_);
+        db_ = db;
+    }
+
+    SessionVolumes::Mode SessionVolumes::mode() const
+    {
+        return mode_;
+    }
+
+    size_t SessionVolumes::numVolumes() const
+    {
+        return dirs_.size();
+    }
+
+    wxString SessionVolumes::sessionDir(size_t volume) const
+    {
+        return dirs_[volume];
+    }
+
+    wxString SessionVolumes::cameraDir(size_t volume, const wxString& cameraName) const
+    {
+        return dirs_[volume] + "\\" + cameraName;
+    }
+
+    //The session directory on each volume still in use.
+    std::vector<wxString> SessionVolumes::sessionDirs() const
+    {
+        wxMutexLocker lock(mutex_);
+
+        std::vector<wxString> dirs;
+        for (size_t v = 0; v < dirs_.size(); ++v)
+        {
+            if (!failed_[v])
+            {
+                dirs.push_back(dirs_[v]);
+            }
+        }
+
+        return dirs;
+    }
+
+    //Measured write speed of a volume, e.g. by the storage benchmark.
+    void SessionVolumes::setThroughput(size_t volume, double bytesPerSecond)
+    {
+        wxMutexLocker lock(mutex_);
+        throughputs_[volume] = bytesPerSecond;
+    }
+
+    //Give each camera a volume. Cameras are handed out one at a time to the volume
+    //with the least load for its throughput, so a volume twice as fast gets about
+    //twice as many cameras. Until every volume has been measured they count the same.
+    void SessionVolumes::balance(const std::vector<wxString>& cameraNames)
+    {
+        wxMutexLocker lock(mutex_);
+
+        std::vector<size_t> load(dirs_.size(), 0);
+        assigned_.clear();
+
+        for (size_t i = 0; i < cameraNames.size(); ++i)
+        {
+            size_t v = leastLoaded(load);
+            if (v == npos)
+            {
+                v = 0;
+            }
+
+            assigned_[cameraNames[i]] = v;
+            ++load[v];
+        }
+
+        credits_.assign(dirs_.size(), 0.0);
+    }
+
+    //The volume for the next frame of "cameraName", or npos if all are full or failed.
+    //Called by the camera threads.
+    size_t SessionVolumes::next(const wxString& cameraName)
+    {
+        wxMutexLocker lock(mutex_);
+
+        std::vector<bool> ok(dirs_.size());
+        for (size_t v = 0; v < dirs_.size(); ++v)
+        {
+            ok[v] = usable(v);
+        }
+
+        bool measured = std::find(throughputs_.begin(), throughputs_.end(), 0.0) == throughputs_.end();
+
+        if (mode_ == ROUND_ROBIN)
+        {
+            //Smooth weighted round robin: each volume gains its weight, the one with 
+            //the most credit is chosen and pays back the total.
+            double total = 0.0;
+            size_t best = npos;
+            for (size_t v = 0; v < dirs_.size(); ++v)
+            {
+                if (ok[v])
+                {
+                    double weight = measured ? throughputs_[v] : 1.0;
+                    credits_[v] += weight;
+                    total += weight;
+                    if (best == npos || credits_[v] > credits_[best])
+                    {
+                        best = v;
+                    }
+                }
+            }
+
+            if (best != npos)
+            {
+                credits_[best] -= total;
+            }
+
+            return best;
+        }
+
+        std::map<wxString, size_t>::iterator it = assigned_.find(cameraName);
+        if (it != assigned_.end() && ok[it->second])
+        {
+            return it->second;
+        }
+
+        //Move the camera to the least loaded of the volumes still in use.
+        std::vector<size_t> load(dirs_.size(), 0);
+        for (std::map<wxString, size_t>::iterator a = assigned_.begin(); a != assigned_.end(); ++a)
+        {
+            if (a->first != cameraName && ok[a->second])
+            {
+                ++load[a->second];
+            }
+        }
+
+        size_t v = leastLoaded(load);
+        if (v != npos && it != assigned_.end())
+        {
+            log(v, "camera " + cameraName + " moved here from " + dirs_[it->second]);
+        }
+        assigned_[cameraName] = v;
+
+        return v;
+    }
+
+    //A write to "volume" failed. It isn't used again this session.
+    void SessionVolumes::failed(size_t volume, const wxString& reason)
+    {
+        wxMutexLocker lock(mutex_);
+
+        if (volume < dirs_.size() && !failed_[volume])
+        {
+            failed_[volume] = true;
+            log(volume, reason);
+        }
+    }
+
+    //One line per volume: directory, state, free space, throughput and, per camera,
+    //the cameras on it.
+    wxString SessionVolumes::status() const
+    {
+        wxMutexLocker lock(mutex_);
+
+        wxString text;
+        for (size_t v = 0; v < dirs_.size(); ++v)
+        {
+            text += dirs_[v] + (failed_[v] ? " failed" : (full_[v] ? " full" : " ok"));
+
+            if (freeBytes_[v] >= 0.0)
+            {
+                text += wxString::Format(" %.0fGB free", freeBytes_[v]/1e9);
+            }
+
+            if (throughputs_[v] > 0.0)
+            {
+                text += wxString::Format(" %.1fMB/s", throughputs_[v]/1e6);
+            }
+
+            if (mode_ == PER_CAMERA)
+            {
+                for (std::map<wxString, size_t>::const_iterator it = assigned_.begin(); it != assigned_.end(); ++it)
+                {
+                    if (it->second == v)
+                    {
+                        text += " " + it->first;
+                    }
+                }
+            }
+
+            text += "\n";
+        }
+
+        return text;
+    }
+
+    //Not failed and not full. The free space is only checked every few seconds.
+    bool SessionVolumes::usable(size_t volume)
+    {
+        if (failed_[volume])
+        {
+            return false;
+        }
+
+        wxLongLong now = wxGetLocalTimeMillis();
+        if (lastChecked_[volume] == 0 || now - lastChecked_[volume] >= freeSpaceInterval_)
+        {
+            wxLongLong free;
+            freeBytes_[volume] = wxGetDiskSpace(dirs_[volume], NULL, &free) ? free.ToDouble() : -1.0;
+            lastChecked_[volume] = now;
+
+            bool full = freeBytes_[volume] >= 0.0 && freeBytes_[volume] < reserveBytes_;
+            if (full != full_[volume])
+            {
+                full_[volume] = full;
+                log(volume, full ? "full" : "space available");
+            }
+        }
+
+        return !full_[volume];
+    }
+
+    //The volume in use with the lowest (load + 1)/throughput, or npos if none are in use.
+    size_t SessionVolumes::leastLoaded(const std::vector<size_t>& load) const
+    {
+        bool measured = std::find(throughputs_.begin(), throughputs_.end(), 0.0) == throughputs_.end();
+
+        size_t best = npos;
+        double bestCost = 0.0;
+        for (size_t v = 0; v < dirs_.size(); ++v)
+        {
+            if (failed_[v] || full_[v])
+            {
+                continue;
+            }
+
+            double cost = (load[v] + 1)/(measured ? throughputs_[v] : 1.0);
+            if (best == npos || cost < bestCost)
+            {
+                best = v;
+                bestCost = cost;
+            }
+        }
+
+        return best;
+    }
+
+    void SessionVolumes::log(size_t volume, const wxString& event)
+    {
+        if (db_)
+        {
+            db_->databaseEnterVolumeEvent(dirs_[volume], event, freeBytes_[volume]);
+        }
+    }
+
+}//namespace
@@ -0,0 +1,111 @@
+/*
+Author: Nariman Habili
+
+Description: Spreads the frames of a session over several volumes (disks). The
+             session directory on each volume has the same layout, with a
+             sub-directory per camera. Either each camera is given a volume,
+             balanced by the measured write throughput of the volumes, or
+             frames go round robin, weighted by throughput. A volume that
+             is nearly full or fails a write is taken out of use and the
+             frames go to the others.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SESSION_VOLUMES_H
+#define SESSION_VOLUMES_H
+
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <boost/shared_ptr.hpp>
+#include <map>
+#include <vector>
+
+namespace rics
+{
+    class Database;
+
+    class SessionVolumes
+    {
+    public:
+        enum Mode
+        {
+            PER_CAMERA,
+            ROUND_ROBIN
+        };
+
+        SessionVolumes(const std::vector<wxString>& sessionDirs, Mode mode);
+        ~SessionVolumes();
+
+        static boost::shared_ptr<SessionVolumes> create(const wxString& sessionDir,
+                                                        const wxString& sessionName,
+                                                        const std::vector<wxString>& roots,
+                                                        Mode mode,
+                                                        Database* db);
+        static boost::shared_ptr<SessionVolumes> open(const wxString& sessionDir, Database* db);
+        static Mode mode(const wxString& name);
+        static wxString modeName(Mode mode);
+
+        bool createDirs(const std::vector<wxString>& cameraNames);
+        void setDatabase(Database* db);
+
+        Mode mode() const;
+        size_t numVolumes() const;
+        wxString sessionDir(size_t volume) const;
+        wxString cameraDir(size_t volume, const wxString& cameraName) const;
+        std::vector<wxString> sessionDirs() const;
+
+        void setThroughput(size_t volume, double bytesPerSecond);
+        void balance(const std::vector<wxString>& cameraNames);
+
+        size_t next(const wxString& cameraName);
+        void failed(size_t volume, const wxString& reason);
+
+        wxString status() const;
+
+    public:
+        static const size_t npos = static_cast<size_t>(-1);
+
+    private:
+        bool usable(size_t volume);
+        size_t leastLoaded(const std::vector<size_t>& load) const;
+        void log(size_t volume, const wxString& event);
+
+    private:
+        mutable wxMutex mutex_;
+        std::vector<wxString> dirs_;
+        Mode mode_;
+        Database* db_;
+
+        std::vector<double> throughputs_;//bytes/sec, 0 if not measured
+        std::vector<bool> failed_;       //write error, out of use for the rest of the session
+        std::vector<bool> full_;
+        std::vector<double> freeBytes_;
+        std::vector<wxLongLong> lastChecked_;
+        std::vector<double> credits_;    //smooth weighted round robin
+        std::map<wxString, size_t> assigned_;
+
+        static const long freeSpaceInterval_ = 10000;//ms between free space checks
+        static const double reserveBytes_;           //left free on each volume
+    };
+
+    typedef boost::shared_ptr<SessionVolumes> SessionVolumesPtr;
+
+}//namespace
+
+#endif //SESSION_VOLUMES_H
@@ -35,7 +35,8 @@ namespace rics
     {
     public:
         SharedGPSData():
-        cond_(mutex_)
+        cond_(mutex_),
+        speedKmh_(0.0)
         {
         }
 
@@ -64,6 +65,13 @@ namespace rics
             cond_.Wait();
             mutex_.Unlock();
         }
+
+        //Without waiting for a reader. For when no GUI is reading every update
+        //(eg ricsd), where writeUnlock() would hold the writer until the next read.
+        void writeUnlockNoWait()
+        {
+            mutex_.Unlock();
+        }
     
         void setLatitude(const wxString& lat)
         {
@@ -205,6 +213,16 @@ namespace rics
             return quality_;
         }
 
+        void setSpeedKmh(double s)
+        {
+            speedKmh_ = s;
+        }
+
+        double speedKmh() const
+        {
+            return speedKmh_;
+        }
+
 
     private:
         wxMutex mutex_;
@@ -224,6 +242,7 @@ namespace rics
         wxString altitude_;
         wxString formatAltitude_;
         wxString quality_;
+        double speedKmh_;
     };
 
     typedef boost::shared_ptr<SharedGPSData> SharedGPSDataPtr;
@@ -27,58 +27,65 @@ along with RICS.  If not, see <http://www.gnu.org/licenses/>.
 #include "wx/thread.h"
 #include <boost/shared_array.hpp>
 #include <boost/shared_ptr.hpp>
+#include <cstring>
 
 namespace rics
 {
+    //Holds the latest preview image of a camera. The camera thread overwrites
+    //the image as frames arrive and never waits for the GUI. The GUI copies 
+    //the image out on its own refresh tick; the frame count lets it skip 
+    //cameras that have not delivered a new frame since the last tick.
     class SharedImageBuffer
     {
     public:
-        SharedImageBuffer():
-        cond_(mutex_)
+        SharedImageBuffer(size_t size):
+        data_(new unsigned char[size]),
+        size_(size),
+        frameCount_(0)
         {
+            memset(data_.get(), 0, size_);
         }
 
         ~SharedImageBuffer()
         {
         }
-        
-        void readLock()
-        {
-            mutex_.Lock();
-        }
-
-        void readUnlock()
-        {
-            cond_.Signal();
-            mutex_.Unlock();
-        }
-
-        void writeLock()
-        {
-            mutex_.Lock();
-        }
 
-        void writeUnlock()
+        //Copy a new image into the buffer. Called by the camera thread.
+        void write(const unsigned char* image)
         {
-            cond_.Wait();
-            mutex_.Unlock();
+            wxMutexLocker lock(mutex_);
+            memcpy(data_.get(), image, size_);
+            ++frameCount_;
         }
 
-        boost::shared_array<unsigned char> data() const
+        //Copy the latest image into "image" if it is newer than "lastFrame".
+        //Returns false if nothing has changed since the last read.
+        bool read(unsigned char* image, unsigned long& lastFrame)
         {
-            return data_;
+            wxMutexLocker lock(mutex_);
+            
+            if (frameCount_ == lastFrame)
+            {
+                return false;
+            }
+
+            memcpy(image, data_.get(), size_);
+            lastFrame = frameCount_;
+            
+            return true;
         }
 
-        void setData(const boost::shared_array<unsigned char>& data)
+        size_t size() const
         {
-            data_ = data;
+            return size_;
         }
         
     private:
         wxMutex mutex_;
-        wxCondition cond_;
 
         boost::shared_array<unsigned char> data_;
+        size_t size_;
+        unsigned long frameCount_;
     };
 
     typedef boost::shared_ptr<SharedImageBuffer> SharedImageBufferPtr;
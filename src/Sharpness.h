@@ -0,0 +1,55 @@
+/*
+Author: Nariman Habili
+
+Description: Sharpness (focus and motion blur) score of a frame: the
+             variance of the Laplacian of a decimated luma plane. Blurred
+             frames have few edges and score low.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SHARPNESS_H
+#define SHARPNESS_H
+
+#include <vector>
+
+namespace rics
+{
+    class Sharpness
+    {
+    public:
+        Sharpness(unsigned long width, unsigned long height, unsigned long decimation = 3);
+        ~Sharpness();
+
+        double measure(const unsigned char* rgb);
+
+    private:
+        void decimate(const unsigned char* rgb);
+        void laplacianRow(unsigned long j, double& sum, double& sumSquares) const;
+
+    private:
+        unsigned long width_;      //frame
+        unsigned long decimation_;
+        unsigned long planeWidth_;
+        unsigned long planeHeight_;
+        std::vector<unsigned char> plane_;
+    };
+
+}//namespace
+
+#endif //SHARPNESS_H
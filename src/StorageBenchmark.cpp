@@ -0,0 +1,317 @@
+/*
+Author: Nariman Habili
+
+Description: Measures whether a drive can take the frames of a session.
+             One thread per camera writes JPEG sized files, and appends
+             to a thumbnail pack, as the camera threads do, for a set
+             time. Reports MB/s, frames/sec per camera and write latency.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "StorageBenchmark.h"
+#include <wx/filename.h>
+#include <windows.h>
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+
+namespace rics
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////Worker thread
+    StorageBenchmarkWorker::StorageBenchmarkWorker(const StorageBenchmark* benchmark, const wxString& dir, wxLongLong end):
+    wxThread(wxTHREAD_JOINABLE),
+    benchmark_(benchmark),
+    dir_(dir),
+    end_(end),
+    bytes_(0.0)
+    {
+    }
+
+    StorageBenchmarkWorker::~StorageBenchmarkWorker()
+    {
+    }
+
+    //Frames are written back to back until the end time. The files are removed afterwards.
+    //With write-behind the time includes writing out what is still queued at the end.
+    void* StorageBenchmarkWorker::Entry()
+    {
+        wxFile pack;
+        if (!pack.Open(dir_ + "\\thumbnails.pack", wxFile::write_append))
+        {
+            return NULL;
+        }
+
+        boost::shared_ptr<ImageWriter> writer;
+        if (benchmark_->writeBehind())
+        {
+            writer = boost::shared_ptr<ImageWriter>(new ImageWriter);
+        }
+
+        long frame = 0;
+        while (wxGetLocalTimeMillis() < end_ && !TestDestroy())
+        {
+            if (!writeFrame(frame++, pack, writer.get()))
+            {
+                break;
+            }
+        }
+        pack.Close();
+
+        if (writer)
+        {
+            writer->flush();
+            if (writer->failures() > 0)
+            {
+                bytes_ -= writer->failures()*static_cast<double>(benchmark_->data().size());
+            }
+        }
+
+        for (long i = 0; i < frame; ++i)
+        {
+            wxRemoveFile(dir_ + wxString::Format("\\%07ld.jpg", i));
+        }
+        wxRemoveFile(dir_ + "\\thumbnails.pack");
+
+        return NULL;
+    }
+
+    //As Camera::saveImageTurbo and saveThumbnails: a new file written in one go, 
+    //then a small append to the pack. With write-behind the time is how long the
+    //camera thread would be held up, ie queuing the file.
+    bool StorageBenchmarkWorker::writeFrame(long frame, wxFile& pack, ImageWriter* writer)
+    {
+        const std::vector<unsigned char>& data = benchmark_->data();
+        size_t thumbnailBytes = data.size()/StorageBenchmark::thumbnailRatio_;
+        wxString name = dir_ + wxString::Format("\\%07ld.jpg", frame);
+
+        LARGE_INTEGER start;
+        QueryPerformanceCounter(&start);
+
+        size_t written = 0;
+        if (writer)
+        {
+            if (!writer->write(name.c_str(), &data[0], data.size()))
+            {
+                return false;
+            }
+            written = data.size();
+        }
+        else
+        {
+            FILE* file = fopen(name.c_str(), "wb");
+            if (file == NULL)
+            {
+                return false;
+            }
+
+            written = fwrite(&data[0], 1, data.size(), file);
+            fclose(file);
+        }
+        written += pack.Write(&data[0], thumbnailBytes);
+
+        LARGE_INTEGER end;
+        LARGE_INTEGER frequency;
+        QueryPerformanceCounter(&end);
+        QueryPerformanceFrequency(&frequency);
+
+        latencies_.push_back(1000.0*(end.QuadPart - start.QuadPart)/frequency.QuadPart);
+        bytes_ += written;
+
+        return written == data.size() + thumbnailBytes;
+    }
+
+    const std::vector<double>& StorageBenchmarkWorker::latencies() const
+    {
+        return latencies_;
+    }
+
+    double StorageBenchmarkWorker::bytes() const
+    {
+        return bytes_;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////Benchmark
+    //Files go in a temporary "storage_benchmark" directory under "dir", which should 
+    //be on the drive the session will be saved to.
+    StorageBenchmark::StorageBenchmark(const wxString& dir):
+    dir_(dir + "\\storage_benchmark"),
+    cameras_(4),
+    frameBytes_(1500000),
+    duration_(10000),
+    writeBehind_(USE_WRITE_BEHIND != 0),
+    bytesPerSecond_(0.0),
+    framesPerSecond_(0.0)
+    {
+    }
+
+    StorageBenchmark::~StorageBenchmark()
+    {
+    }
+
+    void StorageBenchmark::setCameras(size_t cameras)
+    {
+        cameras_ = std::max(cameras, static_cast<size_t>(1));
+    }
+
+    //Bytes per JPEG, eg Camera::savedBytesPerFrame of a previous session.
+    void StorageBenchmark::setFrameBytes(unsigned long bytes)
+    {
+        frameBytes_ = std::max(bytes, thumbnailRatio_);
+    }
+
+    unsigned long StorageBenchmark::frameBytes() const
+    {
+        return frameBytes_;
+    }
+
+    //ms
+    void StorageBenchmark::setDuration(unsigned long ms)
+    {
+        duration_ = ms;
+    }
+
+    //Defaults to the way the cameras save.
+    void StorageBenchmark::setWriteBehind(bool writeBehind)
+    {
+        writeBehind_ = writeBehind;
+    }
+
+    bool StorageBenchmark::writeBehind() const
+    {
+        return writeBehind_;
+    }
+
+    //Random, so it doesn't shrink on a compressed drive, as JPEG data wouldn't.
+    const std::vector<unsigned char>& StorageBenchmark::data() const
+    {
+        return data_;
+    }
+
+    //Blocks for the duration. Returns false if the files couldn't be written.
+    bool StorageBenchmark::run()
+    {
+        data_.resize(frameBytes_);
+        for (size_t i = 0; i < data_.size(); ++i)
+        {
+            data_[i] = static_cast<unsigned char>(rand());
+        }
+
+        std::vector<StorageBenchmarkWorker*> workers;
+        wxLongLong start = wxGetLocalTimeMillis();
+
+        for (size_t i = 0; i < cameras_; ++i)
+        {
+            wxString dir = dir_ + wxString::Format("\\camera%lu", (unsigned long)i);
+            if (!wxFileName::Mkdir(dir, 0777, wxPATH_MKDIR_FULL))
+            {
+                break;
+            }
+
+            StorageBenchmarkWorker* worker = new StorageBenchmarkWorker(this, dir, start + duration_);
+            wxThreadError threadError = worker->Create();
+            assert(threadError == wxTHREAD_NO_ERROR);
+            worker->Run();
+            workers.push_back(worker);
+        }
+
+        double bytes = 0.0;
+        latencies_.clear();
+
+        for (size_t i = 0; i < workers.size(); ++i)
+        {
+            workers[i]->Wait();
+            bytes += workers[i]->bytes();
+            latencies_.insert(latencies_.end(), workers[i]->latencies().begin(), workers[i]->latencies().end());
+            delete workers[i];
+        }
+
+        double seconds = (wxGetLocalTimeMillis() - start).ToDouble()/1000.0;
+        bytesPerSecond_ = bytes/seconds;
+        framesPerSecond_ = latencies_.size()/seconds/cameras_;
+        std::sort(latencies_.begin(), latencies_.end());
+
+        for (size_t i = 0; i < cameras_; ++i)
+        {
+            wxRmdir(dir_ + wxString::Format("\\camera%lu", (unsigned long)i));
+        }
+        wxRmdir(dir_);
+
+        return workers.size() == cameras_ && !latencies_.empty();
+    }
+
+    //All cameras together
+    double StorageBenchmark::bytesPerSecond() const
+    {
+        return bytesPerSecond_;
+    }
+
+    //Frames each camera could save per second if saving were all it did.
+    double StorageBenchmark::framesPerSecond() const
+    {
+        return framesPerSecond_;
+    }
+
+    //ms to write one frame, eg latency(99) for the 99th percentile.
+    double StorageBenchmark::latency(double percentile) const
+    {
+        if (latencies_.empty())
+        {
+            return 0.0;
+        }
+
+        size_t i = static_cast<size_t>((latencies_.size() - 1)*percentile/100.0);
+        return latencies_[i];
+    }
+
+    //The largest frame the cameras have been saving, or an estimate from the saved 
+    //region if nothing has been saved yet.
+    unsigned long StorageBenchmark::frameBytes(Cameras* cameras)
+    {
+        double frameBytes = 0.0;
+        for (size_t i = 0; i < (*cameras).size(); ++i)
+        {
+            double bytes = (*cameras)[i].savedBytesPerFrame();
+            if (bytes <= 0.0)
+            {
+                bytes = (*cameras)[i].saveWidth()*(*cameras)[i].saveHeight()*3/10.0;//about quality 80
+            }
+            frameBytes = std::max(frameBytes, bytes);
+        }
+
+        return static_cast<unsigned long>(frameBytes);
+    }
+
+    wxString StorageBenchmark::report() const
+    {
+        return wxString::Format("%lu cameras, %.2fMB frames, %s: %.1fMB/s, %.1f frames/sec per camera, "
+                                "write ms p50 %.1f, p99 %.1f, max %.1f",
+                                (unsigned long)cameras_,
+                                frameBytes_/1e6,
+                                writeBehind_ ? "write-behind" : "fopen/fwrite",
+                                bytesPerSecond_/1e6,
+                                framesPerSecond_,
+                                latency(50.0),
+                                latency(99.0),
+                                latency(100.0));
+    }
+
+}//namespace
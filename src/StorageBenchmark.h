@@ -0,0 +1,105 @@
+/*
+Author: Nariman Habili
+
+Description: Measures whether a drive can take the frames of a session.
+             One thread per camera writes JPEG sized files, and appends
+             to a thumbnail pack, as the camera threads do, for a set
+             time. Reports MB/s, frames/sec per camera and write latency.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STORAGE_BENCHMARK_H
+#define STORAGE_BENCHMARK_H
+
+#include "Camera.h"
+#include "ImageWriter.h"
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <wx/file.h>
+#include <wx/longlong.h>
+#include <vector>
+
+namespace rics
+{
+    class StorageBenchmark;
+
+    class StorageBenchmarkWorker : public wxThread
+    {
+    public:
+        StorageBenchmarkWorker(const StorageBenchmark* benchmark, const wxString& dir, wxLongLong end);
+        ~StorageBenchmarkWorker();
+
+        void* Entry();
+
+        const std::vector<double>& latencies() const;
+        double bytes() const;
+
+    private:
+        bool writeFrame(long frame, wxFile& pack, ImageWriter* writer);
+
+    private:
+        const StorageBenchmark* benchmark_;
+        wxString dir_;
+        wxLongLong end_;
+        std::vector<double> latencies_;//ms per frame
+        double bytes_;
+    };
+
+    class StorageBenchmark
+    {
+    public:
+        StorageBenchmark(const wxString& dir);
+        ~StorageBenchmark();
+
+        void setCameras(size_t cameras);
+        void setFrameBytes(unsigned long bytes);
+        unsigned long frameBytes() const;
+        void setDuration(unsigned long ms);
+        void setWriteBehind(bool writeBehind);
+        bool writeBehind() const;
+        const std::vector<unsigned char>& data() const;
+
+        bool run();
+
+        double bytesPerSecond() const;
+        double framesPerSecond() const;
+        double latency(double percentile) const;
+        wxString report() const;
+
+        static unsigned long frameBytes(Cameras* cameras);
+
+    public:
+        static const unsigned long thumbnailRatio_ = 64;//frame bytes per thumbnail byte
+
+    private:
+        wxString dir_;
+        size_t cameras_;
+        unsigned long frameBytes_;
+        unsigned long duration_;
+        bool writeBehind_;//through ImageWriter, as the cameras save, rather than fopen/fwrite
+        std::vector<unsigned char> data_;
+
+        double bytesPerSecond_;
+        double framesPerSecond_;
+        std::vector<double> latencies_;//sorted
+    };
+
+}//namespace
+
+#endif //STORAGE_BENCHMARK_H
@@ -0,0 +1,276 @@
+/*
+Author: Nariman Habili
+
+Description: Predicts how long the session drive lasts at the current
+             write rate, from the bytes the cameras have saved and the
+             free space, and warns when saving can't keep up with the
+             cameras or the drive is nearly full.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "StorageForecast.h"
+#include <wx/filename.h>
+#include <algorithm>
+#include <set>
+
+namespace rics
+{
+    static const double busyLimit = 0.8;        //share of a camera thread's time spent converting and saving
+    static const double throughputLimit = 0.8;  //share of the benchmarked drive throughput
+    static const double minSecondsLeft = 1800.0;//warn when the drive will be full within half an hour
+    static const double backlogLimit = 0.8;     //share of an image writer queue in use
+
+    StorageForecast::StorageForecast():
+    throughput_(0.0),
+    lastSample_(0),
+    lastFreeSpace_(0),
+    bytesPerSecond_(0.0),
+    freeBytes_(-1.0),
+    load_(0.0),
+    backlog_(0.0),
+    latency_(0.0)
+    {
+    }
+
+    StorageForecast::~StorageForecast()
+    {
+    }
+
+    //The session directory. Empty when nothing is being saved.
+    void StorageForecast::setPath(const wxString& path)
+    {
+        setPaths(path == "" ? std::vector<wxString>() : std::vector<wxString>(1, path));
+    }
+
+    //A session saved to several volumes. The free space is the total of the volumes.
+    void StorageForecast::setPaths(const std::vector<wxString>& paths)
+    {
+        if (paths != paths_)
+        {
+            paths_ = paths;
+            path_ = paths_.empty() ? "" : paths_[0];
+            lastFreeSpace_ = 0;
+            freeBytes_ = -1.0;
+        }
+    }
+
+    wxString StorageForecast::path() const
+    {
+        return path_;
+    }
+
+    //From StorageBenchmark. The forecast warns as the write rate gets close to it.
+    void StorageForecast::setThroughput(double bytesPerSecond)
+    {
+        throughput_ = bytesPerSecond;
+    }
+
+    double StorageForecast::throughput() const
+    {
+        return throughput_;
+    }
+
+    //Call regularly (eg from a GUI timer). The write rate and load are measured 
+    //over sampleInterval_, from the running totals kept by each camera. JPEGs are
+    //written behind the camera threads, so the rate is of the bytes the image writers
+    //have put on disk, and a drive that can't keep up shows as the writers' queues
+    //filling and their latency growing rather than as camera thread load.
+    void StorageForecast::update(Cameras* cameras, wxLongLong now)
+    {
+        if (path_ != "" && (lastFreeSpace_ == 0 || now - lastFreeSpace_ >= freeSpaceInterval_))
+        {
+            //Directories on the same drive are only counted once.
+            std::set<wxString> drives;
+            freeBytes_ = -1.0;
+            for (size_t i = 0; i < paths_.size(); ++i)
+            {
+                wxLongLong free;
+                if (drives.insert(wxFileName(paths_[i]).GetVolume().Lower()).second && 
+                    wxGetDiskSpace(paths_[i], NULL, &free))
+                {
+                    freeBytes_ = std::max(freeBytes_, 0.0) + free.ToDouble();
+                }
+            }
+            lastFreeSpace_ = now;
+        }
+
+        if (lastBytes_.size() != (*cameras).size() || lastSample_ == 0)
+        {
+            lastBytes_.resize((*cameras).size());
+            lastSaveTimes_.resize((*cameras).size());
+            for (size_t i = 0; i < (*cameras).size(); ++i)
+            {
+                lastBytes_[i] = (*cameras)[i].bytesWritten();
+                lastSaveTimes_[i] = (*cameras)[i].saveTimeTotal();
+            }
+            lastSample_ = now;
+            return;
+        }
+
+        if (now - lastSample_ < sampleInterval_)
+        {
+            return;
+        }
+
+        double seconds = (now - lastSample_).ToDouble()/1000.0;
+        double bytes = 0.0;
+        double load = 0.0;
+        double backlog = 0.0;
+        double latency = 0.0;
+
+        for (size_t i = 0; i < (*cameras).size(); ++i)
+        {
+            Camera& camera = (*cameras)[i];
+            double saveTime = camera.saveTimeTotal();
+
+            //Frames are converted and saved on the camera's own thread, so once this 
+            //reaches 1 the thread can't keep up and frames are lost.
+            double busy = (saveTime - lastSaveTimes_[i])/(1000.0*seconds) + 
+                          camera.convertTime()*camera.actualFrameRate()/1000.0;
+            load = std::max(load, busy);
+
+            backlog = std::max(backlog, camera.writeBacklog());
+            latency = std::max(latency, camera.writeLatency(99.0));
+
+            double written = camera.bytesWritten();
+            bytes += written - lastBytes_[i];
+            lastBytes_[i] = written;
+            lastSaveTimes_[i] = saveTime;
+        }
+
+        bytesPerSecond_ = bytes/seconds;
+        load_ = load;
+        backlog_ = backlog;
+        latency_ = latency;
+        lastSample_ = now;
+    }
+
+    //Start measuring again, eg when capture restarts.
+    void StorageForecast::reset()
+    {
+        lastSample_ = 0;
+        bytesPerSecond_ = 0.0;
+        load_ = 0.0;
+        backlog_ = 0.0;
+        latency_ = 0.0;
+    }
+
+    //Bytes written by all cameras over the last sample.
+    double StorageForecast::bytesPerSecond() const
+    {
+        return bytesPerSecond_;
+    }
+
+    //-1 if not known
+    double StorageForecast::freeBytes() const
+    {
+        return freeBytes_;
+    }
+
+    //At the current write rate. -1 if nothing is being written.
+    double StorageForecast::secondsToFull() const
+    {
+        if (freeBytes_ < 0.0 || bytesPerSecond_ <= 0.0)
+        {
+            return -1.0;
+        }
+
+        return freeBytes_/bytesPerSecond_;
+    }
+
+    //The busiest camera thread's share of time spent converting and saving frames.
+    double StorageForecast::load() const
+    {
+        return load_;
+    }
+
+    //The fullest image writer queue, as a share of the files it holds before the 
+    //camera thread has to wait.
+    double StorageForecast::backlog() const
+    {
+        return backlog_;
+    }
+
+    //ms for the slowest camera's JPEGs to reach the disk (99th percentile), 0 if 
+    //nothing has been written.
+    double StorageForecast::latency() const
+    {
+        return latency_;
+    }
+
+    bool StorageForecast::warning() const
+    {
+        double seconds = secondsToFull();
+
+        return load_ >= busyLimit ||
+               backlog_ >= backlogLimit ||
+               (throughput_ > 0.0 && bytesPerSecond_ >= throughputLimit*throughput_) ||
+               (seconds >= 0.0 && seconds < minSecondsLeft);
+    }
+
+    //For the status bar, eg "Disk 23.5MB/s 40ms 412GB free 4.9h left" (the 40ms is the
+    //write latency). Empty if there is no session directory.
+    wxString StorageForecast::status() const
+    {
+        if (path_ == "")
+        {
+            return "";
+        }
+
+        wxString text = "Disk";
+        if (bytesPerSecond_ > 0.0)
+        {
+            text += wxString::Format(" %.1fMB/s", bytesPerSecond_/1e6);
+        }
+        if (latency_ > 0.0)
+        {
+            text += wxString::Format(" %.0fms", latency_);
+        }
+        if (freeBytes_ >= 0.0)
+        {
+            text += wxString::Format(" %.0fGB free", freeBytes_/1e9);
+        }
+
+        double seconds = secondsToFull();
+        if (seconds >= 0.0)
+        {
+            text += wxString::Format(" %.1fh left", seconds/3600.0);
+        }
+
+        if (load_ >= busyLimit)
+        {
+            text += wxString::Format(" - SAVING %.0f%% BUSY", 100.0*load_);
+        }
+        if (backlog_ >= backlogLimit)
+        {
+            text += " - WRITES BACKING UP";
+        }
+        if (throughput_ > 0.0 && bytesPerSecond_ >= throughputLimit*throughput_)
+        {
+            text += wxString::Format(" - AT %.0f%% OF DISK SPEED", 100.0*bytesPerSecond_/throughput_);
+        }
+        if (seconds >= 0.0 && seconds < minSecondsLeft)
+        {
+            text += " - DISK NEARLY FULL";
+        }
+
+        return text;
+    }
+
+}//namespace
@@ -0,0 +1,83 @@
+/*
+Author: Nariman Habili
+
+Description: Predicts how long the session drive lasts at the current
+             write rate, from the bytes the cameras have saved and the
+             free space, and warns when saving can't keep up with the
+             cameras or the drive is nearly full.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STORAGE_FORECAST_H
+#define STORAGE_FORECAST_H
+
+#include "Camera.h"
+#include <wx/wx.h>
+#include <wx/longlong.h>
+#include <vector>
+
+namespace rics
+{
+    class StorageForecast
+    {
+    public:
+        StorageForecast();
+        ~StorageForecast();
+
+        void setPath(const wxString& path);
+        void setPaths(const std::vector<wxString>& paths);
+        wxString path() const;
+        void setThroughput(double bytesPerSecond);
+        double throughput() const;
+
+        void update(Cameras* cameras, wxLongLong now);
+        void reset();
+
+        double bytesPerSecond() const;
+        double freeBytes() const;
+        double secondsToFull() const;
+        double load() const;
+        double backlog() const;
+        double latency() const;
+        bool warning() const;
+        wxString status() const;
+
+    public:
+        static const long sampleInterval_ = 5000;     //ms between rate samples
+        static const long freeSpaceInterval_ = 10000; //ms between free space checks
+
+    private:
+        wxString path_;
+        std::vector<wxString> paths_;//the session directory on each volume
+        double throughput_;//bytes/sec the drive sustained in the benchmark, 0 if not measured
+
+        wxLongLong lastSample_;
+        wxLongLong lastFreeSpace_;
+        std::vector<double> lastBytes_;
+        std::vector<double> lastSaveTimes_;
+        double bytesPerSecond_;
+        double freeBytes_;
+        double load_;
+        double backlog_;//fullest image writer queue, 0 to 1
+        double latency_;//ms, 99th percentile from queued to written, slowest camera
+    };
+
+}//namespace
+
+#endif //STORAGE_FORECAST_H
@@ -0,0 +1,122 @@
+/*
+Author: Nariman Habili
+
+Description: Settings for the network (MJPEG) preview stream.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STREAM_SETTINGS_H
+#define STREAM_SETTINGS_H
+
+namespace rics
+{
+    class StreamSettings
+    {
+    public:
+        StreamSettings():
+        enabled_(false),
+        lan_(false),
+        port_(8080),
+        rate_(2),
+        scale_(4),
+        quality_(70)
+        {
+        }
+
+        ~StreamSettings()
+        {
+        }
+
+        bool enabled() const
+        {
+            return enabled_;
+        }
+
+        void setEnabled(bool enabled)
+        {
+            enabled_ = enabled;
+        }
+
+        //Accept connections from other computers. Otherwise only from this computer.
+        bool lan() const
+        {
+            return lan_;
+        }
+
+        void setLan(bool lan)
+        {
+            lan_ = lan;
+        }
+
+        //HTTP port
+        unsigned short port() const
+        {
+            return port_;
+        }
+
+        void setPort(unsigned short port)
+        {
+            port_ = port;
+        }
+
+        //Frames/sec sent to each client
+        unsigned long rate() const
+        {
+            return rate_;
+        }
+
+        void setRate(unsigned long rate)
+        {
+            rate_ = rate;
+        }
+
+        //Streamed images are 1/scale of the camera resolution in each direction.
+        unsigned long scale() const
+        {
+            return scale_;
+        }
+
+        void setScale(unsigned long scale)
+        {
+            scale_ = scale;
+        }
+
+        //JPEG quality (0-100)
+        unsigned long quality() const
+        {
+            return quality_;
+        }
+
+        void setQuality(unsigned long quality)
+        {
+            quality_ = quality;
+        }
+
+    private:
+        bool enabled_;
+        bool lan_;
+        unsigned short port_;
+        unsigned long rate_;
+        unsigned long scale_;
+        unsigned long quality_;
+    };
+
+}//namespace
+
+#endif //STREAM_SETTINGS_H
@@ -0,0 +1,258 @@
+/*
+Author: Nariman Habili
+
+Description: Thumbnail pack file. The thumbnails of one camera, at one scale,
+             are appended as JPEGs to a single .pack file, with a fixed size
+             record per frame in an .idx file (frame number, offset, size).
+             A review tool can then page through a whole session without
+             opening the full size images.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ThumbnailPack.h"
+#include <io.h>
+#include <algorithm>
+
+namespace rics
+{
+    ThumbnailPack::ThumbnailPack():
+    packLength_(0)
+    {
+    }
+
+    ThumbnailPack::~ThumbnailPack()
+    {
+        close();
+    }
+
+    //eg <camera dir>\thumbs_8.pack for thumbnails 1/8 of the camera resolution
+    wxString ThumbnailPack::packName(const wxString& dir, unsigned long scale)
+    {
+        return dir + wxString::Format("\\thumbs_%lu.pack", scale);
+    }
+
+    wxString ThumbnailPack::indexName(const wxString& dir, unsigned long scale)
+    {
+        return dir + wxString::Format("\\thumbs_%lu.idx", scale);
+    }
+
+    //Open for writing, appending to any existing pack (eg when a session is reopened).
+    bool ThumbnailPack::create(const wxString& dir, unsigned long scale)
+    {
+        close();
+
+        wxMutexLocker lock(mutex_);
+        if (!trim(packName(dir, scale), indexName(dir, scale)) ||
+            !pack_.Open(packName(dir, scale), wxFile::write_append) ||
+            !index_.Open(indexName(dir, scale), wxFile::write_append))
+        {
+            pack_.Close();
+            index_.Close();
+            return false;
+        }
+
+        packLength_ = pack_.Length();
+
+        return true;
+    }
+
+    //Open for reading.
+    bool ThumbnailPack::open(const wxString& dir, unsigned long scale)
+    {
+        close();
+
+        wxMutexLocker lock(mutex_);
+        if (!wxFileExists(packName(dir, scale)) || !wxFileExists(indexName(dir, scale)))
+        {
+            return false;
+        }
+
+        if (!pack_.Open(packName(dir, scale), wxFile::read) ||
+            !index_.Open(indexName(dir, scale), wxFile::read))
+        {
+            pack_.Close();
+            index_.Close();
+            return false;
+        }
+
+        return loadIndex();
+    }
+
+    void ThumbnailPack::close()
+    {
+        wxMutexLocker lock(mutex_);
+        pack_.Close();
+        index_.Close();
+        entries_.clear();
+        packLength_ = 0;
+    }
+
+    bool ThumbnailPack::isOpened() const
+    {
+        return pack_.IsOpened();
+    }
+
+    //The thumbnail is written before its index record, so if capture stops
+    //part way through a write the index never points past the end of the pack.
+    bool ThumbnailPack::append(long frame, const std::vector<unsigned char>& jpeg)
+    {
+        wxMutexLocker lock(mutex_);
+        if (!pack_.IsOpened() || jpeg.empty())
+        {
+            return false;
+        }
+
+        ThumbnailEntry entry;
+        entry.frame = frame;
+        entry.size = static_cast<wxUint32>(jpeg.size());
+        entry.offset = packLength_;
+
+        //Part of the data may have been written, so the next offset is taken from the file.
+        if (pack_.Write(&jpeg[0], jpeg.size()) != jpeg.size())
+        {
+            packLength_ = pack_.Length();
+            return false;
+        }
+        packLength_ += jpeg.size();
+
+        //A partial record would misalign every record after it.
+        if (index_.Write(&entry, sizeof(entry)) != sizeof(entry))
+        {
+            wxFileOffset length = index_.Length();
+            _chsize_s(index_.fd(), length - length % sizeof(ThumbnailEntry));
+            return false;
+        }
+
+        entries_[frame] = entry;
+
+        return true;
+    }
+
+    //Copy the JPEG data for "frame" into "jpeg".
+    bool ThumbnailPack::read(long frame, std::vector<unsigned char>& jpeg)
+    {
+        wxMutexLocker lock(mutex_);
+        std::map<long, ThumbnailEntry>::const_iterator it = entries_.find(frame);
+        if (it == entries_.end())
+        {
+            return false;
+        }
+
+        jpeg.resize(it->second.size);
+        if (pack_.Seek(it->second.offset) == wxInvalidOffset)
+        {
+            return false;
+        }
+
+        return pack_.Read(&jpeg[0], jpeg.size()) == static_cast<ssize_t>(jpeg.size());
+    }
+
+    bool ThumbnailPack::contains(long frame) const
+    {
+        return entries_.find(frame) != entries_.end();
+    }
+
+    //Frame numbers in the pack, in order
+    std::vector<long> ThumbnailPack::frames() const
+    {
+        std::vector<long> frames;
+        frames.reserve(entries_.size());
+        for (std::map<long, ThumbnailEntry>::const_iterator it = entries_.begin(); it != entries_.end(); ++it)
+        {
+            frames.push_back(it->first);
+        }
+
+        return frames;
+    }
+
+    //A partial record at the end of the index, or a record pointing past the
+    //end of the pack, is left over from an interrupted write and is ignored.
+    //If a frame appears twice the later record wins.
+    bool ThumbnailPack::loadIndex()
+    {
+        packLength_ = pack_.Length();
+        size_t count = static_cast<size_t>(index_.Length()/sizeof(ThumbnailEntry));
+
+        std::vector<ThumbnailEntry> records(count);
+        if (count > 0 && 
+            index_.Read(&records[0], count*sizeof(ThumbnailEntry)) != static_cast<ssize_t>(count*sizeof(ThumbnailEntry)))
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (records[i].offset + records[i].size <= static_cast<wxUint64>(packLength_))
+            {
+                entries_[records[i].frame] = records[i];
+            }
+        }
+
+        return true;
+    }
+
+    //Cut off what an interrupted capture left at the end of the files before more is
+    //appended: a partial index record, index records pointing past the end of the 
+    //pack (which would point at the new thumbnails later) and thumbnail data without
+    //an index record. 
+    bool ThumbnailPack::trim(const wxString& packName, const wxString& indexName)
+    {
+        wxFile pack;
+        wxFile index;
+        if ((wxFileExists(packName) && !pack.Open(packName, wxFile::read_write)) ||
+            (wxFileExists(indexName) && !index.Open(indexName, wxFile::read_write)))
+        {
+            return false;
+        }
+
+        wxFileOffset packLength = pack.IsOpened() ? pack.Length() : 0;
+        size_t count = index.IsOpened() ? static_cast<size_t>(index.Length()/sizeof(ThumbnailEntry)) : 0;
+
+        std::vector<ThumbnailEntry> records(count);
+        if (count > 0 && 
+            index.Read(&records[0], count*sizeof(ThumbnailEntry)) != static_cast<ssize_t>(count*sizeof(ThumbnailEntry)))
+        {
+            return false;
+        }
+
+        //Records are appended in order, so the first bad one ends the valid part.
+        size_t valid = 0;
+        wxUint64 end = 0;
+        while (valid < count && records[valid].offset + records[valid].size <= static_cast<wxUint64>(packLength))
+        {
+            end = std::max(end, records[valid].offset + records[valid].size);
+            ++valid;
+        }
+
+        if (index.IsOpened() && index.Length() != static_cast<wxFileOffset>(valid*sizeof(ThumbnailEntry)) &&
+            _chsize_s(index.fd(), valid*sizeof(ThumbnailEntry)) != 0)
+        {
+            return false;
+        }
+
+        if (pack.IsOpened() && packLength != static_cast<wxFileOffset>(end) && 
+            _chsize_s(pack.fd(), end) != 0)
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+} //namespace
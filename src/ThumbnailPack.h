@@ -0,0 +1,79 @@
+/*
+Author: Nariman Habili
+
+Description: Thumbnail pack file. The thumbnails of one camera, at one scale,
+             are appended as JPEGs to a single .pack file, with a fixed size
+             record per frame in an .idx file (frame number, offset, size).
+             A review tool can then page through a whole session without
+             opening the full size images.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef THUMBNAIL_PACK_H
+#define THUMBNAIL_PACK_H
+
+#include <wx/wx.h>
+#include <wx/file.h>
+#include <wx/thread.h>
+#include <map>
+#include <vector>
+
+namespace rics
+{
+    //Index record, as stored in the .idx file
+    struct ThumbnailEntry
+    {
+        wxInt32 frame;
+        wxUint32 size;
+        wxUint64 offset;
+    };
+
+    class ThumbnailPack
+    {
+    public:
+        ThumbnailPack();
+        ~ThumbnailPack();
+
+        bool create(const wxString& dir, unsigned long scale);
+        bool open(const wxString& dir, unsigned long scale);
+        void close();
+        bool isOpened() const;
+
+        bool append(long frame, const std::vector<unsigned char>& jpeg);
+        bool read(long frame, std::vector<unsigned char>& jpeg);
+        bool contains(long frame) const;
+        std::vector<long> frames() const;
+
+        static wxString packName(const wxString& dir, unsigned long scale);
+        static wxString indexName(const wxString& dir, unsigned long scale);
+
+    private:
+        bool loadIndex();
+        static bool trim(const wxString& packName, const wxString& indexName);
+
+    private:
+        wxFile pack_;
+        wxFile index_;
+        wxFileOffset packLength_;
+        std::map<long, ThumbnailEntry> entries_;
+        wxMutex mutex_;
+    };
+} //namespace
+
+#endif //THUMBNAIL_PACK_H
@@ -0,0 +1,98 @@
+/*
+Author: Nariman Habili
+
+Description: Software triggers all cameras together, either by distance
+             travelled or at the frame rate.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TriggerThread.h"
+
+namespace rics
+{
+    TriggerThread::TriggerThread()
+    {
+    }
+
+    TriggerThread::TriggerThread(Cameras* cameras, SharedGPSDataPtr gpsData, const DistanceTrigger& trigger):
+    cameras_(cameras),
+    gpsData_(gpsData),
+    trigger_(trigger)
+    {
+    }
+
+    TriggerThread::~TriggerThread()
+    {
+    }
+
+    //In distance based capture mode frames are triggered by the distance travelled.
+    //The GPS only updates a few times a second, so the distance travelled between
+    //updates is integrated from the last speed on a much shorter tick.
+    //Otherwise the cameras are triggered together at the camera frame rate.
+    void* TriggerThread::Entry()
+    {
+        wxLongLong now = wxGetLocalTimeMillis();
+        trigger_.reset(now);
+
+        float frameRate = (*cameras_).empty() ? 0.0f : (*cameras_)[0].frameRate();
+        long period = frameRate > 0.0f ? static_cast<long>(1000.0f/frameRate) : 250;
+        wxLongLong nextTrigger = now;
+
+        while (!TestDestroy())
+        {
+            Sleep(10);
+
+            now = wxGetLocalTimeMillis();
+            bool fire = false;
+
+            if (trigger_.enabled())
+            {
+                gpsData_->readLock();
+                double speed = gpsData_->speedKmh();
+                gpsData_->readUnlock();
+
+                fire = trigger_.update(speed, now);
+            }
+            else if (now >= nextTrigger)
+            {
+                fire = true;
+                nextTrigger += period;
+                if (nextTrigger < now)
+                {
+                    nextTrigger = now + period;
+                }
+            }
+
+            if (fire)
+            {
+                for (size_t i = 0; i < (*cameras_).size(); ++i)
+                {
+                    (*cameras_)[i].softwareTrigger();
+                }
+            }
+        }
+
+        return NULL;
+    }
+
+    void TriggerThread::OnExit()
+    {
+    }
+
+}//namespace
\ No newline at end of file
@@ -0,0 +1,55 @@
+/*
+Author: Nariman Habili
+
+Description: Software triggers all cameras together, either by distance
+             travelled or at the frame rate.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRIGGER_THREAD_H
+#define TRIGGER_THREAD_H
+
+#include "DistanceTrigger.h"
+#include "SharedGPSData.h"
+#include "Camera.h"
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <windows.h>
+
+namespace rics
+{
+    class TriggerThread : public wxThread
+    {
+    public:
+        TriggerThread();
+        TriggerThread(Cameras* cameras, SharedGPSDataPtr gpsData, const DistanceTrigger& trigger);
+        ~TriggerThread();
+
+        void* Entry();
+
+        void OnExit();
+
+    private:
+        Cameras* cameras_;
+        SharedGPSDataPtr gpsData_;
+        DistanceTrigger trigger_;
+    };
+} //namespace
+
+#endif //TRIGGER_THREAD_H
\ No newline at end of file
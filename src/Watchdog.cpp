@@ -0,0 +1,155 @@
+/*
+Author: Nariman Habili
+
+Description: Detects a camera that has stopped sending frames. When no frame
+             arrives within the deadline the camera thread restarts the
+             stream, retrying with a growing interval until frames resume.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Watchdog.h"
+#include <algorithm>
+
+namespace rics
+{
+    static const unsigned long maxRetryInterval = 30000;//ms
+
+    Watchdog::Watchdog():
+    enabled_(true),
+    deadline_(2000),
+    effectiveDeadline_(2000),
+    lastFrame_(0),
+    stalled_(false),
+    nextAttempt_(0),
+    attempts_(0),
+    failures_(0)
+    {
+    }
+
+    Watchdog::~Watchdog()
+    {
+    }
+
+    bool Watchdog::enabled() const
+    {
+        return enabled_;
+    }
+
+    void Watchdog::setEnabled(bool enabled)
+    {
+        enabled_ = enabled;
+    }
+
+    //Milliseconds without a frame before the camera is considered stalled.
+    unsigned long Watchdog::deadline() const
+    {
+        return deadline_;
+    }
+
+    void Watchdog::setDeadline(unsigned long ms)
+    {
+        deadline_ = ms;
+    }
+
+    //At low frame rates the deadline is stretched to at least three frame periods,
+    //so a slow camera isn't mistaken for a stalled one.
+    void Watchdog::start(wxLongLong now, float frameRate)
+    {
+        effectiveDeadline_ = deadline_;
+        if (frameRate > 0.0f)
+        {
+            effectiveDeadline_ = std::max(deadline_, static_cast<unsigned long>(3000.0f/frameRate));
+        }
+
+        lastFrame_ = now;
+        stalled_ = false;
+        attempts_ = 0;
+        failures_ = 0;
+    }
+
+    void Watchdog::frameArrived(wxLongLong now)
+    {
+        lastFrame_ = now;
+        stalled_ = false;
+        attempts_ = 0;
+        failures_ = 0;
+    }
+
+    //True when the camera should be restarted: the first time the deadline 
+    //passes, then again after each retry interval (doubled every attempt).
+    bool Watchdog::recoveryDue(wxLongLong now)
+    {
+        if (!enabled_)
+        {
+            return false;
+        }
+
+        if (!stalled_)
+        {
+            if (now - lastFrame_ < effectiveDeadline_)
+            {
+                return false;
+            }
+
+            stalled_ = true;
+            nextAttempt_ = now;
+        }
+
+        return now >= nextAttempt_;
+    }
+
+    void Watchdog::recoveryAttempted(wxLongLong now, bool restarted)
+    {
+        unsigned long interval = effectiveDeadline_ << std::min(attempts_, 4UL);
+        nextAttempt_ = now + std::min(interval, maxRetryInterval);
+
+        ++attempts_;
+        if (!restarted)
+        {
+            ++failures_;
+        }
+    }
+
+    bool Watchdog::stalled() const
+    {
+        return stalled_;
+    }
+
+    //PC time (ms) of the last frame, ie when the stall started.
+    wxLongLong Watchdog::lastFrame() const
+    {
+        return lastFrame_;
+    }
+
+    wxLongLong Watchdog::downtime(wxLongLong now) const
+    {
+        return now - lastFrame_;
+    }
+
+    unsigned long Watchdog::attempts() const
+    {
+        return attempts_;
+    }
+
+    unsigned long Watchdog::failures() const
+    {
+        return failures_;
+    }
+
+}//namespace
@@ -0,0 +1,69 @@
+/*
+Author: Nariman Habili
+
+Description: Detects a camera that has stopped sending frames. When no frame
+             arrives within the deadline the camera thread restarts the
+             stream, retrying with a growing interval until frames resume.
+
+Copyright (c) 2011-2012 Commonwealth of Australia (Geoscience Australia)
+
+This file is part of RICS.
+
+RICS is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+RICS is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with RICS.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <wx/longlong.h>
+
+namespace rics
+{
+    class Watchdog
+    {
+    public:
+        Watchdog();
+        ~Watchdog();
+
+        bool enabled() const;
+        void setEnabled(bool enabled);
+        unsigned long deadline() const;
+        void setDeadline(unsigned long ms);
+
+        void start(wxLongLong now, float frameRate);
+        void frameArrived(wxLongLong now);
+        bool recoveryDue(wxLongLong now);
+        void recoveryAttempted(wxLongLong now, bool restarted);
+
+        bool stalled() const;
+        wxLongLong lastFrame() const;
+        wxLongLong downtime(wxLongLong now) const;
+        unsigned long attempts() const;
+        unsigned long failures() const;
+
+    private:
+        bool enabled_;
+        unsigned long deadline_;
+        unsigned long effectiveDeadline_;
+
+        wxLongLong lastFrame_;
+        bool stalled_;
+        wxLongLong nextAttempt_;
+        unsigned long attempts_;
+        unsigned long failures_;//attempts where the camera didn't respond
+    };
+
+}//namespace
+
+#endif //WATCHDOG_H